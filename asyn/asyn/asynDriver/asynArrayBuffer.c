@@ -0,0 +1,231 @@
+/* asynArrayBuffer.c */
+/***********************************************************************
+* asynDriver is distributed subject to a Software License Agreement
+* found in file LICENSE that is included with this distribution.
+***********************************************************************/
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <ellLib.h>
+#include <epicsMutex.h>
+#include <epicsThread.h>
+#include <epicsVersion.h>
+#include <cantProceed.h>
+#include <epicsAssert.h>
+
+#include <epicsExport.h>
+#include "asynArrayBuffer.h"
+
+/* The reference count is changed with epicsAtomic where base has it,
+ * so that reference and release take no lock. */
+#if (EPICS_VERSION > 3) || ((EPICS_VERSION == 3) && (EPICS_REVISION >= 15))
+#define REFERENCE_ATOMIC 1
+#include <epicsAtomic.h>
+#define referenceIncr(p) epicsAtomicIncrIntT(p)
+#define referenceDecr(p) epicsAtomicDecrIntT(p)
+#define referenceGet(p)  epicsAtomicGetIntT(p)
+#else
+static int referenceIncr(int *p);
+static int referenceDecr(int *p);
+#define referenceGet(p)  (*(p))
+#endif
+
+/* Released buffers that are kept for reuse by create */
+#define MAX_FREE_BUFFERS 4
+/* Alignment of the data, enough for any element type */
+#define DATA_ALIGN 16
+/* Number of chains of the table of active buffers, must be a power of 2 */
+#define HASH_SIZE 256
+
+typedef struct bufferPvt {
+    ELLNODE          node;      /*For activeList or freeList*/
+    struct bufferPvt *hashNext; /*Next active buffer in the same chain*/
+    asynArrayBuffer  buffer;
+    size_t           capacity;  /*bytes allocated for data*/
+    int              referenceCount;
+} bufferPvt;
+#define bufferToPvt(p) \
+  ((bufferPvt *) ((char *)(p) \
+          - ( (char *)&(((bufferPvt *)0)->buffer) - (char *)0 ) ) )
+
+/* The data of a buffer is in the same allocation as its bufferPvt */
+#define DATA_OFFSET \
+  ((sizeof(bufferPvt) + DATA_ALIGN - 1) & ~(size_t)(DATA_ALIGN - 1))
+/* The low bits of data are always 0 */
+#define hashIndex(p) \
+  ((((size_t)(p) >> 4) ^ ((size_t)(p) >> 12)) & (HASH_SIZE - 1))
+
+static epicsThreadOnceId arrayBufferOnceId = EPICS_THREAD_ONCE_INIT;
+static epicsMutexId arrayBufferLock;
+static ELLLIST      activeList; /*buffers with references*/
+static ELLLIST      freeList;   /*most recently released first*/
+static bufferPvt    *hashTable[HASH_SIZE]; /*activeList by data*/
+static unsigned long numberCreated;
+static unsigned long numberReused;
+
+static void arrayBufferInit(void *arg)
+{
+    arrayBufferLock = epicsMutexMustCreate();
+    ellInit(&activeList);
+    ellInit(&freeList);
+}
+
+#ifndef REFERENCE_ATOMIC
+static int referenceIncr(int *p)
+{
+    int count;
+
+    epicsMutexMustLock(arrayBufferLock);
+    count = ++*p;
+    epicsMutexUnlock(arrayBufferLock);
+    return count;
+}
+
+static int referenceDecr(int *p)
+{
+    int count;
+
+    epicsMutexMustLock(arrayBufferLock);
+    count = --*p;
+    epicsMutexUnlock(arrayBufferLock);
+    return count;
+}
+#endif
+
+/* The caller holds arrayBufferLock */
+static void hashAdd(bufferPvt *pbufferPvt)
+{
+    bufferPvt **pchain = &hashTable[hashIndex(pbufferPvt->buffer.data)];
+
+    pbufferPvt->hashNext = *pchain;
+    *pchain = pbufferPvt;
+}
+
+static void hashDelete(bufferPvt *pbufferPvt)
+{
+    bufferPvt **pchain = &hashTable[hashIndex(pbufferPvt->buffer.data)];
+
+    while(*pchain!=pbufferPvt) pchain = &(*pchain)->hashNext;
+    *pchain = pbufferPvt->hashNext;
+    pbufferPvt->hashNext = 0;
+}
+
+static asynArrayBuffer *create(size_t nElements, size_t elementSize)
+{
+    bufferPvt  *pbufferPvt;
+    size_t     nbytes = nElements*elementSize;
+
+    epicsThreadOnce(&arrayBufferOnceId, arrayBufferInit, 0);
+    epicsMutexMustLock(arrayBufferLock);
+    /* Only the most recently released buffer is considered, drivers
+     * normally publish arrays of the same size */
+    pbufferPvt = (bufferPvt *)ellFirst(&freeList);
+    if(pbufferPvt && (pbufferPvt->capacity<nbytes || pbufferPvt->capacity/2>nbytes))
+        pbufferPvt = 0;
+    if(pbufferPvt) {
+        ellDelete(&freeList, &pbufferPvt->node);
+        numberReused++;
+    }
+    epicsMutexUnlock(arrayBufferLock);
+    if(!pbufferPvt) {
+        pbufferPvt = callocMustSucceed(1, DATA_OFFSET + (nbytes ? nbytes : 1),
+            "asynArrayBuffer:create");
+        pbufferPvt->buffer.data = (char *)pbufferPvt + DATA_OFFSET;
+        pbufferPvt->capacity = nbytes;
+        epicsMutexMustLock(arrayBufferLock);
+        numberCreated++;
+        epicsMutexUnlock(arrayBufferLock);
+    }
+    pbufferPvt->buffer.nElements = nElements;
+    pbufferPvt->buffer.elementSize = elementSize;
+    pbufferPvt->referenceCount = 1;
+    epicsMutexMustLock(arrayBufferLock);
+    ellAdd(&activeList, &pbufferPvt->node);
+    hashAdd(pbufferPvt);
+    epicsMutexUnlock(arrayBufferLock);
+    return &pbufferPvt->buffer;
+}
+
+/* Looks data up in the table of active buffers. Arrays that are not the
+ * data of a buffer are never read */
+static asynArrayBuffer *find(const void *data)
+{
+    bufferPvt *pbufferPvt;
+
+    if(!data) return 0;
+    epicsThreadOnce(&arrayBufferOnceId, arrayBufferInit, 0);
+    epicsMutexMustLock(arrayBufferLock);
+    pbufferPvt = hashTable[hashIndex(data)];
+    while(pbufferPvt && pbufferPvt->buffer.data!=data)
+        pbufferPvt = pbufferPvt->hashNext;
+    /* A buffer whose count reached 0 is about to be released. The caller is an
+     * interrupt callback of the driver that holds a reference to the buffer
+     * it passed, so the count of that buffer cannot reach 0 here */
+    if(pbufferPvt && referenceGet(&pbufferPvt->referenceCount)==0) pbufferPvt = 0;
+    if(pbufferPvt) referenceIncr(&pbufferPvt->referenceCount);
+    epicsMutexUnlock(arrayBufferLock);
+    return pbufferPvt ? &pbufferPvt->buffer : 0;
+}
+
+static void reference(asynArrayBuffer *pbuffer)
+{
+    bufferPvt *pbufferPvt = bufferToPvt(pbuffer);
+    int       count;
+
+    count = referenceIncr(&pbufferPvt->referenceCount);
+    assert(count>1);
+}
+
+static void release(asynArrayBuffer *pbuffer)
+{
+    bufferPvt *pbufferPvt = bufferToPvt(pbuffer);
+    bufferPvt *pfree = 0;
+    int       count;
+
+    count = referenceDecr(&pbufferPvt->referenceCount);
+    assert(count>=0);
+    if(count>0) return;
+    epicsMutexMustLock(arrayBufferLock);
+    ellDelete(&activeList, &pbufferPvt->node);
+    hashDelete(pbufferPvt);
+    ellInsert(&freeList, 0, &pbufferPvt->node);
+    if(ellCount(&freeList)>MAX_FREE_BUFFERS) {
+        pfree = (bufferPvt *)ellLast(&freeList);
+        ellDelete(&freeList, &pfree->node);
+    }
+    epicsMutexUnlock(arrayBufferLock);
+    if(pfree) free(pfree);
+}
+
+static void report(FILE *fp, int details)
+{
+    bufferPvt *pbufferPvt;
+
+    epicsThreadOnce(&arrayBufferOnceId, arrayBufferInit, 0);
+    epicsMutexMustLock(arrayBufferLock);
+    fprintf(fp, "asynArrayBuffer active %d free %d created %lu reused %lu\n",
+        ellCount(&activeList), ellCount(&freeList), numberCreated, numberReused);
+    if(details>=1) {
+        pbufferPvt = (bufferPvt *)ellFirst(&activeList);
+        while(pbufferPvt) {
+            fprintf(fp, "    data %p nElements %lu elementSize %lu references %d\n",
+                pbufferPvt->buffer.data,
+                (unsigned long)pbufferPvt->buffer.nElements,
+                (unsigned long)pbufferPvt->buffer.elementSize,
+                referenceGet(&pbufferPvt->referenceCount));
+            pbufferPvt = (bufferPvt *)ellNext(&pbufferPvt->node);
+        }
+    }
+    epicsMutexUnlock(arrayBufferLock);
+}
+
+static asynArrayBufferManager arrayBufferManager = {
+    create,
+    find,
+    reference,
+    release,
+    report
+};
+epicsShareDef asynArrayBufferManager *pasynArrayBuffer = &arrayBufferManager;
@@ -0,0 +1,50 @@
+/* asynArrayBuffer.h */
+/***********************************************************************
+* asynDriver is distributed subject to a Software License Agreement
+* found in file LICENSE that is included with this distribution.
+***********************************************************************/
+
+/* Reference counted array buffers that drivers can pass to the array
+ * interrupt callbacks. A driver creates a buffer, fills data, passes data
+ * to doCallbacksXXXArray or its own callbacks, and then releases it.
+ * The data must not be modified after it has been passed to callbacks.
+ * A callback that wants to keep the array calls find(value), which returns
+ * the buffer with a new reference, or NULL if value is not the data of a
+ * buffer, in which case the callback must copy the array. find looks the
+ * pointer up in a hash table of the active buffers and never reads the
+ * array, so any array can be passed to it.
+ */
+
+#ifndef asynArrayBufferH
+#define asynArrayBufferH
+
+#include <stddef.h>
+#include <stdio.h>
+#include <shareLib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif  /* __cplusplus */
+
+typedef struct asynArrayBuffer {
+    void   *data;
+    size_t nElements;
+    size_t elementSize;
+} asynArrayBuffer;
+
+typedef struct asynArrayBufferManager {
+    /* Returns a buffer with one reference */
+    asynArrayBuffer *(*create)(size_t nElements, size_t elementSize);
+    /* Returns the buffer with a new reference, or NULL */
+    asynArrayBuffer *(*find)(const void *data);
+    void            (*reference)(asynArrayBuffer *pbuffer);
+    void            (*release)(asynArrayBuffer *pbuffer);
+    void            (*report)(FILE *fp, int details);
+} asynArrayBufferManager;
+epicsShareExtern asynArrayBufferManager *pasynArrayBuffer;
+
+#ifdef __cplusplus
+}
+#endif  /* __cplusplus */
+
+#endif /* asynArrayBufferH */
@@ -88,6 +88,17 @@ typedef struct interruptNode{
     ELLNODE node;
     void    *drvPvt;
 }interruptNode;
+
+/* time histogram bins are <10us, <100us, ..., <10s, >=10s */
+#define ASYN_QUEUE_STATISTICS_BINS 8
+typedef struct asynQueueStatistics {
+    unsigned long queueWait[ASYN_QUEUE_STATISTICS_BINS]; /*queueRequest to callback*/
+    unsigned long service[ASYN_QUEUE_STATISTICS_BINS];   /*callback holding port*/
+    unsigned long numberTimeouts;
+    unsigned long numberCancels;
+}asynQueueStatistics;
+/* labels of the time histogram bins */
+epicsShareExtern const char *asynQueueStatisticsLabels[ASYN_QUEUE_STATISTICS_BINS];
 
 typedef struct asynManager {
     void      (*report)(FILE *fp,int details,const char*portName);
@@ -160,6 +171,22 @@ typedef struct asynManager {
     asynStatus (*setTimeStamp)(asynUser *pasynUser, const epicsTimeStamp *pTimeStamp);
 
     const char *(*strStatus)(asynStatus status);
+    /* Interrupt users that were added with a given reason and addr.
+     * Must be called between interruptStart and interruptEnd */
+    interruptNode *(*interruptFindFirst)(void *pasynPvt,int reason,int addr);
+    interruptNode *(*interruptFindNext)(interruptNode *pinterruptNode);
+    /* Queue statistics of the port (addr -1) or device.
+     * Queue wait and service times are only recorded while enabled for the port */
+    asynStatus (*enableQueueStatistics)(asynUser *pasynUser,int yesNo);
+    asynStatus (*getQueueStatistics)(asynUser *pasynUser,
+                               asynQueueStatistics *pstatistics,int clear);
+    /* Number of threads that process the queued requests of an ASYN_CANBLOCK,
+     * ASYN_MULTIDEVICE port. Requests for different devices run concurrently */
+    asynStatus (*setPortThreads)(asynUser *pasynUser,int numberThreads);
+    /* Number of write-read transactions that asynOctetSyncIO->writeReadPipeline
+     * may have outstanding on the port. The default of 1 means no pipelining */
+    asynStatus (*setPipelineDepth)(asynUser *pasynUser,int depth);
+    asynStatus (*getPipelineDepth)(asynUser *pasynUser,int *depth);
 }asynManager;
 epicsShareExtern asynManager *pasynManager;
 
@@ -249,6 +276,9 @@ typedef struct asynTrace {
     int        (*vprintIOSource)(asynUser *pasynUser,int reason,
                     const char *buffer, size_t len,const char *file, int line, const char *pformat, va_list pvar) EPICS_PRINTF_STYLE(7,0);
 #endif
+    /* numberRecords>0 buffers the trace output of the port in a ring buffer */
+    asynStatus (*setTraceRing)(asynUser *pasynUser,int numberRecords,int drain);
+    int        (*dumpTraceRing)(asynUser *pasynUser,FILE *fp);
 }asynTrace;
 epicsShareExtern asynTrace *pasynTrace;
 
@@ -25,6 +25,7 @@
 #include <epicsMutex.h>
 #include <epicsEvent.h>
 #include <epicsThread.h>
+#include <epicsExit.h>
 #include <epicsTime.h>
 #include <epicsTimer.h>
 #include <cantProceed.h>
@@ -32,6 +33,7 @@
 
 #include <epicsExport.h>
 #include "asynDriver.h"
+#include "asynArrayBuffer.h"
 
 #define BOOL int
 #ifndef TRUE
@@ -46,6 +48,11 @@
 #define DEFAULT_TRACE_BUFFER_SIZE 80
 #define DEFAULT_SECONDS_BETWEEN_PORT_CONNECT 20
 #define DEFAULT_AUTOCONNECT_TIMEOUT 0.5
+#define DEFAULT_DISPATCH_TABLE_SIZE 64
+/* queue depth histogram bins are 1, 2-3, 4-7, ..., >=2048 */
+#define NUM_QUEUE_DEPTH_BINS 12
+/* queue wait histogram bins are <10us, <100us, ..., <10s, >=10s */
+#define NUM_QUEUE_WAIT_BINS ASYN_QUEUE_STATISTICS_BINS
 
 /* This is taken from dbDefs.h, which we don't want to include */
 /* Subtract member byte offset, returning pointer to parent object */
@@ -81,6 +88,59 @@ struct tracePvt {
     char          *traceBuffer;
 };
 
+/* Trace ring buffer. When a port has a ring, asynPrint and asynPrintIO only
+ * copy the raw record into it. The records are formatted later by the
+ * drain thread or by dumpTraceRing. The message and payload buffers of each
+ * record grow when a longer message or a larger truncate size needs them.
+ */
+#define TRACE_RING_MESSAGE_SIZE 128   /*initial size of the message buffer*/
+#define TRACE_RING_THREAD_NAME_SIZE 32
+#define TRACE_RING_DRAIN_PERIOD 0.1
+
+#ifndef va_copy
+#ifdef __va_copy
+#define va_copy(dest,src) __va_copy(dest,src)
+#else
+#define va_copy(dest,src) memcpy(&(dest),&(src),sizeof(va_list))
+#endif
+#endif
+
+typedef struct traceRecord {
+    epicsTimeStamp time;
+    int           addr;
+    int           reason;        /*pasynUser->reason*/
+    int           traceReason;   /*ASYN_TRACE_XXX passed to asynPrint*/
+    int           traceIOMask;   /*0 if not from asynPrintIO*/
+    int           traceInfoMask;
+    tracePvt      *ptracePvt;    /*of the device or port; gives the trace file*/
+    const char    *file;
+    int           line;
+    epicsThreadId threadId;
+    unsigned int  threadPriority;
+    char          threadName[TRACE_RING_THREAD_NAME_SIZE];
+    char          *message;
+    size_t        messageSize;   /*size of the message buffer*/
+    char          *payload;
+    size_t        payloadSize;   /*size of the payload buffer*/
+    size_t        nBytes;
+}traceRecord;
+
+/*The traceRing of a port is never freed because asynPrint reads
+ *pport->ptraceRing without a lock. setTraceRing frees its records.*/
+typedef struct traceRing {
+    epicsMutexId  lock;
+    epicsMutexId  setLock;       /*serializes setTraceRing*/
+    traceRecord   *records;
+    int           numberRecords; /*0 means trace output is not buffered*/
+    int           head;          /*next record to write*/
+    int           count;         /*records not yet formatted*/
+    unsigned long numberOverwritten;
+    BOOL          drain;         /*the drain thread exits when this is FALSE*/
+    epicsEventId  drainEvent;
+    epicsEventId  drainExitEvent;
+    epicsThreadId drainThreadId;
+}traceRing;
+
 #define nMemList 9
 static size_t memListSize[nMemList] =
     {16,32,64,128,256,512,1024,2048,4096};
@@ -93,22 +153,66 @@ typedef struct memNode {
  * Ensure adequate alignment
  */
 #define NODESIZE (((sizeof(memNode)+15)/16)*16)
+
+/*
+ * Free lists for asynUser, interruptNode and the memMalloc size classes.
+ * Each thread caches up to THREAD_CACHE_SIZE free nodes of each kind, so most
+ * create and free calls take no lock. Nodes move between a thread cache and
+ * the shared list, under freeListLock, THREAD_CACHE_SIZE/2 at a time.
+ * When a thread exits its cache is emptied into the shared lists and freed.
+ * The counters are only changed under freeListLock.
+ */
+#define THREAD_CACHE_SIZE 16
+#define FREE_LIST_ASYNUSER 0
+#define FREE_LIST_INTERRUPT 1
+#define FREE_LIST_MEM 2
+#define nFreeList (FREE_LIST_MEM + nMemList)
+
+typedef struct freeList {
+    ELLLIST       list;     /*free nodes shared by all threads*/
+    unsigned long nCreated; /*nodes allocated because no free node was available*/
+    unsigned long nRefill;  /*transfers from list to a thread cache*/
+    unsigned long nFlush;   /*transfers from a thread cache to list*/
+}freeList;
+
+typedef struct threadFreeList {
+    ELLLIST       list;
+}threadFreeList;
+
+typedef struct threadCache {
+    ELLNODE        node;    /*For asynBase.threadCacheList*/
+    epicsThreadId  tid;
+    threadFreeList freeList[nFreeList];
+}threadCache;
 
 typedef struct asynBase {
     ELLLIST           asynPortList;
-    ELLLIST           asynUserFreeList;
-    ELLLIST           interruptNodeFree;
     epicsTimerQueueId timerQueue;
     epicsMutexId      lock;
     epicsMutexId      lockTrace;
     tracePvt          trace;
-    ELLLIST           memList[nMemList];
+    /* following for free lists */
+    epicsMutexId      freeListLock;
+    freeList          freeList[nFreeList];
+    ELLLIST           threadCacheList;
+    epicsThreadPrivateId threadCacheId;
+    /* dpCommon of the device callback a portThread is running */
+    epicsThreadPrivateId deviceCallbackId;
     /* following for connectPort */
     epicsTimerQueueId connectPortTimerQueue;
     double            autoConnectTimeout;
 }asynBase;
 static asynBase *pasynBase = 0;
 
+/* All interrupt users that registered with the same reason and addr.
+ * addr -1 (not multi-device or the port itself) shares the key of addr 0 */
+typedef struct dispatchKey {
+    ELLNODE      node;      /*For interruptBase.dispatchTable*/
+    int          reason;
+    int          addr;
+    ELLLIST      nodeList;  /*interruptNodePvt.dispatchNode*/
+}dispatchKey;
+
 typedef struct interruptBase {
     ELLLIST      callbackList;
     ELLLIST      addRemoveList;
@@ -116,14 +220,21 @@ typedef struct interruptBase {
     BOOL         listModified;
     port         *pport;
     asynInterface *pasynInterface;
+    /* hash table of dispatchKey for interruptFindFirst/interruptFindNext */
+    ELLLIST      *dispatchTable;
+    int          dispatchTableSize;
+    int          numDispatchKeys;
 }interruptBase;
 
 typedef struct interruptNodePvt {
     ELLNODE  addRemoveNode;
+    ELLNODE  dispatchNode;
     BOOL     isOnList;
     BOOL     isOnAddRemoveList;
     epicsEventId  callbackDone;
     interruptBase *pinterruptBase;
+    dispatchKey   *pdispatchKey;
+    asynUser      *pdispatchUser; /*asynUser passed to addInterruptUser*/
     interruptNode nodePublic;
 }interruptNodePvt;
 
@@ -148,6 +259,11 @@ typedef struct dpCommon { /*device/port common fields*/
     tracePvt       trace;
     port           *pport;
     device         *pdevice; /* 0 if port.dpc*/
+    /* requests that can not be processed while disabled or blocked */
+    ELLLIST        parkedList[NUMBER_QUEUE_PRIORITIES];
+    /* The following are for ports with more than one portThread */
+    epicsMutexId   deviceLock; /*devices of ASYN_CANBLOCK ports*/
+    BOOL           callbackActive;
 }dpCommon;
 
 typedef struct exceptionUser {
@@ -176,6 +292,9 @@ struct userPvt {
     exceptionUser *pexceptionUser;
     BOOL          freeAfterCallback;
     BOOL          isQueued;
+    ELLLIST       *pqueueList; /*queueList or parkedList while isQueued*/
+    BOOL          queueTimed; /*queueTime set because statistics are enabled*/
+    epicsTimeStamp queueTime;
     asynUser      user;
 };
 
@@ -183,6 +302,7 @@ struct device {
     ELLNODE   node;     /*For asynPort.deviceList*/
     dpCommon  dpc;
     int       addr;
+    asynQueueStatistics queueStatistics;
 };
 
 struct port {
@@ -204,6 +324,13 @@ struct port {
     BOOL          queueStateChange;
     epicsEventId  notifyPortThread;
     epicsThreadId threadid;
+    int           numberThreads; /*threads that run portThread*/
+    unsigned int  threadPriority;
+    unsigned int  threadStackSize;
+    int           numberDeviceCallbacks; /*device callbacks in progress*/
+    int           portLockCount; /*port locked while numberThreads>1*/
+    int           pipelineDepth; /*outstanding writeReadPipeline transactions*/
+    epicsEventId  deviceCallbacksDone;
     userPvt       *pblockProcessHolder;
     /* following are for portConnect */
     asynUser      *pconnectUser;
@@ -216,6 +343,16 @@ struct port {
     void           *timeStampPvt;
 
     double        secondsBetweenPortConnect;
+    /* The following are for queue statistics */
+    int           numberQueued; /*requests on queueList and parkedList*/
+    BOOL          queueStatisticsEnabled; /*record queue and service times*/
+    unsigned long queueDepthHistogram[NUM_QUEUE_DEPTH_BINS];
+    unsigned long queueWaitHistogram[NUM_QUEUE_WAIT_BINS];
+    unsigned long serviceHistogram[NUM_QUEUE_WAIT_BINS];
+    unsigned long numberTimeouts;
+    unsigned long numberCancels;
+    /* The following is for the trace ring buffer */
+    traceRing     *ptraceRing;
 };
 
 typedef struct queueLockPortPvt {
@@ -224,6 +361,9 @@ typedef struct queueLockPortPvt {
     unsigned int  queueLockPortCount;
 }queueLockPortPvt;
 
+#define dispatchNodeToPvt(pdispatchNode) \
+    ((interruptNodePvt *) ((char *)(pdispatchNode) \
+           - ( (char *)&(((interruptNodePvt *)0)->dispatchNode) - (char *)0 ) ) )
 #define interruptNodeToPvt(pinterruptNode) \
     ((interruptNodePvt *) ((char *)(pinterruptNode) \
            - ( (char *)&(((interruptNodePvt *)0)->nodePublic) - (char *)0 ) ) )
@@ -243,11 +383,33 @@ static void dpCommonInit(port *pport,device *pdevice,BOOL autoConnect);
 static void dpCommonFree(dpCommon *pdpCommon);
 static dpCommon *findDpCommon(userPvt *puserPvt);
 static tracePvt *findTracePvt(userPvt *puserPvt);
+static FILE *traceFile(tracePvt *ptracePvt);
+static int traceRingRecord(port *pport,asynUser *pasynUser,tracePvt *ptracePvt,
+            int reason,int traceIOMask,const char *buffer,size_t nBytes,
+            const char *file,int line,const char *pformat,va_list pvar);
 static port *locatePort(const char *portName);
 static device *locateDevice(port *pport,int addr,BOOL allocNew);
 static interfaceNode *locateInterfaceNode(
             ELLLIST *plist,const char *interfaceType,BOOL allocNew);
 static void exceptionOccurred(asynUser *pasynUser,asynException exception);
+/*dispatch index methods must be called with asynManagerLock held*/
+static dispatchKey *locateDispatchKey(interruptBase *pinterruptBase,
+            int reason,int addr,BOOL allocNew);
+static void dispatchAdd(interruptBase *pinterruptBase,
+            interruptNodePvt *pinterruptNodePvt,asynUser *pasynUser);
+static void dispatchRemove(interruptBase *pinterruptBase,
+            interruptNodePvt *pinterruptNodePvt);
+/*queue methods must be called with asynManagerLock held*/
+static void queueRemove(port *pport,userPvt *puserPvt);
+static void queueStatistics(port *pport,userPvt *puserPvt);
+static void serviceStatistics(port *pport,
+            asynQueueStatistics *pdeviceStatistics,double seconds);
+static void parkRequest(dpCommon *pdpCommon,userPvt *puserPvt,int priority);
+static void unparkRequests(dpCommon *pdpCommon);
+static void lockDpCommon(dpCommon *pdpCommon);
+static void unlockDpCommon(dpCommon *pdpCommon);
+static BOOL callbackCanStart(port *pport,dpCommon *pdpCommon,
+            userPvt *puserPvt);
 static void queueTimeoutCallback(void *pvt);
 /*autoConnectDevice must be called with asynManagerLock held*/
 static BOOL autoConnectDevice(port *pport,device *pdevice);
@@ -316,6 +478,14 @@ static asynStatus removeInterruptUser(asynUser *pasynUser,
                                    interruptNode*pinterruptNode);
 static asynStatus interruptStart(void *pasynPvt,ELLLIST **plist);
 static asynStatus interruptEnd(void *pasynPvt);
+static interruptNode *interruptFindFirst(void *pasynPvt,int reason,int addr);
+static interruptNode *interruptFindNext(interruptNode *pinterruptNode);
+static asynStatus enableQueueStatistics(asynUser *pasynUser,int yesNo);
+static asynStatus getQueueStatistics(asynUser *pasynUser,
+    asynQueueStatistics *pstatistics,int clear);
+static asynStatus setPortThreads(asynUser *pasynUser,int numberThreads);
+static asynStatus setPipelineDepth(asynUser *pasynUser,int depth);
+static asynStatus getPipelineDepth(asynUser *pasynUser,int *depth);
 static void defaultTimeStampSource(void *userPvt, epicsTimeStamp *pTimeStamp);
 static asynStatus registerTimeStampSource(asynUser *pasynUser, void *userPvt, timeStampCallback callback);
 static asynStatus unregisterTimeStampSource(asynUser *pasynUser);
@@ -373,7 +543,14 @@ static asynManager manager = {
     updateTimeStamp,
     getTimeStamp,
     setTimeStamp,
-    strStatus
+    strStatus,
+    interruptFindFirst,
+    interruptFindNext,
+    enableQueueStatistics,
+    getQueueStatistics,
+    setPortThreads,
+    setPipelineDepth,
+    getPipelineDepth
 };
 epicsShareDef asynManager *pasynManager = &manager;
 
@@ -406,6 +583,8 @@ static int        traceVprintIO(asynUser *pasynUser,int reason,
                       const char *buffer, size_t len,const char *pformat, va_list pvar);
 static int        traceVprintIOSource(asynUser *pasynUser,int reason,
                       const char *buffer, size_t len, const char *file, int line, const char *pformat, va_list pvar);
+static asynStatus setTraceRing(asynUser *pasynUser,int numberRecords,int drain);
+static int        dumpTraceRing(asynUser *pasynUser,FILE *fp);
 static asynTrace asynTraceManager = {
     traceLock,
     traceUnlock,
@@ -426,7 +605,9 @@ static asynTrace asynTraceManager = {
     tracePrintIO,
     tracePrintIOSource,
     traceVprintIO,
-    traceVprintIOSource
+    traceVprintIOSource,
+    setTraceRing,
+    dumpTraceRing
 };
 epicsShareDef asynTrace *pasynTrace = &asynTraceManager;
 
@@ -456,22 +637,129 @@ static void asynInit(void)
     if(pasynBase) return;
     pasynBase = callocMustSucceed(1,sizeof(asynBase),"asynInit");
     ellInit(&pasynBase->asynPortList);
-    ellInit(&pasynBase->asynUserFreeList);
-    ellInit(&pasynBase->interruptNodeFree);
     pasynBase->timerQueue = epicsTimerQueueAllocate(
         1,epicsThreadPriorityScanLow);
     pasynBase->lock = epicsMutexMustCreate();
     pasynBase->lockTrace = epicsMutexMustCreate();
     tracePvtInit(&pasynBase->trace);
-    for(i=0; i<nMemList; i++) ellInit(&pasynBase->memList[i]);
+    pasynBase->freeListLock = epicsMutexMustCreate();
+    for(i=0; i<nFreeList; i++) ellInit(&pasynBase->freeList[i].list);
+    ellInit(&pasynBase->threadCacheList);
+    pasynBase->threadCacheId = epicsThreadPrivateCreate();
+    pasynBase->deviceCallbackId = epicsThreadPrivateCreate();
     pasynBase->connectPortTimerQueue = epicsTimerQueueAllocate(
         0,epicsThreadPriorityScanLow);
     pasynBase->autoConnectTimeout = DEFAULT_AUTOCONNECT_TIMEOUT;
 }
 
+/* Free list methods */
+static void threadCacheFree(void *arg)
+{
+    threadCache *pthreadCache = (threadCache *)arg;
+    ELLNODE     *pnode;
+    int         ind;
+
+    epicsThreadPrivateSet(pasynBase->threadCacheId,0);
+    epicsMutexMustLock(pasynBase->freeListLock);
+    for(ind=0; ind<nFreeList; ind++) {
+        while((pnode = ellGet(&pthreadCache->freeList[ind].list))) {
+            ellAdd(&pasynBase->freeList[ind].list,pnode);
+        }
+    }
+    ellDelete(&pasynBase->threadCacheList,&pthreadCache->node);
+    epicsMutexUnlock(pasynBase->freeListLock);
+    free(pthreadCache);
+}
+
+static threadCache *getThreadCache(void)
+{
+    threadCache *pthreadCache;
+    int         i;
+
+    pthreadCache = epicsThreadPrivateGet(pasynBase->threadCacheId);
+    if(pthreadCache) return pthreadCache;
+    pthreadCache = callocMustSucceed(1,sizeof(threadCache),
+        "asynManager:getThreadCache");
+    pthreadCache->tid = epicsThreadGetIdSelf();
+    for(i=0; i<nFreeList; i++) ellInit(&pthreadCache->freeList[i].list);
+    epicsMutexMustLock(pasynBase->freeListLock);
+    ellAdd(&pasynBase->threadCacheList,&pthreadCache->node);
+    epicsMutexUnlock(pasynBase->freeListLock);
+    epicsThreadPrivateSet(pasynBase->threadCacheId,pthreadCache);
+    epicsAtThreadExit(threadCacheFree,pthreadCache);
+    return pthreadCache;
+}
+
+/* Returns a free node from list ind or null if caller must allocate one*/
+static ELLNODE *freeListGet(int ind)
+{
+    threadFreeList *pthreadFreeList = &getThreadCache()->freeList[ind];
+    freeList       *pfreeList = &pasynBase->freeList[ind];
+    ELLNODE        *pnode;
+
+    if(ellCount(&pthreadFreeList->list)==0) {
+        epicsMutexMustLock(pasynBase->freeListLock);
+        while(ellCount(&pthreadFreeList->list)<THREAD_CACHE_SIZE/2
+        && (pnode = ellGet(&pfreeList->list))) {
+            ellAdd(&pthreadFreeList->list,pnode);
+        }
+        if(ellCount(&pthreadFreeList->list)==0) {
+            pfreeList->nCreated++;
+        } else {
+            pfreeList->nRefill++;
+        }
+        epicsMutexUnlock(pasynBase->freeListLock);
+    }
+    return ellGet(&pthreadFreeList->list);
+}
+
+static void freeListPut(int ind,ELLNODE *pnode)
+{
+    threadFreeList *pthreadFreeList = &getThreadCache()->freeList[ind];
+    freeList       *pfreeList = &pasynBase->freeList[ind];
+
+    ellAdd(&pthreadFreeList->list,pnode);
+    if(ellCount(&pthreadFreeList->list)<THREAD_CACHE_SIZE) return;
+    epicsMutexMustLock(pasynBase->freeListLock);
+    while(ellCount(&pthreadFreeList->list)>THREAD_CACHE_SIZE/2) {
+        ellAdd(&pfreeList->list,ellGet(&pthreadFreeList->list));
+    }
+    pfreeList->nFlush++;
+    epicsMutexUnlock(pasynBase->freeListLock);
+}
+
+static void reportFreeLists(FILE *fp)
+{
+    int         ind;
+
+    epicsMutexMustLock(pasynBase->freeListLock);
+    fprintf(fp,"asynManager free lists: %d thread caches\n",
+        ellCount(&pasynBase->threadCacheList));
+    fprintf(fp,"    %-16s %8s %8s %8s %8s\n",
+        "list","created","free","refill","flush");
+    for(ind=0; ind<nFreeList; ind++) {
+        freeList      *pfreeList = &pasynBase->freeList[ind];
+        char          name[20];
+
+        if(ind==FREE_LIST_ASYNUSER) {
+            strcpy(name,"asynUser");
+        } else if(ind==FREE_LIST_INTERRUPT) {
+            strcpy(name,"interruptNode");
+        } else {
+            epicsSnprintf(name,sizeof(name),"memMalloc %lu",
+                (unsigned long)memListSize[ind-FREE_LIST_MEM]);
+        }
+        fprintf(fp,"    %-16s %8lu %8d %8lu %8lu\n",
+            name,pfreeList->nCreated,ellCount(&pfreeList->list),
+            pfreeList->nRefill,pfreeList->nFlush);
+    }
+    epicsMutexUnlock(pasynBase->freeListLock);
+}
+
 static void dpCommonInit(port *pport,device *pdevice,BOOL autoConnect)
 {
     dpCommon *pdpCommon;
+    int      i;
 
     if(pdevice) {
         pdpCommon = &pdevice->dpc;
@@ -481,17 +769,21 @@ static void dpCommonInit(port *pport,device *pdevice,BOOL autoConnect)
     pdpCommon->enabled = TRUE;
     pdpCommon->connected = FALSE;
     pdpCommon->autoConnect = autoConnect;
+    for(i=0; i<NUMBER_QUEUE_PRIORITIES; i++) ellInit(&pdpCommon->parkedList[i]);
     ellInit(&pdpCommon->interposeInterfaceList);
     ellInit(&pdpCommon->exceptionUserList);
     ellInit(&pdpCommon->exceptionNotifyList);
     pdpCommon->pport = pport;
     pdpCommon->pdevice = pdevice;
     tracePvtInit(&pdpCommon->trace);
+    if(pdevice && (pport->attributes&ASYN_CANBLOCK))
+        pdpCommon->deviceLock = epicsMutexMustCreate();
 }
 
 static void dpCommonFree(dpCommon *pdpCommon)
 {
     tracePvtFree(&pdpCommon->trace);
+    if(pdpCommon->deviceLock) epicsMutexDestroy(pdpCommon->deviceLock);
 }
 
 static dpCommon *findDpCommon(userPvt *puserPvt)
@@ -566,6 +858,98 @@ static interfaceNode *locateInterfaceNode(
     }
     return pinterfaceNode;
 }
+
+static unsigned int dispatchHash(int reason,int addr,int tableSize)
+{
+    unsigned int hash = (unsigned int)reason*31u + (unsigned int)addr;
+
+    /*tableSize is always a power of 2*/
+    return (hash ^ (hash>>8)) & (unsigned int)(tableSize-1);
+}
+
+static dispatchKey *locateDispatchKey(interruptBase *pinterruptBase,
+    int reason,int addr,BOOL allocNew)
+{
+    ELLLIST     *pbucket;
+    dispatchKey *pdispatchKey;
+
+    if(addr<0) addr = 0;
+    pbucket = &pinterruptBase->dispatchTable[
+        dispatchHash(reason,addr,pinterruptBase->dispatchTableSize)];
+    pdispatchKey = (dispatchKey *)ellFirst(pbucket);
+    while(pdispatchKey) {
+        if(pdispatchKey->reason==reason && pdispatchKey->addr==addr)
+            return pdispatchKey;
+        pdispatchKey = (dispatchKey *)ellNext(&pdispatchKey->node);
+    }
+    if(!allocNew) return 0;
+    if(pinterruptBase->numDispatchKeys >= 2*pinterruptBase->dispatchTableSize) {
+        /*Grow table so that buckets stay short*/
+        int     oldSize = pinterruptBase->dispatchTableSize;
+        ELLLIST *poldTable = pinterruptBase->dispatchTable;
+        int     i;
+
+        pinterruptBase->dispatchTableSize = 2*oldSize;
+        pinterruptBase->dispatchTable = callocMustSucceed(
+            pinterruptBase->dispatchTableSize,sizeof(ELLLIST),
+            "asynManager:locateDispatchKey");
+        for(i=0; i<oldSize; i++) {
+            while((pdispatchKey = (dispatchKey *)ellGet(&poldTable[i]))) {
+                ellAdd(&pinterruptBase->dispatchTable[dispatchHash(
+                    pdispatchKey->reason,pdispatchKey->addr,
+                    pinterruptBase->dispatchTableSize)],&pdispatchKey->node);
+            }
+        }
+        free(poldTable);
+        pbucket = &pinterruptBase->dispatchTable[
+            dispatchHash(reason,addr,pinterruptBase->dispatchTableSize)];
+    }
+    pdispatchKey = callocMustSucceed(1,sizeof(dispatchKey),
+        "asynManager:locateDispatchKey");
+    pdispatchKey->reason = reason;
+    pdispatchKey->addr = addr;
+    ellInit(&pdispatchKey->nodeList);
+    ellAdd(pbucket,&pdispatchKey->node);
+    pinterruptBase->numDispatchKeys++;
+    return pdispatchKey;
+}
+
+static void dispatchAdd(interruptBase *pinterruptBase,
+    interruptNodePvt *pinterruptNodePvt,asynUser *pasynUser)
+{
+    userPvt *puserPvt = asynUserToUserPvt(pasynUser);
+    port    *pport = puserPvt->pport;
+    int     addr;
+
+    /*Same address that getAddr would return*/
+    if(!pport || !(pport->attributes&ASYN_MULTIDEVICE) || !puserPvt->pdevice) {
+        addr = -1;
+    } else {
+        addr = puserPvt->pdevice->addr;
+    }
+    pinterruptNodePvt->pdispatchKey = locateDispatchKey(
+        pinterruptBase,pasynUser->reason,addr,TRUE);
+    pinterruptNodePvt->pdispatchUser = pasynUser;
+    ellAdd(&pinterruptNodePvt->pdispatchKey->nodeList,
+        &pinterruptNodePvt->dispatchNode);
+}
+
+static void dispatchRemove(interruptBase *pinterruptBase,
+    interruptNodePvt *pinterruptNodePvt)
+{
+    dispatchKey *pdispatchKey = pinterruptNodePvt->pdispatchKey;
+
+    if(!pdispatchKey) return;
+    ellDelete(&pdispatchKey->nodeList,&pinterruptNodePvt->dispatchNode);
+    pinterruptNodePvt->pdispatchKey = 0;
+    if(ellCount(&pdispatchKey->nodeList)==0) {
+        ellDelete(&pinterruptBase->dispatchTable[dispatchHash(
+            pdispatchKey->reason,pdispatchKey->addr,
+            pinterruptBase->dispatchTableSize)],&pdispatchKey->node);
+        free(pdispatchKey);
+        pinterruptBase->numDispatchKeys--;
+    }
+}
 
 /* While an exceptionActive exceptionCallbackAdd and exceptionCallbackRemove
    will wait to be notified that exceptionActive is no longer true.  */
@@ -605,12 +989,170 @@ static void exceptionOccurred(asynUser *pasynUser,asynException exception)
     announceExceptionOccurred(pport, pdevice, exception);
 }
 
+/* A request that is queued is on one of pport->queueList or, while its
+ * device or port is disabled or blocked by another asynUser, on the
+ * parkedList of that dpCommon. portThread parks such a request when it
+ * reaches the head of queueList, so it is looked at only once until
+ * unparkRequests returns it to the front of queueList.
+ */
+static void queueRemove(port *pport,userPvt *puserPvt)
+{
+    assert(puserPvt->isQueued);
+    ellDelete(puserPvt->pqueueList,&puserPvt->node);
+    puserPvt->pqueueList = 0;
+    puserPvt->isQueued = FALSE;
+    pport->numberQueued--;
+}
+
+/* time histogram bins are <10us, <100us, ..., <10s, >=10s */
+static int queueTimeBin(double seconds)
+{
+    double limit;
+    int    bin;
+
+    for(bin=0, limit=1e-5; seconds>=limit && bin<NUM_QUEUE_WAIT_BINS-1; bin++)
+        limit *= 10.0;
+    return bin;
+}
+
+/* Returns 0 if the request is for the port itself*/
+static asynQueueStatistics *deviceQueueStatistics(userPvt *puserPvt)
+{
+    dpCommon *pdpCommon = findDpCommon(puserPvt);
+
+    if(!pdpCommon || !pdpCommon->pdevice) return 0;
+    return &pdpCommon->pdevice->queueStatistics;
+}
+
+/* Only called for requests that were queued with queueTimed set */
+static void queueStatistics(port *pport,userPvt *puserPvt)
+{
+    asynQueueStatistics *pdeviceStatistics = deviceQueueStatistics(puserPvt);
+    epicsTimeStamp now;
+    int            depth = pport->numberQueued;
+    int            bin;
+
+    for(bin=0; depth>1 && bin<NUM_QUEUE_DEPTH_BINS-1; bin++) depth >>= 1;
+    pport->queueDepthHistogram[bin]++;
+    epicsTimeGetCurrent(&now);
+    bin = queueTimeBin(epicsTimeDiffInSeconds(&now,&puserPvt->queueTime));
+    pport->queueWaitHistogram[bin]++;
+    if(pdeviceStatistics) pdeviceStatistics->queueWait[bin]++;
+}
+
+static void serviceStatistics(port *pport,
+            asynQueueStatistics *pdeviceStatistics,double seconds)
+{
+    int bin = queueTimeBin(seconds);
+
+    pport->serviceHistogram[bin]++;
+    if(pdeviceStatistics) pdeviceStatistics->service[bin]++;
+}
+
+static void parkRequest(dpCommon *pdpCommon,userPvt *puserPvt,int priority)
+{
+    ellDelete(puserPvt->pqueueList,&puserPvt->node);
+    ellAdd(&pdpCommon->parkedList[priority],&puserPvt->node);
+    puserPvt->pqueueList = &pdpCommon->parkedList[priority];
+}
+
+static void unparkRequests(dpCommon *pdpCommon)
+{
+    port    *pport = pdpCommon->pport;
+    userPvt *puserPvt;
+    int     i;
+
+    for(i=asynQueuePriorityLow; i<=asynQueuePriorityHigh; i++) {
+        ELLLIST *pparkedList = &pdpCommon->parkedList[i];
+
+        while((puserPvt = (userPvt *)ellLast(pparkedList))) {
+            ellDelete(pparkedList,&puserPvt->node);
+            ellInsert(&pport->queueList[i],0,&puserPvt->node);
+            puserPvt->pqueueList = &pport->queueList[i];
+            pport->queueStateChange = TRUE;
+        }
+    }
+}
+
+/* A port with ASYN_CANBLOCK and ASYN_MULTIDEVICE can be serviced by more
+ * than one portThread (setPortThreads). The callbacks for different devices
+ * then run concurrently, but the callbacks for one device still run one at a
+ * time and in queue order. A device callback only holds the deviceLock of its
+ * device. lockPort for a device holds synchronousLock and deviceLock. A port
+ * callback, and lockPort for the port, hold synchronousLock and wait until no
+ * device callback is active. A device callback can call lockPort for its own
+ * device but not for the port or another device.
+ * The wait for the device callbacks is done before taking synchronousLock,
+ * so a thread that holds synchronousLock never waits for another portThread.
+ * A request from a holder of blockProcessCallback for all devices also
+ * waits until no device callback is active.
+ */
+static void lockDpCommon(dpCommon *pdpCommon)
+{
+    port *pport = pdpCommon->pport;
+
+    if(pport->numberThreads<=1) {
+        epicsMutexMustLock(pport->synchronousLock);
+        return;
+    }
+    if(pdpCommon->pdevice) {
+        if(epicsThreadPrivateGet(pasynBase->deviceCallbackId)!=pdpCommon)
+            epicsMutexMustLock(pport->synchronousLock);
+        epicsMutexMustLock(pdpCommon->deviceLock);
+        return;
+    }
+    epicsMutexMustLock(pport->asynManagerLock);
+    /*no device callback starts while portLockCount>0*/
+    pport->portLockCount++;
+    while(pport->numberDeviceCallbacks>0) {
+        epicsMutexUnlock(pport->asynManagerLock);
+        epicsEventMustWait(pport->deviceCallbacksDone);
+        epicsMutexMustLock(pport->asynManagerLock);
+    }
+    /*pass the wakeup on to other threads waiting to lock the port*/
+    if(pport->portLockCount>1) epicsEventSignal(pport->deviceCallbacksDone);
+    epicsMutexUnlock(pport->asynManagerLock);
+    epicsMutexMustLock(pport->synchronousLock);
+}
+
+static void unlockDpCommon(dpCommon *pdpCommon)
+{
+    port *pport = pdpCommon->pport;
+
+    if(pport->numberThreads<=1) {
+        epicsMutexUnlock(pport->synchronousLock);
+        return;
+    }
+    if(pdpCommon->pdevice) {
+        epicsMutexUnlock(pdpCommon->deviceLock);
+        if(epicsThreadPrivateGet(pasynBase->deviceCallbackId)!=pdpCommon)
+            epicsMutexUnlock(pport->synchronousLock);
+        return;
+    }
+    epicsMutexMustLock(pport->asynManagerLock);
+    pport->portLockCount--;
+    epicsMutexUnlock(pport->asynManagerLock);
+    /*device requests that were skipped can now be started*/
+    epicsEventSignal(pport->notifyPortThread);
+    epicsMutexUnlock(pport->synchronousLock);
+}
+
+/*callbackCanStart must be called with asynManagerLock held*/
+static BOOL callbackCanStart(port *pport,dpCommon *pdpCommon,
+            userPvt *puserPvt)
+{
+    if(pdpCommon->callbackActive || pport->dpc.callbackActive) return FALSE;
+    if(pport->portLockCount>0) return FALSE;
+    if(pdpCommon->pdevice && puserPvt->blockPortCount==0) return TRUE;
+    return (pport->numberDeviceCallbacks==0);
+}
+
 static void queueTimeoutCallback(void *pvt)
 {
     userPvt  *puserPvt = (userPvt *)pvt;
     asynUser *pasynUser = &puserPvt->user;
     port     *pport = puserPvt->pport;
-    int      i;
+    asynQueueStatistics *pdeviceStatistics;
 
     epicsMutexMustLock(pport->asynManagerLock);
     if(!puserPvt->isQueued) {
@@ -620,27 +1162,12 @@ static void queueTimeoutCallback(void *pvt)
             pport->portName );
         return;
     }
-    for(i=asynQueuePriorityConnect; i>=asynQueuePriorityLow; i--) {
-        puserPvt = (userPvt *)ellFirst(&pport->queueList[i]);
-        while(puserPvt) {
-            if(pasynUser == &puserPvt->user) {
-                ellDelete(&pport->queueList[i],&puserPvt->node);
-                break;
-            }
-            puserPvt = (userPvt *)ellNext(&puserPvt->node);
-        }
-        if (puserPvt) break;
-    }
-    if(!puserPvt) {
-        epicsMutexUnlock(pport->asynManagerLock);
-        asynPrint(pasynUser,ASYN_TRACE_ERROR,
-            "%s asynManager:queueTimeoutCallback LOGIC ERROR\n",
-            pport->portName);
-        return;
-    }
+    queueRemove(pport,puserPvt);
+    pport->numberTimeouts++;
+    pdeviceStatistics = deviceQueueStatistics(puserPvt);
+    if(pdeviceStatistics) pdeviceStatistics->numberTimeouts++;
     asynPrint(pasynUser,ASYN_TRACE_FLOW,
         "%s asynManager:queueTimeoutCallback\n", pport->portName);
-    puserPvt->isQueued = FALSE;
     pport->queueStateChange = TRUE;
     if(puserPvt->timeoutUser) {
         puserPvt->state = callbackActive;
@@ -652,9 +1179,7 @@ static void queueTimeoutCallback(void *pvt)
         puserPvt->state = callbackIdle;
         if(puserPvt->freeAfterCallback) {
             puserPvt->freeAfterCallback = FALSE;
-            epicsMutexMustLock(pasynBase->lock);
-            ellAdd(&pasynBase->asynUserFreeList,&puserPvt->node);
-            epicsMutexUnlock(pasynBase->lock);
+            freeListPut(FREE_LIST_ASYNUSER,&puserPvt->node);
         }
     }
     epicsMutexUnlock(pport->asynManagerLock);
@@ -732,9 +1257,9 @@ static void connectAttempt(dpCommon *pdpCommon)
     pasynUser->errorMessage[0] = '\0';
     /* When we were called we were not connected, but we could have connected since that test? */
     if (!pdpCommon->connected) {
-        epicsMutexMustLock(pport->synchronousLock);
+        lockDpCommon(pdpCommon);
         status = pasynCommon->connect(drvPvt,pasynUser);
-        epicsMutexUnlock(pport->synchronousLock);
+        unlockDpCommon(pdpCommon);
     }
     if(status!=asynSuccess) {
         asynPrint(pasynUser,ASYN_TRACE_ERROR,
@@ -756,6 +1281,9 @@ static void portThread(port *pport)
     asynUser *pasynUser;
     double   timeout;
     BOOL     callTimeoutUser = FALSE;
+    BOOL     recordService;
+    asynQueueStatistics *pdeviceStatistics;
+    epicsTimeStamp serviceStart,serviceEnd;
 
     taskwdInsert(epicsThreadGetIdSelf(),0,0);
     while(1) {
@@ -770,10 +1298,8 @@ static void portThread(port *pport)
         &pport->queueList[asynQueuePriorityConnect]))) {
             asynStatus status = asynSuccess;
 
-            assert(puserPvt->isQueued);
-            ellDelete(&pport->queueList[asynQueuePriorityConnect],
-               &puserPvt->node);
-            puserPvt->isQueued = FALSE;
+            if(puserPvt->queueTimed) queueStatistics(pport,puserPvt);
+            queueRemove(pport,puserPvt);
             pasynUser = userPvtToAsynUser(puserPvt);
             pasynUser->errorMessage[0] = '\0';
             asynPrint(pasynUser,ASYN_TRACE_FLOW,
@@ -781,9 +1307,12 @@ static void portThread(port *pport)
                  pport->portName);
             puserPvt->state = callbackActive;
             timeout = puserPvt->timeout;
+            recordService = pport->queueStatisticsEnabled;
+            pdeviceStatistics = deviceQueueStatistics(puserPvt);
             epicsMutexUnlock(pport->asynManagerLock);
             if(puserPvt->timer && timeout>0.0) epicsTimerCancel(puserPvt->timer);
-            epicsMutexMustLock(pport->synchronousLock);
+            lockDpCommon(&pport->dpc);
+            if(recordService) epicsTimeGetCurrent(&serviceStart);
             if(pport->pasynLockPortNotify) {
                 status = pport->pasynLockPortNotify->lock(
                    pport->lockPortNotifyPvt,pasynUser);
@@ -799,16 +1328,17 @@ static void portThread(port *pport)
                         "%s queueCallback pasynLockPortNotify:lock error %s\n",
                          pport->portName,pasynUser->errorMessage);
             }
-            epicsMutexUnlock(pport->synchronousLock);
+            if(recordService) epicsTimeGetCurrent(&serviceEnd);
+            unlockDpCommon(&pport->dpc);
             epicsMutexMustLock(pport->asynManagerLock);
+            if(recordService) serviceStatistics(pport,pdeviceStatistics,
+                epicsTimeDiffInSeconds(&serviceEnd,&serviceStart));
             if (puserPvt->state==callbackCanceled)
                 epicsEventSignal(puserPvt->callbackDone);
             puserPvt->state = callbackIdle;
             if(puserPvt->freeAfterCallback) {
                 puserPvt->freeAfterCallback = FALSE;
-                epicsMutexMustLock(pasynBase->lock);
-                ellAdd(&pasynBase->asynUserFreeList,&puserPvt->node);
-                epicsMutexUnlock(pasynBase->lock);
+                freeListPut(FREE_LIST_ASYNUSER,&puserPvt->node);
             }
         }
         if(!pport->dpc.connected) {
@@ -821,20 +1351,57 @@ static void portThread(port *pport)
             int i;
             dpCommon *pdpCommon = 0;
             asynStatus status = asynSuccess;
+            BOOL portWaiting = FALSE;
+            BOOL isDeviceCallback;
 
             callTimeoutUser = FALSE;
             pport->queueStateChange = FALSE;
             for(i=asynQueuePriorityHigh; i>=asynQueuePriorityLow; i--) {
-                for(puserPvt = (userPvt *)ellFirst(&pport->queueList[i]);
-                puserPvt; puserPvt = (userPvt *)ellNext(&puserPvt->node)) {
+                puserPvt = (userPvt *)ellFirst(&pport->queueList[i]);
+                while(puserPvt) {
+                    userPvt *pnext = (userPvt *)ellNext(&puserPvt->node);
+
                     pdpCommon = findDpCommon(puserPvt);
                     assert(pdpCommon);
 
-                    if(!pdpCommon->enabled) continue;
+                    /*Requests that can not be processed now are parked*/
+                    if(pport->pblockProcessHolder
+                    && pport->pblockProcessHolder!=puserPvt) {
+                        parkRequest(&pport->dpc,puserPvt,i);
+                        puserPvt = pnext;
+                        continue;
+                    }
+                    if(!pdpCommon->enabled
+                    || (pdpCommon->pblockProcessHolder
+                        && pdpCommon->pblockProcessHolder!=puserPvt)) {
+                        parkRequest(pdpCommon,puserPvt,i);
+                        puserPvt = pnext;
+                        continue;
+                    }
+                    /*With more than one portThread requests for a device
+                     *that has a callback active are skipped. A port request,
+                     *or a request that blocks all devices, waits until no
+                     *device callback is active*/
+                    if(pport->numberThreads>1
+                    && !callbackCanStart(pport,pdpCommon,puserPvt)) {
+                        if(!pdpCommon->pdevice || puserPvt->blockPortCount>0) {
+                            portWaiting = TRUE;
+                            puserPvt = 0;
+                            break;
+                        }
+                        puserPvt = pnext;
+                        continue;
+                    }
                     if(!pdpCommon->connected) {
+                        /*other portThreads skip the device while it connects*/
+                        BOOL reserve = (pport->numberThreads>1);
+
+                        if(reserve) pdpCommon->callbackActive = TRUE;
                         autoConnectDevice(pdpCommon->pport,
                             pdpCommon->pdevice);
-                        if(pport->queueStateChange) {
+                        if(reserve) pdpCommon->callbackActive = FALSE;
+                        if(pport->queueStateChange
+                        || puserPvt->pqueueList!=&pport->queueList[i]) {
                             puserPvt = 0;
                             break;
                         }
@@ -842,27 +1409,39 @@ static void portThread(port *pport)
                     if(!pdpCommon->connected && puserPvt->timeoutUser!=0) {
                        callTimeoutUser = TRUE;
                     }
-                    if((pport->pblockProcessHolder==NULL
-                        || pport->pblockProcessHolder==puserPvt)
-                    && (pdpCommon->pblockProcessHolder==NULL
-                        || pdpCommon->pblockProcessHolder==puserPvt)) {
-                        assert(puserPvt->isQueued);
-                        ellDelete(&pport->queueList[i],&puserPvt->node);
-                        puserPvt->isQueued = FALSE;
-                        break;
-                    }
+                    if(puserPvt->queueTimed) queueStatistics(pport,puserPvt);
+                    queueRemove(pport,puserPvt);
+                    /*Claim the block before asynManagerLock is released, so
+                     *other portThreads park requests during this callback*/
+                    if(puserPvt->blockPortCount>0)
+                        pport->pblockProcessHolder = puserPvt;
+                    if(puserPvt->blockDeviceCount>0)
+                        pdpCommon->pblockProcessHolder = puserPvt;
+                    break;
                 }
-                if(puserPvt || pport->queueStateChange) break; /*for*/
+                if(puserPvt || pport->queueStateChange || portWaiting) break; /*for*/
             }
             if(!puserPvt) break; /*while(1)*/
+            if(pport->numberThreads>1) {
+                pdpCommon->callbackActive = TRUE;
+                if(pdpCommon->pdevice) pport->numberDeviceCallbacks++;
+                /*another portThread can look for a request for another device*/
+                epicsEventSignal(pport->notifyPortThread);
+            }
+            isDeviceCallback = (pdpCommon->callbackActive && pdpCommon->pdevice);
             pasynUser = userPvtToAsynUser(puserPvt);
             pasynUser->errorMessage[0] = '\0';
             asynPrint(pasynUser,ASYN_TRACE_FLOW,"asynManager::portThread port=%s callback\n",pport->portName);
             puserPvt->state = callbackActive;
             timeout = puserPvt->timeout;
+            recordService = pport->queueStatisticsEnabled;
+            pdeviceStatistics = deviceQueueStatistics(puserPvt);
             epicsMutexUnlock(pport->asynManagerLock);
             if(puserPvt->timer && timeout>0.0) epicsTimerCancel(puserPvt->timer);
-            epicsMutexMustLock(pport->synchronousLock);
+            if(isDeviceCallback)
+                epicsThreadPrivateSet(pasynBase->deviceCallbackId,pdpCommon);
+            lockDpCommon(pdpCommon);
+            if(recordService) epicsTimeGetCurrent(&serviceStart);
             if(pport->pasynLockPortNotify) {
                 status = pport->pasynLockPortNotify->lock(
                    pport->lockPortNotifyPvt,pasynUser);
@@ -882,8 +1461,18 @@ static void portThread(port *pport)
                         "%s queueCallback pasynLockPortNotify:lock error %s\n",
                          pport->portName,pasynUser->errorMessage);
             }    
-            epicsMutexUnlock(pport->synchronousLock);
+            if(recordService) epicsTimeGetCurrent(&serviceEnd);
+            unlockDpCommon(pdpCommon);
+            if(isDeviceCallback)
+                epicsThreadPrivateSet(pasynBase->deviceCallbackId,0);
             epicsMutexMustLock(pport->asynManagerLock);
+            if(recordService) serviceStatistics(pport,pdeviceStatistics,
+                epicsTimeDiffInSeconds(&serviceEnd,&serviceStart));
+            if(pdpCommon->callbackActive) {
+                pdpCommon->callbackActive = FALSE;
+                if(pdpCommon->pdevice && --pport->numberDeviceCallbacks==0)
+                    epicsEventSignal(pport->deviceCallbacksDone);
+            }
             if(puserPvt->blockPortCount>0)
                 pport->pblockProcessHolder = puserPvt;
             if(puserPvt->blockDeviceCount>0)
@@ -893,9 +1482,7 @@ static void portThread(port *pport)
             puserPvt->state = callbackIdle;
             if(puserPvt->freeAfterCallback) {
                 puserPvt->freeAfterCallback = FALSE;
-                epicsMutexMustLock(pasynBase->lock);
-                ellAdd(&pasynBase->asynUserFreeList,&puserPvt->node);
-                epicsMutexUnlock(pasynBase->lock);
+                freeListPut(FREE_LIST_ASYNUSER,&puserPvt->node);
             }
             if(pport->queueStateChange) break;
         }
@@ -941,6 +1528,54 @@ static void reportPrintInterfaceList(FILE *fp,ELLLIST *plist,const char *title)
     }
 }
 
+static int reportCountParked(dpCommon *pdpCommon)
+{
+    int i, nParked = 0;
+
+    for(i=asynQueuePriorityLow; i<=asynQueuePriorityHigh; i++)
+        nParked += ellCount(&pdpCommon->parkedList[i]);
+    return nParked;
+}
+
+epicsShareDef const char *asynQueueStatisticsLabels[ASYN_QUEUE_STATISTICS_BINS] =
+    {"<10us","<100us","<1ms","<10ms","<100ms","<1s","<10s",">=10s"};
+
+static void reportPrintTimeHistogram(FILE *fp,const char *title,
+    unsigned long *histogram)
+{
+    int i;
+
+    fprintf(fp,"%s:",title);
+    for(i=0; i<NUM_QUEUE_WAIT_BINS; i++) {
+        fprintf(fp," %s:%lu",asynQueueStatisticsLabels[i],histogram[i]);
+    }
+    fprintf(fp,"\n");
+}
+
+/* The histograms are only filled while queue statistics are enabled */
+static void reportPrintQueueStatistics(FILE *fp,port *pport)
+{
+    int i;
+
+    if(pport->attributes&ASYN_CANBLOCK) {
+        fprintf(fp,"    timeouts %lu cancels %lu\n",
+            pport->numberTimeouts,pport->numberCancels);
+    }
+    if(!pport->queueStatisticsEnabled) return;
+    if(pport->attributes&ASYN_CANBLOCK) {
+        fprintf(fp,"    queue depth histogram:");
+        for(i=0; i<NUM_QUEUE_DEPTH_BINS; i++) {
+            fprintf(fp," %d%s:%lu",1<<i,(i==NUM_QUEUE_DEPTH_BINS-1 ? "+" : ""),
+                pport->queueDepthHistogram[i]);
+        }
+        fprintf(fp,"\n");
+        reportPrintTimeHistogram(fp,"    queue wait histogram",
+            pport->queueWaitHistogram);
+    }
+    reportPrintTimeHistogram(fp,"    service time histogram",
+        pport->serviceHistogram);
+}
+
 /* reportPrintPort is done by separate thread so that synchronousLock
 *  and asynManagerLock can be properly reported. If report is run by same thread
 *  that has mutex then it would be reported no instead of yes
@@ -965,6 +1600,8 @@ static void reportPrintPort(printPortArgs *pprintPortArgs)
     asynCommon    *pasynCommon = 0;
     void          *drvPvt = 0;
     int           nQueued = 0;
+    int           nParked;
+    device        *pdevice;
 
     if (details < 0) {
         showDevices = 0;
@@ -973,6 +1610,12 @@ static void reportPrintPort(printPortArgs *pprintPortArgs)
     for(i=asynQueuePriorityLow; i<=asynQueuePriorityConnect; i++) 
         nQueued += ellCount(&pport->queueList[i]);
     pdpc = &pport->dpc;
+    nParked = reportCountParked(pdpc);
+    pdevice = (device *)ellFirst(&pport->deviceList);
+    while(pdevice) {
+        nParked += reportCountParked(&pdevice->dpc);
+        pdevice = (device *)ellNext(&pdevice->node);
+    }
     fprintf(fp,"%s multiDevice:%s canBlock:%s autoConnect:%s\n",
         pport->portName,
         ((pport->attributes&ASYN_MULTIDEVICE) ? "Yes" : "No"),
@@ -991,10 +1634,18 @@ static void reportPrintPort(printPortArgs *pprintPortArgs)
             (pdpc->enabled ? "Yes" : "No"),
             (pdpc->connected ? "Yes" : "No"),
              pdpc->numberConnects);
-        fprintf(fp,"    nDevices %d nQueued %d blocked:%s\n",
+        fprintf(fp,"    nDevices %d nQueued %d nParked %d blocked:%s\n",
             ellCount(&pport->deviceList),
-            nQueued,
+            nQueued, nParked,
             (pport->pblockProcessHolder ? "Yes" : "No"));
+        reportPrintQueueStatistics(fp,pport);
+        if(pport->numberThreads>1) {
+            fprintf(fp,"    portThreads %d active device callbacks %d\n",
+                pport->numberThreads,pport->numberDeviceCallbacks);
+        }
+        if(pport->pipelineDepth>1) {
+            fprintf(fp,"    pipelineDepth %d\n",pport->pipelineDepth);
+        }
         fprintf(fp,"    asynManagerLock:%s synchronousLock:%s\n",
             ((mgrStatus==epicsMutexLockOK) ? "No" : "Yes"),
             ((syncStatus==epicsMutexLockOK) ? "No" : "Yes"));
@@ -1005,6 +1656,12 @@ static void reportPrintPort(printPortArgs *pprintPortArgs)
             ellCount(&pdpc->exceptionNotifyList));
         fprintf(fp,"    traceMask:0x%x traceIOMask:0x%x traceInfoMask:0x%x\n",
             pdpc->trace.traceMask, pdpc->trace.traceIOMask, pdpc->trace.traceInfoMask);
+        if(pport->ptraceRing) {
+            traceRing *ptraceRing = pport->ptraceRing;
+            fprintf(fp,"    traceRing records %d pending %d overwritten %lu drain:%s\n",
+                ptraceRing->numberRecords, ptraceRing->count,
+                ptraceRing->numberOverwritten, (ptraceRing->drain ? "Yes" : "No"));
+        }
     }
     if(details>=2) {
         reportPrintInterfaceList(fp,&pdpc->interposeInterfaceList,
@@ -1012,7 +1669,7 @@ static void reportPrintPort(printPortArgs *pprintPortArgs)
         reportPrintInterfaceList(fp,&pport->interfaceList,"interfaceList");
     }
     if (showDevices) {
-        device   *pdevice = (device *)ellFirst(&pport->deviceList);
+        pdevice = (device *)ellFirst(&pport->deviceList);
         while(pdevice) {
             pdpc = &pdevice->dpc;
             if(!pdpc->connected || details>=1) {
@@ -1029,8 +1686,9 @@ static void reportPrintPort(printPortArgs *pprintPortArgs)
                     (pdpc->exceptionActive ? "Yes" : "No"),
                     ellCount(&pdpc->exceptionUserList),
                     ellCount(&pdpc->exceptionNotifyList));
-                fprintf(fp,"        blocked %s\n",
-                    (pdpc->pblockProcessHolder ? "Yes" : "No"));
+                fprintf(fp,"        blocked %s nParked %d\n",
+                    (pdpc->pblockProcessHolder ? "Yes" : "No"),
+                    reportCountParked(pdpc));
                 fprintf(fp,"        traceMask:0x%x traceIOMask:0x%x traceInfoMask:0x%x\n",
                     pdpc->trace.traceMask, pdpc->trace.traceIOMask, pdpc->trace.traceInfoMask);
             }
@@ -1098,6 +1756,10 @@ static void report(FILE *fp,int details,const char *portName)
             epicsEventMustWait(done);
             pport = (port *)ellNext(&pport->node);
         }
+        if(details>=1) {
+            reportFreeLists(fp);
+            pasynArrayBuffer->report(fp,details-1);
+        }
     }
     epicsEventDestroy(done);
 }
@@ -1109,10 +1771,8 @@ static asynUser *createAsynUser(userCallback process, userCallback timeout)
     int      nbytes;
 
     if(!pasynBase) asynInit();
-    epicsMutexMustLock(pasynBase->lock);
-    puserPvt = (userPvt *)ellFirst(&pasynBase->asynUserFreeList);
+    puserPvt = (userPvt *)freeListGet(FREE_LIST_ASYNUSER);
     if(!puserPvt) {
-        epicsMutexUnlock(pasynBase->lock);
         nbytes = sizeof(userPvt) + ERROR_MESSAGE_SIZE + 1;
         puserPvt = callocMustSucceed(1,nbytes,"asynCommon:registerDriver");
         puserPvt->timer = epicsTimerQueueCreateTimer(
@@ -1122,8 +1782,6 @@ static asynUser *createAsynUser(userCallback process, userCallback timeout)
         pasynUser->errorMessage = (char *)(puserPvt +1);
         pasynUser->errorMessageSize = ERROR_MESSAGE_SIZE;
     } else {
-        ellDelete(&pasynBase->asynUserFreeList,&puserPvt->node);
-        epicsMutexUnlock(pasynBase->lock);
         pasynUser = userPvtToAsynUser(puserPvt);
     }
     puserPvt->processUser = process;
@@ -1170,20 +1828,19 @@ static asynStatus freeAsynUser(asynUser *pasynUser)
         status = disconnect(pasynUser);
         if(status!=asynSuccess) return asynError;
     }
-    epicsMutexMustLock(pasynBase->lock);
     if(puserPvt->state==callbackIdle) {
-        ellAdd(&pasynBase->asynUserFreeList,&puserPvt->node);
+        freeListPut(FREE_LIST_ASYNUSER,&puserPvt->node);
     } else {
+        epicsMutexMustLock(pasynBase->lock);
         puserPvt->freeAfterCallback = TRUE;
+        epicsMutexUnlock(pasynBase->lock);
     }
-    epicsMutexUnlock(pasynBase->lock);
     return asynSuccess;
 }
 
 static void *memMalloc(size_t size)
 {
     int ind;
-    ELLLIST *pmemList;
     memNode *pmemNode;
     
     if(!pasynBase) asynInit();
@@ -1193,25 +1850,19 @@ static void *memMalloc(size_t size)
     if(ind>=nMemList) {
         return mallocMustSucceed(size,"asynManager::memMalloc");
     }
-    pmemList = &pasynBase->memList[ind];
-    epicsMutexMustLock(pasynBase->lock);
-    pmemNode = (memNode *)ellFirst(pmemList);
-    if(pmemNode) {
-         ellDelete(pmemList,&pmemNode->node);
-     } else {
+    pmemNode = (memNode *)freeListGet(FREE_LIST_MEM + ind);
+    if(!pmemNode) {
         /* Note: pmemNode->memory must be multiple of 16 in order to hold any data type */
         pmemNode = mallocMustSucceed(NODESIZE + memListSize[ind],
              "asynManager::memMalloc");
         pmemNode->memory = (char *)pmemNode + NODESIZE;
      }
-     epicsMutexUnlock(pasynBase->lock);
      return pmemNode->memory;
 }
 
 static void memFree(void *pmem,size_t size)
 {
     int ind;
-    ELLLIST *pmemList;
     memNode *pmemNode;
     
     assert(size>0);
@@ -1224,12 +1875,9 @@ static void memFree(void *pmem,size_t size)
         if(size<=memListSize[ind]) break;
     }
     assert(ind<nMemList);
-    pmemList = &pasynBase->memList[ind];
     pmemNode = (memNode *)((char *)pmem - NODESIZE);
     assert(pmemNode->memory==pmem);
-    epicsMutexMustLock(pasynBase->lock);
-    ellAdd(pmemList,&pmemNode->node);
-    epicsMutexUnlock(pasynBase->lock);
+    freeListPut(FREE_LIST_MEM + ind,&pmemNode->node);
 }
 
 static asynStatus isMultiDevice(asynUser *pasynUser,
@@ -1457,6 +2105,9 @@ static asynStatus queueRequest(asynUser *pasynUser,
         device   *pdevice = puserPvt->pdevice;
         int      addr = (pdevice ? pdevice->addr : -1);
         dpCommon *pdpCommon;
+        BOOL     recordService;
+        asynQueueStatistics *pdeviceStatistics;
+        epicsTimeStamp serviceStart,serviceEnd;
         
         pdpCommon = findDpCommon(puserPvt);
         asynPrint(pasynUser,ASYN_TRACE_FLOW,"%s queueRequest synchronous\n",
@@ -1478,10 +2129,20 @@ static asynStatus queueRequest(asynUser *pasynUser,
                 return asynError;
             }
         }
+        recordService = pport->queueStatisticsEnabled;
+        pdeviceStatistics = deviceQueueStatistics(puserPvt);
         epicsMutexUnlock(pport->asynManagerLock);
         epicsMutexMustLock(pport->synchronousLock);
+        if(recordService) epicsTimeGetCurrent(&serviceStart);
         puserPvt->processUser(pasynUser);
+        if(recordService) epicsTimeGetCurrent(&serviceEnd);
         epicsMutexUnlock(pport->synchronousLock);
+        if(recordService) {
+            epicsMutexMustLock(pport->asynManagerLock);
+            serviceStatistics(pport,pdeviceStatistics,
+                epicsTimeDiffInSeconds(&serviceEnd,&serviceStart));
+            epicsMutexUnlock(pport->asynManagerLock);
+        }
         return asynSuccess;
     }
     if(puserPvt->isQueued) {
@@ -1517,6 +2178,10 @@ static asynStatus queueRequest(asynUser *pasynUser,
     }
     pport->queueStateChange = TRUE;
     puserPvt->isQueued = TRUE;
+    puserPvt->pqueueList = &pport->queueList[priority];
+    pport->numberQueued++;
+    puserPvt->queueTimed = pport->queueStatisticsEnabled;
+    if(puserPvt->queueTimed) epicsTimeGetCurrent(&puserPvt->queueTime);
     if(timeout<=0.0) {
         puserPvt->timeout = 0.0;
     } else {
@@ -1537,7 +2202,7 @@ static asynStatus cancelRequest(asynUser *pasynUser,int *wasQueued)
     device   *pdevice = puserPvt->pdevice;
     double   timeout;
     int      addr = (pdevice ? pdevice->addr : -1);
-    int      i;
+    asynQueueStatistics *pdeviceStatistics;
     *wasQueued = 0; /*Initialize to not removed*/
     if(!pport) {
         asynPrint(pasynUser,ASYN_TRACE_ERROR,
@@ -1561,29 +2226,14 @@ static asynStatus cancelRequest(asynUser *pasynUser,int *wasQueued)
         }
         return asynSuccess;
     }
-    for(i=asynQueuePriorityConnect; i>=asynQueuePriorityLow; i--) {
-        puserPvt = (userPvt *)ellFirst(&pport->queueList[i]);
-        while(puserPvt) {
-            if(pasynUser == &puserPvt->user) {
-                ellDelete(&pport->queueList[i],&puserPvt->node);
-                *wasQueued = 1;
-                break;
-            }
-            puserPvt = (userPvt *)ellNext(&puserPvt->node);
-        }
-        if(puserPvt) break;
-    }
-    if(!puserPvt) {
-        asynPrint(pasynUser,ASYN_TRACE_ERROR,
-            "%s addr %d asynManager:cancelRequest LOGIC ERROR\n",
-            pport->portName, addr);
-        epicsMutexUnlock(pport->asynManagerLock);
-        return asynError;
-    }
+    queueRemove(pport,puserPvt);
+    *wasQueued = 1;
+    pport->numberCancels++;
+    pdeviceStatistics = deviceQueueStatistics(puserPvt);
+    if(pdeviceStatistics) pdeviceStatistics->numberCancels++;
     asynPrint(pasynUser,ASYN_TRACE_FLOW,
              "%s addr %d asynManager:cancelRequest\n",
               pport->portName,addr);
-    puserPvt->isQueued = FALSE;
     pport->queueStateChange = TRUE;
     timeout = puserPvt->timeout;
     epicsMutexUnlock(pport->asynManagerLock);
@@ -1661,6 +2311,7 @@ static asynStatus unblockProcessCallback(asynUser *pasynUser, int allDevices)
         if(puserPvt->blockPortCount==0
         && pport->pblockProcessHolder==puserPvt) {
             pport->pblockProcessHolder = 0;
+            unparkRequests(&pport->dpc);
             wasOwner = TRUE;
         }
     } else if (--puserPvt->blockDeviceCount==0) {
@@ -1668,6 +2319,7 @@ static asynStatus unblockProcessCallback(asynUser *pasynUser, int allDevices)
 
         if (pdpCommon->pblockProcessHolder==puserPvt) {
             pdpCommon->pblockProcessHolder = 0;
+            unparkRequests(pdpCommon);
             wasOwner = TRUE;
         }
     }
@@ -1687,7 +2339,7 @@ static asynStatus lockPort(asynUser *pasynUser)
         return asynError;
     }
     asynPrint(pasynUser,ASYN_TRACE_FLOW,"%s lockPort\n", pport->portName);
-    epicsMutexMustLock(pport->synchronousLock);
+    lockDpCommon(findDpCommon(puserPvt));
     if(pport->pasynLockPortNotify) {
         pport->pasynLockPortNotify->lock(
            pport->lockPortNotifyPvt,pasynUser);
@@ -1711,11 +2363,11 @@ static asynStatus unlockPort(asynUser *pasynUser)
         status = pport->pasynLockPortNotify->unlock(
            pport->lockPortNotifyPvt,pasynUser);
         if(status!=asynSuccess) {
-            epicsMutexUnlock(pport->synchronousLock);
+            unlockDpCommon(findDpCommon(puserPvt));
             return status;
         }
     }
-    epicsMutexUnlock(pport->synchronousLock);
+    unlockDpCommon(findDpCommon(puserPvt));
     return asynSuccess;
 }
 
@@ -1918,16 +2570,21 @@ static asynStatus registerPort(const char *portName,
     if((attributes&ASYN_CANBLOCK)) {
         for(i=0; i<NUMBER_QUEUE_PRIORITIES; i++) ellInit(&pport->queueList[i]);
         pport->notifyPortThread = epicsEventMustCreate(epicsEventEmpty);
+        pport->deviceCallbacksDone = epicsEventMustCreate(epicsEventEmpty);
         priority = priority ? priority : epicsThreadPriorityMedium;
         stackSize = stackSize ?
                        stackSize :
                        epicsThreadGetStackSize(epicsThreadStackMedium);
+        pport->threadPriority = priority;
+        pport->threadStackSize = stackSize;
+        pport->numberThreads = 1;
         pport->threadid = epicsThreadCreate(portName,priority,stackSize,        
              (EPICSTHREADFUNC)portThread,pport);
         if(!pport->threadid){
             printf("asynCommon:registerDriver %s epicsThreadCreate failed \n",
                 portName);
             epicsEventDestroy(pport->notifyPortThread);
+            epicsEventDestroy(pport->deviceCallbacksDone);
             freeAsynUser(pport->pasynUser);
             dpCommonFree(&pport->dpc);
             epicsMutexDestroy(pport->synchronousLock);
@@ -2073,7 +2730,10 @@ static asynStatus enable(asynUser *pasynUser,int yesNo)
             "asynManager:enable not connected");
         return asynError;
     }
+    epicsMutexMustLock(pport->asynManagerLock);
     pdpCommon->enabled = (yesNo ? 1 : 0);
+    if(pdpCommon->enabled) unparkRequests(pdpCommon);
+    epicsMutexUnlock(pport->asynManagerLock);
     exceptionOccurred(pasynUser,asynExceptionEnable);
     return asynSuccess;
 }
@@ -2181,6 +2841,10 @@ static asynStatus registerInterruptSource(const char *portName,
     pinterfaceNode->pinterruptBase = pinterruptBase;
     ellInit(&pinterruptBase->callbackList);
     ellInit(&pinterruptBase->addRemoveList);
+    pinterruptBase->dispatchTableSize = DEFAULT_DISPATCH_TABLE_SIZE;
+    pinterruptBase->dispatchTable = callocMustSucceed(
+        pinterruptBase->dispatchTableSize,sizeof(ELLLIST),
+        "asynManager:registerInterruptSource");
     pinterruptBase->pasynInterface = pinterfaceNode->pasynInterface;
     pinterruptBase->pport = pport;
     *pasynPvt = pinterruptBase;
@@ -2231,17 +2895,13 @@ static interruptNode *createInterruptNode(void *pasynPvt)
     interruptNode    *pinterruptNode;
     interruptNodePvt *pinterruptNodePvt;
 
-    epicsMutexMustLock(pasynBase->lock);
-    pinterruptNode = (interruptNode *)ellFirst(&pasynBase->interruptNodeFree);
+    pinterruptNode = (interruptNode *)freeListGet(FREE_LIST_INTERRUPT);
     if(pinterruptNode) {
         pinterruptNodePvt = interruptNodeToPvt(pinterruptNode);
-        ellDelete(&pasynBase->interruptNodeFree,&pinterruptNode->node);
-        epicsMutexUnlock(pasynBase->lock);
         pinterruptNodePvt->isOnList = 0;
         pinterruptNodePvt->isOnAddRemoveList = 0;
         memset(&pinterruptNodePvt->nodePublic,0,sizeof(interruptNode));
     } else {
-        epicsMutexUnlock(pasynBase->lock);
         pinterruptNodePvt = (interruptNodePvt *)
             callocMustSucceed(1,sizeof(interruptNodePvt),
                 "asynManager:createInterruptNode");
@@ -2265,9 +2925,7 @@ static asynStatus freeInterruptNode(asynUser *pasynUser,interruptNode *pinterrup
         return asynError;
     }
     epicsMutexUnlock(pport->asynManagerLock);
-    epicsMutexMustLock(pasynBase->lock);
-    ellAdd(&pasynBase->interruptNodeFree,&pinterruptNode->node);
-    epicsMutexUnlock(pasynBase->lock);
+    freeListPut(FREE_LIST_INTERRUPT,&pinterruptNode->node);
     return asynSuccess;
 }
 
@@ -2300,6 +2958,7 @@ static asynStatus addInterruptUser(asynUser *pasynUser,
         epicsMutexMustLock(pport->asynManagerLock);
     }
     ellAdd(&pinterruptBase->callbackList,&pinterruptNode->node);
+    dispatchAdd(pinterruptBase,pinterruptNodePvt,pasynUser);
     pinterruptNodePvt->isOnList = TRUE;
     epicsMutexUnlock(pport->asynManagerLock);
     return asynSuccess;
@@ -2334,6 +2993,7 @@ static asynStatus removeInterruptUser(asynUser *pasynUser,
         epicsMutexMustLock(pport->asynManagerLock);
     }
     ellDelete(&pinterruptBase->callbackList,&pinterruptNode->node);
+    dispatchRemove(pinterruptBase,pinterruptNodePvt);
     pinterruptNodePvt->isOnList = FALSE;
     epicsMutexUnlock(pport->asynManagerLock);
     return asynSuccess;
@@ -2376,6 +3036,192 @@ static asynStatus interruptEnd(void *pasynPvt)
     return asynSuccess;
 }
 
+/* interruptFindFirst and interruptFindNext must be called between
+ * interruptStart and interruptEnd. They return only the interrupt users
+ * that were added with the given reason and address, in the order they
+ * were added, without walking the entire callback list.
+ * Address -1 and 0 are the same. Users that changed the reason of their
+ * asynUser after addInterruptUser are skipped.
+ */
+static interruptNode *dispatchSkip(ELLNODE *pdispatchNode,int reason)
+{
+    interruptNodePvt *pinterruptNodePvt;
+
+    while(pdispatchNode) {
+        pinterruptNodePvt = dispatchNodeToPvt(pdispatchNode);
+        if(pinterruptNodePvt->pdispatchUser->reason==reason)
+            return &pinterruptNodePvt->nodePublic;
+        pdispatchNode = ellNext(pdispatchNode);
+    }
+    return 0;
+}
+
+static interruptNode *interruptFindFirst(void *pasynPvt,int reason,int addr)
+{
+    interruptBase  *pinterruptBase = (interruptBase *)pasynPvt;
+    dispatchKey    *pdispatchKey;
+
+    pdispatchKey = locateDispatchKey(pinterruptBase,reason,addr,FALSE);
+    if(!pdispatchKey) return 0;
+    return dispatchSkip(ellFirst(&pdispatchKey->nodeList),reason);
+}
+
+static interruptNode *interruptFindNext(interruptNode *pinterruptNode)
+{
+    interruptNodePvt *pinterruptNodePvt = interruptNodeToPvt(pinterruptNode);
+    dispatchKey      *pdispatchKey = pinterruptNodePvt->pdispatchKey;
+
+    if(!pdispatchKey) return 0;
+    return dispatchSkip(ellNext(&pinterruptNodePvt->dispatchNode),
+        pdispatchKey->reason);
+}
+
+/* Queue statistics */
+
+static asynStatus enableQueueStatistics(asynUser *pasynUser,int yesNo)
+{
+    userPvt *puserPvt = asynUserToUserPvt(pasynUser);
+    port    *pport = puserPvt->pport;
+
+    if(!pport) {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+            "asynManager:enableQueueStatistics not connected");
+        return asynError;
+    }
+    epicsMutexMustLock(pport->asynManagerLock);
+    pport->queueStatisticsEnabled = (yesNo ? TRUE : FALSE);
+    epicsMutexUnlock(pport->asynManagerLock);
+    return asynSuccess;
+}
+
+static asynStatus getQueueStatistics(asynUser *pasynUser,
+    asynQueueStatistics *pstatistics,int clear)
+{
+    userPvt  *puserPvt = asynUserToUserPvt(pasynUser);
+    dpCommon *pdpCommon = findDpCommon(puserPvt);
+    port     *pport;
+
+    if(!pdpCommon) {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+            "asynManager:getQueueStatistics not connected");
+        return asynError;
+    }
+    pport = pdpCommon->pport;
+    epicsMutexMustLock(pport->asynManagerLock);
+    if(pdpCommon->pdevice) {
+        device *pdevice = pdpCommon->pdevice;
+
+        if(pstatistics) *pstatistics = pdevice->queueStatistics;
+        if(clear) memset(&pdevice->queueStatistics,0,sizeof(asynQueueStatistics));
+    } else {
+        if(pstatistics) {
+            memcpy(pstatistics->queueWait,pport->queueWaitHistogram,
+                sizeof(pstatistics->queueWait));
+            memcpy(pstatistics->service,pport->serviceHistogram,
+                sizeof(pstatistics->service));
+            pstatistics->numberTimeouts = pport->numberTimeouts;
+            pstatistics->numberCancels = pport->numberCancels;
+        }
+        if(clear) {
+            memset(pport->queueDepthHistogram,0,sizeof(pport->queueDepthHistogram));
+            memset(pport->queueWaitHistogram,0,sizeof(pport->queueWaitHistogram));
+            memset(pport->serviceHistogram,0,sizeof(pport->serviceHistogram));
+            pport->numberTimeouts = 0;
+            pport->numberCancels = 0;
+        }
+    }
+    epicsMutexUnlock(pport->asynManagerLock);
+    return asynSuccess;
+}
+
+/* Port threads */
+
+static asynStatus setPortThreads(asynUser *pasynUser,int numberThreads)
+{
+    userPvt    *puserPvt = asynUserToUserPvt(pasynUser);
+    port       *pport = puserPvt->pport;
+    asynStatus status = asynSuccess;
+    char       threadName[80];
+
+    if(!pport) {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+            "asynManager:setPortThreads not connected");
+        return asynError;
+    }
+    if(!(pport->attributes&ASYN_CANBLOCK)
+    || !(pport->attributes&ASYN_MULTIDEVICE)) {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+            "asynManager:setPortThreads %s is not ASYN_CANBLOCK and ASYN_MULTIDEVICE",
+            pport->portName);
+        return asynError;
+    }
+    /*No callback is active while synchronousLock is held by a single portThread*/
+    epicsMutexMustLock(pport->synchronousLock);
+    epicsMutexMustLock(pport->asynManagerLock);
+    if(numberThreads<pport->numberThreads) {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+            "asynManager:setPortThreads %s already has %d threads",
+            pport->portName,pport->numberThreads);
+        status = asynError;
+    }
+    while(status==asynSuccess && pport->numberThreads<numberThreads) {
+        epicsSnprintf(threadName,sizeof(threadName),"%s_%d",
+            pport->portName,pport->numberThreads);
+        if(!epicsThreadCreate(threadName,pport->threadPriority,
+            pport->threadStackSize,(EPICSTHREADFUNC)portThread,pport)) {
+            epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+                "asynManager:setPortThreads %s epicsThreadCreate failed",
+                pport->portName);
+            status = asynError;
+            break;
+        }
+        pport->numberThreads++;
+    }
+    epicsMutexUnlock(pport->asynManagerLock);
+    epicsMutexUnlock(pport->synchronousLock);
+    return status;
+}
+
+/* Pipelined write-read */
+
+static asynStatus setPipelineDepth(asynUser *pasynUser,int depth)
+{
+    userPvt    *puserPvt = asynUserToUserPvt(pasynUser);
+    port       *pport = puserPvt->pport;
+
+    if(!pport) {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+            "asynManager:setPipelineDepth not connected");
+        return asynError;
+    }
+    if(depth<1) {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+            "asynManager:setPipelineDepth %s depth %d must be at least 1",
+            pport->portName,depth);
+        return asynError;
+    }
+    epicsMutexMustLock(pport->asynManagerLock);
+    pport->pipelineDepth = depth;
+    epicsMutexUnlock(pport->asynManagerLock);
+    return asynSuccess;
+}
+
+static asynStatus getPipelineDepth(asynUser *pasynUser,int *depth)
+{
+    userPvt    *puserPvt = asynUserToUserPvt(pasynUser);
+    port       *pport = puserPvt->pport;
+
+    if(!pport) {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+            "asynManager:getPipelineDepth not connected");
+        return asynError;
+    }
+    epicsMutexMustLock(pport->asynManagerLock);
+    *depth = (pport->pipelineDepth>1) ? pport->pipelineDepth : 1;
+    epicsMutexUnlock(pport->asynManagerLock);
+    return asynSuccess;
+}
+
 /* Time stamp functions */
 
 static void defaultTimeStampSource(void *userPvt, epicsTimeStamp *pTimeStamp)
@@ -2648,7 +3494,12 @@ static asynStatus setTraceFile(asynUser *pasynUser,FILE *fp)
 static FILE *getTraceFile(asynUser *pasynUser)
 {
     userPvt  *puserPvt = asynUserToUserPvt(pasynUser);
-    tracePvt *ptracePvt  = findTracePvt(puserPvt);
+
+    return traceFile(findTracePvt(puserPvt));
+}
+
+static FILE *traceFile(tracePvt *ptracePvt)
+{
     FILE     *fp = 0;
 
     switch(ptracePvt->type) {
@@ -2686,35 +3537,27 @@ static size_t getTraceIOTruncateSize(asynUser *pasynUser)
     return ptracePvt->traceTruncateSize;
 }
 
-static size_t printThread(FILE *fp)
+static size_t printThread(FILE *fp,const char *threadName,
+    epicsThreadId threadId,unsigned int threadPriority)
 {
     size_t nout = 0;
-    unsigned int threadPriority = epicsThreadGetPrioritySelf();
-    epicsThreadId threadId = epicsThreadGetIdSelf();
     if(fp) {
-        nout = fprintf(fp,"[%s,%p,%d] ",epicsThreadGetNameSelf(),
+        nout = fprintf(fp,"[%s,%p,%d] ",threadName,
                        (void*)threadId,threadPriority);
     } else {
-        nout = errlogPrintf("[%s,%p,%d] ",epicsThreadGetNameSelf(),
+        nout = errlogPrintf("[%s,%p,%d] ",threadName,
                             (void*)threadId,threadPriority);
     }
     return nout;
 }
-
-static size_t printTime(FILE *fp)
+
+static size_t printTime(FILE *fp,const epicsTimeStamp *ptime)
 {
-    epicsTimeStamp now;
     char nowText[40];
-    size_t rtn;
 
-    rtn = epicsTimeGetCurrent(&now);
-    if(rtn) {
-        printf("epicsTimeGetCurrent failed\n");
-        return 0;
-    }
     nowText[0] = 0;
     epicsTimeToStrftime(nowText,sizeof(nowText),
-         "%Y/%m/%d %H:%M:%S.%03f",&now);
+         "%Y/%m/%d %H:%M:%S.%03f",ptime);
     if(fp) {
         return fprintf(fp,"%s ",nowText);
     } else {
@@ -2722,22 +3565,14 @@ static size_t printTime(FILE *fp)
     }
 }
 
-static size_t printPort(FILE *fp, asynUser *pasynUser)
+static size_t printPort(FILE *fp,const char *portName,int addr,int reason)
 {
-    userPvt *puserPvt = asynUserToUserPvt(pasynUser);
-    port    *pport = puserPvt->pport;
-    int addr;
     size_t nout = 0;
     
-    if(!pport) {
-        return nout;
-    }
-    
-    getAddr(pasynUser, &addr);
     if(fp) {
-        nout = fprintf(fp,"[%s,%d,%d] ",pport->portName, addr, pasynUser->reason);
+        nout = fprintf(fp,"[%s,%d,%d] ",portName, addr, reason);
     } else {
-        nout = errlogPrintf("[%s,%d,%d] ",pport->portName, addr, pasynUser->reason);
+        nout = errlogPrintf("[%s,%d,%d] ",portName, addr, reason);
     }
     return nout;
 }
@@ -2754,6 +3589,100 @@ static size_t printSource(FILE *fp, const char *file, int line)
     return nout;
 }
 
+static size_t printInfo(FILE *fp,asynUser *pasynUser,int traceInfoMask,
+    const char *file,int line)
+{
+    userPvt *puserPvt = asynUserToUserPvt(pasynUser);
+    port    *pport = puserPvt->pport;
+    size_t  nout = 0;
+    int     addr;
+
+    if(traceInfoMask & ASYN_TRACEINFO_TIME) {
+        epicsTimeStamp now;
+
+        if(epicsTimeGetCurrent(&now)) {
+            printf("epicsTimeGetCurrent failed\n");
+        } else {
+            nout += printTime(fp,&now);
+        }
+    }
+    if((traceInfoMask & ASYN_TRACEINFO_PORT) && pport) {
+        getAddr(pasynUser, &addr);
+        nout += printPort(fp,pport->portName,addr,pasynUser->reason);
+    }
+    if(traceInfoMask & ASYN_TRACEINFO_SOURCE) nout += printSource(fp,file,line);
+    if(traceInfoMask & ASYN_TRACEINFO_THREAD) {
+        nout += printThread(fp,epicsThreadGetNameSelf(),
+            epicsThreadGetIdSelf(),epicsThreadGetPrioritySelf());
+    }
+    return nout;
+}
+
+/* Hex dump, 20 bytes per line, formatted a line at a time */
+#define HEX_BYTES_PER_LINE 20
+static size_t printHex(FILE *fp,const char *buffer,size_t nBytes)
+{
+    static const char hexDigits[] = "0123456789abcdef";
+    char   text[HEX_BYTES_PER_LINE*3 + 2];
+    size_t nout = 0;
+    size_t i = 0;
+
+    while(i<nBytes) {
+        char *p = text;
+
+        *p++ = '\n';
+        do {
+            unsigned char c = (unsigned char)buffer[i++];
+            *p++ = hexDigits[c>>4];
+            *p++ = hexDigits[c&0xf];
+            *p++ = ' ';
+        } while(i<nBytes && i%HEX_BYTES_PER_LINE != 0);
+        *p = 0;
+        if(fp) {
+            nout += fprintf(fp,"%s",text);
+        } else {
+            nout += errlogPrintf("%s",text);
+        }
+    }
+    if(fp) {
+        nout += fprintf(fp,"\n");
+    } else {
+        nout += errlogPrintf("\n");
+    }
+    return nout;
+}
+
+/*Must be called with lockTrace held. ptracePvt provides the errlog buffer*/
+static size_t printIOData(FILE *fp,tracePvt *ptracePvt,int traceIOMask,
+    const char *buffer,size_t nBytes)
+{
+    size_t nout = 0;
+
+    if((traceIOMask&ASYN_TRACEIO_ASCII) && (nBytes>0)) {
+       if(fp) {
+           nout += fprintf(fp,"%.*s\n",(int)nBytes,buffer);
+       } else {
+           nout += errlogPrintf("%.*s\n",(int)nBytes,buffer);
+       }
+    }
+    if(traceIOMask&ASYN_TRACEIO_ESCAPE) {
+        if(nBytes>0) {
+            if(fp) {
+                nout += epicsStrPrintEscaped(fp,buffer,nBytes);
+                nout += fprintf(fp,"\n");
+            } else {
+                nout += epicsStrSnPrintEscaped(ptracePvt->traceBuffer,
+                                               ptracePvt->traceBufferSize,
+                                               buffer,
+                                               nBytes);
+                errlogPrintf("%s\n",ptracePvt->traceBuffer);
+            }
+        }
+    }
+    if(traceIOMask&ASYN_TRACEIO_HEX) nout += printHex(fp,buffer,nBytes);
+    return nout;
+}
+
 static int tracePrint(asynUser *pasynUser,int reason, const char *pformat, ...)
 {
     va_list  pvar;
@@ -2789,12 +3718,15 @@ static int traceVprintSource(asynUser *pasynUser,int reason, const char *file, i
     FILE     *fp;
 
     if(!(reason & ptracePvt->traceMask)) return 0;
+    if(puserPvt->pport && puserPvt->pport->ptraceRing) {
+        nout = traceRingRecord(puserPvt->pport,pasynUser,ptracePvt,reason,
+            0,0,0,file,line,pformat,pvar);
+        if(nout>=0) return nout;
+        nout = 0;
+    }
     epicsMutexMustLock(pasynBase->lockTrace);
     fp = getTraceFile(pasynUser);
-    if (ptracePvt->traceInfoMask & ASYN_TRACEINFO_TIME) nout += (int)printTime(fp);
-    if (ptracePvt->traceInfoMask & ASYN_TRACEINFO_PORT) nout += (int)printPort(fp, pasynUser);
-    if (ptracePvt->traceInfoMask & ASYN_TRACEINFO_SOURCE) nout += (int)printSource(fp, file, line);
-    if (ptracePvt->traceInfoMask & ASYN_TRACEINFO_THREAD) nout += (int)printThread(fp);
+    nout += (int)printInfo(fp,pasynUser,ptracePvt->traceInfoMask,file,line);
     if(fp) {
         nout += vfprintf(fp,pformat,pvar);
     } else {
@@ -2804,7 +3736,7 @@ static int traceVprintSource(asynUser *pasynUser,int reason, const char *file, i
     epicsMutexUnlock(pasynBase->lockTrace);
     return nout;
 }
-
+
 static int tracePrintIO(asynUser *pasynUser,int reason,
     const char *buffer, size_t len,const char *pformat, ...)
 {
@@ -2849,64 +3781,271 @@ static int traceVprintIOSource(asynUser *pasynUser,int reason,
     traceIOMask = ptracePvt->traceIOMask;
     traceTruncateSize = ptracePvt->traceTruncateSize;
     if(!(reason&traceMask)) return 0;
+    if(traceTruncateSize==0) traceIOMask &= ~ASYN_TRACEIO_HEX;
+    nBytes = (len<traceTruncateSize) ? len : traceTruncateSize;
+    if(puserPvt->pport && puserPvt->pport->ptraceRing) {
+        nout = traceRingRecord(puserPvt->pport,pasynUser,ptracePvt,reason,
+            traceIOMask,buffer,traceIOMask ? nBytes : 0,file,line,pformat,pvar);
+        if(nout>=0) return nout;
+        nout = 0;
+    }
     epicsMutexMustLock(pasynBase->lockTrace);
     fp = getTraceFile(pasynUser);
-    if (ptracePvt->traceInfoMask & ASYN_TRACEINFO_TIME) nout += (int)printTime(fp);
-    if (ptracePvt->traceInfoMask & ASYN_TRACEINFO_PORT) nout += (int)printPort(fp, pasynUser);
-    if (ptracePvt->traceInfoMask & ASYN_TRACEINFO_SOURCE) nout += (int)printSource(fp, file, line);
-    if (ptracePvt->traceInfoMask & ASYN_TRACEINFO_THREAD) nout += (int)printThread(fp);
+    nout += (int)printInfo(fp,pasynUser,ptracePvt->traceInfoMask,file,line);
     if(fp) {
         nout += vfprintf(fp,pformat,pvar);
     } else {
         nout += errlogVprintf(pformat,pvar);
     }
-    nBytes = (len<traceTruncateSize) ? len : traceTruncateSize;
-    if((traceIOMask&ASYN_TRACEIO_ASCII) && (nBytes>0)) {
-       if(fp) {
-           nout += fprintf(fp,"%.*s\n",(int)nBytes,buffer);
-       } else {
-           nout += errlogPrintf("%.*s\n",(int)nBytes,buffer);
-       }
-    }
-    if(traceIOMask&ASYN_TRACEIO_ESCAPE) {
-        if(nBytes>0) {
-            if(fp) {
-                nout += epicsStrPrintEscaped(fp,buffer,nBytes);
-                nout += fprintf(fp,"\n");
-            } else {
-                nout += epicsStrSnPrintEscaped(ptracePvt->traceBuffer,
-                                               ptracePvt->traceBufferSize,
-                                               buffer,
-                                               nBytes);
-                errlogPrintf("%s\n",ptracePvt->traceBuffer);
-            }
-        }
-    }
-    if((traceIOMask&ASYN_TRACEIO_HEX) && (traceTruncateSize>0)) {
-        size_t i;
-        for(i=0; i<nBytes; i++) {
-            if(i%20 == 0) {
-                if(fp) {
-                    nout += fprintf(fp,"\n");
-                } else {
-                    nout += errlogPrintf("\n");
-                }
-            }
-            if(fp) {
-                nout += fprintf(fp,"%2.2x ",(unsigned char)buffer[i]);
-            } else {
-                nout += errlogPrintf("%2.2x ",(unsigned char)buffer[i]);
-            }
+    nout += (int)printIOData(fp,ptracePvt,traceIOMask,buffer,nBytes);
+    if(fp==stdout || fp==stderr) fflush(fp);
+    epicsMutexUnlock(pasynBase->lockTrace);
+    return nout;
+}
+
+/* Trace ring buffer */
+
+/*Grows a record or format buffer. Must be called with the ring lock held*/
+static void traceRingGrow(char **pbuffer,size_t *pbufferSize,size_t size)
+{
+    if(size<=*pbufferSize) return;
+    free(*pbuffer);
+    *pbuffer = mallocMustSucceed(size,"asynManager:traceRingGrow");
+    *pbufferSize = size;
+}
+
+/*Returns -1, without using pvar, if the port does not buffer its trace output*/
+static int traceRingRecord(port *pport,asynUser *pasynUser,tracePvt *ptracePvt,
+    int reason,int traceIOMask,const char *buffer,size_t nBytes,
+    const char *file,int line,const char *pformat,va_list pvar)
+{
+    traceRing   *ptraceRing = pport->ptraceRing;
+    traceRecord *precord;
+    BOOL        wakeDrain = FALSE;
+    va_list     pvarCopy;
+    int         nout;
+
+    epicsMutexMustLock(ptraceRing->lock);
+    if(ptraceRing->numberRecords==0) {
+        epicsMutexUnlock(ptraceRing->lock);
+        return -1;
+    }
+    precord = &ptraceRing->records[ptraceRing->head];
+    if(++ptraceRing->head>=ptraceRing->numberRecords) ptraceRing->head = 0;
+    if(ptraceRing->count==ptraceRing->numberRecords) {
+        ptraceRing->numberOverwritten++;
+    } else {
+        ptraceRing->count++;
+        if(ptraceRing->drain && ptraceRing->count==ptraceRing->numberRecords/2)
+            wakeDrain = TRUE;
+    }
+    epicsTimeGetCurrent(&precord->time);
+    getAddr(pasynUser,&precord->addr);
+    precord->reason = pasynUser->reason;
+    precord->traceReason = reason;
+    precord->traceIOMask = traceIOMask;
+    precord->traceInfoMask = ptracePvt->traceInfoMask;
+    precord->ptracePvt = ptracePvt;
+    precord->file = file;
+    precord->line = line;
+    if(precord->traceInfoMask & ASYN_TRACEINFO_THREAD) {
+        precord->threadId = epicsThreadGetIdSelf();
+        precord->threadPriority = epicsThreadGetPrioritySelf();
+        strncpy(precord->threadName,epicsThreadGetNameSelf(),
+            TRACE_RING_THREAD_NAME_SIZE-1);
+        precord->threadName[TRACE_RING_THREAD_NAME_SIZE-1] = 0;
+    }
+    traceRingGrow(&precord->message,&precord->messageSize,TRACE_RING_MESSAGE_SIZE);
+    va_copy(pvarCopy,pvar);
+    nout = epicsVsnprintf(precord->message,precord->messageSize,pformat,pvarCopy);
+    va_end(pvarCopy);
+    if(nout>=(int)precord->messageSize) {
+        traceRingGrow(&precord->message,&precord->messageSize,(size_t)nout+1);
+        nout = epicsVsnprintf(precord->message,precord->messageSize,pformat,pvar);
+    }
+    if(nout<0) {
+        precord->message[0] = 0;
+        nout = 0;
+    }
+    traceRingGrow(&precord->payload,&precord->payloadSize,nBytes);
+    precord->nBytes = nBytes;
+    if(nBytes>0) memcpy(precord->payload,buffer,nBytes);
+    epicsMutexUnlock(ptraceRing->lock);
+    if(wakeDrain) epicsEventSignal(ptraceRing->drainEvent);
+    return nout;
+}
+
+/*Formats the records not yet formatted. If toTraceFile is true each record is
+ *written to the trace file of the device or port that logged it, otherwise to fp*/
+static int traceRingFormat(port *pport,FILE *fp,BOOL toTraceFile)
+{
+    traceRing   *ptraceRing = pport->ptraceRing;
+    traceRecord record;
+    char        *message = 0;
+    size_t      messageSize = 0;
+    char        *payload = 0;
+    size_t      payloadSize = 0;
+    int         nFormatted = 0;
+    int         n;
+
+    while(1) {
+        traceRecord *precord;
+
+        epicsMutexMustLock(ptraceRing->lock);
+        if(ptraceRing->count==0) {
+            epicsMutexUnlock(ptraceRing->lock);
+            break;
         }
+        n = ptraceRing->head - ptraceRing->count;
+        if(n<0) n += ptraceRing->numberRecords;
+        precord = &ptraceRing->records[n];
+        record = *precord;
+        traceRingGrow(&message,&messageSize,strlen(precord->message)+1);
+        strcpy(message,precord->message);
+        record.message = message;
+        traceRingGrow(&payload,&payloadSize,precord->nBytes);
+        if(precord->nBytes>0) memcpy(payload,precord->payload,precord->nBytes);
+        record.payload = payload;
+        ptraceRing->count--;
+        epicsMutexUnlock(ptraceRing->lock);
+
+        epicsMutexMustLock(pasynBase->lockTrace);
+        if(toTraceFile) fp = traceFile(record.ptracePvt);
+        if(record.traceInfoMask & ASYN_TRACEINFO_TIME) printTime(fp,&record.time);
+        if(record.traceInfoMask & ASYN_TRACEINFO_PORT)
+            printPort(fp,pport->portName,record.addr,record.reason);
+        if(record.traceInfoMask & ASYN_TRACEINFO_SOURCE)
+            printSource(fp,record.file,record.line);
+        if(record.traceInfoMask & ASYN_TRACEINFO_THREAD)
+            printThread(fp,record.threadName,record.threadId,record.threadPriority);
         if(fp) {
-            nout += fprintf(fp,"\n");
+            fprintf(fp,"%s",record.message);
         } else {
-            nout += errlogPrintf("\n");
+            errlogPrintf("%s",record.message);
+        }
+        printIOData(fp,record.ptracePvt,record.traceIOMask,record.payload,record.nBytes);
+        if(fp==stdout || fp==stderr) fflush(fp);
+        epicsMutexUnlock(pasynBase->lockTrace);
+        nFormatted++;
+    }
+    free(message);
+    free(payload);
+    return nFormatted;
+}
+
+static void traceRingDrainThread(port *pport)
+{
+    traceRing *ptraceRing = pport->ptraceRing;
+    BOOL      drain;
+
+    while(1) {
+        epicsEventWaitWithTimeout(ptraceRing->drainEvent,TRACE_RING_DRAIN_PERIOD);
+        epicsMutexMustLock(ptraceRing->lock);
+        drain = ptraceRing->drain;
+        epicsMutexUnlock(ptraceRing->lock);
+        if(!drain) break;
+        traceRingFormat(pport,0,TRUE);
+    }
+    epicsEventSignal(ptraceRing->drainExitEvent);
+}
+
+static asynStatus setTraceRing(asynUser *pasynUser,int numberRecords,int drain)
+{
+    userPvt    *puserPvt = asynUserToUserPvt(pasynUser);
+    port       *pport = puserPvt->pport;
+    traceRing  *ptraceRing;
+    asynStatus status = asynSuccess;
+    char       threadName[80];
+    int        i;
+
+    if(!pport) {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+            "asynManager:setTraceRing not connected");
+        return asynError;
+    }
+    if(numberRecords<0) {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+            "asynManager:setTraceRing illegal numberRecords %d",numberRecords);
+        return asynError;
+    }
+    if(numberRecords==0) drain = 0;
+    epicsMutexMustLock(pport->asynManagerLock);
+    ptraceRing = pport->ptraceRing;
+    if(!ptraceRing) {
+        ptraceRing = callocMustSucceed(1,sizeof(traceRing),
+            "asynManager:setTraceRing");
+        ptraceRing->lock = epicsMutexMustCreate();
+        ptraceRing->setLock = epicsMutexMustCreate();
+        ptraceRing->drainEvent = epicsEventMustCreate(epicsEventEmpty);
+        ptraceRing->drainExitEvent = epicsEventMustCreate(epicsEventEmpty);
+        pport->ptraceRing = ptraceRing;
+    }
+    epicsMutexUnlock(pport->asynManagerLock);
+    /*asynManagerLock is not held while waiting for the drain thread to exit
+     *because setTraceFile takes it while holding lockTrace*/
+    epicsMutexMustLock(ptraceRing->setLock);
+    if(ptraceRing->drainThreadId && !drain) {
+        epicsMutexMustLock(ptraceRing->lock);
+        ptraceRing->drain = FALSE;
+        epicsMutexUnlock(ptraceRing->lock);
+        epicsEventSignal(ptraceRing->drainEvent);
+        epicsEventMustWait(ptraceRing->drainExitEvent);
+        ptraceRing->drainThreadId = 0;
+    }
+    /*Records not yet formatted are discarded*/
+    epicsMutexMustLock(ptraceRing->lock);
+    for(i=0; i<ptraceRing->numberRecords; i++) {
+        free(ptraceRing->records[i].message);
+        free(ptraceRing->records[i].payload);
+    }
+    free(ptraceRing->records);
+    ptraceRing->records = 0;
+    ptraceRing->numberRecords = numberRecords;
+    ptraceRing->head = 0;
+    ptraceRing->count = 0;
+    ptraceRing->numberOverwritten = 0;
+    ptraceRing->drain = drain ? TRUE : FALSE;
+    if(numberRecords>0) {
+        ptraceRing->records = callocMustSucceed(numberRecords,
+            sizeof(traceRecord),"asynManager:setTraceRing");
+    }
+    epicsMutexUnlock(ptraceRing->lock);
+    if(drain && !ptraceRing->drainThreadId) {
+        epicsSnprintf(threadName,sizeof(threadName),"%s_trace",pport->portName);
+        ptraceRing->drainThreadId = epicsThreadCreate(threadName,
+            epicsThreadPriorityLow,
+            epicsThreadGetStackSize(epicsThreadStackMedium),
+            (EPICSTHREADFUNC)traceRingDrainThread,pport);
+        if(!ptraceRing->drainThreadId) {
+            epicsMutexMustLock(ptraceRing->lock);
+            ptraceRing->drain = FALSE;
+            epicsMutexUnlock(ptraceRing->lock);
+            epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+                "asynManager:setTraceRing %s epicsThreadCreate failed",
+                pport->portName);
+            status = asynError;
         }
     }
-    if(fp==stdout || fp==stderr) fflush(fp);
-    epicsMutexUnlock(pasynBase->lockTrace);
-    return nout;
+    epicsMutexUnlock(ptraceRing->setLock);
+    return status;
+}
+
+static int dumpTraceRing(asynUser *pasynUser,FILE *fp)
+{
+    userPvt    *puserPvt = asynUserToUserPvt(pasynUser);
+    port       *pport = puserPvt->pport;
+
+    if(!pport) {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+            "asynManager:dumpTraceRing not connected");
+        return -1;
+    }
+    if(!pport->ptraceRing) {
+        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+            "asynManager:dumpTraceRing %s has no trace ring",pport->portName);
+        return -1;
+    }
+    return traceRingFormat(pport,fp,FALSE);
 }
 
 /*
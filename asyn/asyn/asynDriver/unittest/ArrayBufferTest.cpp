@@ -0,0 +1,191 @@
+/*
+ * ArrayBufferTest.cpp
+ *
+ * Tests the reference counting of asynArrayBuffers passed to asynInt32Array
+ * interrupt clients, and compares the time of the callbacks when each client
+ * copies the array with the time when the clients keep a shared buffer.
+ *
+ ***************************************************************************
+ * This file is distributed subject to a Software License Agreement found  *
+ * in the file LICENSE that is included with this distribution.            *
+ ***************************************************************************
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <epicsTime.h>
+#include <asynInt32Array.h>
+#include <asynArrayBuffer.h>
+#include "asynPortDriver.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#define PORT_NAME   "ARRAY_BUFFER"
+#define NUM_CLIENTS 4
+#define NUM_ELEMENTS (1024*1024)
+#define NUM_LOOPS   20
+
+/* An interrupt client that keeps the latest array, as devAsynXXXArray does */
+typedef struct arrayClient {
+    asynArrayBuffer *pbuffer;
+    epicsInt32      *copy;
+    size_t          nElements;
+    int             nCopied;
+    int             nShared;
+} arrayClient;
+
+static arrayClient clients[NUM_CLIENTS];
+
+static void arrayCallback(void *userPvt, asynUser *pasynUser, epicsInt32 *value, size_t nElements)
+{
+    arrayClient *pclient = (arrayClient *)userPvt;
+    asynArrayBuffer *pbuffer = pasynArrayBuffer->find(value);
+
+    if (pclient->pbuffer) pasynArrayBuffer->release(pclient->pbuffer);
+    pclient->pbuffer = pbuffer;
+    pclient->nElements = nElements;
+    if (pbuffer) {
+        pclient->nShared++;
+    } else {
+        memcpy(pclient->copy, value, nElements*sizeof(epicsInt32));
+        pclient->nCopied++;
+    }
+}
+
+static const epicsInt32 *clientData(arrayClient *pclient)
+{
+    return pclient->pbuffer ? (epicsInt32 *)pclient->pbuffer->data : pclient->copy;
+}
+
+static int registerClients()
+{
+    asynUser *pasynUser;
+    asynInterface *pasynInterface;
+    asynInt32Array *pasynInt32Array;
+    void *registrarPvt;
+    int i, nBad=0;
+
+    for (i=0; i<NUM_CLIENTS; i++) {
+        clients[i].copy = (epicsInt32 *)calloc(NUM_ELEMENTS, sizeof(epicsInt32));
+        pasynUser = pasynManager->createAsynUser(0, 0);
+        if (pasynManager->connectDevice(pasynUser, PORT_NAME, 0)) { nBad++; continue; }
+        pasynInterface = pasynManager->findInterface(pasynUser, asynInt32ArrayType, 1);
+        if (!pasynInterface) { nBad++; continue; }
+        pasynInt32Array = (asynInt32Array *)pasynInterface->pinterface;
+        pasynUser->reason = 0;
+        if (pasynInt32Array->registerInterruptUser(pasynInterface->drvPvt, pasynUser, arrayCallback,
+                                                   &clients[i], &registrarPvt)) nBad++;
+    }
+    return nBad;
+}
+
+static int checkClients(epicsInt32 first, size_t nElements)
+{
+    int i, nBad=0;
+
+    for (i=0; i<NUM_CLIENTS; i++) {
+        const epicsInt32 *data = clientData(&clients[i]);
+        if (clients[i].nElements != nElements || data[0] != first ||
+            data[nElements-1] != first + (epicsInt32)nElements - 1) nBad++;
+    }
+    return nBad;
+}
+
+static void releaseClients()
+{
+    int i;
+
+    for (i=0; i<NUM_CLIENTS; i++) {
+        if (clients[i].pbuffer) pasynArrayBuffer->release(clients[i].pbuffer);
+        clients[i].pbuffer = 0;
+    }
+}
+
+static void fill(epicsInt32 *data, epicsInt32 first)
+{
+    int i;
+
+    for (i=0; i<NUM_ELEMENTS; i++) data[i] = first + i;
+}
+
+MAIN(ArrayBufferTest)
+{
+    asynPortDriver *pPort;
+    asynArrayBuffer *pbuffer, *pfound;
+    epicsInt32 *legacy;
+    void *data;
+    epicsTimeStamp start, end;
+    double copyTime, sharedTime;
+    int index, loop, i, nShared;
+    epicsInt32 *small;
+
+    testPlan(11);
+    pPort = new asynPortDriver(PORT_NAME, 1, 1,
+                               asynInt32ArrayMask | asynDrvUserMask, asynInt32ArrayMask,
+                               0, 1, 0, 0);
+    pPort->createParam("ARRAY", asynParamInt32Array, &index);
+    testOk(registerClients() == 0, "registered %d asynInt32Array interrupt clients", NUM_CLIENTS);
+
+    pbuffer = pasynArrayBuffer->create(NUM_ELEMENTS, sizeof(epicsInt32));
+    testOk(pbuffer && pbuffer->data && pbuffer->nElements == NUM_ELEMENTS &&
+           pbuffer->elementSize == sizeof(epicsInt32), "create");
+    pfound = pasynArrayBuffer->find(pbuffer->data);
+    testOk(pfound == pbuffer && pasynArrayBuffer->find((epicsInt32 *)pbuffer->data + 1) == 0,
+           "find returns the buffer only for its data");
+    pasynArrayBuffer->release(pfound);
+    small = (epicsInt32 *)malloc(sizeof(epicsInt32));
+    testOk(pasynArrayBuffer->find(small) == 0 && pasynArrayBuffer->find(&index) == 0,
+           "find returns NULL for arrays that are not from a buffer");
+    free(small);
+
+    /* The clients keep the buffer after the driver releases it */
+    fill((epicsInt32 *)pbuffer->data, 100);
+    pPort->doCallbacksInt32Array((epicsInt32 *)pbuffer->data, NUM_ELEMENTS, index, 0);
+    data = pbuffer->data;
+    pasynArrayBuffer->release(pbuffer);
+    for (i=0, nShared=0; i<NUM_CLIENTS; i++) nShared += clients[i].nShared;
+    testOk(nShared == NUM_CLIENTS && checkClients(100, NUM_ELEMENTS) == 0,
+           "all clients share the buffer after the driver released it");
+    testOk(pasynArrayBuffer->find(data) == pbuffer, "buffer is still active");
+    pasynArrayBuffer->release(pbuffer);
+    releaseClients();
+    testOk(pasynArrayBuffer->find(data) == 0, "buffer is inactive after the last release");
+
+    /* Released buffers of the same size are reused */
+    pbuffer = pasynArrayBuffer->create(NUM_ELEMENTS, sizeof(epicsInt32));
+    testOk(pbuffer->data == data, "create reuses the released buffer");
+    pasynArrayBuffer->release(pbuffer);
+    pbuffer = pasynArrayBuffer->create(2*NUM_ELEMENTS, sizeof(epicsInt32));
+    testOk(pbuffer->data != data && pasynArrayBuffer->find(data) == 0,
+           "create does not reuse a smaller buffer");
+    pasynArrayBuffer->release(pbuffer);
+
+    /* Legacy driver: each client copies the array */
+    legacy = (epicsInt32 *)malloc(NUM_ELEMENTS*sizeof(epicsInt32));
+    epicsTimeGetCurrent(&start);
+    for (loop=0; loop<NUM_LOOPS; loop++) {
+        fill(legacy, loop);
+        pPort->doCallbacksInt32Array(legacy, NUM_ELEMENTS, index, 0);
+    }
+    epicsTimeGetCurrent(&end);
+    copyTime = epicsTimeDiffInSeconds(&end, &start);
+    testOk(checkClients(NUM_LOOPS-1, NUM_ELEMENTS) == 0, "clients copied the array from a legacy driver");
+
+    /* Driver publishing shared buffers */
+    epicsTimeGetCurrent(&start);
+    for (loop=0; loop<NUM_LOOPS; loop++) {
+        pbuffer = pasynArrayBuffer->create(NUM_ELEMENTS, sizeof(epicsInt32));
+        fill((epicsInt32 *)pbuffer->data, loop);
+        pPort->doCallbacksInt32Array((epicsInt32 *)pbuffer->data, NUM_ELEMENTS, index, 0);
+        pasynArrayBuffer->release(pbuffer);
+    }
+    epicsTimeGetCurrent(&end);
+    sharedTime = epicsTimeDiffInSeconds(&end, &start);
+    testOk(checkClients(NUM_LOOPS-1, NUM_ELEMENTS) == 0, "clients share the arrays from a driver using buffers");
+    testDiag("%d arrays of %d elements to %d clients: %f sec copied, %f sec shared",
+             NUM_LOOPS, NUM_ELEMENTS, NUM_CLIENTS, copyTime, sharedTime);
+    releaseClients();
+    free(legacy);
+    return testDone();
+}
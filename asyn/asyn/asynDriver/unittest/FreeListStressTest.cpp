@@ -0,0 +1,214 @@
+/*
+ * FreeListStressTest.cpp
+ *
+ * Creates and frees asynUsers, interruptNodes and memMalloc buffers from many
+ * threads at once, including buffers that are freed by a different thread
+ * than the one that allocated them.
+ *
+ ***************************************************************************
+ * This file is distributed subject to a Software License Agreement found  *
+ * in the file LICENSE that is included with this distribution.            *
+ ***************************************************************************
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <epicsThread.h>
+#include <epicsEvent.h>
+#include <epicsMutex.h>
+#include <epicsTime.h>
+#include <asynInt32.h>
+#include "asynPortDriver.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#define PORT_NAME   "FREE_LIST_STRESS"
+#define NUM_THREADS 16
+#define NUM_LOOPS   20000
+#define NUM_HELD    24
+#define NUM_SHARED  64
+
+typedef struct heldBuffer {
+    char   *pbuf;
+    size_t size;
+    int    owner;
+} heldBuffer;
+
+typedef struct threadArgs {
+    int          id;
+    epicsEventId done;
+    int          nBadUser;
+    int          nBadNode;
+    int          nBadMem;
+} threadArgs;
+
+static void *interruptPvt;
+static epicsMutexId sharedLock;
+static heldBuffer sharedBuffers[NUM_SHARED];
+
+/* Every buffer is filled with its owner's id, so a buffer handed out twice is detected */
+static int checkBuffer(heldBuffer *pheld)
+{
+    size_t i;
+
+    for (i=0; i<pheld->size; i++) {
+        if (pheld->pbuf[i] != (char)pheld->owner) return 1;
+    }
+    return 0;
+}
+
+static void fillBuffer(heldBuffer *pheld, int owner, size_t size)
+{
+    pheld->pbuf = (char *)pasynManager->memMalloc(size);
+    pheld->size = size;
+    pheld->owner = owner;
+    memset(pheld->pbuf, owner, size);
+}
+
+static void stressThread(void *arg)
+{
+    threadArgs *pargs = (threadArgs *)arg;
+    asynUser *users[NUM_HELD];
+    interruptNode *nodes[NUM_HELD];
+    heldBuffer buffers[NUM_HELD];
+    heldBuffer swap;
+    asynUser *pasynUser;
+    int loop, slot, shared;
+    size_t size;
+
+    memset(users, 0, sizeof(users));
+    memset(nodes, 0, sizeof(nodes));
+    memset(buffers, 0, sizeof(buffers));
+    pasynUser = pasynManager->createAsynUser(0, 0);
+    for (loop=0; loop<NUM_LOOPS; loop++) {
+        slot = loop % NUM_HELD;
+        /* Sizes cover every memMalloc size class and the sizes above them */
+        size = 1 + (loop*37 + pargs->id*101) % 5000;
+
+        if (users[slot]) {
+            if (users[slot]->userData != (void *)pargs) pargs->nBadUser++;
+            pasynManager->freeAsynUser(users[slot]);
+        }
+        users[slot] = pasynManager->createAsynUser(0, 0);
+        if (users[slot]->userData != 0) pargs->nBadUser++;
+        users[slot]->userData = pargs;
+
+        if (nodes[slot]) {
+            if (nodes[slot]->drvPvt != (void *)pargs) pargs->nBadNode++;
+            pasynManager->freeInterruptNode(pasynUser, nodes[slot]);
+        }
+        nodes[slot] = pasynManager->createInterruptNode(interruptPvt);
+        if (nodes[slot]->drvPvt != 0) pargs->nBadNode++;
+        nodes[slot]->drvPvt = pargs;
+
+        if (buffers[slot].pbuf) {
+            if (checkBuffer(&buffers[slot])) pargs->nBadMem++;
+            /* Every few loops swap the buffer with one left by another thread, which frees it */
+            if ((loop % 5) == 0) {
+                shared = (loop + pargs->id) % NUM_SHARED;
+                epicsMutexMustLock(sharedLock);
+                swap = sharedBuffers[shared];
+                sharedBuffers[shared] = buffers[slot];
+                epicsMutexUnlock(sharedLock);
+                buffers[slot] = swap;
+                if (buffers[slot].pbuf && checkBuffer(&buffers[slot])) pargs->nBadMem++;
+            }
+            if (buffers[slot].pbuf) pasynManager->memFree(buffers[slot].pbuf, buffers[slot].size);
+        }
+        fillBuffer(&buffers[slot], pargs->id, size);
+    }
+    for (slot=0; slot<NUM_HELD; slot++) {
+        pasynManager->freeAsynUser(users[slot]);
+        pasynManager->freeInterruptNode(pasynUser, nodes[slot]);
+        if (checkBuffer(&buffers[slot])) pargs->nBadMem++;
+        pasynManager->memFree(buffers[slot].pbuf, buffers[slot].size);
+    }
+    pasynManager->freeAsynUser(pasynUser);
+    epicsEventSignal(pargs->done);
+}
+
+/* Returns the number of thread caches shown by asynReport, -1 if not shown */
+static int reportFreeLists(int show)
+{
+    FILE *fp;
+    char line[200];
+    int found=0, nCaches=-1;
+
+    fp = tmpfile();
+    pasynManager->report(fp, 1, 0);
+    rewind(fp);
+    while (fgets(line, sizeof(line), fp)) {
+        line[strcspn(line, "\n")] = 0;
+        if (sscanf(line, "asynManager free lists: %d thread caches", &nCaches) == 1) found = 1;
+        if (found && show) testDiag("%s", line);
+    }
+    fclose(fp);
+    return nCaches;
+}
+
+MAIN(FreeListStressTest)
+{
+    asynPortDriver *pPort;
+    asynUser *pasynUser;
+    threadArgs args[NUM_THREADS];
+    char name[20];
+    epicsTimeStamp start, end;
+    int i, nBadUser=0, nBadNode=0, nBadMem=0;
+    int nCachesBefore, nCaches;
+
+    testPlan(6);
+    pPort = new asynPortDriver(PORT_NAME, 1, 1,
+                               asynInt32Mask | asynDrvUserMask, asynInt32Mask,
+                               0, 1, 0, 0);
+    pasynUser = pasynManager->createAsynUser(0, 0);
+    pasynManager->connectDevice(pasynUser, PORT_NAME, 0);
+    testOk(pasynManager->getInterruptPvt(pasynUser, asynInt32Type, &interruptPvt) == asynSuccess,
+           "getInterruptPvt for %s", asynInt32Type);
+    sharedLock = epicsMutexMustCreate();
+    nCachesBefore = reportFreeLists(0);
+
+    epicsTimeGetCurrent(&start);
+    for (i=0; i<NUM_THREADS; i++) {
+        args[i].id = i+1;
+        args[i].done = epicsEventMustCreate(epicsEventEmpty);
+        args[i].nBadUser = args[i].nBadNode = args[i].nBadMem = 0;
+        sprintf(name, "freeList%d", i);
+        epicsThreadCreate(name, epicsThreadPriorityMedium,
+                          epicsThreadGetStackSize(epicsThreadStackMedium),
+                          stressThread, &args[i]);
+    }
+    for (i=0; i<NUM_THREADS; i++) {
+        epicsEventMustWait(args[i].done);
+        epicsEventDestroy(args[i].done);
+        nBadUser += args[i].nBadUser;
+        nBadNode += args[i].nBadNode;
+        nBadMem  += args[i].nBadMem;
+    }
+    epicsTimeGetCurrent(&end);
+    for (i=0; i<NUM_SHARED; i++) {
+        if (sharedBuffers[i].pbuf) {
+            if (checkBuffer(&sharedBuffers[i])) nBadMem++;
+            pasynManager->memFree(sharedBuffers[i].pbuf, sharedBuffers[i].size);
+        }
+    }
+    testDiag("%d threads x %d loops: %f sec", NUM_THREADS, NUM_LOOPS,
+             epicsTimeDiffInSeconds(&end, &start));
+    testOk(nBadUser == 0, "asynUsers were unique and initialized, %d errors", nBadUser);
+    testOk(nBadNode == 0, "interruptNodes were unique and initialized, %d errors", nBadNode);
+    testOk(nBadMem == 0, "memMalloc buffers were unique, %d errors", nBadMem);
+
+    testOk(nCachesBefore >= 0, "asynReport shows free list statistics");
+
+    /* The threads signal done just before they exit */
+    for (i=0; i<100; i++) {
+        nCaches = reportFreeLists(0);
+        if (nCaches <= nCachesBefore) break;
+        epicsThreadSleep(0.01);
+    }
+    reportFreeLists(1);
+    testOk(nCaches <= nCachesBefore, "thread caches freed when threads exit, %d before, %d after",
+           nCachesBefore, nCaches);
+
+    return testDone();
+}
@@ -0,0 +1,304 @@
+/*
+ * PortThreadsTest.cpp
+ *
+ * Tests a multi-device port that is serviced by several port threads. Requests
+ * for different devices must run concurrently, requests for one device one at a
+ * time and in order, and lockPort for the port or a blockProcessCallback holder
+ * for all devices must exclude all other callbacks.
+ *
+ ***************************************************************************
+ * This file is distributed subject to a Software License Agreement found  *
+ * in the file LICENSE that is included with this distribution.            *
+ ***************************************************************************
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <epicsThread.h>
+#include <epicsEvent.h>
+#include <epicsMutex.h>
+#include <epicsTime.h>
+#include "asynPortDriver.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#define PORT_NAME     "PORT_THREADS"
+#define SINGLE_NAME   "PORT_THREADS_SINGLE"
+#define NUM_DEVICES   4
+#define NUM_THREADS   4
+#define NUM_REQUESTS  10
+#define CALLBACK_TIME 0.02
+
+typedef struct requestPvt {
+    int addr;
+    int sequence;
+} requestPvt;
+
+static epicsMutexId doneLock;
+static epicsEventId doneEvent;
+static int doneCount[NUM_DEVICES];
+static int lastSequence[NUM_DEVICES];
+static int outOfOrder[NUM_DEVICES];
+static int deviceActive[NUM_DEVICES];
+static int deviceOverlap;
+static int numberActive;
+static int maxActive;
+static int totalDone;
+static int doneWait;
+static int portOverlap;
+static int holderOverlap;
+static int holderDone;
+
+static void processCallback(asynUser *pasynUser)
+{
+    requestPvt *preq = (requestPvt *)pasynUser->userPvt;
+
+    epicsMutexMustLock(doneLock);
+    if (deviceActive[preq->addr]++) deviceOverlap++;
+    if (++numberActive > maxActive) maxActive = numberActive;
+    if (preq->sequence != lastSequence[preq->addr] + 1) outOfOrder[preq->addr]++;
+    lastSequence[preq->addr] = preq->sequence;
+    epicsMutexUnlock(doneLock);
+    epicsThreadSleep(CALLBACK_TIME);
+    epicsMutexMustLock(doneLock);
+    deviceActive[preq->addr]--;
+    numberActive--;
+    doneCount[preq->addr]++;
+    if (++totalDone == doneWait) epicsEventSignal(doneEvent);
+    epicsMutexUnlock(doneLock);
+}
+
+static void portCallback(asynUser *pasynUser)
+{
+    epicsMutexMustLock(doneLock);
+    if (numberActive) portOverlap++;
+    epicsMutexUnlock(doneLock);
+    epicsThreadSleep(CALLBACK_TIME);
+    epicsMutexMustLock(doneLock);
+    if (numberActive) portOverlap++;
+    if (++totalDone == doneWait) epicsEventSignal(doneEvent);
+    epicsMutexUnlock(doneLock);
+}
+
+static void holderCallback(asynUser *pasynUser)
+{
+    epicsMutexMustLock(doneLock);
+    if (numberActive) holderOverlap++;
+    epicsMutexUnlock(doneLock);
+    epicsThreadSleep(CALLBACK_TIME);
+    epicsMutexMustLock(doneLock);
+    if (numberActive) holderOverlap++;
+    holderDone++;
+    epicsMutexUnlock(doneLock);
+}
+
+static void lockPortThread(void *arg)
+{
+    asynUser *pasynUser = (asynUser *)arg;
+
+    pasynManager->lockPort(pasynUser);
+    epicsThreadSleep(CALLBACK_TIME);
+    pasynManager->unlockPort(pasynUser);
+    epicsEventSignal((epicsEventId)pasynUser->userPvt);
+}
+
+static int getHolderDone()
+{
+    int count;
+
+    epicsMutexMustLock(doneLock);
+    count = holderDone;
+    epicsMutexUnlock(doneLock);
+    return count;
+}
+
+static asynUser *createUser(const char *portName, int addr, userCallback callback, requestPvt *preq)
+{
+    asynUser *pasynUser = pasynManager->createAsynUser(callback, 0);
+
+    pasynManager->connectDevice(pasynUser, portName, addr);
+    pasynUser->userPvt = preq;
+    return pasynUser;
+}
+
+static int getTotalDone()
+{
+    int count;
+
+    epicsMutexMustLock(doneLock);
+    count = totalDone;
+    epicsMutexUnlock(doneLock);
+    return count;
+}
+
+static void waitDone(int count)
+{
+    epicsMutexMustLock(doneLock);
+    doneWait = count;
+    if (totalDone >= count) {
+        epicsMutexUnlock(doneLock);
+        return;
+    }
+    epicsMutexUnlock(doneLock);
+    epicsEventWaitWithTimeout(doneEvent, 30.0);
+}
+
+MAIN(PortThreadsTest)
+{
+    asynPortDriver *pPort, *pSingle;
+    asynUser *pport, *psingle, *pdevice, *pholder;
+    asynUser *lockUsers[2];
+    asynUser *users[NUM_DEVICES][NUM_REQUESTS];
+    asynUser *portUsers[2];
+    requestPvt reqs[NUM_DEVICES][NUM_REQUESTS];
+    epicsTimeStamp start, end;
+    double elapsed;
+    int addr, i, nBad, total, before;
+
+    testPlan(16);
+    doneLock = epicsMutexMustCreate();
+    doneEvent = epicsEventMustCreate(epicsEventEmpty);
+    pPort = new asynPortDriver(PORT_NAME, NUM_DEVICES, 1,
+                               asynInt32Mask | asynDrvUserMask, asynInt32Mask,
+                               ASYN_CANBLOCK | ASYN_MULTIDEVICE, 1, 0, 0);
+    pSingle = new asynPortDriver(SINGLE_NAME, 1, 1,
+                                 asynInt32Mask | asynDrvUserMask, asynInt32Mask,
+                                 ASYN_CANBLOCK, 1, 0, 0);
+
+    pport = createUser(PORT_NAME, -1, 0, 0);
+    psingle = createUser(SINGLE_NAME, -1, 0, 0);
+    testOk(pasynManager->setPortThreads(psingle, NUM_THREADS) == asynError,
+           "setPortThreads fails for a port without ASYN_MULTIDEVICE");
+    testOk(pasynManager->setPortThreads(pport, NUM_THREADS) == asynSuccess,
+           "setPortThreads %d", NUM_THREADS);
+    testOk(pasynManager->setPortThreads(pport, 1) == asynError,
+           "setPortThreads can not reduce the number of threads");
+
+    for (addr=0; addr<NUM_DEVICES; addr++) {
+        for (i=0; i<NUM_REQUESTS; i++) {
+            reqs[addr][i].addr = addr;
+            reqs[addr][i].sequence = i+1;
+            users[addr][i] = createUser(PORT_NAME, addr, processCallback, &reqs[addr][i]);
+        }
+    }
+
+    /* Requests for all devices are processed concurrently, but each device in order */
+    total = NUM_DEVICES * NUM_REQUESTS;
+    epicsTimeGetCurrent(&start);
+    for (i=0, nBad=0; i<NUM_REQUESTS; i++) {
+        for (addr=0; addr<NUM_DEVICES; addr++) {
+            if (pasynManager->queueRequest(users[addr][i], asynQueuePriorityLow, 0.0)) nBad++;
+        }
+    }
+    testOk(nBad == 0, "queued %d requests for each of %d devices", NUM_REQUESTS, NUM_DEVICES);
+    waitDone(total);
+    epicsTimeGetCurrent(&end);
+    elapsed = epicsTimeDiffInSeconds(&end, &start);
+    testDiag("%d requests of %f sec with %d threads: %f sec", total, CALLBACK_TIME, NUM_THREADS, elapsed);
+    testOk(getTotalDone() == total, "%d requests completed", getTotalDone());
+    testOk(maxActive > 1, "up to %d callbacks were active at once", maxActive);
+    testOk(elapsed < total * CALLBACK_TIME / 2, "requests completed faster than with one thread");
+    for (addr=0, nBad=0; addr<NUM_DEVICES; addr++) nBad += outOfOrder[addr];
+    testOk(deviceOverlap == 0 && nBad == 0, "callbacks for one device were serialized and in order");
+
+    /* A port request waits for the device callbacks and excludes them */
+    portUsers[0] = createUser(PORT_NAME, -1, portCallback, 0);
+    portUsers[1] = createUser(PORT_NAME, -1, portCallback, 0);
+    for (addr=0; addr<NUM_DEVICES; addr++) lastSequence[addr] = 0;
+    for (i=0; i<NUM_REQUESTS; i++) {
+        for (addr=0; addr<NUM_DEVICES; addr++) {
+            pasynManager->queueRequest(users[addr][i], asynQueuePriorityLow, 0.0);
+        }
+        if (i==2 || i==6) pasynManager->queueRequest(portUsers[i/6], asynQueuePriorityLow, 0.0);
+    }
+    waitDone(2*total + 2);
+    testOk(getTotalDone() == 2*total + 2 && portOverlap == 0,
+           "port requests ran while no device callback was active");
+
+    /* lockPort for the port excludes all callbacks */
+    for (addr=0; addr<NUM_DEVICES; addr++) lastSequence[addr] = 0;
+    for (i=0; i<NUM_REQUESTS; i++) {
+        for (addr=0; addr<NUM_DEVICES; addr++) {
+            pasynManager->queueRequest(users[addr][i], asynQueuePriorityLow, 0.0);
+        }
+    }
+    pasynManager->lockPort(pport);
+    epicsMutexMustLock(doneLock);
+    nBad = numberActive;
+    before = totalDone;
+    epicsMutexUnlock(doneLock);
+    epicsThreadSleep(5 * CALLBACK_TIME);
+    testOk(nBad == 0 && getTotalDone() == before, "no callback ran while the port was locked");
+    pasynManager->unlockPort(pport);
+    waitDone(3*total + 2);
+
+    /* lockPort for a device excludes only the callbacks for that device */
+    for (addr=0; addr<NUM_DEVICES; addr++) lastSequence[addr] = 0;
+    pdevice = createUser(PORT_NAME, 1, 0, 0);
+    pasynManager->lockPort(pdevice);
+    for (i=0; i<NUM_REQUESTS; i++) {
+        for (addr=0; addr<NUM_DEVICES; addr++) {
+            pasynManager->queueRequest(users[addr][i], asynQueuePriorityLow, 0.0);
+        }
+    }
+    epicsThreadSleep((NUM_REQUESTS + 5) * CALLBACK_TIME);
+    epicsMutexMustLock(doneLock);
+    nBad = doneCount[1];
+    before = doneCount[0] + doneCount[2] + doneCount[3];
+    epicsMutexUnlock(doneLock);
+    testOk(nBad == 3*NUM_REQUESTS && before == 4*3*NUM_REQUESTS,
+           "other devices completed while device 1 was locked");
+    pasynManager->unlockPort(pdevice);
+    waitDone(4*total + 2);
+    for (addr=0, nBad=0; addr<NUM_DEVICES; addr++) nBad += outOfOrder[addr];
+    testOk(getTotalDone() == 4*total + 2 && deviceOverlap == 0 && nBad == 0,
+           "all requests completed in order");
+
+    /* A holder of blockProcessCallback for all devices waits for the device callbacks,
+     * and no other callback runs until it calls unblockProcessCallback */
+    for (addr=0; addr<NUM_DEVICES; addr++) lastSequence[addr] = 0;
+    pholder = createUser(PORT_NAME, 0, holderCallback, 0);
+    pasynManager->blockProcessCallback(pholder, 1);
+    for (i=0; i<NUM_REQUESTS; i++) {
+        for (addr=0; addr<NUM_DEVICES; addr++) {
+            pasynManager->queueRequest(users[addr][i], asynQueuePriorityLow, 0.0);
+        }
+        if (i == 0) pasynManager->queueRequest(pholder, asynQueuePriorityLow, 0.0);
+    }
+    for (i=0; i<100 && getHolderDone()<1; i++) epicsThreadSleep(CALLBACK_TIME);
+    before = getTotalDone();
+    epicsThreadSleep(5 * CALLBACK_TIME);
+    testOk(getHolderDone() == 1 && getTotalDone() == before,
+           "no callback ran after the block holder's callback");
+    pasynManager->queueRequest(pholder, asynQueuePriorityLow, 0.0);
+    for (i=0; i<100 && getHolderDone()<2; i++) epicsThreadSleep(CALLBACK_TIME);
+    testOk(getHolderDone() == 2 && getTotalDone() == before && holderOverlap == 0,
+           "block holder's callbacks ran with no other callback active");
+    pasynManager->unblockProcessCallback(pholder, 1);
+    waitDone(5*total + 2);
+    for (addr=0, nBad=0; addr<NUM_DEVICES; addr++) nBad += outOfOrder[addr];
+    testOk(getTotalDone() == 5*total + 2 && deviceOverlap == 0 && nBad == 0,
+           "requests completed in order after unblockProcessCallback");
+
+    /* Several threads can wait at once to lock the port */
+    for (i=0; i<NUM_REQUESTS; i++) {
+        for (addr=0; addr<NUM_DEVICES; addr++) {
+            pasynManager->queueRequest(users[addr][i], asynQueuePriorityLow, 0.0);
+        }
+    }
+    for (i=0; i<2; i++) {
+        lockUsers[i] = createUser(PORT_NAME, -1, 0, 0);
+        lockUsers[i]->userPvt = epicsEventMustCreate(epicsEventEmpty);
+        epicsThreadCreate("lockPortThread", epicsThreadPriorityMedium,
+                          epicsThreadGetStackSize(epicsThreadStackMedium),
+                          lockPortThread, lockUsers[i]);
+    }
+    for (i=0, nBad=0; i<2; i++) {
+        if (epicsEventWaitWithTimeout((epicsEventId)lockUsers[i]->userPvt, 10.0) != epicsEventWaitOK) nBad++;
+    }
+    waitDone(6*total + 2);
+    testOk(nBad == 0 && getTotalDone() == 6*total + 2, "two threads locked the port while device callbacks were active");
+
+    return testDone();
+}
@@ -0,0 +1,193 @@
+/*
+ * QueueSchedulingTest.cpp
+ *
+ * Tests the asynManager port thread with many queued requests for a device that
+ * is blocked or disabled, which must not delay the requests for other devices.
+ *
+ ***************************************************************************
+ * This file is distributed subject to a Software License Agreement found  *
+ * in the file LICENSE that is included with this distribution.            *
+ ***************************************************************************
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <epicsThread.h>
+#include <epicsEvent.h>
+#include <epicsMutex.h>
+#include <epicsTime.h>
+#include "asynPortDriver.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#define PORT_NAME    "QUEUE_SCHED"
+#define NUM_REQUESTS 5000
+#define BLOCKED_ADDR 1
+#define RUNNING_ADDR 2
+#define DISABLED_ADDR 3
+
+typedef struct requestPvt {
+    int addr;
+    int sequence;
+} requestPvt;
+
+static epicsMutexId doneLock;
+static epicsEventId doneEvent;
+static int doneCount[4];
+static int doneWait[4];
+static int outOfOrder[4];
+static int lastSequence[4];
+
+static void processCallback(asynUser *pasynUser)
+{
+    requestPvt *preq = (requestPvt *)pasynUser->userPvt;
+
+    epicsMutexMustLock(doneLock);
+    if (preq->sequence != lastSequence[preq->addr] + 1) outOfOrder[preq->addr]++;
+    lastSequence[preq->addr] = preq->sequence;
+    doneCount[preq->addr]++;
+    if (doneCount[preq->addr] == doneWait[preq->addr]) epicsEventSignal(doneEvent);
+    epicsMutexUnlock(doneLock);
+}
+
+static void holderCallback(asynUser *pasynUser)
+{
+    epicsEventSignal(doneEvent);
+}
+
+static asynUser *createUser(int addr, userCallback callback, requestPvt *preq)
+{
+    asynUser *pasynUser = pasynManager->createAsynUser(callback, 0);
+
+    pasynManager->connectDevice(pasynUser, PORT_NAME, addr);
+    pasynUser->userPvt = preq;
+    return pasynUser;
+}
+
+static int getDone(int addr)
+{
+    int count;
+
+    epicsMutexMustLock(doneLock);
+    count = doneCount[addr];
+    epicsMutexUnlock(doneLock);
+    return count;
+}
+
+static void waitDone(int addr, int count)
+{
+    epicsMutexMustLock(doneLock);
+    doneWait[addr] = count;
+    if (doneCount[addr] >= count) {
+        epicsMutexUnlock(doneLock);
+        return;
+    }
+    epicsMutexUnlock(doneLock);
+    epicsEventWaitWithTimeout(doneEvent, 30.0);
+}
+
+static double elapsed(epicsTimeStamp *start)
+{
+    epicsTimeStamp now;
+    epicsTimeGetCurrent(&now);
+    return epicsTimeDiffInSeconds(&now, start);
+}
+
+MAIN(QueueSchedulingTest)
+{
+    asynPortDriver *pPort;
+    asynUser *pholder, *pcontrol;
+    asynUser **blockedUsers, **runningUsers, **disabledUsers;
+    requestPvt *blockedReqs, *runningReqs, *disabledReqs;
+    epicsTimeStamp start;
+    int i, wasQueued, nBad;
+    FILE *fp;
+    char line[200];
+    int found=0;
+
+    testPlan(11);
+    doneLock = epicsMutexMustCreate();
+    doneEvent = epicsEventMustCreate(epicsEventEmpty);
+    pPort = new asynPortDriver(PORT_NAME, 4, 1,
+                               asynInt32Mask | asynDrvUserMask, asynInt32Mask,
+                               ASYN_CANBLOCK | ASYN_MULTIDEVICE, 1, 0, 0);
+
+    blockedUsers  = (asynUser **)calloc(NUM_REQUESTS, sizeof(asynUser *));
+    runningUsers  = (asynUser **)calloc(NUM_REQUESTS, sizeof(asynUser *));
+    disabledUsers = (asynUser **)calloc(NUM_REQUESTS, sizeof(asynUser *));
+    blockedReqs   = (requestPvt *)calloc(NUM_REQUESTS, sizeof(requestPvt));
+    runningReqs   = (requestPvt *)calloc(NUM_REQUESTS, sizeof(requestPvt));
+    disabledReqs  = (requestPvt *)calloc(NUM_REQUESTS, sizeof(requestPvt));
+    for (i=0; i<NUM_REQUESTS; i++) {
+        blockedReqs[i].addr = BLOCKED_ADDR;
+        blockedReqs[i].sequence = i+1;
+        blockedUsers[i] = createUser(BLOCKED_ADDR, processCallback, &blockedReqs[i]);
+        runningReqs[i].addr = RUNNING_ADDR;
+        runningReqs[i].sequence = i+1;
+        runningUsers[i] = createUser(RUNNING_ADDR, processCallback, &runningReqs[i]);
+        disabledReqs[i].addr = DISABLED_ADDR;
+        disabledReqs[i].sequence = i+1;
+        disabledUsers[i] = createUser(DISABLED_ADDR, processCallback, &disabledReqs[i]);
+    }
+
+    /* Block BLOCKED_ADDR with a holder, as devGpib does for a multi-step command */
+    pholder = createUser(BLOCKED_ADDR, holderCallback, 0);
+    /* For the queue depth and wait histograms shown by asynReport */
+    pasynManager->enableQueueStatistics(pholder, 1);
+    testOk(pasynManager->blockProcessCallback(pholder, 0) == asynSuccess, "blockProcessCallback");
+    pasynManager->queueRequest(pholder, asynQueuePriorityLow, 0.0);
+    epicsEventWaitWithTimeout(doneEvent, 10.0);
+
+    /* Disable DISABLED_ADDR */
+    pcontrol = createUser(DISABLED_ADDR, processCallback, 0);
+    pasynManager->enable(pcontrol, 0);
+
+    /* Requests for the blocked and disabled devices are queued ahead of those for the running device */
+    epicsTimeGetCurrent(&start);
+    for (i=0, nBad=0; i<NUM_REQUESTS; i++) {
+        if (pasynManager->queueRequest(blockedUsers[i], asynQueuePriorityLow, 0.0)) nBad++;
+        if (pasynManager->queueRequest(disabledUsers[i], asynQueuePriorityLow, 0.0)) nBad++;
+        if (pasynManager->queueRequest(runningUsers[i], asynQueuePriorityLow, 0.0)) nBad++;
+    }
+    testOk(nBad == 0, "queued %d requests for each device", NUM_REQUESTS);
+    waitDone(RUNNING_ADDR, NUM_REQUESTS);
+    testDiag("%d requests for running device with %d requests for blocked and disabled devices: %f sec",
+             NUM_REQUESTS, NUM_REQUESTS, elapsed(&start));
+    testOk(getDone(RUNNING_ADDR) == NUM_REQUESTS, "running device completed %d requests", getDone(RUNNING_ADDR));
+    testOk(getDone(BLOCKED_ADDR) == 0 && getDone(DISABLED_ADDR) == 0,
+           "blocked and disabled devices completed no requests");
+
+    /* A parked request can be canceled */
+    pasynManager->cancelRequest(blockedUsers[NUM_REQUESTS-1], &wasQueued);
+    testOk(wasQueued == 1, "cancelRequest of a parked request");
+
+    /* Unblock the device; its requests are processed in order */
+    testOk(pasynManager->unblockProcessCallback(pholder, 0) == asynSuccess, "unblockProcessCallback");
+    waitDone(BLOCKED_ADDR, NUM_REQUESTS-1);
+    testOk(getDone(BLOCKED_ADDR) == NUM_REQUESTS-1 && outOfOrder[BLOCKED_ADDR] == 0,
+           "blocked device completed %d requests in order after unblock", getDone(BLOCKED_ADDR));
+    testOk(getDone(DISABLED_ADDR) == 0, "disabled device still completed no requests");
+
+    /* Enable the device; its requests are processed in order */
+    pasynManager->enable(pcontrol, 1);
+    waitDone(DISABLED_ADDR, NUM_REQUESTS);
+    testOk(getDone(DISABLED_ADDR) == NUM_REQUESTS && outOfOrder[DISABLED_ADDR] == 0,
+           "disabled device completed %d requests in order after enable", getDone(DISABLED_ADDR));
+    testOk(outOfOrder[RUNNING_ADDR] == 0, "running device completed requests in order");
+
+    fp = tmpfile();
+    pasynManager->report(fp, 1, PORT_NAME);
+    rewind(fp);
+    while (fgets(line, sizeof(line), fp)) {
+        line[strcspn(line, "\n")] = 0;
+        if (strstr(line, "queue")) {
+            found++;
+            testDiag("%s", line);
+        }
+    }
+    fclose(fp);
+    testOk(found == 2, "asynReport shows queue depth and wait histograms");
+
+    return testDone();
+}
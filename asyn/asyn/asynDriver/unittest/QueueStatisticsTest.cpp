@@ -0,0 +1,171 @@
+/*
+ * QueueStatisticsTest.cpp
+ *
+ * Tests the asynManager queue wait and service time histograms, timeout and
+ * cancel counters, and the asynPortDriver parameters that provide them.
+ *
+ ***************************************************************************
+ * This file is distributed subject to a Software License Agreement found  *
+ * in the file LICENSE that is included with this distribution.            *
+ ***************************************************************************
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <epicsThread.h>
+#include <epicsEvent.h>
+#include <epicsTime.h>
+#include <asynInt32.h>
+#include "asynPortDriver.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#define PORT_NAME    "QUEUE_STATS"
+#define NUM_REQUESTS 20
+#define DEVICE_ADDR  1
+#define OTHER_ADDR   2
+
+static epicsEventId doneEvent;
+static epicsEventId slowStarted;
+
+static void processCallback(asynUser *pasynUser)
+{
+    /* Holds the port for about 2 msec, i.e. the <10ms service time bin */
+    epicsThreadSleep(0.002);
+    epicsEventSignal(doneEvent);
+}
+
+static void slowCallback(asynUser *pasynUser)
+{
+    epicsEventSignal(slowStarted);
+    epicsThreadSleep(0.5);
+}
+
+static void timeoutCallback(asynUser *pasynUser)
+{
+}
+
+static asynUser *createUser(int addr, userCallback process, userCallback timeout)
+{
+    asynUser *pasynUser = pasynManager->createAsynUser(process, timeout);
+
+    pasynManager->connectDevice(pasynUser, PORT_NAME, addr);
+    return pasynUser;
+}
+
+static unsigned long sumBins(unsigned long *histogram)
+{
+    unsigned long sum = 0;
+    int i;
+
+    for (i=0; i<ASYN_QUEUE_STATISTICS_BINS; i++) sum += histogram[i];
+    return sum;
+}
+
+static int readParam(asynInt32 *pasynInt32, void *drvPvt, int addr, const char *name,
+                     asynPortDriver *pPort)
+{
+    asynUser *pasynUser = createUser(addr, 0, 0);
+    epicsInt32 value = -1;
+
+    pPort->findParam(name, &pasynUser->reason);
+    pasynInt32->read(drvPvt, pasynUser, &value);
+    pasynManager->freeAsynUser(pasynUser);
+    return value;
+}
+
+MAIN(QueueStatisticsTest)
+{
+    asynPortDriver *pPort;
+    asynUser *pport, *pdevice, *pother, *pslow, *ptimeout, *pcancel;
+    asynUser *users[NUM_REQUESTS];
+    asynInterface *pasynInterface;
+    asynInt32 *pasynInt32;
+    asynQueueStatistics portStats, deviceStats, otherStats;
+    int i, wasQueued, nDone;
+
+    testPlan(13);
+    doneEvent = epicsEventMustCreate(epicsEventEmpty);
+    slowStarted = epicsEventMustCreate(epicsEventEmpty);
+    pPort = new asynPortDriver(PORT_NAME, 3, ASYN_QUEUE_STATISTICS_NUM_PARAMS,
+                               asynInt32Mask | asynDrvUserMask, asynInt32Mask,
+                               ASYN_CANBLOCK | ASYN_MULTIDEVICE, 1, 0, 0);
+    testOk(pPort->createQueueStatisticsParams() == asynSuccess, "createQueueStatisticsParams");
+
+    pport   = createUser(-1, 0, 0);
+    pdevice = createUser(DEVICE_ADDR, 0, 0);
+    pother  = createUser(OTHER_ADDR, 0, 0);
+
+    /* Nothing is timed until the statistics are enabled */
+    users[0] = createUser(DEVICE_ADDR, processCallback, 0);
+    pasynManager->queueRequest(users[0], asynQueuePriorityLow, 0.0);
+    epicsEventWaitWithTimeout(doneEvent, 10.0);
+    pasynManager->freeAsynUser(users[0]);
+    pasynManager->getQueueStatistics(pdevice, &deviceStats, 0);
+    testOk(sumBins(deviceStats.queueWait) == 0 && sumBins(deviceStats.service) == 0,
+           "no queue wait or service times while disabled");
+
+    testOk(pasynManager->enableQueueStatistics(pport, 1) == asynSuccess, "enableQueueStatistics");
+    /* Clear the port connect request done before the test */
+    pasynManager->getQueueStatistics(pport, 0, 1);
+
+    for (i=0; i<NUM_REQUESTS; i++) {
+        users[i] = createUser(DEVICE_ADDR, processCallback, 0);
+        pasynManager->queueRequest(users[i], asynQueuePriorityLow, 0.0);
+    }
+    for (nDone=0; nDone<NUM_REQUESTS; nDone++) {
+        if (epicsEventWaitWithTimeout(doneEvent, 10.0) != epicsEventWaitOK) break;
+    }
+    testOk(nDone == NUM_REQUESTS, "%d requests completed", nDone);
+
+    /* While a slow callback holds the port, one request times out and one is canceled */
+    pslow    = createUser(OTHER_ADDR, slowCallback, 0);
+    ptimeout = createUser(DEVICE_ADDR, processCallback, timeoutCallback);
+    pcancel  = createUser(DEVICE_ADDR, processCallback, 0);
+    pasynManager->queueRequest(pslow, asynQueuePriorityLow, 0.0);
+    epicsEventWaitWithTimeout(slowStarted, 10.0);
+    pasynManager->queueRequest(ptimeout, asynQueuePriorityLow, 0.05);
+    pasynManager->queueRequest(pcancel, asynQueuePriorityLow, 0.0);
+    pasynManager->cancelRequest(pcancel, &wasQueued);
+    epicsThreadSleep(0.2);
+    testOk(wasQueued == 1, "request canceled while queued");
+
+    /* Wait for the slow callback to finish and its service time to be recorded */
+    pasynManager->lockPort(pport);
+    pasynManager->unlockPort(pport);
+    epicsThreadSleep(0.1);
+
+    pasynManager->getQueueStatistics(pdevice, &deviceStats, 0);
+    pasynManager->getQueueStatistics(pother, &otherStats, 0);
+    pasynManager->getQueueStatistics(pport, &portStats, 0);
+    testOk(sumBins(deviceStats.queueWait) == NUM_REQUESTS && sumBins(deviceStats.service) == NUM_REQUESTS,
+           "device queue wait %lu, service %lu", sumBins(deviceStats.queueWait), sumBins(deviceStats.service));
+    testOk(deviceStats.service[3] == NUM_REQUESTS, "device service times in <10ms bin: %lu",
+           deviceStats.service[3]);
+    testOk(deviceStats.numberTimeouts == 1 && deviceStats.numberCancels == 1,
+           "device timeouts %lu, cancels %lu", deviceStats.numberTimeouts, deviceStats.numberCancels);
+    testOk(otherStats.service[5] == 1 && otherStats.numberTimeouts == 0 && otherStats.numberCancels == 0,
+           "other device has one <1s service time and no timeouts or cancels");
+    testOk(sumBins(portStats.queueWait) == NUM_REQUESTS+1 && sumBins(portStats.service) == NUM_REQUESTS+1 &&
+           portStats.numberTimeouts == 1 && portStats.numberCancels == 1,
+           "port statistics include both devices");
+
+    pasynInterface = pasynManager->findInterface(pdevice, asynInt32Type, 1);
+    pasynInt32 = (asynInt32 *)pasynInterface->pinterface;
+    testOk(readParam(pasynInt32, pasynInterface->drvPvt, DEVICE_ADDR, "ASYN_SERVICE_TIME_3", pPort) == NUM_REQUESTS &&
+           readParam(pasynInt32, pasynInterface->drvPvt, DEVICE_ADDR, "ASYN_QUEUE_TIMEOUTS", pPort) == 1 &&
+           readParam(pasynInt32, pasynInterface->drvPvt, DEVICE_ADDR, "ASYN_QUEUE_CANCELS", pPort) == 1,
+           "asynPortDriver parameters for device");
+    testOk(readParam(pasynInt32, pasynInterface->drvPvt, OTHER_ADDR, "ASYN_SERVICE_TIME_5", pPort) == 1,
+           "asynPortDriver parameters for other device");
+
+    pasynManager->getQueueStatistics(pdevice, 0, 1);
+    pasynManager->getQueueStatistics(pdevice, &deviceStats, 0);
+    testOk(sumBins(deviceStats.queueWait) == 0 && sumBins(deviceStats.service) == 0 &&
+           deviceStats.numberTimeouts == 0 && deviceStats.numberCancels == 0,
+           "statistics cleared");
+
+    for (i=0; i<NUM_REQUESTS; i++) pasynManager->freeAsynUser(users[i]);
+    return testDone();
+}
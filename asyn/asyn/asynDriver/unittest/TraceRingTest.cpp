@@ -0,0 +1,205 @@
+/*
+ * TraceRingTest.cpp
+ *
+ * Tests the asynTrace ring buffer: records are only formatted when dumped or
+ * drained, the oldest are overwritten when it is full, and the output is the
+ * same as printing immediately. Also compares the time of asynPrintIO with
+ * ASYN_TRACEIO_HEX with and without the ring buffer.
+ *
+ ***************************************************************************
+ * This file is distributed subject to a Software License Agreement found  *
+ * in the file LICENSE that is included with this distribution.            *
+ ***************************************************************************
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <epicsThread.h>
+#include <epicsTime.h>
+#include "asynPortDriver.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#define PORT_NAME    "TRACE_RING"
+#define MULTI_PORT_NAME "TRACE_RING_MULTI"
+#define RING_SIZE    8
+#define NUM_TIMED    20000
+#define TEXT_SIZE    4096
+
+/* Returns the text written to fp */
+static char *readText(FILE *fp, char *text)
+{
+    size_t n;
+
+    fflush(fp);
+    rewind(fp);
+    n = fread(text, 1, TEXT_SIZE-1, fp);
+    text[n] = 0;
+    return text;
+}
+
+/* Messages longer than the initial record buffer, and a truncate size set after setTraceRing */
+static void testLongRecords(asynUser *pasynUser)
+{
+    FILE *traceFp, *dumpFp;
+    char text[TEXT_SIZE], expected[TEXT_SIZE];
+    char longMessage[1000], data[600];
+    int i, nRecords;
+
+    for (i=0; i<(int)sizeof(longMessage)-1; i++) longMessage[i] = (char)('a' + i%26);
+    longMessage[sizeof(longMessage)-1] = 0;
+    for (i=0; i<(int)sizeof(data); i++) data[i] = (char)('A' + i%26);
+    pasynTrace->setTraceInfoMask(pasynUser, 0);
+    pasynTrace->setTraceIOMask(pasynUser, ASYN_TRACEIO_ASCII);
+    traceFp = tmpfile();
+    pasynTrace->setTraceFile(pasynUser, traceFp);
+    pasynTrace->setTraceRing(pasynUser, RING_SIZE, 0);
+    pasynTrace->setTraceIOTruncateSize(pasynUser, sizeof(data));
+    asynPrint(pasynUser, ASYN_TRACE_ERROR, "%s\n", longMessage);
+    asynPrintIO(pasynUser, ASYN_TRACEIO_DRIVER, data, sizeof(data), "data\n");
+    dumpFp = tmpfile();
+    nRecords = pasynTrace->dumpTraceRing(pasynUser, dumpFp);
+    readText(dumpFp, text);
+    fclose(dumpFp);
+    sprintf(expected, "%s\ndata\n%.*s\n", longMessage, (int)sizeof(data), data);
+    testOk(nRecords == 2 && strcmp(text, expected) == 0,
+           "dumped %d records with a %d character message and %d bytes", nRecords,
+           (int)strlen(longMessage), (int)sizeof(data));
+    pasynTrace->setTraceRing(pasynUser, 0, 0);
+    pasynTrace->setTraceIOTruncateSize(pasynUser, 80);
+}
+
+/* The drain thread writes each record to the trace file of the device that logged it */
+static void testDeviceTraceFile()
+{
+    asynUser *pport, *pdevice;
+    FILE *portFp, *deviceFp;
+    char text[TEXT_SIZE];
+    int portOk;
+
+    new asynPortDriver(MULTI_PORT_NAME, 2, 1, asynInt32Mask | asynDrvUserMask, 0,
+                       ASYN_MULTIDEVICE, 1, 0, 0);
+    pport = pasynManager->createAsynUser(0, 0);
+    pasynManager->connectDevice(pport, MULTI_PORT_NAME, -1);
+    pdevice = pasynManager->createAsynUser(0, 0);
+    pasynManager->connectDevice(pdevice, MULTI_PORT_NAME, 1);
+    pasynTrace->setTraceInfoMask(pport, 0);
+    pasynTrace->setTraceInfoMask(pdevice, 0);
+    portFp = tmpfile();
+    pasynTrace->setTraceFile(pport, portFp);
+    deviceFp = tmpfile();
+    pasynTrace->setTraceFile(pdevice, deviceFp);
+    pasynTrace->setTraceRing(pport, RING_SIZE, 1);
+    asynPrint(pport, ASYN_TRACE_ERROR, "port\n");
+    asynPrint(pdevice, ASYN_TRACE_ERROR, "device\n");
+    epicsThreadSleep(0.5);
+    readText(portFp, text);
+    portOk = (strcmp(text, "port\n") == 0);
+    readText(deviceFp, text);
+    testOk(portOk && strcmp(text, "device\n") == 0, "drained records written to the port and device trace files");
+
+    /* drain=0 stops the drain thread, so later records stay in the ring */
+    testOk(pasynTrace->setTraceRing(pport, RING_SIZE, 0) == asynSuccess, "setTraceRing stops the drain thread");
+    asynPrint(pport, ASYN_TRACE_ERROR, "kept\n");
+    epicsThreadSleep(0.3);
+    testOk(pasynTrace->dumpTraceRing(pport, 0) == 1, "record kept after the drain thread stopped");
+    pasynTrace->setTraceRing(pport, 0, 0);
+    pasynTrace->setTraceFile(pport, stderr);
+    pasynTrace->setTraceFile(pdevice, stderr);
+}
+
+MAIN(TraceRingTest)
+{
+    asynUser *pasynUser, *pnotConnected;
+    FILE *traceFp, *dumpFp;
+    char text[TEXT_SIZE], expected[TEXT_SIZE];
+    char data[25];
+    epicsTimeStamp start, end;
+    double directTime, ringTime;
+    int i, nRecords;
+
+    testPlan(14);
+    new asynPortDriver(PORT_NAME, 1, 1, asynInt32Mask | asynDrvUserMask, 0, 0, 1, 0, 0);
+    pasynUser = pasynManager->createAsynUser(0, 0);
+    pasynManager->connectDevice(pasynUser, PORT_NAME, 0);
+    pnotConnected = pasynManager->createAsynUser(0, 0);
+    pasynTrace->setTraceMask(pasynUser, ASYN_TRACE_ERROR | ASYN_TRACEIO_DRIVER);
+    pasynTrace->setTraceInfoMask(pasynUser, 0);
+    pasynTrace->setTraceIOMask(pasynUser, ASYN_TRACEIO_HEX);
+    for (i=0; i<(int)sizeof(data); i++) data[i] = (char)(i + 0xf0);
+
+    testOk(pasynTrace->setTraceRing(pnotConnected, RING_SIZE, 0) == asynError,
+           "setTraceRing fails if not connected");
+    testOk(pasynTrace->dumpTraceRing(pasynUser, stdout) == -1,
+           "dumpTraceRing fails if the port has no ring");
+
+    /* Output printed immediately, used to check the formatted records */
+    traceFp = tmpfile();
+    pasynTrace->setTraceFile(pasynUser, traceFp);
+    asynPrint(pasynUser, ASYN_TRACE_ERROR, "message %d\n", 1);
+    asynPrintIO(pasynUser, ASYN_TRACEIO_DRIVER, data, sizeof(data), "data\n");
+    readText(traceFp, expected);
+    testOk(strcmp(expected, "message 1\ndata\n\nf0 f1 f2 f3 f4 f5 f6 f7 f8 f9 fa fb fc fd fe ff 00 01 02 03 "
+                            "\n04 05 06 07 08 \n") == 0,
+           "printed immediately with 20 bytes per hex line");
+
+    traceFp = tmpfile();
+    pasynTrace->setTraceFile(pasynUser, traceFp);
+    testOk(pasynTrace->setTraceRing(pasynUser, RING_SIZE, 0) == asynSuccess, "setTraceRing %d", RING_SIZE);
+    asynPrint(pasynUser, ASYN_TRACE_ERROR, "message %d\n", 1);
+    asynPrintIO(pasynUser, ASYN_TRACEIO_DRIVER, data, sizeof(data), "data\n");
+    fflush(traceFp);
+    testOk(ftell(traceFp) == 0, "nothing printed while records are in the ring");
+    dumpFp = tmpfile();
+    nRecords = pasynTrace->dumpTraceRing(pasynUser, dumpFp);
+    readText(dumpFp, text);
+    fclose(dumpFp);
+    testOk(nRecords == 2 && strcmp(text, expected) == 0, "dumped %d records the same as printed immediately",
+           nRecords);
+
+    /* When the ring is full the oldest records are overwritten */
+    for (i=0; i<RING_SIZE+4; i++) asynPrint(pasynUser, ASYN_TRACE_ERROR, "message %d\n", i);
+    dumpFp = tmpfile();
+    nRecords = pasynTrace->dumpTraceRing(pasynUser, dumpFp);
+    readText(dumpFp, text);
+    fclose(dumpFp);
+    testOk(nRecords == RING_SIZE && strncmp(text, "message 4\n", 10) == 0,
+           "ring kept the newest %d records", nRecords);
+
+    /* The drain thread formats the records to the trace file */
+    pasynTrace->setTraceRing(pasynUser, RING_SIZE, 1);
+    asynPrint(pasynUser, ASYN_TRACE_ERROR, "message %d\n", 1);
+    asynPrintIO(pasynUser, ASYN_TRACEIO_DRIVER, data, sizeof(data), "data\n");
+    epicsThreadSleep(0.5);
+    testOk(pasynTrace->dumpTraceRing(pasynUser, stdout) == 0, "drain thread formatted the records");
+    pasynTrace->setTraceRing(pasynUser, 0, 0);
+    readText(traceFp, text);
+    testOk(strcmp(text, expected) == 0, "drained records written to the trace file");
+
+    /* Time of asynPrintIO with ASYN_TRACEIO_HEX with and without the ring */
+    traceFp = tmpfile();
+    pasynTrace->setTraceFile(pasynUser, traceFp);
+    pasynTrace->setTraceInfoMask(pasynUser, ASYN_TRACEINFO_TIME | ASYN_TRACEINFO_PORT);
+    epicsTimeGetCurrent(&start);
+    for (i=0; i<NUM_TIMED; i++) asynPrintIO(pasynUser, ASYN_TRACEIO_DRIVER, data, sizeof(data), "data %d\n", i);
+    epicsTimeGetCurrent(&end);
+    directTime = epicsTimeDiffInSeconds(&end, &start);
+    pasynTrace->setTraceRing(pasynUser, NUM_TIMED, 0);
+    epicsTimeGetCurrent(&start);
+    for (i=0; i<NUM_TIMED; i++) asynPrintIO(pasynUser, ASYN_TRACEIO_DRIVER, data, sizeof(data), "data %d\n", i);
+    epicsTimeGetCurrent(&end);
+    ringTime = epicsTimeDiffInSeconds(&end, &start);
+    testDiag("asynPrintIO with ASYN_TRACEIO_HEX: %f usec printed, %f usec to the ring",
+             directTime/NUM_TIMED*1e6, ringTime/NUM_TIMED*1e6);
+    dumpFp = tmpfile();
+    nRecords = pasynTrace->dumpTraceRing(pasynUser, dumpFp);
+    fclose(dumpFp);
+    testOk(nRecords == NUM_TIMED, "dumped %d timed records", nRecords);
+
+    pasynTrace->setTraceRing(pasynUser, 0, 0);
+    testLongRecords(pasynUser);
+    testDeviceTraceFile();
+    pasynTrace->setTraceFile(pasynUser, stderr);
+    return testDone();
+}
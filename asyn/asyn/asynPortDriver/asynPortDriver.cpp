@@ -15,6 +15,7 @@
 
 #include <epicsString.h>
 #include <epicsMutex.h>
+#include <gpHash.h>
 #include <epicsThread.h>
 #include <cantProceed.h>
 /* NOTE: This is needed for interruptAccept */
@@ -60,28 +61,38 @@ public:
     asynStatus callCallbacks();
     asynStatus setStatus(int index, asynStatus status);
     asynStatus getStatus(int index, asynStatus *status);
+    void getCallbackCounts(int *numParams, int *numCallbacks);
     void report(FILE *fp, int details);
 
 private:
     asynStatus setFlag(int index);
-    asynStatus int32Callback(int command, int addr);
-    asynStatus uint32Callback(int command, int addr, epicsUInt32 interruptMask);
-    asynStatus float64Callback(int command, int addr);
-    asynStatus octetCallback(int command, int addr);
+    void clearFlags();
+    asynStatus typeCallbacks(asynParamType type, int nChanged, int addr, epicsTimeStamp *pTimeStamp);
+    int int32Callback(int command, int addr, epicsTimeStamp *pTimeStamp);
+    int uint32Callback(int command, int addr, epicsUInt32 interruptMask, epicsTimeStamp *pTimeStamp);
+    int float64Callback(int command, int addr, epicsTimeStamp *pTimeStamp);
+    int octetCallback(int command, int addr, epicsTimeStamp *pTimeStamp);
     void registerParameterChange(paramVal *param, int index);
     int nextParam;
     int nVals;
     int nFlags;
     asynPortDriver *pasynPortDriver;
-    int *flags;
+    int *flags;                /**< Changed parameters, in the order they were first changed */
+    epicsUInt32 *flagBits;     /**< Bitmap of the parameters in flags, so setFlag does not search it */
     paramVal **vals;
+    struct gphPvt *nameHash;  /**< gpHash index of parameter names to parameter numbers */
+    int numParamsLast;         /**< Number of changed parameters passed by the last callCallbacks */
+    int numCallbacksLast;      /**< Number of client callbacks done by the last callCallbacks */
+    unsigned long numCallParamCallbacks; /**< Number of calls to callCallbacks */
+    unsigned long numCallbacksTotal;     /**< Number of client callbacks done by all calls to callCallbacks */
 };
 
 /** Constructor for paramList class.
   * \param[in] nValues Number of parameters in the list.
   * \param[in] pPort Pointer to asynPortDriver port for this paramList. */
 paramList::paramList(int nValues, asynPortDriver *pPort)
-    : nextParam(0), nVals(nValues), nFlags(0), pasynPortDriver(pPort)
+    : nextParam(0), nVals(nValues), nFlags(0), pasynPortDriver(pPort),
+      numParamsLast(0), numCallbacksLast(0), numCallParamCallbacks(0), numCallbacksTotal(0)
 {
     char eName[6];
     sprintf(eName, "empty");
@@ -90,27 +101,46 @@ paramList::paramList(int nValues, asynPortDriver *pPort)
         vals[ii] = new paramVal(eName);
     }
     flags = (int *) calloc(nVals, sizeof(int));
+    flagBits = (epicsUInt32 *) calloc((nVals+31)/32, sizeof(epicsUInt32));
+    /* gpHash requires a power of 2 table size; it clamps this to the range 256-65536 */
+    int hashSize = 256;
+    while (hashSize < nVals && hashSize < 65536) hashSize <<= 1;
+    nameHash = 0;
+    gphInitPvt(&nameHash, hashSize);
 }
 
 /** Destructor for paramList class; frees resources allocated in constructor */
 paramList::~paramList()
 {
+    gphFreeMem(nameHash);
     free(vals);
     free(flags);
+    free(flagBits);
 }
 
 asynStatus paramList::setFlag(int index)
 {
-    int i;
+    epicsUInt32 bit;
 
     if (index < 0 || index >= this->nVals) return asynParamBadIndex;
     /* See if we have already set the flag for this parameter */
-    for (i=0; i<this->nFlags; i++) if (this->flags[i] == index) break;
-    /* If not found add a flag */
-    if (i == this->nFlags) this->flags[this->nFlags++] = index;
+    bit = 1u << (index % 32);
+    if (this->flagBits[index/32] & bit) return asynSuccess;
+    /* If not add a flag */
+    this->flagBits[index/32] |= bit;
+    this->flags[this->nFlags++] = index;
     return asynSuccess;
 }
 
+/** Clears the flags set by setFlag; only touches the words of flagBits that have a flag set */
+void paramList::clearFlags()
+{
+    int i;
+
+    for (i=0; i<this->nFlags; i++) this->flagBits[this->flags[i]/32] = 0;
+    this->nFlags = 0;
+}
+
 /** Adds a new parameter to the parameter library.
   * \param[in] name The name of this parameter
   * \param[in] type The type of this parameter
@@ -119,24 +149,34 @@ asynStatus paramList::setFlag(int index)
   * adding this parameter would exceed the size of the parameter list. */
 asynStatus paramList::createParam(const char *name, asynParamType type, int *index)
 {
+    GPHENTRY *hashEntry;
+
     if (this->findParam(name, index) == asynSuccess) return asynParamAlreadyExists;
     *index = this->nextParam++;
     if (*index < 0 || *index >= this->nVals) return asynParamBadIndex;
     delete this->vals[*index];
     this->vals[*index] = new paramVal(name, type);
+    /* The hash table does not copy the name, so point it at the copy owned by paramVal.
+     * The entry points to the slot in vals so the index can be recovered directly. */
+    hashEntry = gphAdd(this->nameHash, this->vals[*index]->getName(), NULL);
+    if (hashEntry) hashEntry->userPvt = (void *)&this->vals[*index];
     return asynSuccess;
 }
 
 /** Finds a parameter in the parameter library.
+  * Uses the hash table of parameter names built by createParam, so the cost does not depend on
+  * the number of parameters in the list.
   * \param[in] name The name of this parameter
   * \param[out] index The parameter number
   * \return Returns asynParamNotFound if name is not found in the parameter list. */
 asynStatus paramList::findParam(const char *name, int *index)
 {
-    for (*index=0; *index<this->nVals; (*index)++) {
-        if (this->vals[*index]->nameEquals(name)) return asynSuccess;
-    }
-    return asynParamNotFound;
+    GPHENTRY *hashEntry;
+
+    hashEntry = gphFind(this->nameHash, name, NULL);
+    if (!hashEntry) return asynParamNotFound;
+    *index = (int)((paramVal **)hashEntry->userPvt - this->vals);
+    return asynSuccess;
 }
 
 void paramList::registerParameterChange(paramVal *param,int index)
@@ -436,202 +476,236 @@ asynStatus paramList::getName(int index, const char **value)
     return asynSuccess;
 }
 
-/** Calls the registered asyn callback functions for all clients for an integer parameter */
-asynStatus paramList::int32Callback(int command, int addr)
+/** Returns the first interrupt client registered for a reason and address.
+  * Clients of ports that are not multi-device have address -1, which asynManager treats as address 0.
+  * Must be called between pasynManager->interruptStart and interruptEnd. */
+static interruptNode *firstInterruptClient(void *interruptPvt, int reason, int addr)
 {
-    ELLLIST *pclientList;
+    return pasynManager->interruptFindFirst(interruptPvt, reason, addr);
+}
+
+/** Returns the interrupt client following pnode for the same reason and address, or NULL.
+  * Clients are returned in the order they were registered. */
+static interruptNode *nextInterruptClient(interruptNode *pnode)
+{
+    return pasynManager->interruptFindNext(pnode);
+}
+
+/** Calls the registered asyn callback functions for all clients for an integer parameter.
+  * Must be called between pasynManager->interruptStart and interruptEnd on the asynInt32 interface.
+  * \return Returns the number of clients that were called. */
+int paramList::int32Callback(int command, int addr, epicsTimeStamp *pTimeStamp)
+{
+    void *interruptPvt = this->pasynPortDriver->getAsynStdInterfaces()->int32InterruptPvt;
     interruptNode *pnode;
-    asynStandardInterfaces *pInterfaces = this->pasynPortDriver->getAsynStdInterfaces();
-    epicsTimeStamp timeStamp;
-    this->pasynPortDriver->getTimeStamp(&timeStamp);
-    int address;
     epicsInt32 value;
     asynStatus status;
+    int nCallbacks = 0;
 
     /* Pass int32 interrupts */
     status = getInteger(command, &value);
-    if (!pInterfaces->int32InterruptPvt) return(asynParamNotFound);
-    pasynManager->interruptStart(pInterfaces->int32InterruptPvt, &pclientList);
-    pnode = (interruptNode *)ellFirst(pclientList);
+    pnode = firstInterruptClient(interruptPvt, command, addr);
     while (pnode) {
         asynInt32Interrupt *pInterrupt = (asynInt32Interrupt *) pnode->drvPvt;
-        pasynManager->getAddr(pInterrupt->pasynUser, &address);
-        /* If this is not a multi-device then address is -1, change to 0 */
-        if (address == -1) address = 0;
-        if ((command == pInterrupt->pasynUser->reason) &&
-            (address == addr)) {
-            /* Set the status for the callback */
-            pInterrupt->pasynUser->auxStatus = status;
-            /* Set the timestamp for the callback */
-            pInterrupt->pasynUser->timestamp = timeStamp;
-            pInterrupt->callback(pInterrupt->userPvt,
-                                 pInterrupt->pasynUser,
-                                 value);
-        }
-        pnode = (interruptNode *)ellNext(&pnode->node);
+        /* Set the status for the callback */
+        pInterrupt->pasynUser->auxStatus = status;
+        /* Set the timestamp for the callback */
+        pInterrupt->pasynUser->timestamp = *pTimeStamp;
+        pInterrupt->callback(pInterrupt->userPvt,
+                             pInterrupt->pasynUser,
+                             value);
+        nCallbacks++;
+        pnode = nextInterruptClient(pnode);
     }
-    pasynManager->interruptEnd(pInterfaces->int32InterruptPvt);
-    return(asynSuccess);
+    return nCallbacks;
 }
 
-/** Calls the registered asyn callback functions for all clients for an UInt32 parameter */
-asynStatus paramList::uint32Callback(int command, int addr, epicsUInt32 interruptMask)
+/** Calls the registered asyn callback functions for all clients for an UInt32 parameter.
+  * Must be called between pasynManager->interruptStart and interruptEnd on the asynUInt32Digital interface.
+  * \return Returns the number of clients that were called. */
+int paramList::uint32Callback(int command, int addr, epicsUInt32 interruptMask, epicsTimeStamp *pTimeStamp)
 {
-    ELLLIST *pclientList;
+    void *interruptPvt = this->pasynPortDriver->getAsynStdInterfaces()->uInt32DigitalInterruptPvt;
     interruptNode *pnode;
-    asynStandardInterfaces *pInterfaces = this->pasynPortDriver->getAsynStdInterfaces();
-    epicsTimeStamp timeStamp;
-    this->pasynPortDriver->getTimeStamp(&timeStamp);
-    int address;
     epicsUInt32 value;
     asynStatus status;
+    int nCallbacks = 0;
 
     /* Pass UInt32Digital interrupts */
     status = getUInt32(command, &value, 0xFFFFFFFF);
-    if (!pInterfaces->uInt32DigitalInterruptPvt) return(asynParamNotFound);
-    pasynManager->interruptStart(pInterfaces->uInt32DigitalInterruptPvt, &pclientList);
-    pnode = (interruptNode *)ellFirst(pclientList);
+    pnode = firstInterruptClient(interruptPvt, command, addr);
     while (pnode) {
         asynUInt32DigitalInterrupt *pInterrupt = (asynUInt32DigitalInterrupt *) pnode->drvPvt;
-        pasynManager->getAddr(pInterrupt->pasynUser, &address);
-        /* If this is not a multi-device then address is -1, change to 0 */
-        if (address == -1) address = 0;
-        if ((command == pInterrupt->pasynUser->reason) &&
-            (address == addr) &&
-            (pInterrupt->mask & interruptMask)) {
+        if (pInterrupt->mask & interruptMask) {
             /* Set the status for the callback */
             pInterrupt->pasynUser->auxStatus = status;
             /* Set the timestamp for the callback */
-            pInterrupt->pasynUser->timestamp = timeStamp;
+            pInterrupt->pasynUser->timestamp = *pTimeStamp;
             pInterrupt->callback(pInterrupt->userPvt,
                                  pInterrupt->pasynUser,
                                  pInterrupt->mask & value);
+            nCallbacks++;
         }
-        pnode = (interruptNode *)ellNext(&pnode->node);
+        pnode = nextInterruptClient(pnode);
     }
-    pasynManager->interruptEnd(pInterfaces->uInt32DigitalInterruptPvt);
-    return(asynSuccess);
+    return nCallbacks;
 }
 
-/** Calls the registered asyn callback functions for all clients for a double parameter */
-asynStatus paramList::float64Callback(int command, int addr)
+/** Calls the registered asyn callback functions for all clients for a double parameter.
+  * Must be called between pasynManager->interruptStart and interruptEnd on the asynFloat64 interface.
+  * \return Returns the number of clients that were called. */
+int paramList::float64Callback(int command, int addr, epicsTimeStamp *pTimeStamp)
 {
-    ELLLIST *pclientList;
+    void *interruptPvt = this->pasynPortDriver->getAsynStdInterfaces()->float64InterruptPvt;
     interruptNode *pnode;
-    asynStandardInterfaces *pInterfaces = this->pasynPortDriver->getAsynStdInterfaces();
-    epicsTimeStamp timeStamp;
-    this->pasynPortDriver->getTimeStamp(&timeStamp);
-    int address;
     epicsFloat64 value;
     asynStatus status;
+    int nCallbacks = 0;
 
     /* Pass float64 interrupts */
     status = getDouble(command, &value);
-    if (!pInterfaces->float64InterruptPvt) return(asynParamNotFound);
-    pasynManager->interruptStart(pInterfaces->float64InterruptPvt, &pclientList);
-    pnode = (interruptNode *)ellFirst(pclientList);
+    pnode = firstInterruptClient(interruptPvt, command, addr);
     while (pnode) {
         asynFloat64Interrupt *pInterrupt = (asynFloat64Interrupt *) pnode->drvPvt;
-        pasynManager->getAddr(pInterrupt->pasynUser, &address);
-        /* If this is not a multi-device then address is -1, change to 0 */
-        if (address == -1) address = 0;
-        if ((command == pInterrupt->pasynUser->reason) &&
-            (address == addr)) {
-            /* Set the status for the callback */
-            pInterrupt->pasynUser->auxStatus = status;
-            /* Set the timestamp for the callback */
-            pInterrupt->pasynUser->timestamp = timeStamp;
-            pInterrupt->callback(pInterrupt->userPvt,
-                                 pInterrupt->pasynUser,
-                                 value);
-        }
-        pnode = (interruptNode *)ellNext(&pnode->node);
+        /* Set the status for the callback */
+        pInterrupt->pasynUser->auxStatus = status;
+        /* Set the timestamp for the callback */
+        pInterrupt->pasynUser->timestamp = *pTimeStamp;
+        pInterrupt->callback(pInterrupt->userPvt,
+                             pInterrupt->pasynUser,
+                             value);
+        nCallbacks++;
+        pnode = nextInterruptClient(pnode);
     }
-    pasynManager->interruptEnd(pInterfaces->float64InterruptPvt);
-    return(asynSuccess);
+    return nCallbacks;
 }
 
-/** Calls the registered asyn callback functions for all clients for a string parameter */
-asynStatus paramList::octetCallback(int command, int addr)
+/** Calls the registered asyn callback functions for all clients for a string parameter.
+  * Must be called between pasynManager->interruptStart and interruptEnd on the asynOctet interface.
+  * \return Returns the number of clients that were called. */
+int paramList::octetCallback(int command, int addr, epicsTimeStamp *pTimeStamp)
 {
-    ELLLIST *pclientList;
+    void *interruptPvt = this->pasynPortDriver->getAsynStdInterfaces()->octetInterruptPvt;
     interruptNode *pnode;
-    asynStandardInterfaces *pInterfaces = this->pasynPortDriver->getAsynStdInterfaces();
-    epicsTimeStamp timeStamp;
-    this->pasynPortDriver->getTimeStamp(&timeStamp);
-    int address;
     char *value;
     asynStatus status;
+    int nCallbacks = 0;
 
     /* Pass octet interrupts */
     value = getParameter(command)->getString();
     getStatus(command, &status);
-    if (!pInterfaces->octetInterruptPvt) return(asynParamNotFound);
-    pasynManager->interruptStart(pInterfaces->octetInterruptPvt, &pclientList);
-    pnode = (interruptNode *)ellFirst(pclientList);
+    pnode = firstInterruptClient(interruptPvt, command, addr);
     while (pnode) {
         asynOctetInterrupt *pInterrupt = (asynOctetInterrupt *) pnode->drvPvt;
-        pasynManager->getAddr(pInterrupt->pasynUser, &address);
-        /* If this is not a multi-device then address is -1, change to 0 */
-        if (address == -1) address = 0;
-        if ((command == pInterrupt->pasynUser->reason) &&
-            (address == addr)) {
-            /* Set the status for the callback */
-            pInterrupt->pasynUser->auxStatus = status;
-            /* Set the timestamp for the callback */
-            pInterrupt->pasynUser->timestamp = timeStamp;
-            pInterrupt->callback(pInterrupt->userPvt,
-                                 pInterrupt->pasynUser,
-                                 value, strlen(value)+1, ASYN_EOM_END);
+        /* Set the status for the callback */
+        pInterrupt->pasynUser->auxStatus = status;
+        /* Set the timestamp for the callback */
+        pInterrupt->pasynUser->timestamp = *pTimeStamp;
+        pInterrupt->callback(pInterrupt->userPvt,
+                             pInterrupt->pasynUser,
+                             value, strlen(value)+1, ASYN_EOM_END);
+        nCallbacks++;
+        pnode = nextInterruptClient(pnode);
+    }
+    return nCallbacks;
+}
+
+/** Returns the interrupt source for the interface that does callbacks for a parameter type,
+  * or NULL if the type has no callbacks or the driver did not register that interface. */
+static void *paramInterruptPvt(asynStandardInterfaces *pInterfaces, asynParamType type)
+{
+    switch(type) {
+        case asynParamInt32:         return pInterfaces->int32InterruptPvt;
+        case asynParamUInt32Digital: return pInterfaces->uInt32DigitalInterruptPvt;
+        case asynParamFloat64:       return pInterfaces->float64InterruptPvt;
+        case asynParamOctet:         return pInterfaces->octetInterruptPvt;
+        default:                     return 0;
+    }
+}
+
+/** Calls the registered asyn callback functions for all clients for the changed parameters of one type.
+  * The interrupt list for the interface is locked once with pasynManager->interruptStart for all of the
+  * parameters, rather than once per parameter.
+  * \param[in] type The parameter type.
+  * \param[in] nChanged The number of entries in flags to process.
+  * \param[in] addr The asyn address to be used in the callbacks.
+  * \param[in] pTimeStamp The timestamp for the callbacks.
+  * \return Returns asynParamNotFound if there are changed parameters of this type but the driver
+  * does not support the interface for them. */
+asynStatus paramList::typeCallbacks(asynParamType type, int nChanged, int addr, epicsTimeStamp *pTimeStamp)
+{
+    void *interruptPvt = paramInterruptPvt(this->pasynPortDriver->getAsynStdInterfaces(), type);
+    ELLLIST *pclientList;
+    int i, index;
+    int started = 0;
+
+    for (i = 0; i < nChanged; i++) {
+        index = this->flags[i];
+        if (this->vals[index]->type != type) continue;
+        if (!interruptPvt) return asynParamNotFound;
+        if (!started) {
+            pasynManager->interruptStart(interruptPvt, &pclientList);
+            started = 1;
+        }
+        switch(type) {
+            case asynParamInt32:
+                this->numCallbacksLast += int32Callback(index, addr, pTimeStamp);
+                break;
+            case asynParamUInt32Digital:
+                this->numCallbacksLast += uint32Callback(index, addr, this->vals[index]->uInt32CallbackMask,
+                                                         pTimeStamp);
+                this->vals[index]->uInt32CallbackMask = 0;
+                break;
+            case asynParamFloat64:
+                this->numCallbacksLast += float64Callback(index, addr, pTimeStamp);
+                break;
+            case asynParamOctet:
+                this->numCallbacksLast += octetCallback(index, addr, pTimeStamp);
+                break;
+            default:
+                break;
         }
-        pnode = (interruptNode *)ellNext(&pnode->node);
     }
-    pasynManager->interruptEnd(pInterfaces->octetInterruptPvt);
-    return(asynSuccess);
+    if (started) pasynManager->interruptEnd(interruptPvt);
+    return asynSuccess;
 }
 
 /** Calls the registered asyn callback functions for all clients for any parameters that have changed
   * since the last time this function was called.
   * \param[in] addr A client will be called if addr matches the asyn address registered for that client.
   *
+  * The changed parameters are passed one interface at a time, in the order asynInt32, asynUInt32Digital,
+  * asynFloat64, asynOctet, so each interface's interrupt list is locked only once.  Within each interface
+  * the parameters are passed in the order in which they were first changed.
+  *
   * Don't do anything if interruptAccept=0.
   * There is a thread that will do all callbacks once when interruptAccept goes to 1.
   */
 asynStatus paramList::callCallbacks(int addr)
 {
-    int i, index;
+    static const asynParamType callbackTypes[] =
+        {asynParamInt32, asynParamUInt32Digital, asynParamFloat64, asynParamOctet};
+    int i, nChanged;
+    epicsTimeStamp timeStamp;
     asynStatus status = asynSuccess;
 
     if (!interruptAccept) return(asynSuccess);
 
-    try {
-        for (i = 0; i < this->nFlags; i++)
-        {
-            index = this->flags[i];
-            if (!getParameter(index)->isDefined()) return status;
-            switch(getParameter(index)->type) {
-                case asynParamInt32:
-                    status = int32Callback(index, addr);
-                    break;
-                case asynParamUInt32Digital:
-                    status = uint32Callback(index, addr, this->vals[index]->uInt32CallbackMask);
-                    this->vals[index]->uInt32CallbackMask = 0;
-                    break;
-                case asynParamFloat64:
-                    status = float64Callback(index, addr);
-                    break;
-                case asynParamOctet:
-                    status = octetCallback(index, addr);
-                    break;
-                default:
-                    break;
-            }
-        }
-    }
-    catch (ParamListInvalidIndex&) {
-        return asynParamBadIndex;
+    /* Callbacks stop at the first changed parameter that is undefined; the flags are not cleared in that case */
+    for (nChanged = 0; nChanged < this->nFlags; nChanged++) {
+        if (!this->vals[this->flags[nChanged]]->isDefined()) break;
     }
-    this->nFlags=0;
+    this->pasynPortDriver->getTimeStamp(&timeStamp);
+    this->numParamsLast = nChanged;
+    this->numCallbacksLast = 0;
+    for (i = 0; i < (int)(sizeof(callbackTypes)/sizeof(callbackTypes[0])); i++) {
+        if (typeCallbacks(callbackTypes[i], nChanged, addr, &timeStamp) != asynSuccess)
+            status = asynParamNotFound;
+    }
+    this->numCallParamCallbacks++;
+    this->numCallbacksTotal += this->numCallbacksLast;
+    if (nChanged < this->nFlags) return status;
+    clearFlags();
     return(status);
 }
 
@@ -650,12 +724,23 @@ void paramList::report(FILE *fp, int details)
     int i;
 
     fprintf(fp, "Number of parameters is: %d\n", this->nVals );
+    fprintf(fp, "callParamCallbacks: %lu calls, %lu callbacks; last call %d parameters, %d callbacks\n",
+            this->numCallParamCallbacks, this->numCallbacksTotal, this->numParamsLast, this->numCallbacksLast);
     for (i=0; i<this->nVals; i++)
     {
         this->vals[i]->report(i, fp, details);
     }
 }
 
+/** Returns the callback counters for the most recent call to callCallbacks.
+  * \param[out] numParams Number of changed parameters that were passed to clients.
+  * \param[out] numCallbacks Number of client callbacks that were done. */
+void paramList::getCallbackCounts(int *numParams, int *numCallbacks)
+{
+    *numParams = this->numParamsLast;
+    *numCallbacks = this->numCallbacksLast;
+}
+
 /** Get a parameter from the list by index
  *  \param[in] index The index of the desired parameter in the list
  *  \return The parameter associated with the input index
@@ -1213,6 +1298,90 @@ asynStatus asynPortDriver::callParamCallbacks(int list, int addr)
     return this->params[list]->callCallbacks(addr);
 }
 
+/** Returns the callback counters for the most recent callParamCallbacks on parameter list 0.
+  * Calls getParamCallbackCounts(0, numParams, numCallbacks). */
+asynStatus asynPortDriver::getParamCallbackCounts(int *numParams, int *numCallbacks)
+{
+    return this->getParamCallbackCounts(0, numParams, numCallbacks);
+}
+
+/** Returns the callback counters for the most recent callParamCallbacks on a parameter list.
+  * High-rate drivers can use these to monitor the cost of their callbacks.
+  * \param[in] list The parameter list number.  Must be < maxAddr passed to asynPortDriver::asynPortDriver.
+  * \param[out] numParams The number of changed parameters that were passed to clients.
+  * \param[out] numCallbacks The number of client callbacks that were done.
+  * \return Returns asynParamBadIndex if the list is not valid. */
+asynStatus asynPortDriver::getParamCallbackCounts(int list, int *numParams, int *numCallbacks)
+{
+    if (list < 0 || list >= this->maxAddr) return asynParamBadIndex;
+    this->params[list]->getCallbackCounts(numParams, numCallbacks);
+    return asynSuccess;
+}
+
+/** Creates asynInt32 parameters in all parameter lists for the asynManager queue statistics
+  * of this port.  The parameters are ASYN_QUEUE_WAIT_0 to ASYN_QUEUE_WAIT_7 and
+  * ASYN_SERVICE_TIME_0 to ASYN_SERVICE_TIME_7, the counts in the time histogram bins
+  * <10us, <100us, ..., <10s, >=10s, and ASYN_QUEUE_TIMEOUTS and ASYN_QUEUE_CANCELS.
+  * paramTableSize passed to asynPortDriver::asynPortDriver must allow for
+  * ASYN_QUEUE_STATISTICS_NUM_PARAMS more parameters.
+  * readInt32 updates the parameters from asynManager when they are read, so records
+  * can periodically scan them.  Queue wait and service times are only recorded after
+  * pasynManager->enableQueueStatistics or the asynEnableQueueStatistics iocsh command. */
+asynStatus asynPortDriver::createQueueStatisticsParams()
+{
+    char name[40];
+    int i, index;
+    asynStatus status;
+
+    if (this->queueStatisticsUsers) return asynError;
+    /* One asynUser per list, so readInt32 does not create one for each read */
+    this->queueStatisticsUsers = (asynUser **)callocMustSucceed(this->maxAddr, sizeof(asynUser *),
+                                                                "asynPortDriver::createQueueStatisticsParams");
+    for (i=0; i<this->maxAddr; i++) {
+        this->queueStatisticsUsers[i] = pasynManager->createAsynUser(0, 0);
+        status = pasynManager->connectDevice(this->queueStatisticsUsers[i], this->portName, i);
+        if (status) return status;
+    }
+    for (i=0; i<ASYN_QUEUE_STATISTICS_NUM_PARAMS; i++) {
+        if (i < ASYN_QUEUE_STATISTICS_BINS)
+            epicsSnprintf(name, sizeof(name), "ASYN_QUEUE_WAIT_%d", i);
+        else if (i < 2*ASYN_QUEUE_STATISTICS_BINS)
+            epicsSnprintf(name, sizeof(name), "ASYN_SERVICE_TIME_%d", i-ASYN_QUEUE_STATISTICS_BINS);
+        else if (i == 2*ASYN_QUEUE_STATISTICS_BINS)
+            strcpy(name, "ASYN_QUEUE_TIMEOUTS");
+        else
+            strcpy(name, "ASYN_QUEUE_CANCELS");
+        status = createParam(name, asynParamInt32, &index);
+        if (status) return status;
+        if (i == 0) this->firstQueueStatisticsParam = index;
+    }
+    for (i=0; i<this->maxAddr; i++) updateQueueStatisticsParams(i);
+    return asynSuccess;
+}
+
+/** Copies the asynManager queue statistics into the parameters created by createQueueStatisticsParams.
+  * For ASYN_MULTIDEVICE ports these are the statistics of device addr=list, otherwise
+  * those of the port.  Does not call callParamCallbacks.
+  * \param[in] list The parameter list number.  Must be < maxAddr passed to asynPortDriver::asynPortDriver. */
+asynStatus asynPortDriver::updateQueueStatisticsParams(int list)
+{
+    asynQueueStatistics statistics;
+    int i, param = this->firstQueueStatisticsParam;
+    asynStatus status;
+
+    if (param < 0) return asynError;
+    if (list < 0 || list >= this->maxAddr) return asynParamBadIndex;
+    status = pasynManager->getQueueStatistics(this->queueStatisticsUsers[list], &statistics, 0);
+    if (status) return status;
+    for (i=0; i<ASYN_QUEUE_STATISTICS_BINS; i++) {
+        setIntegerParam(list, param + i, (int)statistics.queueWait[i]);
+        setIntegerParam(list, param + ASYN_QUEUE_STATISTICS_BINS + i, (int)statistics.service[i]);
+    }
+    setIntegerParam(list, param + 2*ASYN_QUEUE_STATISTICS_BINS, (int)statistics.numberTimeouts);
+    setIntegerParam(list, param + 2*ASYN_QUEUE_STATISTICS_BINS + 1, (int)statistics.numberCancels);
+    return asynSuccess;
+}
+
 /** Calls paramList::report(fp, details) for each parameter list that the driver supports. 
   * \param[in] fp The file pointer on which report information will be written
   * \param[in] details The level of report detail desired; always report details on address 0; >=2 report all addresses */
@@ -1254,27 +1423,20 @@ asynStatus asynPortDriver::doCallbacksArray(epicsType *value, size_t nElements,
     interruptNode *pnode;
     asynStatus status;
     epicsTimeStamp timeStamp; getTimeStamp(&timeStamp);
-    int addr;
 
     pasynManager->interruptStart(interruptPvt, &pclientList);
-    pnode = (interruptNode *)ellFirst(pclientList);
+    pnode = firstInterruptClient(interruptPvt, reason, address);
     getParamStatus(address, reason, &status);
     while (pnode) {
         interruptType *pInterrupt = (interruptType *)pnode->drvPvt;
-        pasynManager->getAddr(pInterrupt->pasynUser, &addr);
-        /* If this is not a multi-device then address is -1, change to 0 */
-        if (addr == -1) addr = 0;
-        if ((pInterrupt->pasynUser->reason == reason) &&
-            (address == addr)) {
-            /* Set the status for the callback */
-            pInterrupt->pasynUser->auxStatus = status;
-            /* Set the timestamp for the callback */
-            pInterrupt->pasynUser->timestamp = timeStamp;
-            pInterrupt->callback(pInterrupt->userPvt,
-                                 pInterrupt->pasynUser,
-                                 value, nElements);
-        }
-        pnode = (interruptNode *)ellNext(&pnode->node);
+        /* Set the status for the callback */
+        pInterrupt->pasynUser->auxStatus = status;
+        /* Set the timestamp for the callback */
+        pInterrupt->pasynUser->timestamp = timeStamp;
+        pInterrupt->callback(pInterrupt->userPvt,
+                             pInterrupt->pasynUser,
+                             value, nElements);
+        pnode = nextInterruptClient(pnode);
     }
     pasynManager->interruptEnd(interruptPvt);
     return(asynSuccess);
@@ -1356,6 +1518,11 @@ asynStatus asynPortDriver::readInt32(asynUser *pasynUser, epicsInt32 *value)
     static const char *functionName = "readInt32";
     
     status = getAddress(pasynUser, &addr); if (status != asynSuccess) return(status);
+    /* The queue statistics are kept by asynManager, so they are copied when read */
+    if ((this->firstQueueStatisticsParam >= 0) &&
+        (function >= this->firstQueueStatisticsParam) &&
+        (function < this->firstQueueStatisticsParam + ASYN_QUEUE_STATISTICS_NUM_PARAMS))
+        updateQueueStatisticsParams(addr);
     /* We just read the current value of the parameter from the parameter library.
      * Those values are updated whenever anything could cause them to change */
     status = (asynStatus) getIntegerParam(addr, function, value);
@@ -2374,26 +2541,20 @@ asynStatus asynPortDriver::doCallbacksGenericPointer(void *genericPointer, int r
     ELLLIST *pclientList;
     interruptNode *pnode;
     epicsTimeStamp timeStamp; getTimeStamp(&timeStamp);
-    int addr;
+    void *interruptPvt = this->asynStdInterfaces.genericPointerInterruptPvt;
 
-    pasynManager->interruptStart(this->asynStdInterfaces.genericPointerInterruptPvt, &pclientList);
-    pnode = (interruptNode *)ellFirst(pclientList);
+    pasynManager->interruptStart(interruptPvt, &pclientList);
+    pnode = firstInterruptClient(interruptPvt, reason, address);
     while (pnode) {
         asynGenericPointerInterrupt *pInterrupt = (asynGenericPointerInterrupt *)pnode->drvPvt;
-        pasynManager->getAddr(pInterrupt->pasynUser, &addr);
-        /* If this is not a multi-device then address is -1, change to 0 */
-        if (addr == -1) addr = 0;
-        if ((pInterrupt->pasynUser->reason == reason) &&
-            (address == addr)) {
-            /* Set the status for the callback */
-            // PROBLEM - WE DON'T HAVE A WAY TO STORE THE STATUS EXCEPT IN PARAMETER LIST
-            /* Set the timestamp for the callback */
-            pInterrupt->pasynUser->timestamp = timeStamp;
-            pInterrupt->callback(pInterrupt->userPvt,
-                                 pInterrupt->pasynUser,
-                                 genericPointer);
-        }
-        pnode = (interruptNode *)ellNext(&pnode->node);
+        /* Set the status for the callback */
+        // PROBLEM - WE DON'T HAVE A WAY TO STORE THE STATUS EXCEPT IN PARAMETER LIST
+        /* Set the timestamp for the callback */
+        pInterrupt->pasynUser->timestamp = timeStamp;
+        pInterrupt->callback(pInterrupt->userPvt,
+                             pInterrupt->pasynUser,
+                             genericPointer);
+        pnode = nextInterruptClient(pnode);
     }
     pasynManager->interruptEnd(this->asynStdInterfaces.genericPointerInterruptPvt);
     return(asynSuccess);
@@ -2518,22 +2679,16 @@ asynStatus asynPortDriver::doCallbacksEnum(char *strings[], int values[], int se
 {
     ELLLIST *pclientList;
     interruptNode *pnode;
-    int addr;
+    void *interruptPvt = this->asynStdInterfaces.enumInterruptPvt;
 
-    pasynManager->interruptStart(this->asynStdInterfaces.enumInterruptPvt, &pclientList);
-    pnode = (interruptNode *)ellFirst(pclientList);
+    pasynManager->interruptStart(interruptPvt, &pclientList);
+    pnode = firstInterruptClient(interruptPvt, reason, address);
     while (pnode) {
         asynEnumInterrupt *pInterrupt = (asynEnumInterrupt *)pnode->drvPvt;
-        pasynManager->getAddr(pInterrupt->pasynUser, &addr);
-        /* If this is not a multi-device then address is -1, change to 0 */
-        if (addr == -1) addr = 0;
-        if ((pInterrupt->pasynUser->reason == reason) &&
-            (address == addr)) {
-            pInterrupt->callback(pInterrupt->userPvt,
-                                 pInterrupt->pasynUser,
-                                 strings, values, severities, nElements);
-        }
-        pnode = (interruptNode *)ellNext(&pnode->node);
+        pInterrupt->callback(pInterrupt->userPvt,
+                             pInterrupt->pasynUser,
+                             strings, values, severities, nElements);
+        pnode = nextInterruptClient(pnode);
     }
     pasynManager->interruptEnd(this->asynStdInterfaces.enumInterruptPvt);
     return(asynSuccess);
@@ -2918,6 +3073,8 @@ asynPortDriver::asynPortDriver(const char *portNameIn, int maxAddrIn, int paramT
     memset(pInterfaces, 0, sizeof(asynStdInterfaces));
         
     this->portName = epicsStrDup(portNameIn);
+    this->firstQueueStatisticsParam = -1;
+    this->queueStatisticsUsers = 0;
     if (maxAddrIn < 1) maxAddrIn = 1;
     this->maxAddr = maxAddrIn;
     interfaceMask |= asynCommonMask;  /* Always need the asynCommon interface */
@@ -3032,6 +3189,14 @@ asynPortDriver::~asynPortDriver()
         delete this->params[addr];
     }
     free(this->params);
+    if (this->queueStatisticsUsers) {
+        for (addr=0; addr<this->maxAddr; addr++) {
+            if (!this->queueStatisticsUsers[addr]) continue;
+            pasynManager->disconnect(this->queueStatisticsUsers[addr]);
+            pasynManager->freeAsynUser(this->queueStatisticsUsers[addr]);
+        }
+        free(this->queueStatisticsUsers);
+    }
 }
 
 /** Utility function that returns a pointer to an asynPortDriver object from its name */
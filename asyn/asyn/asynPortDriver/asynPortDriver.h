@@ -30,6 +30,9 @@ typedef void (*userTimeStampFunction)(void *userPvt, epicsTimeStamp *pTimeStamp)
 #define asynGenericPointerMask  0x00001000
 #define asynEnumMask            0x00002000
 
+/** Number of parameters created by asynPortDriver::createQueueStatisticsParams */
+#define ASYN_QUEUE_STATISTICS_NUM_PARAMS (2*ASYN_QUEUE_STATISTICS_BINS + 2)
+
 
 
 /** Base class for asyn port drivers; handles most of the bookkeeping for writing an asyn port driver
@@ -147,6 +150,10 @@ public:
     virtual asynStatus callParamCallbacks();
     virtual asynStatus callParamCallbacks(          int addr);
     virtual asynStatus callParamCallbacks(int list, int addr);
+    virtual asynStatus getParamCallbackCounts(          int *numParams, int *numCallbacks);
+    virtual asynStatus getParamCallbackCounts(int list, int *numParams, int *numCallbacks);
+    virtual asynStatus createQueueStatisticsParams();
+    virtual asynStatus updateQueueStatisticsParams(int list);
     virtual asynStatus updateTimeStamp();
     virtual asynStatus updateTimeStamp(epicsTimeStamp *pTimeStamp);
     virtual asynStatus getTimeStamp(epicsTimeStamp *pTimeStamp);
@@ -170,6 +177,8 @@ private:
     int inputEosLenOctet;
     char *outputEosOctet;
     int outputEosLenOctet;
+    int firstQueueStatisticsParam;
+    asynUser **queueStatisticsUsers;
     template <typename epicsType, typename interruptType> 
         asynStatus doCallbacksArray(epicsType *value, size_t nElements,
                                     int reason, int address, void *interruptPvt);
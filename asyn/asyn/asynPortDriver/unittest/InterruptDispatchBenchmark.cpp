@@ -0,0 +1,115 @@
+/*
+ * InterruptDispatchBenchmark.cpp
+ *
+ * Times callParamCallbacks on a port with many asynInt32 interrupt clients,
+ * i.e. many I/O Intr records each subscribed to its own parameter.
+ *
+ ***************************************************************************
+ * This file is distributed subject to a Software License Agreement found  *
+ * in the file LICENSE that is included with this distribution.            *
+ ***************************************************************************
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include <epicsTime.h>
+/* NOTE: This is needed for interruptAccept */
+#include <dbAccess.h>
+#include <asynInt32.h>
+#include "asynPortDriver.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#define NUM_PARAMS  10000
+#define NUM_CHANGED 100
+#define NUM_LOOPS   100
+#define PORT_NAME   "INTR_BENCH"
+
+static int callbackCount[NUM_PARAMS];
+
+static void int32Callback(void *userPvt, asynUser *pasynUser, epicsInt32 value)
+{
+    int *pcount = (int *)userPvt;
+    (*pcount)++;
+}
+
+static double elapsed(epicsTimeStamp *start)
+{
+    epicsTimeStamp now;
+    epicsTimeGetCurrent(&now);
+    return epicsTimeDiffInSeconds(&now, start);
+}
+
+/* Registers one asynInt32 interrupt client per parameter, as devAsynInt32 does for SCAN=I/O Intr */
+static int registerClients()
+{
+    asynUser *pasynUser;
+    asynInterface *pasynInterface;
+    asynInt32 *pasynInt32;
+    void *registrarPvt;
+    int i, nBad=0;
+
+    for (i=0; i<NUM_PARAMS; i++) {
+        pasynUser = pasynManager->createAsynUser(0, 0);
+        if (pasynManager->connectDevice(pasynUser, PORT_NAME, 0)) { nBad++; continue; }
+        pasynInterface = pasynManager->findInterface(pasynUser, asynInt32Type, 1);
+        if (!pasynInterface) { nBad++; continue; }
+        pasynInt32 = (asynInt32 *)pasynInterface->pinterface;
+        pasynUser->reason = i;
+        if (pasynInt32->registerInterruptUser(pasynInterface->drvPvt, pasynUser, int32Callback,
+                                              &callbackCount[i], &registrarPvt)) nBad++;
+    }
+    return nBad;
+}
+
+MAIN(InterruptDispatchBenchmark)
+{
+    epicsTimeStamp start;
+    asynPortDriver *pPort;
+    char name[20];
+    int i, loop, index, total;
+    int nBad=0;
+    double callbackTime;
+
+    testPlan(3);
+    interruptAccept = 1;
+
+    pPort = new asynPortDriver(PORT_NAME, 1, NUM_PARAMS,
+                               asynInt32Mask | asynDrvUserMask, asynInt32Mask,
+                               0, 1, 0, 0);
+    for (i=0; i<NUM_PARAMS; i++) {
+        sprintf(name, "INTR_PARAM_%d", i);
+        if (pPort->createParam(name, asynParamInt32, &index)) nBad++;
+    }
+    nBad += registerClients();
+    testOk(nBad == 0, "registered %d interrupt clients", NUM_PARAMS);
+
+    /* Change a few parameters per call, which is the common case for a polling driver */
+    epicsTimeGetCurrent(&start);
+    for (loop=1; loop<=NUM_LOOPS; loop++) {
+        pPort->lock();
+        for (i=0; i<NUM_CHANGED; i++) pPort->setIntegerParam((loop*NUM_CHANGED + i) % NUM_PARAMS, loop);
+        pPort->callParamCallbacks();
+        pPort->unlock();
+    }
+    callbackTime = elapsed(&start);
+    for (i=0, total=0; i<NUM_PARAMS; i++) total += callbackCount[i];
+    testOk(total == NUM_LOOPS*NUM_CHANGED, "%d callbacks for %d parameter changes", total, NUM_LOOPS*NUM_CHANGED);
+    testDiag("%d x callParamCallbacks with %d changed parameters, %d clients: %f sec (%f usec/callback)",
+             NUM_LOOPS, NUM_CHANGED, NUM_PARAMS, callbackTime, callbackTime*1e6/(NUM_LOOPS*NUM_CHANGED));
+
+    /* Change every parameter at once */
+    memset(callbackCount, 0, sizeof(callbackCount));
+    epicsTimeGetCurrent(&start);
+    pPort->lock();
+    for (i=0; i<NUM_PARAMS; i++) pPort->setIntegerParam(i, -1);
+    pPort->callParamCallbacks();
+    pPort->unlock();
+    callbackTime = elapsed(&start);
+    for (i=0, nBad=0; i<NUM_PARAMS; i++) if (callbackCount[i] != 1) nBad++;
+    testOk(nBad == 0, "each of %d clients called exactly once", NUM_PARAMS);
+    testDiag("callParamCallbacks with %d changed parameters, %d clients: %f sec",
+             NUM_PARAMS, NUM_PARAMS, callbackTime);
+
+    return testDone();
+}
@@ -0,0 +1,75 @@
+/*
+ * ParamListBenchmark.cpp
+ *
+ * Times creating and looking up a large number of parameters in the
+ * asynPortDriver parameter library.
+ *
+ ***************************************************************************
+ * This file is distributed subject to a Software License Agreement found  *
+ * in the file LICENSE that is included with this distribution.            *
+ ***************************************************************************
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include <epicsTime.h>
+#include "asynPortDriver.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#define NUM_PARAMS 10000
+#define NUM_ADDR   4
+
+static char paramNames[NUM_PARAMS][20];
+
+static double elapsed(epicsTimeStamp *start)
+{
+    epicsTimeStamp now;
+    epicsTimeGetCurrent(&now);
+    return epicsTimeDiffInSeconds(&now, start);
+}
+
+MAIN(ParamListBenchmark)
+{
+    epicsTimeStamp start;
+    asynPortDriver *pPort;
+    int i, index;
+    int nBadCreate=0, nBadFind=0;
+    double createTime, findTime;
+
+    testPlan(4);
+    for (i=0; i<NUM_PARAMS; i++) sprintf(paramNames[i], "BENCH_PARAM_%d", i);
+
+    pPort = new asynPortDriver("PARAM_BENCH", NUM_ADDR, NUM_PARAMS,
+                               asynInt32Mask | asynDrvUserMask, asynInt32Mask,
+                               ASYN_MULTIDEVICE, 1, 0, 0);
+
+    /* Creating a parameter adds it to every address, so this is NUM_PARAMS*NUM_ADDR inserts */
+    epicsTimeGetCurrent(&start);
+    for (i=0; i<NUM_PARAMS; i++) {
+        if (pPort->createParam(paramNames[i], asynParamInt32, &index) ||
+            (index != i)) nBadCreate++;
+    }
+    createTime = elapsed(&start);
+    testOk(nBadCreate == 0, "created %d parameters on %d addresses", NUM_PARAMS, NUM_ADDR);
+    testDiag("createParam: %d parameters in %f sec (%f usec/param)",
+             NUM_PARAMS, createTime, createTime*1e6/NUM_PARAMS);
+
+    /* Look every parameter up in every list, as drvUserCreate does for each record at iocInit */
+    epicsTimeGetCurrent(&start);
+    for (i=0; i<NUM_PARAMS*NUM_ADDR; i++) {
+        if (pPort->findParam(i%NUM_ADDR, paramNames[i/NUM_ADDR], &index) ||
+            (index != i/NUM_ADDR)) nBadFind++;
+    }
+    findTime = elapsed(&start);
+    testOk(nBadFind == 0, "found %d parameters", NUM_PARAMS*NUM_ADDR);
+    testDiag("findParam: %d lookups in %f sec (%f usec/lookup)",
+             NUM_PARAMS*NUM_ADDR, findTime, findTime*1e6/(NUM_PARAMS*NUM_ADDR));
+
+    testOk(pPort->findParam("NO_SUCH_PARAM", &index) != asynSuccess,
+           "unknown parameter is not found");
+    testOk(pPort->createParam(paramNames[0], asynParamInt32, &index) != asynSuccess,
+           "duplicate parameter is rejected");
+
+    return testDone();
+}
@@ -6,289 +6,263 @@
  * EPICS BASE is distributed subject to a Software License Agreement found
  * in file LICENSE that is included with this distribution.
  \*************************************************************************/
-
+/*
+ * ParamListTest.cpp
+ *
+ * Tests of the asynPortDriver parameter library.  The paramList class is
+ * private to asynPortDriver.cpp, so these go through the asynPortDriver methods
+ * and observe callbacks with asynInt32 interrupt clients.
+ */
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+/* NOTE: This is needed for interruptAccept */
+#include <dbAccess.h>
+#include <asynInt32.h>
 #include "asynPortDriver.h"
-#include "ParamVal.h"
-#include "ParamListInvalidIndex.h"
-#include "ParamValInvalidMethod.h"
 #include "epicsUnitTest.h"
 #include "testMain.h"
-const char PARAM1[] = "PARAM1";
-const char PARAM2[] = "PARAM2";
-const char PARAM3[] = "PARAM3";
-const char PARAM4[] = "PARAM4";
-const char PARAM5[] = "PARAM5";
-const char PARAM6[] = "PARAM6";
-const char PARAM7[] = "PARAM7";
-const char PARAM8[] = "PARAM8";
-const char PARAM9[] = "PARAM9";
-const char PARAM10[] = "PARAM10";
-const char PARAM11[] = "PARAM11";
-const char paramListPassMessage[] =
-    "ParamList::%s for index %d should have passed";
-const char paramListFailMessage[] =
-    "ParamList::%s for index %d should have failed";
-const char paramListFailWrongReasonMessage[] =
-    "ParamList::%s for index %d should have failed, "
-      "but failed for the wrong reason";
 
-void testCreateParam(const char *paramName, paramList *pList,
-    asynParamType pType, asynStatus expResult, int expIndex)
-{
-  int index = -999;
-  asynStatus status;
-  status = pList->createParam(paramName, pType, &index);
+#define PORT_NAME  "PARAM_LIST_TEST"
+/* More than one 32-bit word of change flags */
+#define NUM_PARAMS 70
+#define MAX_CALLBACKS (4*NUM_PARAMS)
 
-  bool result = (status == expResult);
-  testOk(result, "Create param %s", paramName);
-  if (result)
-    testOk(index == expIndex, " Parameter index %d expected %d", index,
-        expIndex);
-}
+static int callbackOrder[MAX_CALLBACKS];
+static int numCallbacks;
 
-void testCreateParams(paramList *pList)
+static void int32Callback(void *userPvt, asynUser *pasynUser, epicsInt32 value)
 {
-  testCreateParam(PARAM1, pList, asynParamInt32, asynSuccess, 0);
-  testCreateParam(PARAM1, pList, asynParamInt32, asynParamAlreadyExists, 0);
-  testCreateParam(PARAM2, pList, asynParamUInt32Digital, asynSuccess, 1);
-  testCreateParam(PARAM3, pList, asynParamFloat64, asynSuccess, 2);
-  testCreateParam(PARAM4, pList, asynParamOctet, asynSuccess, 3);
-  testCreateParam(PARAM5, pList, asynParamInt8Array, asynSuccess, 4);
-  testCreateParam(PARAM6, pList, asynParamInt16Array, asynSuccess, 5);
-  testCreateParam(PARAM7, pList, asynParamInt32Array, asynSuccess, 6);
-  testCreateParam(PARAM8, pList, asynParamFloat32Array, asynSuccess, 7);
-  testCreateParam(PARAM9, pList, asynParamFloat64Array, asynSuccess, 8);
-  testCreateParam(PARAM10, pList, asynParamGenericPointer, asynSuccess, 9);
-  testCreateParam(PARAM11, pList, asynParamGenericPointer, asynParamBadIndex,
-      10);
-  testCreateParam(PARAM11, pList, asynParamGenericPointer, asynParamBadIndex,
-      10);
+    if (numCallbacks < MAX_CALLBACKS) callbackOrder[numCallbacks] = pasynUser->reason;
+    numCallbacks++;
 }
 
-void testGetParam(paramList *pList, int index, bool expectToPass)
+static int registerClients()
 {
-  const char getParamString[] = "getParam";
-  if (expectToPass)
-  {
-    try
-    {
-      pList->getParam(index);
-      testPass(paramListPassMessage, getParamString, index);
-    } catch (ParamListInvalidIndex&)
-    {
-      testFail(paramListPassMessage, getParamString, index);
-    }
-  }
-  else
-  {
-    try
-    {
-      pList->getParam(index);
-      testFail(paramListFailMessage, getParamString, index);
-    } catch (ParamListInvalidIndex&)
-    {
-      testPass(paramListFailMessage, getParamString, index);
+    asynUser *pasynUser;
+    asynInterface *pasynInterface;
+    asynInt32 *pasynInt32;
+    void *registrarPvt;
+    int i, nBad=0;
+
+    for (i=0; i<NUM_PARAMS; i++) {
+        pasynUser = pasynManager->createAsynUser(0, 0);
+        if (pasynManager->connectDevice(pasynUser, PORT_NAME, 0)) { nBad++; continue; }
+        pasynInterface = pasynManager->findInterface(pasynUser, asynInt32Type, 1);
+        if (!pasynInterface) { nBad++; continue; }
+        pasynInt32 = (asynInt32 *)pasynInterface->pinterface;
+        pasynUser->reason = i;
+        if (pasynInt32->registerInterruptUser(pasynInterface->drvPvt, pasynUser, int32Callback,
+                                              0, &registrarPvt)) nBad++;
     }
-  }
+    return nBad;
 }
 
-void testGetParams(paramList *pList)
+/* Sets the parameters in order, calls callbacks, and checks that they were called in expected order */
+static void testCallbackOrder(asynPortDriver *pPort, const char *test,
+                              const int *set, int nSet, const int *expected, int nExpected)
 {
-  testGetParam(pList, 0, true);
-  testGetParam(pList, 1, true);
-  testGetParam(pList, 2, true);
-  testGetParam(pList, 3, true);
-  testGetParam(pList, 4, true);
-  testGetParam(pList, 5, true);
-  testGetParam(pList, 6, true);
-  testGetParam(pList, 7, true);
-  testGetParam(pList, 8, true);
-  testGetParam(pList, 9, true);
-  testGetParam(pList, 10, false);
+    int i, ok;
+    static int value;
+
+    value++;
+    numCallbacks = 0;
+    pPort->lock();
+    for (i=0; i<nSet; i++) {
+        /* Setting the same parameter twice with different values must still flag it only once */
+        pPort->setIntegerParam(set[i], value*1000 + i);
+    }
+    pPort->callParamCallbacks();
+    pPort->unlock();
+    ok = (numCallbacks == nExpected);
+    for (i=0; ok && i<nExpected; i++) ok = (callbackOrder[i] == expected[i]);
+    testOk(ok, "%s: %d callbacks, expected %d", test, numCallbacks, nExpected);
+    if (!ok) {
+        for (i=0; i<numCallbacks && i<MAX_CALLBACKS; i++)
+            testDiag("  callback %d reason=%d", i, callbackOrder[i]);
+    }
 }
 
-void tesstFindParams(const char *paramName, paramList *pList,
-    asynStatus expStatus, int expIndex)
+static void testCreateAndFind(asynPortDriver *pPort)
 {
-  asynStatus status;
-  int index = -999;
-  status = pList->findParam(paramName, &index);
-  testOk(status == expStatus, "Trying to find parameter %s", paramName);
-  if (status == expStatus)
-    testOk(index == expIndex, "Comparing index and expected index %d, %d",
-        index, expIndex);
+    char name[20];
+    const char *pName;
+    int i, index, nBad;
+    int value;
 
+    for (i=0, nBad=0; i<NUM_PARAMS; i++) {
+        sprintf(name, "PARAM%d", i);
+        if (pPort->createParam(name, asynParamInt32, &index) || (index != i)) nBad++;
+    }
+    testOk(nBad == 0, "createParam for %d parameters", NUM_PARAMS);
+    testOk(pPort->createParam("PARAM0", asynParamInt32, &index) != asynSuccess,
+           "createParam for existing parameter fails");
+
+    for (i=NUM_PARAMS-1, nBad=0; i>=0; i--) {
+        sprintf(name, "PARAM%d", i);
+        if (pPort->findParam(name, &index) || (index != i)) nBad++;
+    }
+    testOk(nBad == 0, "findParam for %d parameters", NUM_PARAMS);
+    testOk(pPort->findParam("PARAM_NONE", &index) != asynSuccess,
+           "findParam for unknown parameter fails");
+
+    testOk(pPort->getParamName(NUM_PARAMS-1, &pName) == asynSuccess &&
+           strcmp(pName, "PARAM69") == 0, "getParamName for last parameter");
+    testOk(pPort->getParamName(NUM_PARAMS, &pName) != asynSuccess,
+           "getParamName for bad index fails");
+
+    testOk(pPort->setIntegerParam(3, 42) == asynSuccess &&
+           pPort->getIntegerParam(3, &value) == asynSuccess && value == 42,
+           "setIntegerParam/getIntegerParam");
+    testOk(pPort->setIntegerParam(NUM_PARAMS, 42) != asynSuccess,
+           "setIntegerParam for bad index fails");
+    testOk(pPort->setDoubleParam(3, 1.0) != asynSuccess,
+           "setDoubleParam for asynParamInt32 parameter fails");
 }
 
-void testFindParams(paramList *pList)
+static void testChangeSet(asynPortDriver *pPort)
 {
-  tesstFindParams(PARAM1, pList, asynSuccess, 0);
-  tesstFindParams(PARAM2, pList, asynSuccess, 1);
-  tesstFindParams(PARAM3, pList, asynSuccess, 2);
-  tesstFindParams(PARAM4, pList, asynSuccess, 3);
-  tesstFindParams(PARAM5, pList, asynSuccess, 4);
-  tesstFindParams(PARAM6, pList, asynSuccess, 5);
-  tesstFindParams(PARAM7, pList, asynSuccess, 6);
-  tesstFindParams(PARAM8, pList, asynSuccess, 7);
-  tesstFindParams(PARAM9, pList, asynSuccess, 8);
-  tesstFindParams(PARAM10, pList, asynSuccess, 9);
-  tesstFindParams(PARAM11, pList, asynParamNotFound, 0);
+    int i;
+    int all[NUM_PARAMS], reversed[NUM_PARAMS];
+    const int order[]      = {5, 2, 8};
+    const int repeats[]    = {5, 2, 5, 8, 2, 5};
+    const int words[]      = {69, 0, 31, 32, 63, 64, 33};
+    const int wordsAgain[] = {33, 64, 0};
+    const int none[]       = {0};
+
+    /* Flush the changes made while creating the parameters */
+    pPort->lock();
+    pPort->callParamCallbacks();
+    pPort->unlock();
+
+    testCallbackOrder(pPort, "callbacks in order parameters were changed", order, 3, order, 3);
+    testCallbackOrder(pPort, "repeated changes give one callback", repeats, 6, order, 3);
+    testCallbackOrder(pPort, "no changes give no callbacks", none, 0, none, 0);
+    testCallbackOrder(pPort, "changes across flag words", words, 7, words, 7);
+    testCallbackOrder(pPort, "flags cleared after callbacks", wordsAgain, 3, wordsAgain, 3);
+    for (i=0; i<NUM_PARAMS; i++) {
+        all[i] = i;
+        reversed[i] = NUM_PARAMS-1-i;
+    }
+    testCallbackOrder(pPort, "every parameter changed", reversed, NUM_PARAMS, reversed, NUM_PARAMS);
+    testCallbackOrder(pPort, "every parameter changed again", all, NUM_PARAMS, all, NUM_PARAMS);
+
+    /* Setting a parameter to its current value does not flag it */
+    numCallbacks = 0;
+    pPort->lock();
+    pPort->setIntegerParam(7, 123);
+    pPort->callParamCallbacks();
+    pPort->setIntegerParam(7, 123);
+    pPort->callParamCallbacks();
+    pPort->unlock();
+    testOk(numCallbacks == 1, "unchanged value gives no callback");
 }
 
-void testGetName(int index, paramList *pList, asynStatus expStatus,
-    const char *expName)
+static void testCallbackCounts(asynPortDriver *pPort)
 {
-  asynStatus status;
-  const char *value;
-  status = pList->getName(index, &value);
-  testOk(status == expStatus, "Testing getName for index %d", index);
-  if (status == asynSuccess)
-    testOk((strcmp(value, expName) == 0),
-        "  Comparing retrieved:expected %s:%s", value, expName);
+    int numParams=-1, numCallbacks=-1;
+    const int order[] = {9, 1, 40};
 
+    testCallbackOrder(pPort, "callbacks for counters", order, 3, order, 3);
+    pPort->getParamCallbackCounts(&numParams, &numCallbacks);
+    testOk(numParams == 3 && numCallbacks == 3,
+           "callback counts for 3 changed parameters: %d parameters, %d callbacks", numParams, numCallbacks);
+    pPort->lock();
+    pPort->callParamCallbacks();
+    pPort->unlock();
+    pPort->getParamCallbackCounts(0, &numParams, &numCallbacks);
+    testOk(numParams == 0 && numCallbacks == 0,
+           "callback counts for no changed parameters: %d parameters, %d callbacks", numParams, numCallbacks);
+    testOk(pPort->getParamCallbackCounts(1, &numParams, &numCallbacks) != asynSuccess &&
+           pPort->getParamCallbackCounts(-1, &numParams, &numCallbacks) != asynSuccess,
+           "callback counts for bad list fail");
 }
 
-void testGetNames(paramList *pList)
+#define MULTI_PORT_NAME "PARAM_LIST_TEST_MULTI"
+#define NUM_ORDER_CLIENTS 6
+
+static int clientOrder[NUM_ORDER_CLIENTS+1];
+static int numClientCallbacks;
+
+static void orderCallback(void *userPvt, asynUser *pasynUser, epicsInt32 value)
 {
-  testGetName(0, pList, asynSuccess, PARAM1);
-  testGetName(1, pList, asynSuccess, PARAM2);
-  testGetName(2, pList, asynSuccess, PARAM3);
-  testGetName(3, pList, asynSuccess, PARAM4);
-  testGetName(4, pList, asynSuccess, PARAM5);
-  testGetName(5, pList, asynSuccess, PARAM6);
-  testGetName(6, pList, asynSuccess, PARAM7);
-  testGetName(7, pList, asynSuccess, PARAM8);
-  testGetName(8, pList, asynSuccess, PARAM9);
-  testGetName(9, pList, asynSuccess, PARAM10);
-  testGetName(10, pList, asynParamBadIndex, PARAM1);
+    if (numClientCallbacks < NUM_ORDER_CLIENTS+1)
+        clientOrder[numClientCallbacks] = (int)(size_t)userPvt;
+    numClientCallbacks++;
 }
 
-void testTryFailureMode(bool expectToPass, int expectedReason, int reason,
-    const char *method, int index)
+/* Clients of address -1 and 0 get callbacks for address 0 in the order they registered.
+ * A client that changes its reason after registering gets no callbacks. */
+static void testRegistrationOrder()
 {
-  if (!expectToPass && (reason == expectedReason))
-  {
-    testPass(paramListFailMessage, method, index);
-  }
-  else
-  {
-    if (reason == expectedReason)
-    {
-      testFail(paramListFailMessage, method, index);
-    }
-    else
-    {
-      testFail(paramListFailWrongReasonMessage, method, index);
-    }
+    asynPortDriver *pPort;
+    asynUser *pasynUser;
+    asynUser *pchanged = 0;
+    asynInterface *pasynInterface;
+    asynInt32 *pasynInt32;
+    void *registrarPvt;
+    const int addrs[NUM_ORDER_CLIENTS] = {-1, 0, -1, 1, 0, -1};
+    const int expected[] = {0, 1, 2, 4};
+    int i, index, nBad=0, ok;
 
-  }
-}
-void testSetInteger(int index, int value, paramList *pList, bool expectToPass,
-    int expectedReason)
-{
-  asynStatus status;
-  const char setIntegerString[] = "(ParamVal->setInteger)";
-  const char getIntegerString[] = "(ParamVal->getInteger)";
-  bool passedSet = false;
-  try
-  {
-    pList->getParam(index)->setInteger(value);
-    if (expectToPass)
-    {
-      testPass(paramListPassMessage, setIntegerString, index);
-      passedSet = true;
-    }
-    else
-    {
-      testFail(paramListPassMessage, setIntegerString, index);
+    pPort = new asynPortDriver(MULTI_PORT_NAME, 2, 2,
+                               asynInt32Mask | asynDrvUserMask, asynInt32Mask,
+                               ASYN_MULTIDEVICE, 1, 0, 0);
+    pPort->createParam("ORDER", asynParamInt32, &index);
+    pPort->createParam("OTHER", asynParamInt32, &index);
+    for (i=0; i<NUM_ORDER_CLIENTS; i++) {
+        pasynUser = pasynManager->createAsynUser(0, 0);
+        if (pasynManager->connectDevice(pasynUser, MULTI_PORT_NAME, addrs[i])) { nBad++; continue; }
+        pasynInterface = pasynManager->findInterface(pasynUser, asynInt32Type, 1);
+        if (!pasynInterface) { nBad++; continue; }
+        pasynInt32 = (asynInt32 *)pasynInterface->pinterface;
+        pasynUser->reason = 0;
+        if (pasynInt32->registerInterruptUser(pasynInterface->drvPvt, pasynUser, orderCallback,
+                                              (void *)(size_t)i, &registrarPvt)) nBad++;
+        pchanged = pasynUser;
     }
-  }
-  catch (ParamListInvalidIndex&)
-  {
-    int reason = 2;
-    testTryFailureMode(expectToPass, expectedReason, reason, setIntegerString,
-        index);
-  }
-  catch (ParamValInvalidMethod&)
-  {
-    int reason = 1;
-    testTryFailureMode(expectToPass, expectedReason, reason, setIntegerString,
-        index);
-  }
+    testOk(nBad == 0, "registered %d clients for address -1, 0 and 1", NUM_ORDER_CLIENTS);
+    /* The last client (address -1) moves to the other parameter */
+    pchanged->reason = 1;
 
-  if (expectToPass && passedSet)
-  {
-    int retVal = 32;
-    try
-    {
-      retVal = pList->getParam(index)->getInteger();
-      testPass(paramListPassMessage, getIntegerString, index);
-      testOk(retVal == value,
-          "Checking returned:expected Value for param %d, %d:%d",
-          index, retVal, value);
-    }
-    catch (ParamListInvalidIndex&)
-    {
-      int reason = 2;
-      testTryFailureMode(expectToPass, expectedReason, reason,
-          setIntegerString, index);
-    }
-    catch (ParamValInvalidMethod&)
-    {
-      int reason = 1;
-      testTryFailureMode(expectToPass, expectedReason, reason,
-          setIntegerString, index);
-    }
-  }
-}
+    numClientCallbacks = 0;
+    pPort->lock();
+    pPort->setIntegerParam(0, 0, 1);
+    pPort->setIntegerParam(0, 1, 1);
+    pPort->callParamCallbacks(0, 0);
+    pPort->unlock();
+    ok = (numClientCallbacks == 4);
+    for (i=0; ok && i<4; i++) ok = (clientOrder[i] == expected[i]);
+    testOk(ok, "callbacks for address 0 in registration order, %d callbacks", numClientCallbacks);
 
-void testSetIntegers(paramList *pList)
-{
-  testSetInteger(0, 5, pList, true, 0);
-  testSetInteger(0, -5, pList, true, 0);
-  testSetInteger(0, 0, pList, true, 0);
-  testSetInteger(0, -2147483648, pList, true, 0);
-  testSetInteger(0, 2147483647, pList, true, 0);
-  testSetInteger(1, 5, pList, false, 1);
-  testSetInteger(2, 5, pList, false, 1);
-  testSetInteger(3, 5, pList, false, 1);
-  testSetInteger(4, 5, pList, false, 1);
-  testSetInteger(5, 5, pList, false, 1);
-  testSetInteger(6, 5, pList, false, 1);
-  testSetInteger(7, 5, pList, false, 1);
-  testSetInteger(8, 5, pList, false, 1);
-  testSetInteger(9, 5, pList, false, 1);
-  testSetInteger(10, 5, pList, false, 2);
+    numClientCallbacks = 0;
+    pPort->lock();
+    pPort->setIntegerParam(0, 0, 2);
+    pPort->setIntegerParam(0, 1, 2);
+    pPort->setIntegerParam(1, 0, 2);
+    pPort->callParamCallbacks(0, 0);
+    pPort->callParamCallbacks(1, 1);
+    pPort->unlock();
+    testOk(numClientCallbacks == 5 && clientOrder[4] == 3,
+           "client with changed reason gets no callbacks, %d callbacks", numClientCallbacks);
 }
 
-MAIN(asynParamListTest)
+MAIN(ParamListTest)
 {
-  int numCreateTests = 26;
-  int numGetParamsTests = 11;
-  int numFindTests = 22;
-  int numGetNameTests = 21;
-  int numSetIntegerTests = 25;
+    asynPortDriver *pPort;
 
-  int totalTests = 0;
-  totalTests += numCreateTests;
-  totalTests += numGetParamsTests;
-  totalTests += numFindTests;
-  totalTests += numGetNameTests;
-  totalTests += numSetIntegerTests;
+    testPlan(25);
+    interruptAccept = 1;
 
-  asynStandardInterfaces asynStdInterfaces;
-  int nVals = 10;
-  paramList pList(nVals, &asynStdInterfaces);
+    pPort = new asynPortDriver(PORT_NAME, 1, NUM_PARAMS,
+                               asynInt32Mask | asynFloat64Mask | asynDrvUserMask, asynInt32Mask,
+                               0, 1, 0, 0);
+    testCreateAndFind(pPort);
+    testOk(registerClients() == 0, "registered %d interrupt clients", NUM_PARAMS);
+    testChangeSet(pPort);
+    testCallbackCounts(pPort);
+    testRegistrationOrder();
 
-  testPlan(totalTests);
-  testCreateParams(&pList);
-  testGetParams(&pList);
-  testFindParams(&pList);
-  testGetNames(&pList);
-  testSetIntegers(&pList);
-  testDone();
+    return testDone();
 }
@@ -20,7 +20,13 @@
 #include <alarm.h>
 #include <epicsAssert.h>
 #include <epicsString.h>
+#include <epicsMutex.h>
+#include <epicsThread.h>
+#include <ellLib.h>
+#include <gpHash.h>
 #include <cantProceed.h>
+#include <dbAccess.h>
+#include <dbStaticLib.h>
 
 #include <epicsExport.h>
 #include "asynEpicsUtils.h"
@@ -34,11 +40,29 @@ static asynStatus parseLinkFree(asynUser *pasynUser,
 static void asynStatusToEpicsAlarm(asynStatus status, 
                                    epicsAlarmCondition defaultStat, epicsAlarmCondition *pStat, 
                                    epicsAlarmSeverity defaultSevr, epicsAlarmSeverity *pSevr);
+static asynReadGroup *readGroupFind(const char *recordName, asynUser *pasynUser,
+                                    const char *interfaceType, epicsUInt32 mask);
+static int readGroupJoin(asynReadGroup *pgroup, asynReadWaiter *pwaiter);
+static void readGroupDone(asynReadGroup *pgroup,
+                          asynReadGroupCallback callback, void *leaderPvt);
 
 static asynEpicsUtils utils = {
-    parseLink,parseLinkMask,parseLinkFree,asynStatusToEpicsAlarm
+    parseLink,parseLinkMask,parseLinkFree,asynStatusToEpicsAlarm,
+    readGroupFind,readGroupJoin,readGroupDone
 };
 
+struct asynReadGroup {
+    char         *key; /*port addr reason mask interfaceType*/
+    epicsMutexId lock;
+    int          pending;
+    ELLLIST      waiterList;
+};
+
+#define READ_GROUP_HASH_SIZE 1024
+static struct gphPvt *readGroupHash;
+static epicsMutexId readGroupHashLock;
+static epicsThreadOnceId readGroupOnceId = EPICS_THREAD_ONCE_INIT;
+
 epicsShareDef asynEpicsUtils *pasynEpicsUtils = &utils;
 
 /* parseLink syntax is:
@@ -276,3 +300,78 @@ static void asynStatusToEpicsAlarm(asynStatus status,
             break;
     }
 }
+
+static void readGroupInit(void *arg)
+{
+    gphInitPvt(&readGroupHash, READ_GROUP_HASH_SIZE);
+    readGroupHashLock = epicsMutexMustCreate();
+}
+
+static asynReadGroup *readGroupFind(const char *recordName, asynUser *pasynUser,
+                                    const char *interfaceType, epicsUInt32 mask)
+{
+    DBENTRY       *pdbentry = dbAllocEntry(pdbbase);
+    const char    *coalesce = 0;
+    const char    *portName;
+    int           addr;
+    char          key[256];
+    GPHENTRY      *pentry;
+    asynReadGroup *pgroup;
+
+    if (dbFindRecord(pdbentry, recordName) == 0)
+        coalesce = dbGetInfo(pdbentry, "COALESCE");
+    if (coalesce) coalesce = (atoi(coalesce) ? coalesce : 0);
+    dbFreeEntry(pdbentry);
+    if (!coalesce) return 0;
+    if (pasynManager->getPortName(pasynUser, &portName) != asynSuccess) return 0;
+    if (pasynManager->getAddr(pasynUser, &addr) != asynSuccess) return 0;
+    epicsSnprintf(key, sizeof(key), "%s %d %d 0x%x %s", portName, addr,
+                  pasynUser->reason, mask, interfaceType);
+    epicsThreadOnce(&readGroupOnceId, readGroupInit, 0);
+    epicsMutexMustLock(readGroupHashLock);
+    pentry = gphFind(readGroupHash, key, NULL);
+    if (pentry) {
+        pgroup = (asynReadGroup *)pentry->userPvt;
+    } else {
+        pgroup = callocMustSucceed(1, sizeof(*pgroup), "asynEpicsUtils::readGroupFind");
+        pgroup->key = epicsStrDup(key);
+        pgroup->lock = epicsMutexMustCreate();
+        ellInit(&pgroup->waiterList);
+        pentry = gphAdd(readGroupHash, pgroup->key, NULL);
+        pentry->userPvt = pgroup;
+    }
+    epicsMutexUnlock(readGroupHashLock);
+    return pgroup;
+}
+
+static int readGroupJoin(asynReadGroup *pgroup, asynReadWaiter *pwaiter)
+{
+    int joined = 0;
+
+    epicsMutexMustLock(pgroup->lock);
+    if (pgroup->pending) {
+        ellAdd(&pgroup->waiterList, &pwaiter->node);
+        joined = 1;
+    } else {
+        pgroup->pending = 1;
+    }
+    epicsMutexUnlock(pgroup->lock);
+    return joined;
+}
+
+static void readGroupDone(asynReadGroup *pgroup,
+                          asynReadGroupCallback callback, void *leaderPvt)
+{
+    ELLLIST        waiterList;
+    asynReadWaiter *pwaiter;
+
+    ellInit(&waiterList);
+    epicsMutexMustLock(pgroup->lock);
+    pgroup->pending = 0;
+    ellConcat(&waiterList, &pgroup->waiterList);
+    epicsMutexUnlock(pgroup->lock);
+    /* The callbacks process records, so they are not called with the lock held */
+    while ((pwaiter = (asynReadWaiter *)ellGet(&waiterList))) {
+        callback(pwaiter->userPvt, leaderPvt);
+    }
+}
@@ -13,6 +13,7 @@
 #define asynEpicsUtilsH
 
 #include <link.h>
+#include <ellLib.h>
 #include <shareLib.h>
 #include <epicsTypes.h>
 #include <alarm.h>
@@ -22,6 +23,16 @@
 extern "C" {
 #endif  /* __cplusplus */
 
+/* Reads for input records with info(COALESCE,"1") that have the same port, addr,
+ * reason, interface and mask are coalesced. While a read queued for one record is
+ * pending, the others are attached to it and completed with the same result. */
+typedef struct asynReadGroup asynReadGroup;
+typedef struct asynReadWaiter {
+    ELLNODE node;
+    void    *userPvt;
+} asynReadWaiter;
+typedef void (*asynReadGroupCallback)(void *userPvt, void *leaderPvt);
+
 typedef struct asynEpicsUtils {
     asynStatus (*parseLink)(asynUser *pasynUser, DBLINK *plink, 
                 char **port, int *addr, char **userParam);
@@ -32,6 +43,15 @@ typedef struct asynEpicsUtils {
     void       (*asynStatusToEpicsAlarm)(asynStatus status, 
                 epicsAlarmCondition defaultStat, epicsAlarmCondition *pStat, 
                 epicsAlarmSeverity defaultSevr, epicsAlarmSeverity *pSevr);
+    /* Returns 0 unless coalescing is enabled for the record */
+    asynReadGroup *(*readGroupFind)(const char *recordName, asynUser *pasynUser,
+                const char *interfaceType, epicsUInt32 mask);
+    /* Returns 1 if pwaiter was attached to a pending read, 0 if the caller must queue the read */
+    int        (*readGroupJoin)(asynReadGroup *pgroup, asynReadWaiter *pwaiter);
+    /* Called when the read is done. Calls callback for each attached waiter,
+     * without holding the group lock */
+    void       (*readGroupDone)(asynReadGroup *pgroup,
+                asynReadGroupCallback callback, void *leaderPvt);
 } asynEpicsUtils;
 epicsShareExtern asynEpicsUtils *pasynEpicsUtils;
 
@@ -76,12 +76,16 @@ typedef struct devPvt{
     char              *portName;
     char              *userParam;
     int               addr;
+    asynReadGroup     *readGroup;
+    asynReadWaiter    readWaiter;
 }devPvt;
 
 static long initCommon(dbCommon *pr, DBLINK *plink,
     userCallback processCallback,interruptCallbackFloat64 interruptCallback);
 static long getIoIntInfo(int cmd, dbCommon *pr, IOSCANPVT *iopvt);
 static void processCallbackInput(asynUser *pasynUser);
+static void readGroupCallback(void *userPvt, void *leaderPvt);
+static asynStatus queueReadRequest(devPvt *pPvt);
 static void processCallbackOutput(asynUser *pasynUser);
 static void interruptCallbackInput(void *drvPvt, asynUser *pasynUser,
                 epicsFloat64 value);
@@ -179,6 +183,12 @@ static long initCommon(dbCommon *pr, DBLINK *plink,
     }
     pPvt->pfloat64 = pasynInterface->pinterface;
     pPvt->float64Pvt = pasynInterface->drvPvt;
+    /* Coalescing of reads is only done for queued reads */
+    if (pPvt->canBlock && (processCallback == processCallbackInput)) {
+        pPvt->readGroup = pasynEpicsUtils->readGroupFind(pr->name, pasynUser,
+                              asynFloat64Type, 0);
+        pPvt->readWaiter.userPvt = pPvt;
+    }
 
     /* Initialize synchronous interface */
     status = pasynFloat64SyncIO->connect(pPvt->portName, pPvt->addr,
@@ -269,9 +279,39 @@ static void processCallbackInput(asynUser *pasynUser)
               "%s devAsynFloat64 process read error %s\n",
               pr->name, pasynUser->errorMessage);
     }
+    if(pPvt->readGroup)
+        pasynEpicsUtils->readGroupDone(pPvt->readGroup, readGroupCallback, pPvt);
     if(pr->pact) callbackRequestProcessCallback(&pPvt->callback,pr->prio,pr);
 }
 
+/* Completes a read that was attached to the read done for another record */
+static void readGroupCallback(void *userPvt, void *leaderPvt)
+{
+    devPvt *pPvt = (devPvt *)userPvt;
+    devPvt *pleader = (devPvt *)leaderPvt;
+    dbCommon *pr = pPvt->pr;
+
+    pPvt->result = pleader->result;
+    asynPrint(pPvt->pasynUser, ASYN_TRACEIO_DEVICE,
+        "%s devAsynFloat64 coalesced read value=%f\n",pr->name,pPvt->result.value);
+    callbackRequestProcessCallback(&pPvt->callback,pr->prio,pr);
+}
+
+/* Queues a read, or attaches it to a read already queued for the same parameter */
+static asynStatus queueReadRequest(devPvt *pPvt)
+{
+    asynStatus status;
+
+    if(pPvt->readGroup
+    && pasynEpicsUtils->readGroupJoin(pPvt->readGroup, &pPvt->readWaiter)) return asynSuccess;
+    status = pasynManager->queueRequest(pPvt->pasynUser, 0, 0);
+    if((status != asynSuccess) && pPvt->readGroup) {
+        pPvt->result.status = status;
+        pasynEpicsUtils->readGroupDone(pPvt->readGroup, readGroupCallback, pPvt);
+    }
+    return status;
+}
+
 static void processCallbackOutput(asynUser *pasynUser)
 {
     devPvt *pPvt = (devPvt *)pasynUser->userPvt;
@@ -419,7 +459,7 @@ static long processAi(aiRecord *pr)
 
     if (!getCallbackValue(pPvt) && !pr->pact) {
         if(pPvt->canBlock) pr->pact = 1;
-        status = pasynManager->queueRequest(pPvt->pasynUser, 0, 0);
+        status = queueReadRequest(pPvt);
         if((status==asynSuccess) && pPvt->canBlock) return 0;
         if(pPvt->canBlock) pr->pact = 0;
         if(status != asynSuccess) {
@@ -101,6 +101,8 @@ typedef struct devInt32Pvt{
     char              *enumStrings[MAX_ENUM_STATES];
     int               enumValues[MAX_ENUM_STATES];
     int               enumSeverities[MAX_ENUM_STATES];
+    asynReadGroup     *readGroup;
+    asynReadWaiter    readWaiter;
 }devInt32Pvt;
 
 static void setEnums(char *outStrings, int *outVals, epicsEnum16 *outSeverities, 
@@ -110,6 +112,8 @@ static long getIoIntInfo(int cmd, dbCommon *pr, IOSCANPVT *iopvt);
 static long convertAi(aiRecord *pai, int pass);
 static long convertAo(aoRecord *pao, int pass);
 static void processCallbackInput(asynUser *pasynUser);
+static void readGroupCallback(void *userPvt, void *leaderPvt);
+static asynStatus queueReadRequest(devInt32Pvt *pPvt);
 static void processCallbackOutput(asynUser *pasynUser);
 static void interruptCallbackInput(void *drvPvt, asynUser *pasynUser,
                 epicsInt32 value);
@@ -266,6 +270,12 @@ static long initCommon(dbCommon *pr, DBLINK *plink,
     }
     pPvt->pint32 = pasynInterface->pinterface;
     pPvt->int32Pvt = pasynInterface->drvPvt;
+    /* Coalescing of reads is only done for queued reads without a mask */
+    if (pPvt->canBlock && (processCallback == processCallbackInput) && !pPvt->mask) {
+        pPvt->readGroup = pasynEpicsUtils->readGroupFind(pr->name, pasynUser,
+                              asynInt32Type, 0);
+        pPvt->readWaiter.userPvt = pPvt;
+    }
     scanIoInit(&pPvt->ioScanPvt);
     pPvt->interruptCallback = interruptCallback;
     /* Initialize synchronous interface */
@@ -432,9 +442,39 @@ static void processCallbackInput(asynUser *pasynUser)
               "%s devAsynInt32 process read error %s\n",
               pr->name, pasynUser->errorMessage);
     }
+    if(pPvt->readGroup)
+        pasynEpicsUtils->readGroupDone(pPvt->readGroup, readGroupCallback, pPvt);
     if(pr->pact) callbackRequestProcessCallback(&pPvt->callback,pr->prio,pr);
 }
 
+/* Completes a read that was attached to the read done for another record */
+static void readGroupCallback(void *userPvt, void *leaderPvt)
+{
+    devInt32Pvt *pPvt = (devInt32Pvt *)userPvt;
+    devInt32Pvt *pleader = (devInt32Pvt *)leaderPvt;
+    dbCommon *pr = pPvt->pr;
+
+    pPvt->result = pleader->result;
+    asynPrint(pPvt->pasynUser, ASYN_TRACEIO_DEVICE,
+        "%s devAsynInt32 coalesced read value=%d\n",pr->name,pPvt->result.value);
+    callbackRequestProcessCallback(&pPvt->callback,pr->prio,pr);
+}
+
+/* Queues a read, or attaches it to a read already queued for the same parameter */
+static asynStatus queueReadRequest(devInt32Pvt *pPvt)
+{
+    asynStatus status;
+
+    if(pPvt->readGroup
+    && pasynEpicsUtils->readGroupJoin(pPvt->readGroup, &pPvt->readWaiter)) return asynSuccess;
+    status = pasynManager->queueRequest(pPvt->pasynUser, 0, 0);
+    if((status != asynSuccess) && pPvt->readGroup) {
+        pPvt->result.status = status;
+        pasynEpicsUtils->readGroupDone(pPvt->readGroup, readGroupCallback, pPvt);
+    }
+    return status;
+}
+
 static void processCallbackOutput(asynUser *pasynUser)
 {
     devInt32Pvt *pPvt = (devInt32Pvt *)pasynUser->userPvt;
@@ -652,7 +692,7 @@ static long processAi(aiRecord *pr)
 
     if(!getCallbackValue(pPvt) && !pr->pact) {
         if(pPvt->canBlock) pr->pact = 1;
-        status = pasynManager->queueRequest(pPvt->pasynUser, 0, 0);
+        status = queueReadRequest(pPvt);
         if((status==asynSuccess) && pPvt->canBlock) return 0;
         if(pPvt->canBlock) pr->pact = 0;
         if(status != asynSuccess) {
@@ -838,7 +878,7 @@ static long processLi(longinRecord *pr)
 
     if(!getCallbackValue(pPvt) && !pr->pact) {
         if(pPvt->canBlock) pr->pact = 1;
-        status = pasynManager->queueRequest(pPvt->pasynUser, 0, 0);
+        status = queueReadRequest(pPvt);
         if((status==asynSuccess) && pPvt->canBlock) return 0;
         if(pPvt->canBlock) pr->pact = 0;
         if(status != asynSuccess) {
@@ -931,7 +971,7 @@ static long processBi(biRecord *pr)
 
     if(!getCallbackValue(pPvt) && !pr->pact) {
         if(pPvt->canBlock) pr->pact = 1;
-        status = pasynManager->queueRequest(pPvt->pasynUser, 0, 0);
+        status = queueReadRequest(pPvt);
         if((status==asynSuccess) && pPvt->canBlock) return 0;
         if(pPvt->canBlock) pr->pact = 0;
         if(status != asynSuccess) {
@@ -1027,7 +1067,7 @@ static long processMbbi(mbbiRecord *pr)
 
     if(!getCallbackValue(pPvt) && !pr->pact) {
         if(pPvt->canBlock) pr->pact = 1;
-        status = pasynManager->queueRequest(pPvt->pasynUser, 0, 0);
+        status = queueReadRequest(pPvt);
         if((status==asynSuccess) && pPvt->canBlock) return 0;
         if(pPvt->canBlock) pr->pact = 0;
         if(status != asynSuccess) {
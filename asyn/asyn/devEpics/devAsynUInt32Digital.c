@@ -92,6 +92,8 @@ typedef struct devPvt{
     char              *enumStrings[MAX_ENUM_STATES];
     int               enumValues[MAX_ENUM_STATES];
     int               enumSeverities[MAX_ENUM_STATES];
+    asynReadGroup     *readGroup;
+    asynReadWaiter    readWaiter;
 }devPvt;
 
 #define NUM_BITS 16
@@ -101,6 +103,8 @@ static void setEnums(char *outStrings, int *outVals, epicsEnum16 *outSeverities,
                      size_t numIn, size_t numOut);
 static long getIoIntInfo(int cmd, dbCommon *pr, IOSCANPVT *iopvt);
 static void processCallbackInput(asynUser *pasynUser);
+static void readGroupCallback(void *userPvt, void *leaderPvt);
+static asynStatus queueReadRequest(devPvt *pPvt);
 static void processCallbackOutput(asynUser *pasynUser);
 static void interruptCallbackInput(void *drvPvt, asynUser *pasynUser,
                 epicsUInt32 value);
@@ -224,6 +228,12 @@ static long initCommon(dbCommon *pr, DBLINK *plink,
     }
     pPvt->puint32 = pasynInterface->pinterface;
     pPvt->uint32Pvt = pasynInterface->drvPvt;
+    /* Coalescing of reads is only done for queued reads */
+    if (pPvt->canBlock && (processCallback == processCallbackInput)) {
+        pPvt->readGroup = pasynEpicsUtils->readGroupFind(pr->name, pasynUser,
+                              asynUInt32DigitalType, pPvt->mask);
+        pPvt->readWaiter.userPvt = pPvt;
+    }
 
     /* Initialize synchronous interface */
     status = pasynUInt32DigitalSyncIO->connect(pPvt->portName, pPvt->addr,
@@ -352,9 +362,39 @@ static void processCallbackInput(asynUser *pasynUser)
             "%s devAsynUInt32Digital::process read error %s\n",
             pr->name, pasynUser->errorMessage);
     }
+    if(pPvt->readGroup)
+        pasynEpicsUtils->readGroupDone(pPvt->readGroup, readGroupCallback, pPvt);
     if(pr->pact) callbackRequestProcessCallback(&pPvt->callback,pr->prio,pr);
 }
 
+/* Completes a read that was attached to the read done for another record */
+static void readGroupCallback(void *userPvt, void *leaderPvt)
+{
+    devPvt *pPvt = (devPvt *)userPvt;
+    devPvt *pleader = (devPvt *)leaderPvt;
+    dbCommon *pr = pPvt->pr;
+
+    pPvt->result = pleader->result;
+    asynPrint(pPvt->pasynUser, ASYN_TRACEIO_DEVICE,
+        "%s devAsynUInt32Digital coalesced read value=%u\n",pr->name,pPvt->result.value);
+    callbackRequestProcessCallback(&pPvt->callback,pr->prio,pr);
+}
+
+/* Queues a read, or attaches it to a read already queued for the same parameter */
+static asynStatus queueReadRequest(devPvt *pPvt)
+{
+    asynStatus status;
+
+    if(pPvt->readGroup
+    && pasynEpicsUtils->readGroupJoin(pPvt->readGroup, &pPvt->readWaiter)) return asynSuccess;
+    status = pasynManager->queueRequest(pPvt->pasynUser, 0, 0);
+    if((status != asynSuccess) && pPvt->readGroup) {
+        pPvt->result.status = status;
+        pasynEpicsUtils->readGroupDone(pPvt->readGroup, readGroupCallback, pPvt);
+    }
+    return status;
+}
+
 static void processCallbackOutput(asynUser *pasynUser)
 {
     devPvt *pPvt = (devPvt *)pasynUser->userPvt;
@@ -555,7 +595,7 @@ static long processBi(biRecord *pr)
 
     if(!getCallbackValue(pPvt) && !pr->pact) {
         if(pPvt->canBlock) pr->pact = 1;
-        status = pasynManager->queueRequest(pPvt->pasynUser, 0, 0);
+        status = queueReadRequest(pPvt);
         if((status==asynSuccess) && pPvt->canBlock) return 0;
         if(pPvt->canBlock) pr->pact = 0;
         if(status != asynSuccess) {
@@ -651,7 +691,7 @@ static long processLi(longinRecord *pr)
 
     if(!getCallbackValue(pPvt) && !pr->pact) {
         if(pPvt->canBlock) pr->pact = 1;
-        status = pasynManager->queueRequest(pPvt->pasynUser, 0, 0);
+        status = queueReadRequest(pPvt);
         if((status==asynSuccess) && pPvt->canBlock) return 0;
         if(pPvt->canBlock) pr->pact = 0;
         if(status != asynSuccess) {
@@ -747,7 +787,7 @@ static long processMbbi(mbbiRecord *pr)
 
     if(!getCallbackValue(pPvt) && !pr->pact) {
         if(pPvt->canBlock) pr->pact = 1;
-        status = pasynManager->queueRequest(pPvt->pasynUser, 0, 0);
+        status = queueReadRequest(pPvt);
         if((status==asynSuccess) && pPvt->canBlock) return 0;
         if(pPvt->canBlock) pr->pact = 0;
         if(status != asynSuccess) {
@@ -865,7 +905,7 @@ static long processMbbiDirect(mbbiDirectRecord *pr)
 
     if(!getCallbackValue(pPvt) && !pr->pact) {
         if(pPvt->canBlock) pr->pact = 1;
-        status = pasynManager->queueRequest(pPvt->pasynUser, 0, 0);
+        status = queueReadRequest(pPvt);
         if((status==asynSuccess) && pPvt->canBlock) return 0;
         if(pPvt->canBlock) pr->pact = 0;
         if(status != asynSuccess) {
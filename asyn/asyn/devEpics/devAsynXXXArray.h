@@ -1,3 +1,19 @@
+#include <string.h>
+#include <stdlib.h>
+#include <epicsVersion.h>
+#include <dbStaticLib.h>
+#include "asynArrayBuffer.h"
+
+/* Input records with info(SWAP_ARRAY,"1") use the data of a shared asynArrayBuffer
+ * as bptr instead of copying it. This needs get_array_info of the waveform record
+ * to set the field address from bptr. The data is only swapped in while DISP=1,
+ * so that a put to the record cannot write the data shared with other records. */
+#if (EPICS_VERSION > 3) || ((EPICS_VERSION == 3) && (EPICS_REVISION >= 16))
+#define ASYN_ARRAY_SWAP 1
+#else
+#define ASYN_ARRAY_SWAP 0
+#endif
+
 #define ASYN_XXX_ARRAY_FUNCS(DRIVER_NAME, INTERFACE, INTERFACE_TYPE, \
                              INTERRUPT, EPICS_TYPE, DSET_IN, DSET_OUT, \
                              SIGNED_TYPE, UNSIGNED_TYPE) \
@@ -19,6 +35,15 @@
 */ \
  \
  \
+/* Element of the optional ring buffer of arrays, info(FIFO,"N") */ \
+typedef struct ringBufferElement { \
+    EPICS_TYPE      *pValue;    /* nelm elements */ \
+    asynArrayBuffer *pbuffer;   /* shared buffer instead of pValue */ \
+    epicsUInt32     len; \
+    epicsTimeStamp  time; \
+    asynStatus      status; \
+} ringBufferElement; \
+ \
 typedef struct devAsynWfPvt{ \
     dbCommon        *pr; \
     asynUser        *pasynUser; \
@@ -37,6 +62,19 @@ typedef struct devAsynWfPvt{ \
     char            *portName; \
     char            *userParam; \
     int             addr; \
+    asynArrayBuffer *pbuffer;   /* shared buffer from interruptCallbackInput */ \
+    asynArrayBuffer *pswapped;  /* shared buffer that bptr points to */ \
+    void            *recordBptr; /* bptr allocated by the record */ \
+    int             swapArray; \
+    ringBufferElement *ringBuffer; \
+    int             ringHead; \
+    int             ringTail; \
+    int             ringSize; \
+    int             ringBufferOverflows; /* since the last warning */ \
+    epicsInt32      totalOverflows; \
+    int             hasOverflowAddr; \
+    DBADDR          overflowAddr; /* info(FIFO_OVERFLOWS,"PV name") */ \
+    CALLBACK        overflowCallback; \
 } devAsynWfPvt; \
  \
 static long getIoIntInfo(int cmd, dbCommon *pr, IOSCANPVT *iopvt); \
@@ -45,6 +83,11 @@ static long initCommon(dbCommon *pr, DBLINK *plink,  \
 static long processCommon(dbCommon *pr); \
 static long initWfArrayIn(waveformRecord *pwf); \
 static long initWfArrayOut(waveformRecord *pwf); \
+static void restoreBptr(devAsynWfPvt *pPvt); \
+static void adoptBuffer(devAsynWfPvt *pPvt); \
+static void initRingBuffer(devAsynWfPvt *pPvt); \
+static int getRingValue(devAsynWfPvt *pPvt); \
+static void overflowCallback(CALLBACK *pcallback); \
 /* processCommon callbacks */ \
 static void callbackWf(asynUser *pasynUser); \
 static void callbackWfOut(asynUser *pasynUser); \
@@ -52,6 +95,8 @@ static void interruptCallbackInput(void *drvPvt, asynUser *pasynUser,  \
                 EPICS_TYPE *value, size_t len); \
 static void interruptCallbackOutput(void *drvPvt, asynUser *pasynUser,  \
                 EPICS_TYPE *value, size_t len); \
+static void interruptCallbackRing(devAsynWfPvt *pPvt, asynUser *pasynUser, \
+                EPICS_TYPE *value, size_t len, asynArrayBuffer *pbuffer); \
  \
 typedef struct analogDset { /* analog  dset */ \
     long        number; \
@@ -157,6 +202,8 @@ static long getIoIntInfo(int cmd, dbCommon *pr, IOSCANPVT *iopvt) \
         asynPrint(pPvt->pasynUser, ASYN_TRACE_FLOW, \
             "%s %s::getIoIntInfo registering interrupt\n", \
             pr->name, driverName); \
+        if ((pPvt->interruptCallback == interruptCallbackInput) && !pPvt->ringBuffer) \
+            initRingBuffer(pPvt); \
         status = pPvt->pArray->registerInterruptUser( \
            pPvt->arrayPvt, pPvt->pasynUser, \
            pPvt->interruptCallback, pPvt, &pPvt->registrarPvt); \
@@ -187,15 +234,158 @@ static long initWfArrayOut(waveformRecord *pwf) \
     callbackWfOut, interruptCallbackOutput); }  \
  \
 static long initWfArrayIn(waveformRecord *pwf) \
-{ return initCommon((dbCommon *)pwf, (DBLINK *)&pwf->inp,  \
-    callbackWf, interruptCallbackInput); }  \
+{ \
+    devAsynWfPvt *pPvt; \
+    DBENTRY *pdbentry; \
+    const char *swapArray = 0; \
+    long status; \
+ \
+    status = initCommon((dbCommon *)pwf, (DBLINK *)&pwf->inp,  \
+        callbackWf, interruptCallbackInput); \
+    if (status) return status; \
+    pPvt = (devAsynWfPvt *)pwf->dpvt; \
+    pPvt->recordBptr = pwf->bptr; \
+    pdbentry = dbAllocEntry(pdbbase); \
+    if (dbFindRecord(pdbentry, pwf->name) == 0) \
+        swapArray = dbGetInfo(pdbentry, "SWAP_ARRAY"); \
+    dbFreeEntry(pdbentry); \
+    if (swapArray && atoi(swapArray)) { \
+        if (ASYN_ARRAY_SWAP && pwf->disp) { \
+            pPvt->swapArray = 1; \
+        } else if (ASYN_ARRAY_SWAP) { \
+            errlogPrintf("%s::initWfArrayIn, %s SWAP_ARRAY needs DISP=1, arrays will be copied\n", \
+                         driverName, pwf->name); \
+        } else { \
+            errlogPrintf("%s::initWfArrayIn, %s SWAP_ARRAY needs EPICS base 3.16 or later, arrays will be copied\n", \
+                         driverName, pwf->name); \
+        } \
+    } \
+    return 0; \
+}  \
+ \
+/* Points bptr back at the array allocated by the record. Must be called with dbScanLock held */ \
+static void restoreBptr(devAsynWfPvt *pPvt) \
+{ \
+    waveformRecord *pwf = (waveformRecord *)pPvt->pr; \
+ \
+    if (!pPvt->pswapped) return; \
+    pwf->bptr = pPvt->recordBptr; \
+    pasynArrayBuffer->release(pPvt->pswapped); \
+    pPvt->pswapped = 0; \
+} \
+ \
+/* The ring buffer is only created if the record has info(FIFO,"N") and is I/O Intr scanned */ \
+static void initRingBuffer(devAsynWfPvt *pPvt) \
+{ \
+    waveformRecord *pwf = (waveformRecord *)pPvt->pr; \
+    DBENTRY *pdbentry = dbAllocEntry(pdbbase); \
+    const char *sizeString = 0; \
+    const char *overflowName = 0; \
+    int i; \
+ \
+    if (dbFindRecord(pdbentry, pwf->name) == 0) { \
+        sizeString = dbGetInfo(pdbentry, "FIFO"); \
+        overflowName = dbGetInfo(pdbentry, "FIFO_OVERFLOWS"); \
+    } \
+    if (sizeString) pPvt->ringSize = atoi(sizeString); \
+    if (pPvt->ringSize > 0) { \
+        pPvt->ringBuffer = callocMustSucceed(pPvt->ringSize+1, sizeof *pPvt->ringBuffer, \
+                                             "devAsynWf::initRingBuffer"); \
+        for (i=0; i<=pPvt->ringSize; i++) { \
+            pPvt->ringBuffer[i].pValue = callocMustSucceed(pwf->nelm, sizeof(EPICS_TYPE), \
+                                                           "devAsynWf::initRingBuffer"); \
+        } \
+        if (overflowName) { \
+            if (dbNameToAddr(overflowName, &pPvt->overflowAddr) == 0) { \
+                pPvt->hasOverflowAddr = 1; \
+                callbackSetCallback(overflowCallback, &pPvt->overflowCallback); \
+                callbackSetPriority(priorityLow, &pPvt->overflowCallback); \
+                callbackSetUser(pPvt, &pPvt->overflowCallback); \
+            } else { \
+                errlogPrintf("%s::initRingBuffer, %s FIFO_OVERFLOWS record %s not found\n", \
+                             driverName, pwf->name, overflowName); \
+            } \
+        } \
+    } else { \
+        pPvt->ringSize = 0; \
+    } \
+    dbFreeEntry(pdbentry); \
+} \
+ \
+/* Writes the number of overflows to the FIFO_OVERFLOWS record */ \
+static void overflowCallback(CALLBACK *pcallback) \
+{ \
+    devAsynWfPvt *pPvt; \
+    epicsInt32 totalOverflows; \
+ \
+    callbackGetUser(pPvt, pcallback); \
+    dbScanLock(pPvt->pr); \
+    totalOverflows = pPvt->totalOverflows; \
+    dbScanUnlock(pPvt->pr); \
+    dbPutField(&pPvt->overflowAddr, DBR_LONG, &totalOverflows, 1); \
+} \
+ \
+/* Takes the oldest array from the ring buffer. Must be called with dbScanLock held */ \
+static int getRingValue(devAsynWfPvt *pPvt) \
+{ \
+    waveformRecord *pwf = (waveformRecord *)pPvt->pr; \
+    ringBufferElement *rp; \
+ \
+    if (pPvt->ringTail == pPvt->ringHead) return 0; \
+    if (pPvt->ringBufferOverflows > 0) { \
+        asynPrint(pPvt->pasynUser, ASYN_TRACE_WARNING, \
+            "%s %s::getRingValue warning, %d ring buffer overflows\n", \
+            pwf->name, driverName, pPvt->ringBufferOverflows); \
+        pPvt->ringBufferOverflows = 0; \
+        if (pPvt->hasOverflowAddr) callbackRequest(&pPvt->overflowCallback); \
+    } \
+    rp = &pPvt->ringBuffer[pPvt->ringTail]; \
+    pPvt->nord = rp->len; \
+    if (rp->pbuffer) { \
+        pPvt->pbuffer = rp->pbuffer; \
+        rp->pbuffer = 0; \
+        adoptBuffer(pPvt); \
+    } else { \
+        restoreBptr(pPvt); \
+        memcpy(pwf->bptr, rp->pValue, rp->len*sizeof(EPICS_TYPE)); \
+    } \
+    pwf->time = rp->time; \
+    if (pPvt->status == asynSuccess) pPvt->status = rp->status; \
+    pPvt->ringTail = (pPvt->ringTail==pPvt->ringSize) ? 0 : pPvt->ringTail+1; \
+    pwf->nord = pPvt->nord; \
+    pwf->udf = 0; \
+    pPvt->gotValue--; \
+    return 1; \
+} \
+ \
+/* Swaps in or copies the shared buffer from interruptCallbackInput. Must be called with dbScanLock held */ \
+static void adoptBuffer(devAsynWfPvt *pPvt) \
+{ \
+    waveformRecord *pwf = (waveformRecord *)pPvt->pr; \
+    asynArrayBuffer *pbuffer = pPvt->pbuffer; \
+ \
+    pPvt->pbuffer = 0; \
+    if (pPvt->swapArray && pwf->disp && (pbuffer->nElements >= pwf->nelm) && \
+        (pbuffer->elementSize == sizeof(EPICS_TYPE))) { \
+        if (pPvt->pswapped) pasynArrayBuffer->release(pPvt->pswapped); \
+        pwf->bptr = pbuffer->data; \
+        pPvt->pswapped = pbuffer; \
+    } else { \
+        restoreBptr(pPvt); \
+        memcpy(pwf->bptr, pbuffer->data, pPvt->nord*sizeof(EPICS_TYPE)); \
+        pasynArrayBuffer->release(pbuffer); \
+    } \
+} \
  \
 static long processCommon(dbCommon *pr) \
 { \
     devAsynWfPvt *pPvt = (devAsynWfPvt *)pr->dpvt; \
     waveformRecord *pwf = (waveformRecord *)pr; \
+    int ringValue = 0; \
  \
-    if (!pPvt->gotValue && !pr->pact) {   /* This is an initial call from record */ \
+    if (pPvt->ringSize && pPvt->gotValue && !pr->pact) ringValue = getRingValue(pPvt); \
+    if (!pPvt->gotValue && !ringValue && !pr->pact) {   /* This is an initial call from record */ \
+        restoreBptr(pPvt); \
         if(pPvt->canBlock) pr->pact = 1; \
         pPvt->status = pasynManager->queueRequest(pPvt->pasynUser, 0, 0); \
         if((pPvt->status==asynSuccess) && pPvt->canBlock) return 0; \
@@ -211,7 +401,8 @@ static long processCommon(dbCommon *pr) \
                                                 INVALID_ALARM, &pPvt->alarmSevr); \
         recGblSetSevr(pr, pPvt->alarmStat, pPvt->alarmSevr); \
     } \
-    if (pPvt->gotValue) { \
+    if (pPvt->gotValue && !pPvt->ringSize) { \
+        if (pPvt->pbuffer) adoptBuffer(pPvt); \
         pwf->nord = pPvt->nord; \
         pwf->udf = 0; \
         pPvt->gotValue--; \
@@ -279,16 +470,25 @@ static void interruptCallbackInput(void *drvPvt, asynUser *pasynUser,  \
 { \
     devAsynWfPvt *pPvt = (devAsynWfPvt *)drvPvt; \
     waveformRecord *pwf = (waveformRecord *)pPvt->pr; \
-    int i; \
-    EPICS_TYPE *pData = (EPICS_TYPE *)pwf->bptr; \
+    /* A shared buffer is kept until the record processes, other arrays are copied */ \
+    asynArrayBuffer *pbuffer = pasynArrayBuffer->find(value); \
  \
     asynPrintIO(pPvt->pasynUser, ASYN_TRACEIO_DEVICE, \
         (char *)value, len*sizeof(EPICS_TYPE), \
         "%s %s::interruptCallbackInput\n", \
         pwf->name, driverName); \
+    if (pPvt->ringSize) { \
+        interruptCallbackRing(pPvt, pasynUser, value, len, pbuffer); \
+        return; \
+    } \
     dbScanLock((dbCommon *)pwf); \
     if (len > pwf->nelm) len = pwf->nelm; \
-    for (i=0; i<(int)len; i++) pData[i] = value[i]; \
+    if (pPvt->pbuffer) pasynArrayBuffer->release(pPvt->pbuffer); \
+    pPvt->pbuffer = pbuffer; \
+    if (!pbuffer) { \
+        restoreBptr(pPvt); \
+        memcpy(pwf->bptr, value, len*sizeof(EPICS_TYPE)); \
+    } \
     pwf->time = pasynUser->timestamp; \
     pPvt->gotValue++; \
     pPvt->nord = (epicsUInt32)len; \
@@ -297,6 +497,45 @@ static void interruptCallbackInput(void *drvPvt, asynUser *pasynUser,  \
     scanIoRequest(pPvt->ioScanPvt); \
 } \
  \
+/* Adds the array to the ring buffer. When the ring buffer is full the oldest array \
+ * is removed, so the last array the record receives is always the most recent */ \
+static void interruptCallbackRing(devAsynWfPvt *pPvt, asynUser *pasynUser, \
+                EPICS_TYPE *value, size_t len, asynArrayBuffer *pbuffer) \
+{ \
+    waveformRecord *pwf = (waveformRecord *)pPvt->pr; \
+    ringBufferElement *rp; \
+    int added = 0; \
+ \
+    /* Records do not process before interruptAccept, see devAsynInt32 */ \
+    if (!interruptAccept) { \
+        if (pbuffer) pasynArrayBuffer->release(pbuffer); \
+        return; \
+    } \
+    dbScanLock((dbCommon *)pwf); \
+    if (len > pwf->nelm) len = pwf->nelm; \
+    rp = &pPvt->ringBuffer[pPvt->ringHead]; \
+    rp->pbuffer = pbuffer; \
+    if (!pbuffer) memcpy(rp->pValue, value, len*sizeof(EPICS_TYPE)); \
+    rp->len = (epicsUInt32)len; \
+    rp->time = pasynUser->timestamp; \
+    rp->status = pasynUser->auxStatus; \
+    pPvt->ringHead = (pPvt->ringHead==pPvt->ringSize) ? 0 : pPvt->ringHead+1; \
+    if (pPvt->ringHead == pPvt->ringTail) { \
+        rp = &pPvt->ringBuffer[pPvt->ringTail]; \
+        if (rp->pbuffer) pasynArrayBuffer->release(rp->pbuffer); \
+        rp->pbuffer = 0; \
+        pPvt->ringTail = (pPvt->ringTail==pPvt->ringSize) ? 0 : pPvt->ringTail+1; \
+        pPvt->ringBufferOverflows++; \
+        pPvt->totalOverflows++; \
+    } else { \
+        pPvt->gotValue++; \
+        added = 1; \
+    } \
+    dbScanUnlock((dbCommon *)pwf); \
+    /* Only request processing if an array was added, not if one was replaced */ \
+    if (added) scanIoRequest(pPvt->ioScanPvt); \
+} \
+ \
 static void interruptCallbackOutput(void *drvPvt, asynUser *pasynUser,  \
                 EPICS_TYPE *value, size_t len) \
 { \
@@ -19,6 +19,8 @@
 #include <devSup.h>
 #include <menuFtype.h>
 #include <dbEvent.h>
+#include <dbStaticLib.h>
+#include <epicsString.h>
 
 #include "asynDriver.h"
 #include "asynDrvUser.h"
@@ -42,6 +44,11 @@
 */ \
  \
  \
+/* How the samples in a block of reduceN samples are reduced to one point, info(TS_REDUCE,"...") */ \
+typedef enum { \
+    tsReduceNone, tsReduceAverage, tsReduceMin, tsReduceMax, tsReduceDecimate \
+} tsReduceType; \
+ \
 typedef struct devAsynWfPvt{ \
     dbCommon        *pr; \
     asynUser        *pasynUser; \
@@ -56,12 +63,26 @@ typedef struct devAsynWfPvt{ \
     epicsMutexId    lock; \
     int             addr; \
     asynStatus      status; \
+    tsReduceType    reduce; \
+    int             reduceN; \
+    int             blockCount;   /* samples in the current block */ \
+    double          blockSum; \
+    EPICS_TYPE      blockValue;   /* first, min or max of the block */ \
+    int             rolling;      /* post every rolling points, info(TS_ROLLING,"M") */ \
+    EPICS_TYPE      *pRing;       /* circular buffer of NELM points for rolling mode */ \
+    epicsUInt32     ringHead; \
+    epicsUInt32     ringCount; \
+    int             sincePost; \
+    int             processPending; \
 } devAsynWfPvt; \
  \
 static long initRecord(dbCommon *pr); \
 static long process(dbCommon *pr); \
 static void interruptCallback(void *drvPvt, asynUser *pasynUser,  \
                 EPICS_TYPE value); \
+static void initReduce(devAsynWfPvt *pPvt); \
+static void resetAcquire(devAsynWfPvt *pPvt); \
+static void addPoint(devAsynWfPvt *pPvt, EPICS_TYPE value); \
  \
 typedef struct analogDset { /* analog  dset */ \
     long        number; \
@@ -140,10 +161,90 @@ static long initRecord(dbCommon *pr) \
     } \
     pPvt->pInterface = pasynInterface->pinterface; \
     pPvt->ifacePvt = pasynInterface->drvPvt; \
+    initReduce(pPvt); \
     return 0; \
 bad: \
    pr->pact=1; \
    return -1; \
+} \
+ \
+/* Reads the optional info tags that select block reduction and rolling mode */ \
+static void initReduce(devAsynWfPvt *pPvt) \
+{ \
+    waveformRecord *pwf = (waveformRecord *)pPvt->pr; \
+    DBENTRY *pdbentry = dbAllocEntry(pdbbase); \
+    const char *reduceString = 0; \
+    const char *reduceNString = 0; \
+    const char *rollingString = 0; \
+ \
+    if (dbFindRecord(pdbentry, pwf->name) == 0) { \
+        reduceString = dbGetInfo(pdbentry, "TS_REDUCE"); \
+        reduceNString = dbGetInfo(pdbentry, "TS_REDUCE_N"); \
+        rollingString = dbGetInfo(pdbentry, "TS_ROLLING"); \
+    } \
+    pPvt->reduce = tsReduceNone; \
+    if (reduceString) { \
+        if      (epicsStrCaseCmp(reduceString, "AVERAGE") == 0)  pPvt->reduce = tsReduceAverage; \
+        else if (epicsStrCaseCmp(reduceString, "MIN") == 0)      pPvt->reduce = tsReduceMin; \
+        else if (epicsStrCaseCmp(reduceString, "MAX") == 0)      pPvt->reduce = tsReduceMax; \
+        else if (epicsStrCaseCmp(reduceString, "DECIMATE") == 0) pPvt->reduce = tsReduceDecimate; \
+        else if (epicsStrCaseCmp(reduceString, "NONE") != 0) { \
+            errlogPrintf("%s::initReduce, %s unknown TS_REDUCE %s\n", \
+                         driverName, pwf->name, reduceString); \
+        } \
+    } \
+    pPvt->reduceN = reduceNString ? atoi(reduceNString) : 1; \
+    if ((pPvt->reduce == tsReduceNone) || (pPvt->reduceN < 1)) pPvt->reduceN = 1; \
+    if (rollingString) pPvt->rolling = atoi(rollingString); \
+    if (pPvt->rolling > 0) { \
+        pPvt->pRing = callocMustSucceed(pwf->nelm, sizeof(EPICS_TYPE), \
+                                        "devAsynXXXTimeSeries::initReduce"); \
+    } else { \
+        pPvt->rolling = 0; \
+    } \
+    dbFreeEntry(pdbentry); \
+} \
+ \
+/* Erases the acquired points. Must be called with pPvt->lock held */ \
+static void resetAcquire(devAsynWfPvt *pPvt) \
+{ \
+    waveformRecord *pwf = (waveformRecord *)pPvt->pr; \
+ \
+    pPvt->nord = 0; \
+    pPvt->blockCount = 0; \
+    pPvt->ringHead = 0; \
+    pPvt->ringCount = 0; \
+    pPvt->sincePost = 0; \
+    memset(pwf->bptr, 0, pwf->nelm*sizeof(EPICS_TYPE)); \
+    if (pPvt->pRing) memset(pPvt->pRing, 0, pwf->nelm*sizeof(EPICS_TYPE)); \
+} \
+ \
+/* Stores one reduced point. Must be called with pPvt->lock held */ \
+static void addPoint(devAsynWfPvt *pPvt, EPICS_TYPE value) \
+{ \
+    waveformRecord *pwf = (waveformRecord *)pPvt->pr; \
+    EPICS_TYPE *pData = (EPICS_TYPE *)pwf->bptr; \
+ \
+    if (pPvt->rolling) { \
+        /* The oldest point is overwritten, acquisition continues until stopped */ \
+        pPvt->pRing[pPvt->ringHead] = value; \
+        if (++pPvt->ringHead == pwf->nelm) pPvt->ringHead = 0; \
+        if (pPvt->ringCount < pwf->nelm) pPvt->ringCount++; \
+        if ((++pPvt->sincePost >= pPvt->rolling) && !pPvt->processPending) { \
+            pPvt->sincePost = 0; \
+            pPvt->processPending = 1; \
+            callbackRequestProcessCallback(&pPvt->callback,pwf->prio,pwf); \
+        } \
+    } \
+    else if (pPvt->nord < pwf->nelm) { \
+        pData[pPvt->nord] = value; \
+        pPvt->nord++; \
+    } \
+    else { \
+        pPvt->busy = 0; \
+        /* When acquisition completes process record */ \
+        callbackRequestProcessCallback(&pPvt->callback,pwf->prio,pwf); \
+    } \
 } \
  \
  \
@@ -162,9 +263,8 @@ static long process(dbCommon *pr) \
       case 0: \
         break; \
       case 1: \
-        pPvt->nord = 0; \
+        resetAcquire(pPvt); \
         busy = 1; \
-        memset(pwf->bptr, 0, pwf->nelm*sizeof(EPICS_TYPE)); \
         break; \
       case 2: \
         busy = 0; \
@@ -173,6 +273,15 @@ static long process(dbCommon *pr) \
         busy = 1; \
         break; \
     } \
+    pPvt->processPending = 0; \
+    if (pPvt->rolling) { \
+        /* Copy the window to the record with the oldest point first */ \
+        EPICS_TYPE *pData = (EPICS_TYPE *)pwf->bptr; \
+        epicsUInt32 first = (pPvt->ringCount < pwf->nelm) ? 0 : pPvt->ringHead; \
+        memcpy(pData, pPvt->pRing + first, (pPvt->ringCount - first)*sizeof(EPICS_TYPE)); \
+        memcpy(pData + pPvt->ringCount - first, pPvt->pRing, first*sizeof(EPICS_TYPE)); \
+        pPvt->nord = pPvt->ringCount; \
+    } \
     if (pwf->nord != pPvt->nord) { \
       pwf->nord = pPvt->nord; \
       db_post_events(pwf, &pwf->nord, DBE_VALUE | DBE_LOG); \
@@ -218,7 +327,7 @@ static void interruptCallback(void *drvPvt, asynUser *pasynUser, EPICS_TYPE valu
 { \
     devAsynWfPvt *pPvt = (devAsynWfPvt *)drvPvt; \
     waveformRecord *pwf = (waveformRecord *)pPvt->pr; \
-    EPICS_TYPE *pData = (EPICS_TYPE *)pwf->bptr; \
+    EPICS_TYPE reduced; \
  \
     epicsMutexLock(pPvt->lock); \
     asynPrint(pPvt->pasynUser, ASYN_TRACEIO_DEVICE, \
@@ -226,14 +335,25 @@ static void interruptCallback(void *drvPvt, asynUser *pasynUser, EPICS_TYPE valu
         pwf->name, driverName, (double)value, pPvt->nord); \
     /* If we are not acquiring then nothing to do */  \
     if (pPvt->busy) { \
-      if (pPvt->nord < pwf->nelm) { \
-        pData[pPvt->nord] = value; \
-        pPvt->nord++; \
+      if (pPvt->blockCount == 0) { \
+        pPvt->blockSum = 0.; \
+        pPvt->blockValue = value; \
       } \
-      else { \
-        pPvt->busy = 0; \
-        /* When acquisition completes process record */ \
-        callbackRequestProcessCallback(&pPvt->callback,pwf->prio,pwf); \
+      pPvt->blockSum += value; \
+      if ((pPvt->reduce == tsReduceMin) && (value < pPvt->blockValue)) pPvt->blockValue = value; \
+      if ((pPvt->reduce == tsReduceMax) && (value > pPvt->blockValue)) pPvt->blockValue = value; \
+      /* One point is stored for each block of reduceN samples */ \
+      if (++pPvt->blockCount >= pPvt->reduceN) { \
+        if (pPvt->reduce == tsReduceAverage) { \
+          double average = pPvt->blockSum / pPvt->blockCount; \
+          /* Round to the nearest integer for integer types rather than truncate */ \
+          if ((EPICS_TYPE)0.5 == 0) average += (average < 0) ? -0.5 : 0.5; \
+          reduced = (EPICS_TYPE)average; \
+        } \
+        else \
+          reduced = pPvt->blockValue; \
+        pPvt->blockCount = 0; \
+        addPoint(pPvt, reduced); \
       } \
     } \
     if (pPvt->status == asynSuccess) pPvt->status = pasynUser->auxStatus; \
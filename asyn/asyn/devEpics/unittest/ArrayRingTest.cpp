@@ -0,0 +1,209 @@
+/*
+ * ArrayRingTest.cpp
+ *
+ * Tests the ring buffer of the array device support, info(FIFO,N). More
+ * callbacks than N are done while the record is locked, and the test checks
+ * the order of the processed arrays, the FIFO_OVERFLOWS count, and that the
+ * shared buffers of the dropped arrays are released.
+ *
+ ***************************************************************************
+ * This file is distributed subject to a Software License Agreement found  *
+ * in the file LICENSE that is included with this distribution.            *
+ ***************************************************************************
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <epicsEvent.h>
+#include <epicsThread.h>
+#include <dbAccess.h>
+#include <dbLock.h>
+#include <dbUnitTest.h>
+#include <aSubRecord.h>
+#include <registryFunction.h>
+#include <epicsUnitTest.h>
+#include <testMain.h>
+#include <epicsExport.h>
+
+#include "asynPortDriver.h"
+#include "asynArrayBuffer.h"
+
+#define PORT_NAME   "RING"
+#define NELM        8
+#define FIFO_SIZE   4
+#define NUM_ARRAYS  6
+#define MAX_RECORD  20
+
+extern "C" int ArrayRingTest_registerRecordDeviceDriver(struct dbBase *pdbbase);
+
+/* First elements of the arrays processed by RING:WF, recorded by RING:FIRST */
+static epicsInt32 firstElements[MAX_RECORD];
+static int numProcessed;
+static epicsEventId processedEvent;
+
+static long arrayRingRecord(aSubRecord *prec)
+{
+    if (numProcessed < MAX_RECORD)
+        firstElements[numProcessed] = ((epicsInt32 *)prec->a)[0];
+    numProcessed++;
+    epicsEventSignal(processedEvent);
+    return 0;
+}
+
+extern "C" {
+epicsRegisterFunction(arrayRingRecord);
+}
+
+class arrayRingDriver : public asynPortDriver {
+public:
+    arrayRingDriver(const char *portName);
+    int P_Array;
+};
+
+arrayRingDriver::arrayRingDriver(const char *portName)
+    : asynPortDriver(portName, 1, 1,
+                     asynInt32ArrayMask | asynDrvUserMask,
+                     asynInt32ArrayMask,
+                     0, 1, 0, 0)
+{
+    createParam("ARRAY", asynParamInt32Array, &P_Array);
+}
+
+/* Waits until count arrays have been processed */
+static int waitProcessed(int count)
+{
+    while (numProcessed < count) {
+        if (epicsEventWaitWithTimeout(processedEvent, 5.0) != epicsEventWaitOK)
+            return 0;
+    }
+    return 1;
+}
+
+/* Waits until the FIFO_OVERFLOWS record shows count */
+static epicsInt32 waitOverflows(epicsInt32 count)
+{
+    DBADDR addr;
+    epicsInt32 value = -1;
+    int i;
+
+    if (dbNameToAddr("RING:OVERFLOWS", &addr)) return -1;
+    for (i = 0; i < 500; i++) {
+        dbGetField(&addr, DBR_LONG, &value, NULL, NULL, NULL);
+        if (value == count) break;
+        epicsThreadSleep(0.01);
+    }
+    return value;
+}
+
+static int checkOrder(int start, epicsInt32 firstValue)
+{
+    int i;
+
+    for (i = 0; i < FIFO_SIZE; i++) {
+        if (firstElements[start + i] != firstValue + i) {
+            testDiag("array %d has first element %d, expected %d",
+                     start + i, firstElements[start + i], firstValue + i);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+MAIN(ArrayRingTest)
+{
+    arrayRingDriver *pDriver;
+    DBADDR addr;
+    dbCommon *precord;
+    epicsInt32 arrays[NUM_ARRAYS][NELM];
+    asynArrayBuffer *pbuffers[NUM_ARRAYS];
+    asynArrayBuffer *pfound;
+    int released, kept;
+    int i;
+
+    testPlan(8);
+    processedEvent = epicsEventMustCreate(epicsEventEmpty);
+
+    testdbPrepare();
+    testdbReadDatabase("ArrayRingTest.dbd", NULL, NULL);
+    ArrayRingTest_registerRecordDeviceDriver(pdbbase);
+    pDriver = new arrayRingDriver(PORT_NAME);
+    testdbReadDatabase("ArrayRingTest.db", NULL, "PORT=" PORT_NAME);
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    if (dbNameToAddr("RING:WF", &addr))
+        testAbort("RING:WF not found");
+    precord = addr.precord;
+
+    /* Arrays copied by the device support. The record is locked so none is
+     * processed until all have been added, and the 2 oldest are dropped */
+    memset(arrays, 0, sizeof(arrays));
+    dbScanLock(precord);
+    for (i = 0; i < NUM_ARRAYS; i++) {
+        arrays[i][0] = i + 1;
+        pDriver->doCallbacksInt32Array(arrays[i], NELM, pDriver->P_Array, 0);
+    }
+    dbScanUnlock(precord);
+    testOk(waitProcessed(FIFO_SIZE) && checkOrder(0, NUM_ARRAYS - FIFO_SIZE + 1),
+           "Copied arrays processed oldest first, oldest %d dropped",
+           NUM_ARRAYS - FIFO_SIZE);
+    testOk(waitOverflows(NUM_ARRAYS - FIFO_SIZE) == NUM_ARRAYS - FIFO_SIZE,
+           "FIFO_OVERFLOWS is %d", NUM_ARRAYS - FIFO_SIZE);
+
+    /* Shared buffers, which the device support keeps in the ring. They are
+     * all created first so a dropped buffer is not reused by the next create */
+    for (i = 0; i < NUM_ARRAYS; i++) {
+        pbuffers[i] = pasynArrayBuffer->create(NELM, sizeof(epicsInt32));
+        memset(pbuffers[i]->data, 0, NELM*sizeof(epicsInt32));
+        ((epicsInt32 *)pbuffers[i]->data)[0] = 11 + i;
+    }
+    dbScanLock(precord);
+    for (i = 0; i < NUM_ARRAYS; i++) {
+        pDriver->doCallbacksInt32Array((epicsInt32 *)pbuffers[i]->data, NELM,
+                                       pDriver->P_Array, 0);
+    }
+    for (i = 0; i < NUM_ARRAYS; i++)
+        pasynArrayBuffer->release(pbuffers[i]);
+    released = 1;
+    for (i = 0; i < NUM_ARRAYS - FIFO_SIZE; i++) {
+        pfound = pasynArrayBuffer->find(pbuffers[i]->data);
+        if (pfound) {
+            pasynArrayBuffer->release(pfound);
+            released = 0;
+        }
+    }
+    testOk(released, "Shared buffers of the dropped arrays released");
+    kept = 1;
+    for (i = NUM_ARRAYS - FIFO_SIZE; i < NUM_ARRAYS; i++) {
+        pfound = pasynArrayBuffer->find(pbuffers[i]->data);
+        if (pfound) pasynArrayBuffer->release(pfound);
+        else kept = 0;
+    }
+    testOk(kept, "Shared buffers of the queued arrays kept");
+    dbScanUnlock(precord);
+
+    testOk(waitProcessed(2*FIFO_SIZE) &&
+           checkOrder(FIFO_SIZE, 11 + NUM_ARRAYS - FIFO_SIZE),
+           "Shared arrays processed oldest first");
+    testOk(waitOverflows(2*(NUM_ARRAYS - FIFO_SIZE)) == 2*(NUM_ARRAYS - FIFO_SIZE),
+           "FIFO_OVERFLOWS is %d", 2*(NUM_ARRAYS - FIFO_SIZE));
+    released = 1;
+    for (i = 0; i < NUM_ARRAYS; i++) {
+        pfound = pasynArrayBuffer->find(pbuffers[i]->data);
+        if (pfound) {
+            pasynArrayBuffer->release(pfound);
+            released = 0;
+        }
+    }
+    testOk(released, "All shared buffers released after processing");
+
+    epicsThreadSleep(0.5);
+    testOk(numProcessed == 2*FIFO_SIZE, "Processed %d times, expected %d",
+           numProcessed, 2*FIFO_SIZE);
+
+    testIocShutdownOk();
+    testdbCleanup();
+    return testDone();
+}
@@ -0,0 +1,168 @@
+/*
+ * TimeSeriesTest.cpp
+ *
+ * Tests the time series device support: averaging of blocks of values into
+ * one point, which must round for integer types, and the rolling window,
+ * which must return the most recent points oldest first after it wraps.
+ *
+ ***************************************************************************
+ * This file is distributed subject to a Software License Agreement found  *
+ * in the file LICENSE that is included with this distribution.            *
+ ***************************************************************************
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <epicsThread.h>
+#include <epicsStdio.h>
+#include <dbAccess.h>
+#include <dbUnitTest.h>
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include "asynPortDriver.h"
+
+#define PORT_NAME   "TS"
+#define NELM        4
+
+extern "C" int TimeSeriesTest_registerRecordDeviceDriver(struct dbBase *pdbbase);
+
+class timeSeriesDriver : public asynPortDriver {
+public:
+    timeSeriesDriver(const char *portName);
+    void sendValues(int param, const epicsInt32 *values, int count);
+    int P_AvgValue;
+    int P_RollValue;
+};
+
+timeSeriesDriver::timeSeriesDriver(const char *portName)
+    : asynPortDriver(portName, 1, 2,
+                     asynInt32Mask | asynDrvUserMask,
+                     asynInt32Mask,
+                     0, 1, 0, 0)
+{
+    createParam("AVG_VALUE", asynParamInt32, &P_AvgValue);
+    createParam("ROLL_VALUE", asynParamInt32, &P_RollValue);
+}
+
+/* Only changed values are called back, so consecutive values must differ */
+void timeSeriesDriver::sendValues(int param, const epicsInt32 *values, int count)
+{
+    int i;
+
+    lock();
+    for (i = 0; i < count; i++) {
+        setIntegerParam(param, values[i]);
+        callParamCallbacks();
+    }
+    unlock();
+}
+
+static epicsInt32 getLong(const char *name)
+{
+    DBADDR addr;
+    epicsInt32 value = -1;
+
+    if (dbNameToAddr(name, &addr) == 0)
+        dbGetField(&addr, DBR_LONG, &value, NULL, NULL, NULL);
+    return value;
+}
+
+static void putLong(const char *name, epicsInt32 value)
+{
+    DBADDR addr;
+
+    if (dbNameToAddr(name, &addr) == 0)
+        dbPutField(&addr, DBR_LONG, &value, 1);
+}
+
+/* Waits until the waveform has nord points equal to expected */
+static int waitArray(const char *name, const epicsInt32 *expected, long nord)
+{
+    DBADDR addr;
+    epicsInt32 data[NELM];
+    long nRequest = 0;
+    int i;
+
+    if (dbNameToAddr(name, &addr)) return 0;
+    for (i = 0; i < 500; i++) {
+        nRequest = NELM;
+        memset(data, 0, sizeof(data));
+        dbGetField(&addr, DBR_LONG, data, NULL, &nRequest, NULL);
+        if ((nRequest == nord) &&
+            (memcmp(data, expected, nord*sizeof(epicsInt32)) == 0)) return 1;
+        epicsThreadSleep(0.01);
+    }
+    testDiag("%s has %ld points %d %d %d %d", name, nRequest,
+             data[0], data[1], data[2], data[3]);
+    return 0;
+}
+
+static int waitNotBusy(const char *name)
+{
+    char busyName[80];
+    int i;
+
+    epicsSnprintf(busyName, sizeof(busyName), "%s.BUSY", name);
+    for (i = 0; i < 500; i++) {
+        if (getLong(busyName) == 0) return 1;
+        epicsThreadSleep(0.01);
+    }
+    return 0;
+}
+
+MAIN(TimeSeriesTest)
+{
+    timeSeriesDriver *pDriver;
+    /* Blocks of 2 whose averages are halfway, plus one block that ends the acquisition */
+    static const epicsInt32 avgValues[] = {-1, -2, 3, 4, -3, -4, 1, 2, 5, 6};
+    static const epicsInt32 avgExpected[NELM] = {-2, 4, -4, 2};
+    static const epicsInt32 roll1[] = {10, 11, 12};
+    static const epicsInt32 roll1Expected[] = {10, 11, 12};
+    static const epicsInt32 roll2[] = {13, 14, 15};
+    static const epicsInt32 roll2Expected[NELM] = {12, 13, 14, 15};
+    static const epicsInt32 roll3[] = {16, 17, 18};
+    static const epicsInt32 roll3Expected[NELM] = {15, 16, 17, 18};
+    static const epicsInt32 roll4[] = {20, 21, 22};
+    static const epicsInt32 roll4Expected[] = {20, 21, 22};
+
+    testPlan(7);
+
+    testdbPrepare();
+    testdbReadDatabase("TimeSeriesTest.dbd", NULL, NULL);
+    TimeSeriesTest_registerRecordDeviceDriver(pdbbase);
+    pDriver = new timeSeriesDriver(PORT_NAME);
+    testdbReadDatabase("TimeSeriesTest.db", NULL, "PORT=" PORT_NAME);
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    /* Block reduction */
+    putLong("TS:AVG.RARM", 1);
+    testOk(getLong("TS:AVG.BUSY") == 1, "TS:AVG acquiring after RARM=1");
+    pDriver->sendValues(pDriver->P_AvgValue, avgValues,
+                        (int)(sizeof(avgValues)/sizeof(avgValues[0])));
+    testOk(waitNotBusy("TS:AVG"), "TS:AVG done after %d blocks", NELM + 1);
+    testOk(waitArray("TS:AVG", avgExpected, NELM),
+           "Block averages rounded to the nearest integer");
+
+    /* Rolling window: before it is full, after it wraps, and after RARM=1 */
+    putLong("TS:ROLL.RARM", 1);
+    pDriver->sendValues(pDriver->P_RollValue, roll1, 3);
+    testOk(waitArray("TS:ROLL", roll1Expected, 3), "Partial window has 3 points");
+    pDriver->sendValues(pDriver->P_RollValue, roll2, 3);
+    testOk(waitArray("TS:ROLL", roll2Expected, NELM),
+           "Wrapped window has the newest points oldest first");
+    pDriver->sendValues(pDriver->P_RollValue, roll3, 3);
+    testOk(waitArray("TS:ROLL", roll3Expected, NELM),
+           "Window wrapped again has the newest points oldest first");
+    putLong("TS:ROLL.RARM", 1);
+    pDriver->sendValues(pDriver->P_RollValue, roll4, 3);
+    testOk(waitArray("TS:ROLL", roll4Expected, 3), "RARM=1 clears the window");
+    putLong("TS:ROLL.RARM", 2);
+
+    testIocShutdownOk();
+    testdbCleanup();
+    return testDone();
+}
@@ -46,6 +46,7 @@
 #include <iocsh.h>
 #include <epicsAssert.h>
 #include <epicsExit.h>
+#include <epicsMutex.h>
 #include <epicsStdio.h>
 #include <epicsString.h>
 #include <epicsThread.h>
@@ -55,9 +56,11 @@
 #include <epicsExport.h>
 #include "asynDriver.h"
 #include "asynOctet.h"
+#include "asynOption.h"
 #include "asynInterposeCom.h"
 #include "asynInterposeEos.h"
 #include "drvAsynIPPort.h"
+#include "drvAsynIPReactor.h"
 
 #if !defined(_WIN32) && !defined(vxWorks) && defined(AF_UNIX)
 # define HAS_AF_UNIX 1
@@ -67,6 +70,11 @@
 # include <sys/un.h>
 #endif
 
+#if !defined(_WIN32) && !defined(vxWorks)
+# define HAS_SENDMSG 1
+# include <sys/uio.h>
+#endif
+
 #if defined(__rtems__)
 # define USE_SOCKTIMEOUT
 #else
@@ -90,6 +98,17 @@
 /* This delay is how long to wait in seconds after a send fails with errno ==
  * EAGAIN or EINTR before trying again */
 #define SEND_RETRY_DELAY 0.01
+/* Maximum number of pieces passed to one sendmsg() call */
+#define MAX_IOV 16
+/* Timeout of the read done when the reactor sees unsolicited input */
+#define UNSOLICITED_READ_TIMEOUT 0.1
+/* Size of the buffer for the read done when the reactor sees unsolicited input */
+#define UNSOLICITED_READ_SIZE 1024
+/* Maximum number of reads done for one wakeup of the reactor */
+#define UNSOLICITED_MAX_READS 100
+/* How long the reactor waits before looking at the socket again when input
+ * arrives and there are no asynOctet interrupt users */
+#define UNSOLICITED_RECHECK_DELAY 1.0
 
 /*
  * This structure holds the hardware-specific information for a single
@@ -114,6 +133,12 @@ typedef struct {
     size_t             farAddrSize;
     asynInterface      common;
     asynInterface      octet;
+    asynInterface      option;
+    drvAsynIPReactorHandle *reactor;     /* Null unless option unsolicitedInput is Y */
+    asynUser          *pasynUserUnsolicited;
+    epicsMutexId       reactorLock;
+    int                readActive;
+    int                unsolicitedQueued;
 } ttyController_t;
 
 #define FLAG_BROADCAST                  0x1
@@ -194,6 +219,7 @@ closeConnection(asynUser *pasynUser,ttyController_t *tty,const char *why)
     asynPrint(pasynUser, ASYN_TRACE_FLOW,
               "Close %s connection (fd %d): %s\n", tty->IPDeviceName, tty->fd, why);
     if (tty->fd != INVALID_SOCKET) {
+        if (tty->reactor) drvAsynIPReactorDetach(tty->reactor);
         epicsSocketDestroy(tty->fd);
         tty->fd = INVALID_SOCKET;
     }
@@ -220,6 +246,7 @@ asynCommonReport(void *drvPvt, FILE *fp, int details)
         fprintf(fp, "                    fd: %d\n", tty->fd);
         fprintf(fp, "    Characters written: %lu\n", tty->nWritten);
         fprintf(fp, "       Characters read: %lu\n", tty->nRead);
+        fprintf(fp, "           Uses reactor: %s\n", tty->reactor ? "Yes" : "No");
     }
 }
 
@@ -238,6 +265,10 @@ cleanup (void *arg)
     if(status!=asynSuccess)
         asynPrint(tty->pasynUser, ASYN_TRACE_ERROR, "%s: cleanup locking error\n", tty->portName);
 
+    if (tty->reactor) {
+        drvAsynIPReactorDestroy(tty->reactor);
+        tty->reactor = 0;
+    }
     if (tty->fd != INVALID_SOCKET) {
         asynPrint(tty->pasynUser, ASYN_TRACE_FLOW, "%s: shutdown socket\n", tty->portName);
         tty->flags |= FLAG_SHUTDOWN; /* prevent reconnect */
@@ -361,6 +392,7 @@ connectIt(void *drvPvt, asynUser *pasynUser)
     asynPrint(pasynUser, ASYN_TRACE_FLOW,
                           "Opened connection to %s\n", tty->IPDeviceName);
     tty->fd = fd;
+    if (tty->reactor) drvAsynIPReactorAttach(tty->reactor, fd);
     return asynSuccess;
 }
 
@@ -389,12 +421,47 @@ asynCommonDisconnect(void *drvPvt, asynUser *pasynUser)
     return asynSuccess;
 }
 
+/*
+ * Send the pieces from vector[0].data+offset on with one system call.
+ * Without sendmsg() only the first piece is sent, the caller loops.
+ */
+static int sendVector(SOCKET fd, const asynOctetVector *vector, int count,
+    size_t offset)
+{
+#ifdef HAS_SENDMSG
+    struct iovec iov[MAX_IOV];
+    struct msghdr msg;
+    int flags = 0;
+    int i;
+
+    if (count > MAX_IOV) {
+        count = MAX_IOV;
+#ifdef MSG_MORE
+        /* The rest follows at once, don't send a short segment */
+        flags |= MSG_MORE;
+#endif
+    }
+    for (i=0; i<count; i++) {
+        iov[i].iov_base = (char *)vector[i].data + offset;
+        iov[i].iov_len = vector[i].numchars - offset;
+        offset = 0;
+    }
+    memset(&msg, 0, sizeof msg);
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+    return (int)sendmsg(fd, &msg, flags);
+#else
+    return send(fd, (char *)vector[0].data + offset,
+                (int)(vector[0].numchars - offset), 0);
+#endif
+}
+
 /*Beginning of asynOctet methods*/
 /*
  * Write to the TCP port
  */
-static asynStatus writeIt(void *drvPvt, asynUser *pasynUser,
-    const char *data, size_t numchars,size_t *nbytesTransfered)
+static asynStatus writeVectorIt(void *drvPvt, asynUser *pasynUser,
+    const asynOctetVector *vector, int count, size_t *nbytesTransfered)
 {
     ttyController_t *tty = (ttyController_t *)drvPvt;
     int thisWrite;
@@ -404,12 +471,18 @@ static asynStatus writeIt(void *drvPvt, asynUser *pasynUser,
     epicsTimeStamp startTime;
     epicsTimeStamp endTime;
     int haveStartTime;
+    size_t numchars = 0;
+    size_t offset = 0;
+    int i;
 
     assert(tty);
     asynPrint(pasynUser, ASYN_TRACE_FLOW,
               "%s write.\n", tty->IPDeviceName);
-    asynPrintIO(pasynUser, ASYN_TRACEIO_DRIVER, data, numchars,
-                "%s write %lu\n", tty->IPDeviceName, (unsigned long)numchars);
+    for (i=0; i<count; i++) {
+        asynPrintIO(pasynUser, ASYN_TRACEIO_DRIVER, vector[i].data, vector[i].numchars,
+                    "%s write %lu\n", tty->IPDeviceName, (unsigned long)vector[i].numchars);
+        numchars += vector[i].numchars;
+    }
     *nbytesTransfered = 0;
     if (tty->fd == INVALID_SOCKET) {
         if (tty->flags & FLAG_CONNECT_PER_TRANSACTION) {
@@ -457,8 +530,14 @@ static asynStatus writeIt(void *drvPvt, asynUser *pasynUser,
             if (epicsTimeDiffInSeconds(&endTime, &startTime)*1000 > writePollmsec) break; 
         }
 #endif
+        /* Skip the pieces that have been sent */
+        while (vector->numchars == offset) {
+            vector++;
+            count--;
+            offset = 0;
+        }
         for (;;) {
-            thisWrite = send(tty->fd, (char *)data, (int)numchars, 0);
+            thisWrite = sendVector(tty->fd, vector, count, offset);
             if (thisWrite >= 0) break;
             if (SOCKERRNO == SOCK_EWOULDBLOCK || SOCKERRNO == SOCK_EINTR) {
                 if (!haveStartTime) {
@@ -483,7 +562,12 @@ static asynStatus writeIt(void *drvPvt, asynUser *pasynUser,
             numchars -= thisWrite;
             if (numchars == 0)
                 break;
-            data += thisWrite;
+            offset += thisWrite;
+            while (offset > vector->numchars) {
+                offset -= vector->numchars;
+                vector++;
+                count--;
+            }
         }
         else if (thisWrite == 0) {
             status = asynTimeout;
@@ -505,10 +589,20 @@ static asynStatus writeIt(void *drvPvt, asynUser *pasynUser,
     return status;
 }
 
+static asynStatus writeIt(void *drvPvt, asynUser *pasynUser,
+    const char *data, size_t numchars,size_t *nbytesTransfered)
+{
+    asynOctetVector vector;
+
+    vector.data = data;
+    vector.numchars = numchars;
+    return writeVectorIt(drvPvt, pasynUser, &vector, 1, nbytesTransfered);
+}
+
 /*
  * Read from the TCP port
  */
-static asynStatus readIt(void *drvPvt, asynUser *pasynUser,
+static asynStatus readSocket(void *drvPvt, asynUser *pasynUser,
     char *data, size_t maxchars,size_t *nbytesTransfered,int *gotEom)
 {
     ttyController_t *tty = (ttyController_t *)drvPvt;
@@ -612,6 +706,214 @@ static asynStatus readIt(void *drvPvt, asynUser *pasynUser,
     return status;
 }
 
+static asynStatus readIt(void *drvPvt, asynUser *pasynUser,
+    char *data, size_t maxchars,size_t *nbytesTransfered,int *gotEom)
+{
+    ttyController_t *tty = (ttyController_t *)drvPvt;
+    asynStatus status;
+
+    if (!tty->reactor)
+        return readSocket(drvPvt, pasynUser, data, maxchars, nbytesTransfered, gotEom);
+    /* Input that arrives while the port reads is not unsolicited */
+    epicsMutexMustLock(tty->reactorLock);
+    tty->readActive = 1;
+    epicsMutexUnlock(tty->reactorLock);
+    status = readSocket(drvPvt, pasynUser, data, maxchars, nbytesTransfered, gotEom);
+    epicsMutexMustLock(tty->reactorLock);
+    tty->readActive = 0;
+    epicsMutexUnlock(tty->reactorLock);
+    drvAsynIPReactorArm(tty->reactor);
+    return status;
+}
+
+/*
+ * Check if anybody wants unsolicited input
+ */
+static int
+hasInterruptUsers(asynUser *pasynUser)
+{
+    void *pasynPvt;
+    ELLLIST *plist;
+    int numberUsers = 0;
+
+    if ((pasynManager->getInterruptPvt(pasynUser, asynOctetType, &pasynPvt) == asynSuccess)
+     && (pasynManager->interruptStart(pasynPvt, &plist) == asynSuccess)) {
+        numberUsers = ellCount(plist);
+        pasynManager->interruptEnd(pasynPvt);
+    }
+    return numberUsers > 0;
+}
+
+/*
+ * Read unsolicited input in the port thread.
+ * asynOctetBase passes what is read to the asynOctet interrupt users.
+ */
+static void
+unsolicitedRead(asynUser *pasynUser)
+{
+    ttyController_t *tty = (ttyController_t *)pasynUser->userPvt;
+    asynInterface *pasynInterface;
+    asynOctet *pasynOctet;
+    char buffer[UNSOLICITED_READ_SIZE];
+    size_t nbytes;
+    int eomReason;
+    asynStatus status;
+    int i;
+
+    pasynInterface = pasynManager->findInterface(pasynUser, asynOctetType, 1);
+    /* unsolicitedInput can have been set to N after the request was queued */
+    if (pasynInterface && tty->reactor) {
+        pasynOctet = (asynOctet *)pasynInterface->pinterface;
+        /* Keep reading while there is input, since an interpose layer can
+         * hold more than one message after the socket has been emptied */
+        pasynUser->timeout = UNSOLICITED_READ_TIMEOUT;
+        for (i=0; i<UNSOLICITED_MAX_READS; i++) {
+            nbytes = 0;
+            status = pasynOctet->read(pasynInterface->drvPvt, pasynUser,
+                                      buffer, sizeof buffer, &nbytes, &eomReason);
+            if ((status != asynSuccess) || (nbytes == 0)) break;
+            if (!hasInterruptUsers(pasynUser)) break;
+            pasynUser->timeout = 0;
+        }
+    }
+    epicsMutexMustLock(tty->reactorLock);
+    tty->unsolicitedQueued = 0;
+    epicsMutexUnlock(tty->reactorLock);
+    /* setOption and cleanup at exit destroy the handle */
+    if (tty->reactor) drvAsynIPReactorArm(tty->reactor);
+}
+
+/*
+ * Called by a reactor thread when the socket has input that no read is waiting for
+ */
+static void
+reactorCallback(void *userPvt, SOCKET fd)
+{
+    ttyController_t *tty = (ttyController_t *)userPvt;
+    asynUser *pasynUser = tty->pasynUserUnsolicited;
+
+    epicsMutexMustLock(tty->reactorLock);
+    if (tty->readActive || tty->unsolicitedQueued) {
+        /* readIt or unsolicitedRead arm the reactor again when they are done */
+        epicsMutexUnlock(tty->reactorLock);
+        return;
+    }
+    epicsMutexUnlock(tty->reactorLock);
+    if (!hasInterruptUsers(pasynUser)) {
+        /* Leave the input for the next read */
+        drvAsynIPReactorArmDelayed(tty->reactor, UNSOLICITED_RECHECK_DELAY);
+        return;
+    }
+    epicsMutexMustLock(tty->reactorLock);
+    tty->unsolicitedQueued = 1;
+    epicsMutexUnlock(tty->reactorLock);
+    if (pasynManager->queueRequest(pasynUser, asynQueuePriorityLow, 0) != asynSuccess) {
+        epicsMutexMustLock(tty->reactorLock);
+        tty->unsolicitedQueued = 0;
+        epicsMutexUnlock(tty->reactorLock);
+        drvAsynIPReactorArmDelayed(tty->reactor, UNSOLICITED_RECHECK_DELAY);
+    }
+}
+
+/*
+ * Start or stop passing input that arrives between reads to the asynOctet
+ * interrupt users. Called with the port locked.
+ */
+static asynStatus
+setUnsolicitedInput(ttyController_t *tty, asynUser *pasynUser, int enable)
+{
+    asynStatus status;
+
+    if (!enable) {
+        if (tty->reactor) {
+            drvAsynIPReactorDestroy(tty->reactor);
+            tty->reactor = 0;
+        }
+        return asynSuccess;
+    }
+    if (tty->reactor)
+        return asynSuccess;
+    if (!drvAsynIPReactorEnabled()) {
+        epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                      "drvAsynIPReactorConfigure has not been called");
+        return asynError;
+    }
+    if (tty->flags & FLAG_CONNECT_PER_TRANSACTION) {
+        epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                      "Unsolicited input needs a permanent connection");
+        return asynError;
+    }
+    if (!tty->pasynUserUnsolicited) {
+        tty->pasynUserUnsolicited = pasynManager->createAsynUser(unsolicitedRead,0);
+        tty->pasynUserUnsolicited->userPvt = tty;
+        status = pasynManager->connectDevice(tty->pasynUserUnsolicited,tty->portName,-1);
+        if (status != asynSuccess) {
+            epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                          "connectDevice failed %s",
+                          tty->pasynUserUnsolicited->errorMessage);
+            pasynManager->freeAsynUser(tty->pasynUserUnsolicited);
+            tty->pasynUserUnsolicited = 0;
+            return asynError;
+        }
+        tty->reactorLock = epicsMutexMustCreate();
+    }
+    tty->reactor = drvAsynIPReactorCreate(tty->portName, reactorCallback, tty);
+    if (tty->fd != INVALID_SOCKET)
+        drvAsynIPReactorAttach(tty->reactor, tty->fd);
+    return asynSuccess;
+}
+
+/*
+ * asynOption methods
+ */
+static asynStatus
+setOption(void *drvPvt, asynUser *pasynUser, const char *key, const char *val)
+{
+    ttyController_t *tty = (ttyController_t *)drvPvt;
+
+    assert(tty);
+    asynPrint(pasynUser, ASYN_TRACE_FLOW,
+                    "%s setOption key %s val %s\n", tty->portName, key, val);
+    if (epicsStrCaseCmp(key, "unsolicitedInput") == 0) {
+        if (epicsStrCaseCmp(val, "Y") == 0)
+            return setUnsolicitedInput(tty, pasynUser, 1);
+        if (epicsStrCaseCmp(val, "N") == 0)
+            return setUnsolicitedInput(tty, pasynUser, 0);
+        epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                                                            "Bad value");
+        return asynError;
+    }
+    epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                                            "Unsupported key \"%s\"", key);
+    return asynError;
+}
+
+static asynStatus
+getOption(void *drvPvt, asynUser *pasynUser,
+                              const char *key, char *val, int valSize)
+{
+    ttyController_t *tty = (ttyController_t *)drvPvt;
+    int l;
+
+    assert(tty);
+    if (epicsStrCaseCmp(key, "unsolicitedInput") == 0) {
+        l = epicsSnprintf(val, valSize, "%c", tty->reactor ? 'Y' : 'N');
+    }
+    else {
+        epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                                                "Unsupported key \"%s\"", key);
+        return asynError;
+    }
+    if (l >= valSize) {
+        epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+                            "Value buffer for key '%s' is too small.", key);
+        return asynError;
+    }
+    return asynSuccess;
+}
+
+static const struct asynOption asynOptionMethods = { setOption, getOption };
+
 /*
  * Flush pending input
  */
@@ -646,6 +948,7 @@ static void
 ttyCleanup(ttyController_t *tty)
 {
     if (tty) {
+        drvAsynIPReactorDestroy(tty->reactor);
         if (tty->fd != INVALID_SOCKET)
             epicsSocketDestroy(tty->fd);
         free(tty->portName);
@@ -808,6 +1111,7 @@ drvAsynIPPortConfigure(const char *portName,
     }
     pasynOctet->read = readIt;
     pasynOctet->write = writeIt;
+    pasynOctet->writeVector = writeVectorIt;
     pasynOctet->flush = flushIt;
     tty->octet.interfaceType = asynOctetType;
     tty->octet.pinterface  = pasynOctet;
@@ -818,6 +1122,15 @@ drvAsynIPPortConfigure(const char *portName,
         ttyCleanup(tty);
         return -1;
     }
+    tty->option.interfaceType = asynOptionType;
+    tty->option.pinterface  = (void *)&asynOptionMethods;
+    tty->option.drvPvt = tty;
+    status = pasynManager->registerInterface(tty->portName,&tty->option);
+    if(status != asynSuccess) {
+        printf("drvAsynIPPortConfigure: Can't register option.\n");
+        ttyCleanup(tty);
+        return -1;
+    }
     if (isCom && (asynInterposeCOM(tty->portName) != 0)) {
         printf("drvAsynIPPortConfigure: asynInterposeCOM failed.\n");
         ttyCleanup(tty);
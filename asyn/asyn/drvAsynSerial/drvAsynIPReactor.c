@@ -0,0 +1,322 @@
+/* drvAsynIPReactor.c */
+/***********************************************************************
+* asynDriver is distributed subject to a Software License Agreement
+* found in file LICENSE that is included with this distribution.
+***********************************************************************/
+
+/*
+ * The reactor waits for input on the sockets of IP ports with a few shared
+ * threads, instead of one thread blocked on each socket. It is used by TCP server ports to
+ * wait for connections, which are then accepted in the port thread, and by
+ * drvAsynIPPort ports that set the option unsolicitedInput to Y. The ports
+ * keep their asynManager port threads, which do all the reads, writes and
+ * connects, so the reactor only removes the listener threads of server ports.
+ * Delayed arms use the shared timer queue that asynManager also uses.
+ *
+ * Each handle is registered with EPOLLONESHOT, so a handle is disarmed when
+ * its callback is called and no two threads run the callback of one handle at
+ * the same time. The port arms the handle again when it has handled the input.
+ *
+ * epoll is only available on Linux. On other systems drvAsynIPReactorConfigure
+ * fails and the ports work as before.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#include <cantProceed.h>
+#include <ellLib.h>
+#include <epicsEvent.h>
+#include <epicsMutex.h>
+#include <epicsStdio.h>
+#include <epicsString.h>
+#include <epicsThread.h>
+#include <epicsTimer.h>
+#include <errlog.h>
+#include <iocsh.h>
+
+#include <epicsExport.h>
+#include "drvAsynIPReactor.h"
+
+#if defined(__linux__)
+# define HAS_EPOLL 1
+# include <sys/epoll.h>
+#endif
+
+#define MAX_REACTOR_THREADS 64
+
+struct drvAsynIPReactorHandle {
+    ELLNODE                  node;  /* Must be first */
+    char                     *name;
+    drvAsynIPReactorCallback callback;
+    void                     *userPvt;
+    SOCKET                   fd;
+    int                      armed;
+    int                      busy;
+    int                      detachWaiting;
+    unsigned long            numberCallbacks;
+    epicsEventId             idleEvent;
+    epicsTimerId             timer;
+};
+
+typedef struct reactorPvt {
+    int               epollFd;
+    int               numberThreads;
+    epicsMutexId      lock;
+    ELLLIST           handleList;
+    epicsTimerQueueId timerQueue;
+} reactorPvt;
+static reactorPvt *preactor = 0;
+
+#ifdef HAS_EPOLL
+static int epollControl(drvAsynIPReactorHandle *phandle, int op)
+{
+    struct epoll_event event;
+
+    memset(&event, 0, sizeof event);
+    event.events = EPOLLIN | EPOLLONESHOT;
+    event.data.ptr = phandle;
+    return epoll_ctl(preactor->epollFd, op, phandle->fd, &event);
+}
+
+static void reactorThread(void *arg)
+{
+    struct epoll_event event;
+    drvAsynIPReactorHandle *phandle;
+    SOCKET fd;
+    int n;
+
+    for (;;) {
+        n = epoll_wait(preactor->epollFd, &event, 1, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            errlogPrintf("drvAsynIPReactor: epoll_wait failed: %s\n", strerror(errno));
+            epicsThreadSleep(1.0);
+            continue;
+        }
+        if (n == 0) continue;
+        phandle = (drvAsynIPReactorHandle *)event.data.ptr;
+        epicsMutexMustLock(preactor->lock);
+        /* The handle can have been detached after epoll_wait returned */
+        if ((phandle->fd == INVALID_SOCKET) || !phandle->armed) {
+            epicsMutexUnlock(preactor->lock);
+            continue;
+        }
+        phandle->armed = 0;
+        phandle->busy = 1;
+        fd = phandle->fd;
+        epicsMutexUnlock(preactor->lock);
+        phandle->callback(phandle->userPvt, fd);
+        epicsMutexMustLock(preactor->lock);
+        phandle->busy = 0;
+        phandle->numberCallbacks++;
+        if (phandle->detachWaiting) epicsEventSignal(phandle->idleEvent);
+        epicsMutexUnlock(preactor->lock);
+    }
+}
+#endif
+
+static void armTimerCallback(void *arg)
+{
+    drvAsynIPReactorArm((drvAsynIPReactorHandle *)arg);
+}
+
+epicsShareFunc int drvAsynIPReactorConfigure(int numberThreads)
+{
+#ifdef HAS_EPOLL
+    char name[40];
+    int i;
+
+    if (preactor) {
+        printf("drvAsynIPReactorConfigure: the reactor is already configured\n");
+        return -1;
+    }
+    if (numberThreads <= 0) numberThreads = 1;
+    if (numberThreads > MAX_REACTOR_THREADS) numberThreads = MAX_REACTOR_THREADS;
+    preactor = callocMustSucceed(1, sizeof(*preactor), "drvAsynIPReactorConfigure");
+    preactor->epollFd = epoll_create(64);
+    if (preactor->epollFd < 0) {
+        printf("drvAsynIPReactorConfigure: epoll_create failed: %s\n", strerror(errno));
+        free(preactor);
+        preactor = 0;
+        return -1;
+    }
+    preactor->numberThreads = numberThreads;
+    preactor->lock = epicsMutexMustCreate();
+    ellInit(&preactor->handleList);
+    preactor->timerQueue = epicsTimerQueueAllocate(1, epicsThreadPriorityScanLow);
+    for (i=0; i<numberThreads; i++) {
+        epicsSnprintf(name, sizeof(name), "asynIPReactor%d", i);
+        epicsThreadCreate(name, epicsThreadPriorityMedium,
+                          epicsThreadGetStackSize(epicsThreadStackMedium),
+                          reactorThread, 0);
+    }
+    return 0;
+#else
+    printf("drvAsynIPReactorConfigure: the reactor needs epoll, which this system does not have\n");
+    return -1;
+#endif
+}
+
+epicsShareFunc int drvAsynIPReactorEnabled(void)
+{
+    return preactor != 0;
+}
+
+epicsShareFunc drvAsynIPReactorHandle *drvAsynIPReactorCreate(const char *name,
+                                          drvAsynIPReactorCallback callback,
+                                          void *userPvt)
+{
+    drvAsynIPReactorHandle *phandle;
+
+    if (!preactor) return 0;
+    phandle = callocMustSucceed(1, sizeof(*phandle), "drvAsynIPReactorCreate");
+    phandle->name = epicsStrDup(name);
+    phandle->callback = callback;
+    phandle->userPvt = userPvt;
+    phandle->fd = INVALID_SOCKET;
+    phandle->idleEvent = epicsEventMustCreate(epicsEventEmpty);
+    phandle->timer = epicsTimerQueueCreateTimer(preactor->timerQueue,
+                                                armTimerCallback, phandle);
+    epicsMutexMustLock(preactor->lock);
+    ellAdd(&preactor->handleList, &phandle->node);
+    epicsMutexUnlock(preactor->lock);
+    return phandle;
+}
+
+epicsShareFunc int drvAsynIPReactorAttach(drvAsynIPReactorHandle *phandle, SOCKET fd)
+{
+    int status = 0;
+
+#ifdef HAS_EPOLL
+    epicsMutexMustLock(preactor->lock);
+    phandle->fd = fd;
+    phandle->armed = 1;
+    if (epollControl(phandle, EPOLL_CTL_ADD) < 0) {
+        errlogPrintf("drvAsynIPReactor: %s can't add fd %d: %s\n",
+                     phandle->name, (int)fd, strerror(errno));
+        phandle->fd = INVALID_SOCKET;
+        phandle->armed = 0;
+        status = -1;
+    }
+    epicsMutexUnlock(preactor->lock);
+#endif
+    return status;
+}
+
+epicsShareFunc void drvAsynIPReactorDetach(drvAsynIPReactorHandle *phandle)
+{
+#ifdef HAS_EPOLL
+    epicsTimerCancel(phandle->timer);
+    epicsMutexMustLock(preactor->lock);
+    if (phandle->fd != INVALID_SOCKET) {
+        epollControl(phandle, EPOLL_CTL_DEL);
+        phandle->fd = INVALID_SOCKET;
+        phandle->armed = 0;
+    }
+    while (phandle->busy) {
+        phandle->detachWaiting = 1;
+        epicsMutexUnlock(preactor->lock);
+        epicsEventMustWait(phandle->idleEvent);
+        epicsMutexMustLock(preactor->lock);
+    }
+    phandle->detachWaiting = 0;
+    epicsMutexUnlock(preactor->lock);
+#endif
+}
+
+epicsShareFunc void drvAsynIPReactorDestroy(drvAsynIPReactorHandle *phandle)
+{
+    if (!phandle) return;
+    drvAsynIPReactorDetach(phandle);
+    /* Waits for a delayed arm that is running, which does nothing once detached */
+    epicsTimerQueueDestroyTimer(preactor->timerQueue, phandle->timer);
+    epicsMutexMustLock(preactor->lock);
+    ellDelete(&preactor->handleList, &phandle->node);
+    epicsMutexUnlock(preactor->lock);
+    epicsEventDestroy(phandle->idleEvent);
+    free(phandle->name);
+    free(phandle);
+}
+
+epicsShareFunc void drvAsynIPReactorArm(drvAsynIPReactorHandle *phandle)
+{
+#ifdef HAS_EPOLL
+    epicsMutexMustLock(preactor->lock);
+    if ((phandle->fd != INVALID_SOCKET) && !phandle->armed) {
+        phandle->armed = 1;
+        if (epollControl(phandle, EPOLL_CTL_MOD) < 0) {
+            errlogPrintf("drvAsynIPReactor: %s can't arm fd %d: %s\n",
+                         phandle->name, (int)phandle->fd, strerror(errno));
+            phandle->armed = 0;
+        }
+    }
+    epicsMutexUnlock(preactor->lock);
+#endif
+}
+
+epicsShareFunc void drvAsynIPReactorArmDelayed(drvAsynIPReactorHandle *phandle,
+                                               double delay)
+{
+    epicsTimerStartDelay(phandle->timer, delay);
+}
+
+epicsShareFunc void drvAsynIPReactorReport(FILE *fp, int details)
+{
+    drvAsynIPReactorHandle *phandle;
+
+    if (!preactor) {
+        fprintf(fp, "drvAsynIPReactor not configured\n");
+        return;
+    }
+    epicsMutexMustLock(preactor->lock);
+    fprintf(fp, "drvAsynIPReactor threads %d handles %d\n",
+            preactor->numberThreads, ellCount(&preactor->handleList));
+    if (details >= 1) {
+        for (phandle = (drvAsynIPReactorHandle *)ellFirst(&preactor->handleList);
+             phandle;
+             phandle = (drvAsynIPReactorHandle *)ellNext(&phandle->node)) {
+            fprintf(fp, "    %s fd %d armed:%s callbacks %lu\n",
+                    phandle->name, (int)phandle->fd,
+                    phandle->armed ? "Yes" : "No", phandle->numberCallbacks);
+        }
+    }
+    epicsMutexUnlock(preactor->lock);
+}
+
+/*
+ * IOC shell command registration
+ */
+static const iocshArg drvAsynIPReactorConfigureArg0 = { "number of threads",iocshArgInt};
+static const iocshArg *drvAsynIPReactorConfigureArgs[] = {
+    &drvAsynIPReactorConfigureArg0};
+static const iocshFuncDef drvAsynIPReactorConfigureFuncDef =
+                      {"drvAsynIPReactorConfigure",1,drvAsynIPReactorConfigureArgs};
+static void drvAsynIPReactorConfigureCallFunc(const iocshArgBuf *args)
+{
+    drvAsynIPReactorConfigure(args[0].ival);
+}
+
+static const iocshArg drvAsynIPReactorReportArg0 = { "details",iocshArgInt};
+static const iocshArg *drvAsynIPReactorReportArgs[] = {
+    &drvAsynIPReactorReportArg0};
+static const iocshFuncDef drvAsynIPReactorReportFuncDef =
+                      {"drvAsynIPReactorReport",1,drvAsynIPReactorReportArgs};
+static void drvAsynIPReactorReportCallFunc(const iocshArgBuf *args)
+{
+    drvAsynIPReactorReport(stdout, args[0].ival);
+}
+
+static void
+drvAsynIPReactorRegisterCommands(void)
+{
+    static int firstTime = 1;
+    if (firstTime) {
+        iocshRegister(&drvAsynIPReactorConfigureFuncDef,drvAsynIPReactorConfigureCallFunc);
+        iocshRegister(&drvAsynIPReactorReportFuncDef,drvAsynIPReactorReportCallFunc);
+        firstTime = 0;
+    }
+}
+epicsExportRegistrar(drvAsynIPReactorRegisterCommands);
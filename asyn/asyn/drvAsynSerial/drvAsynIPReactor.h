@@ -0,0 +1,49 @@
+/* drvAsynIPReactor.h */
+/***********************************************************************
+* asynDriver is distributed subject to a Software License Agreement
+* found in file LICENSE that is included with this distribution.
+***********************************************************************/
+
+#ifndef DRVASYNIPREACTOR_H
+#define DRVASYNIPREACTOR_H
+
+#include <stdio.h>
+#include <shareLib.h>
+#include <osiSock.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif  /* __cplusplus */
+
+/* Shared reactor that waits for input on the sockets of IP ports */
+
+/* Called by a reactor thread when fd is readable. The handle is then disarmed
+ * until drvAsynIPReactorArm is called, so only one callback runs at a time. */
+typedef void (*drvAsynIPReactorCallback)(void *userPvt, SOCKET fd);
+
+typedef struct drvAsynIPReactorHandle drvAsynIPReactorHandle;
+
+/* Starts the reactor with numberThreads threads. Server ports configured later,
+ * and drvAsynIPPort ports that set unsolicitedInput, use it */
+epicsShareFunc int drvAsynIPReactorConfigure(int numberThreads);
+epicsShareFunc int drvAsynIPReactorEnabled(void);
+/* A port keeps its handle for all its connections */
+epicsShareFunc drvAsynIPReactorHandle *drvAsynIPReactorCreate(const char *name,
+                                          drvAsynIPReactorCallback callback,
+                                          void *userPvt);
+/* Starts waiting for input on fd */
+epicsShareFunc int drvAsynIPReactorAttach(drvAsynIPReactorHandle *phandle, SOCKET fd);
+/* Stops waiting for input, and waits for a callback that is running. Must be
+ * called before the socket is closed, and not from the callback */
+epicsShareFunc void drvAsynIPReactorDetach(drvAsynIPReactorHandle *phandle);
+/* Detaches the handle, cancels a delayed arm and frees the handle */
+epicsShareFunc void drvAsynIPReactorDestroy(drvAsynIPReactorHandle *phandle);
+epicsShareFunc void drvAsynIPReactorArm(drvAsynIPReactorHandle *phandle);
+epicsShareFunc void drvAsynIPReactorArmDelayed(drvAsynIPReactorHandle *phandle,
+                                               double delay);
+epicsShareFunc void drvAsynIPReactorReport(FILE *fp, int details);
+
+#ifdef __cplusplus
+}
+#endif  /* __cplusplus */
+#endif  /* DRVASYNIPREACTOR_H */
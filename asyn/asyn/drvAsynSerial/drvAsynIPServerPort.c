@@ -40,6 +40,7 @@
 #include "asynInterposeEos.h"
 #include "drvAsynIPServerPort.h"
 #include "drvAsynIPPort.h"
+#include "drvAsynIPReactor.h"
 
 /* This structure holds the information for an IP port created by the listener */
 typedef struct {
@@ -77,14 +78,21 @@ typedef struct {
     char               *UDPbuffer;
     int                UDPbufferSize;
     int                UDPbufferPos;
+    drvAsynIPReactorHandle *reactor;  /* Accepts TCP connections instead of a listener thread */
+    asynUser          *pasynUserAccept;  /* Queues the accepts to the port thread */
 } ttyController_t;
 
 #define THEORETICAL_UDP_MAX_SIZE 65507
+/* How long the reactor waits before trying again when the accept can not be queued */
+#define ACCEPT_RETRY_DELAY 1.0
 
 /* Function prototypes */
 static void serialBaseInit(void);
 static void closeConnection(asynUser *pasynUser, ttyController_t *tty);
 static void connectionListener(void *drvPvt);
+static void acceptConnection(ttyController_t *tty);
+static void acceptQueued(asynUser *pasynUser);
+static void reactorCallback(void *userPvt, SOCKET fd);
 static void report(void *drvPvt, FILE *fp, int details);
 static asynStatus connectIt(void *drvPvt, asynUser *pasynUser);
 static asynStatus disconnect(void *drvPvt, asynUser *pasynUser);
@@ -154,6 +162,7 @@ static void closeConnection(asynUser *pasynUser, ttyController_t *tty)
     if (tty->fd >= 0) {
         asynPrint(pasynUser, ASYN_TRACE_FLOW,
                 "drvAsynIPServerPort: close %s connection on port %d.\n", tty->portName, tty->portNumber);
+        if (tty->reactor) drvAsynIPReactorDetach(tty->reactor);
         epicsSocketDestroy(tty->fd);
         tty->fd = -1;
         pasynManager->exceptionDisconnect(pasynUser);
@@ -266,29 +275,138 @@ static void report(void *drvPvt, FILE *fp, int details)
         fprintf(fp, "                    fd: %d\n", tty->fd);
         fprintf(fp, "          Max. clients: %d\n", tty->maxClients);
         fprintf(fp, "          Num. clients: %d\n", tty->numClients);
+        fprintf(fp, "           Uses reactor: %s\n", tty->reactor ? "Yes" : "No");
     }
 }
 
 /*
- * This is the thread that listens for new connection requests, and issues asynOctet callbacks with the
- * port name when they occur.
+ * Accept a new connection, connect an IP port to it, and issue asynOctet callbacks
+ * with the port name.
  */
-static void connectionListener(void *drvPvt)
+static void acceptConnection(ttyController_t *tty)
 {
-    ttyController_t *tty = (ttyController_t *) drvPvt;
     struct sockaddr_in clientAddr;
     int clientFd;
     osiSocklen_t clientLen = sizeof (clientAddr);
     ELLLIST *pclientList;
     interruptNode *pnode;
     asynOctetInterrupt *pinterrupt;
-    asynUser *pasynUser;
+    asynUser *pasynUser = tty->pasynUser;
     int len;
     asynStatus status;
     int i;
     portList_t *pl, *p;
     int connected;
 
+    clientFd = epicsSocketAccept(tty->fd, (struct sockaddr *) &clientAddr, &clientLen);
+    asynPrint(pasynUser, ASYN_TRACE_FLOW,
+            "drvAsynIPServerPort: new connection, socket=%d on %s\n",
+            clientFd, tty->serverInfo);
+    if (clientFd < 0) {
+        /* The reactor makes the listening socket non-blocking */
+        if (tty->reactor && (SOCKERRNO == SOCK_EWOULDBLOCK))
+            return;
+        asynPrint(pasynUser, ASYN_TRACE_ERROR,
+                "drvAsynIPServerPort: accept error on %s: fd=%d, %s\n", tty->serverInfo,
+                tty->fd, strerror(errno));
+        return;
+    }
+
+    /* See if any clients have registered for callbacks.  If not, close the connection */
+    pasynManager->interruptStart(tty->octetCallbackPvt, &pclientList);
+    pnode = (interruptNode *) ellFirst(pclientList);
+    pasynManager->interruptEnd(tty->octetCallbackPvt);
+    if (!pnode) {
+        /* There are no registered clients to handle connections on this port */
+        epicsSocketDestroy(clientFd);
+        asynPrint(pasynUser, ASYN_TRACE_ERROR,
+                "drvAsynIPServerPort: no registered clients to handle connections %s\n", tty->serverInfo);
+        return;
+    }
+    /* Search for a port we have already created which is now disconnected */
+    pl = NULL;
+    for (i = 0, p = &tty->portList[0]; i < tty->numClients; i++, p++) {
+        pasynManager->isConnected(p->pasynUser, &connected);
+        if (!connected) {
+            pl = p;
+            break;
+        }
+    }
+    if (pl == NULL) {
+        /* Have we exceeded maxClients? */
+        if (tty->numClients >= tty->maxClients) {
+            asynPrint(pasynUser, ASYN_TRACE_ERROR,
+                    "drvAsynIPServerPort: %s: too many clients\n", tty->portName);
+            epicsSocketDestroy(clientFd);
+            return;
+        }
+        /* Create a new asyn port with a unique name */
+        len = (int)strlen(tty->portName) + 10; /* Room for port name + ":" + numClients */
+        pl = &tty->portList[tty->numClients];
+        pl->portName = callocMustSucceed(1, len, "drvAsynIPServerPort:connectionListener");
+        pl->fd = clientFd;
+        tty->numClients++;
+        epicsSnprintf(pl->portName, len, "%s:%d", tty->portName, tty->numClients);
+        /* Must create port with noAutoConnect, we manually connect with the file descriptor */
+        status = drvAsynIPPortConfigure(pl->portName,
+                tty->serverInfo,
+                tty->priority,
+                1, /* noAutoConnect */
+                tty->noProcessEos);
+        if (status) {
+            asynPrint(pasynUser, ASYN_TRACE_ERROR,
+                    "drvAsynIPServerPort: unable to create port %s\n", pl->portName);
+            return;
+        }
+        status = pasynCommonSyncIO->connect(pl->portName, -1, &pl->pasynUser, NULL);
+        if (status != asynSuccess) {
+            asynPrint(pasynUser, ASYN_TRACE_ERROR,
+                    "%s drvAsynIPServerPort: error calling "
+                    "pasynCommonSyncIO->connect %s\n",
+                    pl->portName, pl->pasynUser->errorMessage);
+            return;
+        }
+    }
+    /* Set the existing port to use the new file descriptor */
+    pl->pasynUser->reason = clientFd;
+    status = pasynCommonSyncIO->connectDevice(pl->pasynUser);
+    if (status != asynSuccess) {
+        asynPrint(pasynUser, ASYN_TRACE_ERROR,
+                "%s drvAsynIPServerPort: error calling "
+                "pasynCommonSyncIO->connectDevice %s\n",
+                pl->portName, pl->pasynUser->errorMessage);
+        return;
+    }
+    pl->pasynUser->reason = 0;
+    /* Set the new port to initially have the same trace mask that we have */
+    pasynTrace->setTraceMask(pl->pasynUser, pasynTrace->getTraceMask(pasynUser));
+    pasynTrace->setTraceIOMask(pl->pasynUser, pasynTrace->getTraceIOMask(pasynUser));
+
+    /* Issue callbacks to all clients who want notification on connection */
+    pasynManager->interruptStart(tty->octetCallbackPvt, &pclientList);
+    pnode = (interruptNode *) ellFirst(pclientList);
+    while (pnode) {
+        pinterrupt = pnode->drvPvt;
+
+        pinterrupt->callback(pinterrupt->userPvt, pinterrupt->pasynUser,
+                pl->portName, strlen(pl->portName), 0);
+        pnode = (interruptNode *) ellNext(&pnode->node);
+    }
+    pasynManager->interruptEnd(tty->octetCallbackPvt);
+}
+
+/*
+ * This is the thread that listens for new connection requests, and issues asynOctet callbacks with the
+ * port name when they occur.
+ */
+static void connectionListener(void *drvPvt)
+{
+    ttyController_t *tty = (ttyController_t *) drvPvt;
+    ELLLIST *pclientList;
+    interruptNode *pnode;
+    asynOctetInterrupt *pinterrupt;
+    asynUser *pasynUser;
+
     /*
      * Sanity check
      */
@@ -316,102 +434,58 @@ static void connectionListener(void *drvPvt)
             }
 
         } else {
-            clientFd = epicsSocketAccept(tty->fd, (struct sockaddr *) &clientAddr, &clientLen);
-            asynPrint(pasynUser, ASYN_TRACE_FLOW,
-                    "drvAsynIPServerPort: new connection, socket=%d on %s\n",
-                    clientFd, tty->serverInfo);
-            if (clientFd < 0) {
-                asynPrint(pasynUser, ASYN_TRACE_ERROR,
-                        "drvAsynIPServerPort: accept error on %s: fd=%d, %s\n", tty->serverInfo,
-                        tty->fd, strerror(errno));
-                continue;
-            }
-
-            /* See if any clients have registered for callbacks.  If not, close the connection */
-            pasynManager->interruptStart(tty->octetCallbackPvt, &pclientList);
-            pnode = (interruptNode *) ellFirst(pclientList);
-            pasynManager->interruptEnd(tty->octetCallbackPvt);
-            if (!pnode) {
-                /* There are no registered clients to handle connections on this port */
-                epicsSocketDestroy(clientFd);
-                asynPrint(pasynUser, ASYN_TRACE_ERROR,
-                        "drvAsynIPServerPort: no registered clients to handle connections %s\n", tty->serverInfo);
-                continue;
-            }
-            /* Search for a port we have already created which is now disconnected */
-            pl = NULL;
-            for (i = 0, p = &tty->portList[0]; i < tty->numClients; i++, p++) {
-                pasynManager->isConnected(p->pasynUser, &connected);
-                if (!connected) {
-                    pl = p;
-                    break;
-                }
-            }
-            if (pl == NULL) {
-                /* Have we exceeded maxClients? */
-                if (tty->numClients >= tty->maxClients) {
-                    asynPrint(pasynUser, ASYN_TRACE_ERROR,
-                            "drvAsynIPServerPort: %s: too many clients\n", tty->portName);
-                    epicsSocketDestroy(clientFd);
-                    continue;
-                }
-                /* Create a new asyn port with a unique name */
-                len = (int)strlen(tty->portName) + 10; /* Room for port name + ":" + numClients */
-                pl = &tty->portList[tty->numClients];
-                pl->portName = callocMustSucceed(1, len, "drvAsynIPServerPort:connectionListener");
-                pl->fd = clientFd;
-                tty->numClients++;
-                epicsSnprintf(pl->portName, len, "%s:%d", tty->portName, tty->numClients);
-                /* Must create port with noAutoConnect, we manually connect with the file descriptor */
-                status = drvAsynIPPortConfigure(pl->portName,
-                        tty->serverInfo,
-                        tty->priority,
-                        1, /* noAutoConnect */
-                        tty->noProcessEos);
-                if (status) {
-                    asynPrint(pasynUser, ASYN_TRACE_ERROR,
-                            "drvAsynIPServerPort: unable to create port %s\n", pl->portName);
-                    continue;
-                }
-                status = pasynCommonSyncIO->connect(pl->portName, -1, &pl->pasynUser, NULL);
-                if (status != asynSuccess) {
-                    asynPrint(pasynUser, ASYN_TRACE_ERROR,
-                            "%s drvAsynIPServerPort: error calling "
-                            "pasynCommonSyncIO->connect %s\n",
-                            pl->portName, pl->pasynUser->errorMessage);
-                    continue;
-                }
-            }
-            /* Set the existing port to use the new file descriptor */
-            pl->pasynUser->reason = clientFd;
-            status = pasynCommonSyncIO->connectDevice(pl->pasynUser);
-            if (status != asynSuccess) {
-                asynPrint(pasynUser, ASYN_TRACE_ERROR,
-                        "%s drvAsynIPServerPort: error calling "
-                        "pasynCommonSyncIO->connectDevice %s\n",
-                        pl->portName, pl->pasynUser->errorMessage);
-                continue;
-            }
-            pl->pasynUser->reason = 0;
-            /* Set the new port to initially have the same trace mask that we have */
-            pasynTrace->setTraceMask(pl->pasynUser, pasynTrace->getTraceMask(pasynUser));
-            pasynTrace->setTraceIOMask(pl->pasynUser, pasynTrace->getTraceIOMask(pasynUser));
-
-            /* Issue callbacks to all clients who want notification on connection */
-            pasynManager->interruptStart(tty->octetCallbackPvt, &pclientList);
-            pnode = (interruptNode *) ellFirst(pclientList);
-            while (pnode) {
-                pinterrupt = pnode->drvPvt;
-
-                pinterrupt->callback(pinterrupt->userPvt, pinterrupt->pasynUser,
-                        pl->portName, strlen(pl->portName), 0);
-                pnode = (interruptNode *) ellNext(&pnode->node);
-            }
-            pasynManager->interruptEnd(tty->octetCallbackPvt);
+            acceptConnection(tty);
         }
     }
 }
 
+/*
+ * Accept a connection in the port thread. Creating and connecting the
+ * client port can block, so it is not done in a reactor thread.
+ */
+static void acceptQueued(asynUser *pasynUser)
+{
+    ttyController_t *tty = (ttyController_t *) pasynUser->userPvt;
+
+    /* The listening socket is closed when the port is disconnected */
+    if (tty->fd >= 0)
+        acceptConnection(tty);
+    drvAsynIPReactorArm(tty->reactor);
+}
+
+/*
+ * Called by a reactor thread when a new connection is waiting on the listening socket
+ */
+static void reactorCallback(void *userPvt, SOCKET fd)
+{
+    ttyController_t *tty = (ttyController_t *) userPvt;
+
+    /* acceptQueued arms the reactor again */
+    if (pasynManager->queueRequest(tty->pasynUserAccept, asynQueuePriorityLow, 0)
+            != asynSuccess) {
+        asynPrint(tty->pasynUser, ASYN_TRACE_ERROR,
+                "drvAsynIPServerPort: %s can't queue accept: %s\n",
+                tty->portName, tty->pasynUserAccept->errorMessage);
+        drvAsynIPReactorArmDelayed(tty->reactor, ACCEPT_RETRY_DELAY);
+    }
+}
+
+/*
+ * Let the reactor wait for connections on the listening socket.
+ * The socket is non-blocking so that a connection which goes away before
+ * it is accepted cannot block the port thread.
+ */
+static int attachReactor(ttyController_t *tty)
+{
+    osiSockIoctl_t flag = 1;
+
+    if (socket_ioctl(tty->fd, FIONBIO, &flag) < 0) {
+        printf("Can't set %s non-blocking: %s\n", tty->serverInfo, strerror(SOCKERRNO));
+        return -1;
+    }
+    return drvAsynIPReactorAttach(tty->reactor, tty->fd);
+}
+
 int createServerSocket(ttyController_t *tty) {
     int i;
     struct sockaddr_in serverAddr;
@@ -456,6 +530,8 @@ int createServerSocket(ttyController_t *tty) {
         } else {
             tty->UDPbuffer = malloc(THEORETICAL_UDP_MAX_SIZE);
         }
+        if (tty->reactor)
+            return attachReactor(tty);
     }
     return 0;
 }
@@ -500,6 +576,7 @@ static asynStatus disconnect(void *drvPvt, asynUser *pasynUser)
 static void ttyCleanup(ttyController_t *tty)
 {
     if (tty) {
+        drvAsynIPReactorDestroy(tty->reactor);
         if (tty->fd >= 0)
             epicsSocketDestroy(tty->fd);
         free(tty->portName);
@@ -664,6 +741,25 @@ int drvAsynIPServerPortConfigure(const char *portName,
         return -1;
     }
 
+    /* Let the reactor wait for TCP connections if it has been configured */
+    if (drvAsynIPReactorEnabled() && (tty->socketType == SOCK_STREAM)) {
+        tty->pasynUserAccept = pasynManager->createAsynUser(acceptQueued, 0);
+        tty->pasynUserAccept->userPvt = tty;
+        status = pasynManager->connectDevice(tty->pasynUserAccept, tty->portName, -1);
+        if (status != asynSuccess) {
+            printf("connectDevice failed %s\n", tty->pasynUserAccept->errorMessage);
+            return -1;
+        }
+        tty->reactor = drvAsynIPReactorCreate(tty->portName, reactorCallback, tty);
+        if ((tty->fd >= 0) && (attachReactor(tty) != 0)) {
+            printf("drvAsynIPServerPortConfigure: Can't attach to the reactor.\n");
+            drvAsynIPReactorDestroy(tty->reactor);
+            tty->reactor = 0;
+            return -1;
+        }
+        return 0;
+    }
+
     /* Start a thread listening on this port */
     epicsThreadCreate(tty->portName,
             epicsThreadPriorityLow,
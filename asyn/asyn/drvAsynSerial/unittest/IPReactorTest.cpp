@@ -0,0 +1,282 @@
+/*
+ * IPReactorTest.cpp
+ *
+ * Tests that drvAsynIPPort only delivers unsolicited input to asynOctet
+ * interrupt users when the option unsolicitedInput is Y, that reads still
+ * work when there are no interrupt users, and that a TCP server port accepts
+ * connections in its port thread when drvAsynIPReactor waits on its socket.
+ *
+ ***************************************************************************
+ * This file is distributed subject to a Software License Agreement found  *
+ * in the file LICENSE that is included with this distribution.            *
+ ***************************************************************************
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <osiSock.h>
+#include <epicsEvent.h>
+#include <epicsMutex.h>
+#include <epicsThread.h>
+#include <asynDriver.h>
+#include <asynOctet.h>
+#include <asynOctetSyncIO.h>
+#include <asynOption.h>
+#include <drvAsynIPPort.h>
+#include <drvAsynIPServerPort.h>
+#include <drvAsynIPReactor.h>
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#define PORT_NAME   "REACTOR_IP"
+#define SERVER_NAME "REACTOR_SERVER"
+#define MAX_DATA    256
+
+/* Keeps what the interrupt users are given */
+typedef struct {
+    epicsMutexId lock;
+    epicsEventId event;
+    int numCallbacks;
+    size_t length;
+    char data[MAX_DATA];
+    char threadName[MAX_DATA];
+} inputRecorder;
+
+static void interruptCallback(void *userPvt, asynUser *pasynUser,
+                              char *data, size_t numchars, int eomReason)
+{
+    inputRecorder *pRecorder = (inputRecorder *)userPvt;
+
+    epicsMutexMustLock(pRecorder->lock);
+    pRecorder->numCallbacks++;
+    if (numchars > MAX_DATA - 1 - pRecorder->length)
+        numchars = MAX_DATA - 1 - pRecorder->length;
+    memcpy(pRecorder->data + pRecorder->length, data, numchars);
+    pRecorder->length += numchars;
+    pRecorder->data[pRecorder->length] = 0;
+    strncpy(pRecorder->threadName, epicsThreadGetNameSelf(), MAX_DATA - 1);
+    epicsMutexUnlock(pRecorder->lock);
+    epicsEventSignal(pRecorder->event);
+}
+
+/* Waits until length octets have been received or the timeout has expired */
+static size_t waitData(inputRecorder *pRecorder, size_t length, double timeout)
+{
+    size_t n;
+
+    for (;;) {
+        epicsMutexMustLock(pRecorder->lock);
+        n = pRecorder->length;
+        epicsMutexUnlock(pRecorder->lock);
+        if (n >= length) return n;
+        if (epicsEventWaitWithTimeout(pRecorder->event, timeout) != epicsEventWaitOK)
+            return n;
+    }
+}
+
+static void unusedCallback(void *userPvt, SOCKET fd)
+{
+}
+
+/* Calls the asynOption method of the port with the port locked, as asynSetOption does */
+static asynStatus setPortOption(asynUser *pasynUser, const char *key, const char *val)
+{
+    asynInterface *pasynInterface;
+    asynOption *pasynOption;
+    asynStatus status;
+
+    pasynInterface = pasynManager->findInterface(pasynUser, asynOptionType, 1);
+    if (!pasynInterface) return asynError;
+    pasynOption = (asynOption *)pasynInterface->pinterface;
+    pasynManager->lockPort(pasynUser);
+    status = pasynOption->setOption(pasynInterface->drvPvt, pasynUser, key, val);
+    pasynManager->unlockPort(pasynUser);
+    return status;
+}
+
+static asynStatus getPortOption(asynUser *pasynUser, const char *key, char *val, int valSize)
+{
+    asynInterface *pasynInterface;
+    asynOption *pasynOption;
+    asynStatus status;
+
+    pasynInterface = pasynManager->findInterface(pasynUser, asynOptionType, 1);
+    if (!pasynInterface) return asynError;
+    pasynOption = (asynOption *)pasynInterface->pinterface;
+    pasynManager->lockPort(pasynUser);
+    status = pasynOption->getOption(pasynInterface->drvPvt, pasynUser, key, val, valSize);
+    pasynManager->unlockPort(pasynUser);
+    return status;
+}
+
+/* Returns a TCP port number that is free on the loopback interface */
+static int freePortNumber()
+{
+    struct sockaddr_in addr;
+    osiSocklen_t addrSize = sizeof(addr);
+    SOCKET fd = epicsSocketCreate(AF_INET, SOCK_STREAM, 0);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+    getsockname(fd, (struct sockaddr *)&addr, &addrSize);
+    epicsSocketDestroy(fd);
+    return ntohs(addr.sin_port);
+}
+
+/* Returns the number of handles shown by drvAsynIPReactorReport */
+static int numberHandles()
+{
+    FILE *fp = tmpfile();
+    char line[120];
+    int threads, handles = -1;
+
+    drvAsynIPReactorReport(fp, 0);
+    rewind(fp);
+    if (fgets(line, sizeof(line), fp))
+        sscanf(line, "drvAsynIPReactor threads %d handles %d", &threads, &handles);
+    fclose(fp);
+    return handles;
+}
+
+MAIN(IPReactorTest)
+{
+    inputRecorder recorder, serverRecorder;
+    asynUser *pasynUser, *pasynUserSyncIO, *pasynUserServer;
+    asynInterface *pasynInterface;
+    asynOctet *pasynOctet;
+    asynCommon *pasynCommon;
+    void *registrarPvt;
+    struct sockaddr_in addr;
+    osiSocklen_t addrSize = sizeof(addr);
+    SOCKET listenFd, fd;
+    char hostInfo[40];
+    char buffer[40];
+    char value[8];
+    size_t nbytes;
+    int eomReason;
+    int numCallbacks;
+    drvAsynIPReactorHandle *phandle;
+    int handles;
+    SOCKET clientFd;
+    int serverPort;
+
+    testPlan(15);
+    memset(&recorder, 0, sizeof(recorder));
+    recorder.lock = epicsMutexMustCreate();
+    recorder.event = epicsEventMustCreate(epicsEventEmpty);
+    memset(&serverRecorder, 0, sizeof(serverRecorder));
+    serverRecorder.lock = epicsMutexMustCreate();
+    serverRecorder.event = epicsEventMustCreate(epicsEventEmpty);
+
+    testOk(drvAsynIPReactorConfigure(2) == 0, "drvAsynIPReactorConfigure");
+    osiSockAttach();
+    listenFd = epicsSocketCreate(AF_INET, SOCK_STREAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    bind(listenFd, (struct sockaddr *)&addr, sizeof(addr));
+    listen(listenFd, 1);
+    getsockname(listenFd, (struct sockaddr *)&addr, &addrSize);
+    sprintf(hostInfo, "127.0.0.1:%d", ntohs(addr.sin_port));
+    testOk(drvAsynIPPortConfigure(PORT_NAME, hostInfo, 0, 1, 0) == 0,
+           "drvAsynIPPortConfigure %s", hostInfo);
+
+    pasynUser = pasynManager->createAsynUser(0, 0);
+    pasynManager->connectDevice(pasynUser, PORT_NAME, 0);
+    pasynInterface = pasynManager->findInterface(pasynUser, asynCommonType, 1);
+    pasynCommon = (asynCommon *)pasynInterface->pinterface;
+    pasynCommon->connect(pasynInterface->drvPvt, pasynUser);
+    fd = epicsSocketAccept(listenFd, (struct sockaddr *)&addr, &addrSize);
+    testOk(fd != INVALID_SOCKET, "connection accepted");
+
+    pasynInterface = pasynManager->findInterface(pasynUser, asynOctetType, 1);
+    pasynOctet = (asynOctet *)pasynInterface->pinterface;
+    pasynOctet->setInputEos(pasynInterface->drvPvt, pasynUser, "\n", 1);
+    pasynOctet->registerInterruptUser(pasynInterface->drvPvt, pasynUser,
+                                      interruptCallback, &recorder, &registrarPvt);
+    pasynOctetSyncIO->connect(PORT_NAME, 0, &pasynUserSyncIO, NULL);
+
+    /* Without the option the input is left for the reads of the port */
+    testOk(getPortOption(pasynUser, "unsolicitedInput", value, sizeof(value)) == asynSuccess
+           && strcmp(value, "N") == 0, "unsolicitedInput is N by default");
+    send(fd, "first\n", 6, 0);
+    epicsThreadSleep(0.2);
+    numCallbacks = recorder.numCallbacks;
+    pasynOctetSyncIO->read(pasynUserSyncIO, buffer, sizeof(buffer), 1.0, &nbytes, &eomReason);
+    testOk(numCallbacks == 0 && nbytes == 5 && strncmp(buffer, "first", 5) == 0,
+           "input stays for a read when unsolicitedInput is N");
+    /* asynOctetBase also gives the interrupt users what the read got */
+    epicsMutexMustLock(recorder.lock);
+    recorder.length = 0;
+    recorder.data[0] = 0;
+    epicsMutexUnlock(recorder.lock);
+    handles = numberHandles();
+    testOk(setPortOption(pasynUser, "unsolicitedInput", "Y") == asynSuccess
+           && numberHandles() == handles + 1, "set unsolicitedInput to Y");
+
+    /* Nobody reads, the reactor notices the input and the port reads it */
+    send(fd, "one\ntwo\n", 8, 0);
+    nbytes = waitData(&recorder, 8, 2.0);
+    testOk(nbytes == 8 && strcmp(recorder.data, "one\ntwo\n") == 0,
+           "%lu unsolicited octets received", (unsigned long)nbytes);
+    send(fd, "three\n", 6, 0);
+    nbytes = waitData(&recorder, 14, 2.0);
+    testOk(nbytes == 14 && strcmp(recorder.data, "one\ntwo\nthree\n") == 0,
+           "the reactor is armed again after a read");
+
+    /* Without interrupt users the input is left for the next read */
+    pasynOctet->cancelInterruptUser(pasynInterface->drvPvt, pasynUser, registrarPvt);
+    numCallbacks = recorder.numCallbacks;
+    /* Let an unsolicited read that is still running finish */
+    epicsThreadSleep(0.2);
+    send(fd, "reply\n", 6, 0);
+    epicsThreadSleep(0.2);
+    pasynOctetSyncIO->read(pasynUserSyncIO, buffer, sizeof(buffer), 1.0, &nbytes, &eomReason);
+    testOk(nbytes == 5 && strncmp(buffer, "reply", 5) == 0, "read got the input");
+    testOk(recorder.numCallbacks == numCallbacks, "no callbacks without interrupt users");
+    testOk(setPortOption(pasynUser, "unsolicitedInput", "N") == asynSuccess
+           && numberHandles() == handles, "set unsolicitedInput to N frees the handle");
+
+    /* A handle that is destroyed is no longer shown */
+    handles = numberHandles();
+    phandle = drvAsynIPReactorCreate("UNUSED", unusedCallback, 0);
+    drvAsynIPReactorAttach(phandle, listenFd);
+    drvAsynIPReactorArmDelayed(phandle, 10.0);
+    testOk(numberHandles() == handles + 1, "handle created");
+    drvAsynIPReactorDestroy(phandle);
+    testOk(numberHandles() == handles, "handle destroyed");
+
+    /* The server port waits on the reactor and accepts in its port thread */
+    serverPort = freePortNumber();
+    sprintf(hostInfo, "localhost:%d", serverPort);
+    testOk(drvAsynIPServerPortConfigure(SERVER_NAME, hostInfo, 1, 0, 0, 0) == 0,
+           "drvAsynIPServerPortConfigure %s", hostInfo);
+    pasynUserServer = pasynManager->createAsynUser(0, 0);
+    pasynManager->connectDevice(pasynUserServer, SERVER_NAME, 0);
+    pasynInterface = pasynManager->findInterface(pasynUserServer, asynOctetType, 1);
+    pasynOctet = (asynOctet *)pasynInterface->pinterface;
+    pasynOctet->registerInterruptUser(pasynInterface->drvPvt, pasynUserServer,
+                                      interruptCallback, &serverRecorder, &registrarPvt);
+    clientFd = epicsSocketCreate(AF_INET, SOCK_STREAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(serverPort);
+    connect(clientFd, (struct sockaddr *)&addr, sizeof(addr));
+    nbytes = waitData(&serverRecorder, 1, 5.0);
+    testOk(nbytes > 0 && strncmp(serverRecorder.data, SERVER_NAME ":", strlen(SERVER_NAME) + 1) == 0
+           && strcmp(serverRecorder.threadName, SERVER_NAME) == 0,
+           "connection %s accepted in thread %s", serverRecorder.data, serverRecorder.threadName);
+
+    epicsSocketDestroy(clientFd);
+
+    pasynOctetSyncIO->disconnect(pasynUserSyncIO);
+    pasynManager->freeAsynUser(pasynUser);
+    epicsSocketDestroy(fd);
+    epicsSocketDestroy(listenFd);
+    return testDone();
+}
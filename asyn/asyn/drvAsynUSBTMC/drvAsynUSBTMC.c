@@ -16,6 +16,7 @@
 #include <epicsMessageQueue.h>
 #include <epicsMutex.h>
 #include <epicsThread.h>
+#include <epicsTime.h>
 #include <epicsExport.h>
 #include <cantProceed.h>
 #include <iocsh.h>
@@ -36,10 +37,17 @@
 #define BULK_IO_PAYLOAD_CAPACITY 4096
 #define IDSTRING_CAPACITY        100
 
+#define BULK_STREAM_TRANSFER_SIZE 16384
+#define BULK_STREAM_TRANSFERS     8
+#define BULK_STREAM_CAPACITY      (1024*1024)
+
 #define ASYN_REASON_SRQ 4345
 #define ASYN_REASON_STB 4346
 #define ASYN_REASON_REN 4347
 
+#define FLAG_NO_AUTOCONNECT 0x1
+#define FLAG_BULK_STREAM    0x2
+
 #if (!defined(LIBUSBX_API_VERSION) || (LIBUSBX_API_VERSION < 0x01000102))
 # error "You need to get a newer version of libsb-1.0 (16 at the very least)"
 #endif
@@ -112,6 +120,22 @@ typedef struct drvPvt {
     const unsigned char   *bufp;
     unsigned char          bulkInPacketFlags;
 
+    /*
+     * Bulk-IN streaming
+     */
+    int                    streamEnable;
+    epicsMutexId           streamMutex;
+    struct libusb_transfer *streamTransfers[BULK_STREAM_TRANSFERS];
+    unsigned char         *streamBuf;
+    int                    streamSubmitted; /* Bytes covered by transfers */
+    int                    streamReceived;  /* Bytes received in order */
+    int                    streamExpected;  /* From header, 0 until known */
+    int                    streamActive;    /* Transfers outstanding */
+    int                    streamBusy;      /* Bit mask of transfers outstanding */
+    int                    streamIdle;      /* No transfers outstanding */
+    int                    streamDone;
+    int                    streamStatus;    /* libusb_transfer_status */
+
     /*
      * Statistics
      */
@@ -119,6 +143,7 @@ typedef struct drvPvt {
     size_t                 interruptCount;
     size_t                 bytesSentCount;
     size_t                 bytesReceivedCount;
+    size_t                 bulkInRequestCount;
 } drvPvt;
 
 static asynStatus disconnect(void *pvt, asynUser *pasynUser);
@@ -321,6 +346,13 @@ report(void *pvt, FILE *fp, int details)
         showCount(fp, "Interrupt", pdpvt->interruptCount);
         showCount(fp, "Send", pdpvt->bytesSentCount);
         showCount(fp, "Receive", pdpvt->bytesReceivedCount);
+        showCount(fp, "Bulk-IN request", pdpvt->bulkInRequestCount);
+        if (pdpvt->streamEnable)
+            fprintf(fp, "%28s: %d transfers of %d bytes, %d byte buffer\n",
+                                            "Bulk-IN streaming",
+                                            BULK_STREAM_TRANSFERS,
+                                            BULK_STREAM_TRANSFER_SIZE,
+                                            BULK_STREAM_CAPACITY);
     }
     if (details >= 100) {
         int l = details % 100;
@@ -693,6 +725,179 @@ disconnect(void *pvt, asynUser *pasynUser)
 }
 static asynCommon commonMethods = { report, connect, disconnect };
 
+/*
+ * Bulk-IN streaming
+ * A single REQUEST_DEV_DEP_MSG_IN asks for as much as fits in the stream
+ * buffer and BULK_STREAM_TRANSFERS asynchronous bulk-IN transfers are kept
+ * outstanding to receive the reply.  Transfers on an endpoint complete in
+ * order so the reply is reassembled in place in the stream buffer.
+ * The stream variables are protected by streamMutex since the callbacks
+ * may also be run by the interrupt thread.
+ */
+static void LIBUSB_CALL streamCallback(struct libusb_transfer *xfer);
+
+static void
+streamCancel(drvPvt *pdpvt)
+{
+    int i;
+
+    for (i = 0 ; i < BULK_STREAM_TRANSFERS ; i++) {
+        if (pdpvt->streamBusy & (1 << i))
+            libusb_cancel_transfer(pdpvt->streamTransfers[i]);
+    }
+}
+
+static int
+streamSubmit(drvPvt *pdpvt, int i)
+{
+    struct libusb_transfer *xfer = pdpvt->streamTransfers[i];
+    int s;
+
+    libusb_fill_bulk_transfer(xfer, pdpvt->handle,
+                              pdpvt->bulkInEndpointAddress,
+                              pdpvt->streamBuf + pdpvt->streamSubmitted,
+                              BULK_STREAM_TRANSFER_SIZE,
+                              streamCallback, pdpvt, 0);
+    s = libusb_submit_transfer(xfer);
+    if (s == 0) {
+        pdpvt->streamSubmitted += BULK_STREAM_TRANSFER_SIZE;
+        pdpvt->streamBusy |= 1 << i;
+        pdpvt->streamActive++;
+    }
+    return s;
+}
+
+static void LIBUSB_CALL
+streamCallback(struct libusb_transfer *xfer)
+{
+    drvPvt *pdpvt = (drvPvt *)xfer->user_data;
+    unsigned long payloadSize;
+    int i;
+
+    epicsMutexLock(pdpvt->streamMutex);
+    for (i = 0 ; pdpvt->streamTransfers[i] != xfer ; i++)
+        continue;
+    pdpvt->streamBusy &= ~(1 << i);
+    pdpvt->streamActive--;
+    if (!pdpvt->streamDone) {
+        if (xfer->status == LIBUSB_TRANSFER_COMPLETED) {
+            pdpvt->streamReceived = (xfer->buffer - pdpvt->streamBuf) +
+                                                            xfer->actual_length;
+            if ((pdpvt->streamExpected == 0)
+             && (pdpvt->streamReceived >= BULK_IO_HEADER_SIZE)) {
+                payloadSize = (unsigned long)pdpvt->streamBuf[4]        |
+                             ((unsigned long)pdpvt->streamBuf[5] << 8)  |
+                             ((unsigned long)pdpvt->streamBuf[6] << 16) |
+                             ((unsigned long)pdpvt->streamBuf[7] << 24);
+                if (payloadSize > BULK_STREAM_CAPACITY - BULK_IO_HEADER_SIZE)
+                    pdpvt->streamExpected = BULK_STREAM_CAPACITY;
+                else
+                    pdpvt->streamExpected = BULK_IO_HEADER_SIZE + payloadSize;
+            }
+
+            /*
+             * A short packet or the length claimed by the header ends the
+             * reply.  The device won't send anything more before the next
+             * request so the transfers still outstanding can be cancelled.
+             */
+            if ((xfer->actual_length < xfer->length)
+             || (pdpvt->streamExpected
+              && (pdpvt->streamReceived >= pdpvt->streamExpected))) {
+                pdpvt->streamDone = 1;
+            }
+            else if (pdpvt->streamSubmitted < BULK_STREAM_CAPACITY) {
+                if (streamSubmit(pdpvt, i) != 0) {
+                    pdpvt->streamStatus = LIBUSB_TRANSFER_ERROR;
+                    pdpvt->streamDone = 1;
+                }
+            }
+        }
+        else {
+            pdpvt->streamStatus = xfer->status;
+            pdpvt->streamDone = 1;
+        }
+        if (pdpvt->streamDone)
+            streamCancel(pdpvt);
+    }
+    if (pdpvt->streamActive == 0)
+        pdpvt->streamIdle = 1;
+    epicsMutexUnlock(pdpvt->streamMutex);
+}
+
+/*
+ * Receive a reply into the stream buffer.  Like the synchronous transfers the
+ * timeout (ms) applies to the time without any data arriving.
+ */
+static int
+streamRead(drvPvt *pdpvt, int timeout, int *ioCount)
+{
+    epicsTimeStamp deadline, now;
+    int received = 0;
+    int i;
+    int s = 0;
+
+    epicsMutexLock(pdpvt->streamMutex);
+    pdpvt->streamSubmitted = 0;
+    pdpvt->streamReceived = 0;
+    pdpvt->streamExpected = 0;
+    pdpvt->streamDone = 0;
+    pdpvt->streamIdle = 0;
+    pdpvt->streamStatus = LIBUSB_TRANSFER_COMPLETED;
+    for (i = 0 ; i < BULK_STREAM_TRANSFERS ; i++) {
+        s = streamSubmit(pdpvt, i);
+        if (s != 0) {
+            pdpvt->streamDone = 1;
+            streamCancel(pdpvt);
+            break;
+        }
+    }
+    if (pdpvt->streamActive == 0)
+        pdpvt->streamIdle = 1;
+    epicsMutexUnlock(pdpvt->streamMutex);
+    epicsTimeGetCurrent(&deadline);
+    epicsTimeAddSeconds(&deadline, timeout / 1000.0);
+    for (;;) {
+        struct timeval tv;
+        double remaining;
+
+        epicsMutexLock(pdpvt->streamMutex);
+        if (pdpvt->streamIdle) {
+            epicsMutexUnlock(pdpvt->streamMutex);
+            break;
+        }
+        epicsTimeGetCurrent(&now);
+        if (pdpvt->streamReceived != received) {
+            received = pdpvt->streamReceived;
+            deadline = now;
+            epicsTimeAddSeconds(&deadline, timeout / 1000.0);
+        }
+        remaining = epicsTimeDiffInSeconds(&deadline, &now);
+        if (!pdpvt->streamDone && (timeout >= 0) && (remaining <= 0)) {
+            pdpvt->streamStatus = LIBUSB_TRANSFER_TIMED_OUT;
+            pdpvt->streamDone = 1;
+            streamCancel(pdpvt);
+        }
+        epicsMutexUnlock(pdpvt->streamMutex);
+        if ((remaining <= 0) || (remaining > 0.1))
+            remaining = 0.1;
+        tv.tv_sec = 0;
+        tv.tv_usec = remaining * 1000000;
+        libusb_handle_events_timeout_completed(pdpvt->usb, &tv,
+                                                        &pdpvt->streamIdle);
+    }
+    *ioCount = pdpvt->streamReceived;
+    if (s != 0)
+        return s;
+    switch (pdpvt->streamStatus) {
+    case LIBUSB_TRANSFER_COMPLETED:     return 0;
+    case LIBUSB_TRANSFER_TIMED_OUT:     return LIBUSB_ERROR_TIMEOUT;
+    case LIBUSB_TRANSFER_STALL:         return LIBUSB_ERROR_PIPE;
+    case LIBUSB_TRANSFER_NO_DEVICE:     return LIBUSB_ERROR_NO_DEVICE;
+    case LIBUSB_TRANSFER_OVERFLOW:      return LIBUSB_ERROR_OVERFLOW;
+    default:                            return LIBUSB_ERROR_IO;
+    }
+}
+
 /*
  * asynOctet methods
  */
@@ -771,12 +976,18 @@ asynOctetRead(void *pvt, asynUser *pasynUser,
 {
     drvPvt *pdpvt = (drvPvt *)pvt;
     unsigned char bTag;
+    unsigned char *pk;
     int s;
     int nCopy, ioCount, payloadSize;
+    int requestSize;
     int eom = 0;
     int timeout = pasynUser->timeout * 1000;
     if (timeout == 0) timeout = 1;
 
+    if (pdpvt->streamEnable)
+        requestSize = BULK_STREAM_CAPACITY - BULK_IO_HEADER_SIZE;
+    else
+        requestSize = BULK_IO_PAYLOAD_CAPACITY;
     *nbytesTransfered = 0;
     for (;;) {
         /*
@@ -793,6 +1004,7 @@ asynOctetRead(void *pvt, asynUser *pasynUser,
             if (nCopy > pdpvt->bufCount)
                 nCopy = pdpvt->bufCount;
             memcpy(data, pdpvt->bufp, nCopy);
+            data += nCopy;
             pdpvt->bufp += nCopy;
             pdpvt->bufCount -= nCopy;
             maxchars -= nCopy;
@@ -806,6 +1018,7 @@ asynOctetRead(void *pvt, asynUser *pasynUser,
                 eom |= ASYN_EOM_EOS;
             if (pdpvt->bulkInPacketFlags & 0x1)
                 eom |= ASYN_EOM_END;
+            pdpvt->bulkInPacketFlags = 0;
         }
         if (eom) {
             if (eomReason) *eomReason = eom;
@@ -820,10 +1033,10 @@ asynOctetRead(void *pvt, asynUser *pasynUser,
         pdpvt->buf[1] = pdpvt->bTag;
         pdpvt->buf[2] = ~pdpvt->bTag;
         pdpvt->buf[3] = 0;
-        pdpvt->buf[4] = BULK_IO_PAYLOAD_CAPACITY & 0xFF;
-        pdpvt->buf[5] = (BULK_IO_PAYLOAD_CAPACITY >> 8) & 0xFF;
-        pdpvt->buf[6] = (BULK_IO_PAYLOAD_CAPACITY >> 16) & 0xFF;
-        pdpvt->buf[7] = (BULK_IO_PAYLOAD_CAPACITY >> 24) & 0xFF;
+        pdpvt->buf[4] = requestSize & 0xFF;
+        pdpvt->buf[5] = (requestSize >> 8) & 0xFF;
+        pdpvt->buf[6] = (requestSize >> 16) & 0xFF;
+        pdpvt->buf[7] = (requestSize >> 24) & 0xFF;
         if (pdpvt->termChar >= 0) {
             pdpvt->buf[8] = 2;
             pdpvt->buf[9] = pdpvt->termChar;
@@ -838,7 +1051,7 @@ asynOctetRead(void *pvt, asynUser *pasynUser,
         pdpvt->bTag = (pdpvt->bTag == 0xFF) ? 0x1 : pdpvt->bTag + 1;
         asynPrintIO(pasynUser, ASYN_TRACEIO_DRIVER, (const char *)pdpvt->buf,
                             BULK_IO_HEADER_SIZE,
-                            "Request %d, command: ", BULK_IO_PAYLOAD_CAPACITY);
+                            "Request %d, command: ", requestSize);
         s = libusb_bulk_transfer(pdpvt->handle, pdpvt->bulkOutEndpointAddress,
                           pdpvt->buf, BULK_IO_HEADER_SIZE, &ioCount, timeout);
         if (s) {
@@ -847,20 +1060,28 @@ asynOctetRead(void *pvt, asynUser *pasynUser,
                         "Bulk transfer request failed: %s", libusb_strerror(s));
             return asynError;
         }
+        pdpvt->bulkInRequestCount++;
 
         /*
          * Read back
          */
-        s = libusb_bulk_transfer(pdpvt->handle, pdpvt->bulkInEndpointAddress, pdpvt->buf,
-                                            sizeof pdpvt->buf, &ioCount, timeout);
+        if (pdpvt->streamEnable) {
+            pk = pdpvt->streamBuf;
+            s = streamRead(pdpvt, timeout, &ioCount);
+        }
+        else {
+            pk = pdpvt->buf;
+            s = libusb_bulk_transfer(pdpvt->handle, pdpvt->bulkInEndpointAddress,
+                                     pk, sizeof pdpvt->buf, &ioCount, timeout);
+        }
         if (s) {
             disconnectIfGone(pdpvt, pasynUser, s);
             epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
                                     "Bulk read failed: %s", libusb_strerror(s));
             return asynError;
         }
-        asynPrintIO(pasynUser, ASYN_TRACEIO_DRIVER, (const char *)pdpvt->buf,
-                        ioCount, "Read %d, flags %#x: ", ioCount, pdpvt->buf[8]);
+        asynPrintIO(pasynUser, ASYN_TRACEIO_DRIVER, (const char *)pk,
+                        ioCount, "Read %d, flags %#x: ", ioCount, pk[8]);
 
         /*
          * Sanity check on transfer
@@ -870,32 +1091,32 @@ asynOctetRead(void *pvt, asynUser *pasynUser,
                             "Incomplete packet header (read only %d)", ioCount);
             return asynError;
         }
-        if ((pdpvt->buf[0] != MESSAGE_ID_REQUEST_DEV_DEP_MSG_IN)
-         || (pdpvt->buf[1] != bTag)
-         || (pdpvt->buf[2] != (unsigned char)~bTag)) {
+        if ((pk[0] != MESSAGE_ID_REQUEST_DEV_DEP_MSG_IN)
+         || (pk[1] != bTag)
+         || (pk[2] != (unsigned char)~bTag)) {
             epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
                             "Packet header corrupt %x %x %x (btag %x)",
-                        pdpvt->buf[0], pdpvt->buf[1], pdpvt->buf[2], bTag);
+                                                    pk[0], pk[1], pk[2], bTag);
             return asynError;
         }
-        payloadSize = pdpvt->buf[4]        |
-                     (pdpvt->buf[5] << 8)  |
-                     (pdpvt->buf[6] << 16) |
-                     (pdpvt->buf[7] << 24);
+        payloadSize = pk[4]        |
+                     (pk[5] << 8)  |
+                     (pk[6] << 16) |
+                     (pk[7] << 24);
         if (payloadSize > (ioCount - BULK_IO_HEADER_SIZE)) {
             epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
                 "Packet header claims %d sent, but packet contains only %d",
                             payloadSize, ioCount - BULK_IO_HEADER_SIZE);
             return asynError;
         }
-        if (payloadSize > BULK_IO_PAYLOAD_CAPACITY) {
+        if (payloadSize > requestSize) {
             epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
                     "Packet header claims %d sent, but requested only %d",
-                                    payloadSize, BULK_IO_PAYLOAD_CAPACITY);
+                                                    payloadSize, requestSize);
             return asynError;
         }
         pdpvt->bufCount = payloadSize;
-        pdpvt->bufp = &pdpvt->buf[BULK_IO_HEADER_SIZE];
+        pdpvt->bufp = &pk[BULK_IO_HEADER_SIZE];
 
         /*
          * USB TMC uses a short packet to mark the end of a transfer
@@ -904,7 +1125,7 @@ asynOctetRead(void *pvt, asynUser *pasynUser,
          * finish on a pdpvt->buf sized boundary.  For now I am assuming
          * that I will, in fact, get a short packet following.
          */
-        pdpvt->bulkInPacketFlags = pdpvt->buf[8];
+        pdpvt->bulkInPacketFlags = pk[8];
     }
 }
 
@@ -1211,13 +1432,26 @@ usbtmcConfigure(const char *portName,
         printf("Can't create message queue!\n");
         return;
     }
+    if (flags & FLAG_BULK_STREAM) {
+        int i;
+        pdpvt->streamMutex = epicsMutexMustCreate();
+        pdpvt->streamBuf = mallocMustSucceed(BULK_STREAM_CAPACITY, portName);
+        for (i = 0 ; i < BULK_STREAM_TRANSFERS ; i++) {
+            pdpvt->streamTransfers[i] = libusb_alloc_transfer(0);
+            if (pdpvt->streamTransfers[i] == NULL) {
+                printf("Can't allocate bulk-IN transfer!\n");
+                return;
+            }
+        }
+        pdpvt->streamEnable = 1;
+    }
 
     /*
      * Create our port
      */
     status = pasynManager->registerPort(pdpvt->portName,
                                         ASYN_CANBLOCK,
-                                        (flags & 0x1) == 0,
+                                        (flags & FLAG_NO_AUTOCONNECT) == 0,
                                         priority, 0);
     if(status != asynSuccess) {
         printf("registerPort failed\n");
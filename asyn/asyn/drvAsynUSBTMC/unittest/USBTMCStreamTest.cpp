@@ -0,0 +1,109 @@
+/*
+ * USBTMCStreamTest.cpp
+ *
+ * Tests the bulk-IN streaming mode of drvAsynUSBTMC with the loopback
+ * device of usbtmcMock.c, which is linked in place of libusb.
+ *
+ ***************************************************************************
+ * This file is distributed subject to a Software License Agreement found  *
+ * in the file LICENSE that is included with this distribution.            *
+ ***************************************************************************
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <epicsTime.h>
+#include <asynDriver.h>
+#include <asynOctet.h>
+#include <asynOctetSyncIO.h>
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#define SYNC_PORT       "USBTMC_SYNC"
+#define STREAM_PORT     "USBTMC_STREAM"
+#define WAVEFORM_SIZE   (3*1024*1024 + 123)
+
+extern "C" {
+void usbtmcConfigure(const char *portName,
+                     int vendorId, int productId, const char *serialNumber,
+                     int priority, int flags);
+unsigned long usbtmcMockRequestCount(void);
+}
+
+static char writeBuffer[WAVEFORM_SIZE];
+static char readBuffer[WAVEFORM_SIZE];
+
+/* Sends the waveform to the loopback device and reads it back.
+ * Returns the number of REQUEST_DEV_DEP_MSG_IN used to read it */
+static unsigned long readWaveform(asynUser *pasynUser, const char *port)
+{
+    size_t nwrite, nread;
+    int eomReason = 0;
+    unsigned long requests;
+    epicsTimeStamp start, end;
+
+    pasynOctetSyncIO->write(pasynUser, writeBuffer, WAVEFORM_SIZE, 5.0, &nwrite);
+    memset(readBuffer, 0, WAVEFORM_SIZE);
+    requests = usbtmcMockRequestCount();
+    epicsTimeGetCurrent(&start);
+    pasynOctetSyncIO->read(pasynUser, readBuffer, WAVEFORM_SIZE, 5.0, &nread, &eomReason);
+    epicsTimeGetCurrent(&end);
+    requests = usbtmcMockRequestCount() - requests;
+    testOk((nread == WAVEFORM_SIZE) && (memcmp(readBuffer, writeBuffer, WAVEFORM_SIZE) == 0) &&
+           (eomReason & ASYN_EOM_END), "%s read %lu bytes", port, (unsigned long)nread);
+    testDiag("%s: %lu requests, %.3f seconds", port, requests,
+             epicsTimeDiffInSeconds(&end, &start));
+    return requests;
+}
+
+MAIN(USBTMCStreamTest)
+{
+    asynUser *pasynUserSync, *pasynUserStream;
+    unsigned long syncRequests, streamRequests;
+    char buffer[100];
+    size_t nwrite, nread;
+    int eomReason;
+    int i;
+
+    testPlan(8);
+
+    for (i=0; i<WAVEFORM_SIZE; i++) writeBuffer[i] = (char)(i*7 + i/4096);
+    usbtmcConfigure(SYNC_PORT, 0, 0, "", 0, 0);
+    usbtmcConfigure(STREAM_PORT, 0, 0, "", 0, 0x2);
+    pasynOctetSyncIO->connect(SYNC_PORT, 0, &pasynUserSync, NULL);
+    pasynOctetSyncIO->connect(STREAM_PORT, 0, &pasynUserStream, NULL);
+
+    syncRequests = readWaveform(pasynUserSync, SYNC_PORT);
+    streamRequests = readWaveform(pasynUserStream, STREAM_PORT);
+    testOk(streamRequests*100 < syncRequests,
+           "streaming needs %lu requests instead of %lu", streamRequests, syncRequests);
+
+    /* Short replies end the transfers early */
+    pasynOctetSyncIO->write(pasynUserStream, "*IDN?\n", 6, 1.0, &nwrite);
+    pasynOctetSyncIO->read(pasynUserStream, buffer, sizeof(buffer), 1.0, &nread, &eomReason);
+    testOk((nread == 6) && (strncmp(buffer, "*IDN?\n", 6) == 0) && (eomReason & ASYN_EOM_END),
+           "short reply");
+
+    /* The device ends the reply at the terminating character */
+    pasynOctetSyncIO->setInputEos(pasynUserStream, "\n", 1);
+    pasynOctetSyncIO->write(pasynUserStream, "A\nB\n", 4, 1.0, &nwrite);
+    pasynOctetSyncIO->read(pasynUserStream, buffer, sizeof(buffer), 1.0, &nread, &eomReason);
+    testOk((nread == 2) && (strncmp(buffer, "A\n", 2) == 0) && (eomReason & ASYN_EOM_EOS),
+           "first reply ends at the terminating character");
+    pasynOctetSyncIO->read(pasynUserStream, buffer, sizeof(buffer), 1.0, &nread, &eomReason);
+    testOk((nread == 2) && (strncmp(buffer, "B\n", 2) == 0) && (eomReason & ASYN_EOM_END),
+           "second reply");
+    pasynOctetSyncIO->setInputEos(pasynUserStream, "", 0);
+
+    /* Without a reply the transfers are cancelled and the next read works */
+    testOk(pasynOctetSyncIO->read(pasynUserStream, buffer, sizeof(buffer), 0.2, &nread,
+                                  &eomReason) != asynSuccess, "read without a reply fails");
+    pasynOctetSyncIO->write(pasynUserStream, "XYZ", 3, 1.0, &nwrite);
+    pasynOctetSyncIO->read(pasynUserStream, buffer, sizeof(buffer), 1.0, &nread, &eomReason);
+    testOk((nread == 3) && (strncmp(buffer, "XYZ", 3) == 0), "read after a failed read");
+
+    pasynOctetSyncIO->disconnect(pasynUserSync);
+    pasynOctetSyncIO->disconnect(pasynUserStream);
+    return testDone();
+}
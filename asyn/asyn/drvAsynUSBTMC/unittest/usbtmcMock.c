@@ -0,0 +1,530 @@
+/*
+ * Loopback USBTMC device behind a mock of the libusb-1.0 API
+ *
+ * Linked in place of libusb by the drvAsynUSBTMC tests so that the driver
+ * can be run without hardware.  Data sent with DEV_DEP_MSG_OUT is returned
+ * by the following REQUEST_DEV_DEP_MSG_IN.  Only the parts of libusb used
+ * by drvAsynUSBTMC are provided and there is a single device.
+ *
+ ***************************************************************************
+ * This file is distributed subject to a Software License Agreement found  *
+ * in the file LICENSE that is included with this distribution.            *
+ ***************************************************************************
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <epicsEvent.h>
+#include <epicsMutex.h>
+#include <cantProceed.h>
+#include <libusb-1.0/libusb.h>
+
+#define MOCK_MAX_PACKET_SIZE    512
+#define MOCK_MAX_PENDING        32
+#define MOCK_BULK_OUT_ENDPOINT  0x02
+#define MOCK_BULK_IN_ENDPOINT   0x81
+#define MOCK_HEADER_SIZE        12
+
+struct libusb_context { int unused; };
+struct libusb_device { int unused; };
+struct libusb_device_handle { int unused; };
+
+static libusb_device mockDevice;
+static libusb_device_handle mockHandle;
+
+static const struct libusb_endpoint_descriptor mockEndpoints[] = {
+    { .bEndpointAddress = MOCK_BULK_OUT_ENDPOINT,
+      .bmAttributes = LIBUSB_TRANSFER_TYPE_BULK,
+      .wMaxPacketSize = MOCK_MAX_PACKET_SIZE },
+    { .bEndpointAddress = MOCK_BULK_IN_ENDPOINT,
+      .bmAttributes = LIBUSB_TRANSFER_TYPE_BULK,
+      .wMaxPacketSize = MOCK_MAX_PACKET_SIZE },
+};
+static const struct libusb_interface_descriptor mockAltsetting = {
+    .bInterfaceNumber = 0,
+    .bNumEndpoints = 2,
+    .bInterfaceClass = 0xFE,
+    .bInterfaceSubClass = 0x03,
+    .bInterfaceProtocol = 1,
+    .endpoint = mockEndpoints,
+};
+static const struct libusb_interface mockInterface = { &mockAltsetting, 1 };
+static struct libusb_config_descriptor mockConfig = {
+    .bNumInterfaces = 1,
+    .interface = &mockInterface,
+};
+
+/*
+ * Device state
+ */
+static struct {
+    epicsMutexId            mutex;
+    epicsEventId            activity;
+
+    /* Data sent with DEV_DEP_MSG_OUT and not yet requested */
+    unsigned char          *queue;
+    size_t                  queueStart;
+    size_t                  queueCount;
+    size_t                  queueCapacity;
+
+    /* DEV_DEP_MSG_IN being returned on the bulk-IN endpoint */
+    unsigned char          *reply;
+    size_t                  replyCount;
+    size_t                  replySent;
+    size_t                  replyCapacity;
+
+    /* Asynchronous bulk-IN transfers in the order of submission */
+    struct libusb_transfer *pending[MOCK_MAX_PENDING];
+    int                     cancelled[MOCK_MAX_PENDING];
+    int                     pendingCount;
+
+    unsigned long           requestCount;
+} mock;
+
+static void
+mockReserve(unsigned char **buf, size_t *capacity, size_t size)
+{
+    if (size > *capacity) {
+        *capacity = size * 2;
+        *buf = realloc(*buf, *capacity);
+        if (*buf == NULL)
+            cantProceed("usbtmcMock");
+    }
+}
+
+static void
+mockClear(void)
+{
+    mock.queueStart = 0;
+    mock.queueCount = 0;
+    mock.replyCount = 0;
+    mock.replySent = 0;
+}
+
+/*
+ * Handle a message on the bulk-OUT endpoint
+ */
+static void
+mockBulkOut(const unsigned char *data, int length)
+{
+    size_t size, n;
+    unsigned char *cp;
+    int term = 0;
+
+    if (length < MOCK_HEADER_SIZE)
+        return;
+    size = data[4] | (data[5] << 8) | (data[6] << 16) | ((size_t)data[7] << 24);
+    switch (data[0]) {
+    case 1: /* DEV_DEP_MSG_OUT */
+        if (size > (size_t)length - MOCK_HEADER_SIZE)
+            size = length - MOCK_HEADER_SIZE;
+        if (mock.queueStart) {
+            memmove(mock.queue, mock.queue + mock.queueStart, mock.queueCount);
+            mock.queueStart = 0;
+        }
+        mockReserve(&mock.queue, &mock.queueCapacity, mock.queueCount + size);
+        memcpy(mock.queue + mock.queueCount, data + MOCK_HEADER_SIZE, size);
+        mock.queueCount += size;
+        break;
+
+    case 2: /* REQUEST_DEV_DEP_MSG_IN */
+        mock.requestCount++;
+
+        /*
+         * A real device would answer once it has data.  The loopback
+         * device just drops the request.
+         */
+        if (mock.queueCount == 0)
+            break;
+        n = size;
+        if (n > mock.queueCount)
+            n = mock.queueCount;
+        if (data[8] & 0x2) {
+            cp = memchr(mock.queue + mock.queueStart, data[9], n);
+            if (cp) {
+                n = cp - (mock.queue + mock.queueStart) + 1;
+                term = 1;
+            }
+        }
+        mockReserve(&mock.reply, &mock.replyCapacity, MOCK_HEADER_SIZE + n + 3);
+        mock.reply[0] = 2;
+        mock.reply[1] = data[1];
+        mock.reply[2] = ~data[1];
+        mock.reply[3] = 0;
+        mock.reply[4] = n;
+        mock.reply[5] = n >> 8;
+        mock.reply[6] = n >> 16;
+        mock.reply[7] = n >> 24;
+        mock.reply[8] = ((n == mock.queueCount) ? 0x1 : 0) | (term ? 0x2 : 0);
+        mock.reply[9] = 0;
+        mock.reply[10] = 0;
+        mock.reply[11] = 0;
+        memcpy(mock.reply + MOCK_HEADER_SIZE, mock.queue + mock.queueStart, n);
+        mock.queueStart += n;
+        mock.queueCount -= n;
+        mock.replyCount = MOCK_HEADER_SIZE + n;
+        while (mock.replyCount & 0x3)
+            mock.reply[mock.replyCount++] = 0;
+        mock.replySent = 0;
+        break;
+    }
+}
+
+/*
+ * Move reply data to a bulk-IN transfer.  Returns non-zero when the transfer
+ * is complete, that is when it is full or got the short packet ending the
+ * reply.  A reply that is a multiple of the packet size ends without a short
+ * packet and leaves the transfer waiting for the next reply.
+ */
+static int
+mockBulkIn(unsigned char *buffer, int length, int *actual_length)
+{
+    size_t n = mock.replyCount - mock.replySent;
+    int isShort = 0;
+
+    if (n == 0)
+        return 0;
+    if (n > (size_t)(length - *actual_length))
+        n = length - *actual_length;
+    memcpy(buffer + *actual_length, mock.reply + mock.replySent, n);
+    *actual_length += n;
+    mock.replySent += n;
+    if (mock.replySent == mock.replyCount) {
+        isShort = (mock.replyCount % MOCK_MAX_PACKET_SIZE) != 0;
+        mock.replyCount = 0;
+        mock.replySent = 0;
+    }
+    return isShort || (*actual_length == length);
+}
+
+/*
+ * Test support
+ */
+unsigned long
+usbtmcMockRequestCount(void)
+{
+    unsigned long n;
+
+    epicsMutexLock(mock.mutex);
+    n = mock.requestCount;
+    epicsMutexUnlock(mock.mutex);
+    return n;
+}
+
+/*
+ * libusb API
+ */
+int LIBUSB_CALL
+libusb_init(libusb_context **ctx)
+{
+    if (mock.mutex == NULL) {
+        mock.mutex = epicsMutexMustCreate();
+        mock.activity = epicsEventMustCreate(epicsEventEmpty);
+    }
+    *ctx = callocMustSucceed(1, sizeof **ctx, "usbtmcMock");
+    return 0;
+}
+
+void LIBUSB_CALL
+libusb_set_debug(libusb_context *ctx, int level)
+{
+}
+
+const char * LIBUSB_CALL
+libusb_strerror(enum libusb_error errcode)
+{
+    switch (errcode) {
+    case LIBUSB_SUCCESS:                return "Success";
+    case LIBUSB_ERROR_NO_DEVICE:        return "No such device";
+    case LIBUSB_ERROR_NOT_FOUND:        return "Entity not found";
+    case LIBUSB_ERROR_BUSY:             return "Resource busy";
+    case LIBUSB_ERROR_TIMEOUT:          return "Operation timed out";
+    case LIBUSB_ERROR_PIPE:             return "Pipe error";
+    case LIBUSB_ERROR_NOT_SUPPORTED:    return "Operation not supported";
+    default:                            return "Other error";
+    }
+}
+
+ssize_t LIBUSB_CALL
+libusb_get_device_list(libusb_context *ctx, libusb_device ***list)
+{
+    *list = callocMustSucceed(2, sizeof **list, "usbtmcMock");
+    (*list)[0] = &mockDevice;
+    return 1;
+}
+
+void LIBUSB_CALL
+libusb_free_device_list(libusb_device **list, int unref_devices)
+{
+    free(list);
+}
+
+int LIBUSB_CALL
+libusb_get_device_descriptor(libusb_device *dev,
+                             struct libusb_device_descriptor *desc)
+{
+    memset(desc, 0, sizeof *desc);
+    desc->bDeviceClass = LIBUSB_CLASS_PER_INTERFACE;
+    desc->idVendor = 0x1234;
+    desc->idProduct = 0x5678;
+    desc->iManufacturer = 1;
+    desc->iProduct = 2;
+    desc->iSerialNumber = 3;
+    desc->bNumConfigurations = 1;
+    return 0;
+}
+
+int LIBUSB_CALL
+libusb_get_active_config_descriptor(libusb_device *dev,
+                                    struct libusb_config_descriptor **config)
+{
+    *config = &mockConfig;
+    return 0;
+}
+
+int LIBUSB_CALL
+libusb_get_config_descriptor(libusb_device *dev, uint8_t config_index,
+                             struct libusb_config_descriptor **config)
+{
+    *config = &mockConfig;
+    return 0;
+}
+
+void LIBUSB_CALL
+libusb_free_config_descriptor(struct libusb_config_descriptor *config)
+{
+}
+
+int LIBUSB_CALL
+libusb_open(libusb_device *dev, libusb_device_handle **dev_handle)
+{
+    *dev_handle = &mockHandle;
+    return 0;
+}
+
+void LIBUSB_CALL
+libusb_close(libusb_device_handle *dev_handle)
+{
+}
+
+int LIBUSB_CALL
+libusb_claim_interface(libusb_device_handle *dev_handle, int interface_number)
+{
+    return 0;
+}
+
+int LIBUSB_CALL
+libusb_detach_kernel_driver(libusb_device_handle *dev_handle,
+                            int interface_number)
+{
+    return 0;
+}
+
+int LIBUSB_CALL
+libusb_clear_halt(libusb_device_handle *dev_handle, unsigned char endpoint)
+{
+    return 0;
+}
+
+int LIBUSB_CALL
+libusb_reset_device(libusb_device_handle *dev_handle)
+{
+    return 0;
+}
+
+int LIBUSB_CALL
+libusb_get_string_descriptor_ascii(libusb_device_handle *dev_handle,
+                                   uint8_t desc_index,
+                                   unsigned char *data, int length)
+{
+    static const char *strings[] = { "", "Mock", "USBTMC Loopback", "0001" };
+    int n;
+
+    if (desc_index >= sizeof strings / sizeof strings[0])
+        return LIBUSB_ERROR_PIPE;
+    n = strlen(strings[desc_index]);
+    if (n >= length)
+        n = length - 1;
+    memcpy(data, strings[desc_index], n);
+    data[n] = '\0';
+    return n;
+}
+
+int LIBUSB_CALL
+libusb_control_transfer(libusb_device_handle *dev_handle,
+                        uint8_t request_type, uint8_t bRequest,
+                        uint16_t wValue, uint16_t wIndex,
+                        unsigned char *data, uint16_t wLength,
+                        unsigned int timeout)
+{
+    memset(data, 0, wLength);
+    switch (bRequest) {
+    case 0x05: /* INITIATE_CLEAR */
+        epicsMutexLock(mock.mutex);
+        mockClear();
+        epicsMutexUnlock(mock.mutex);
+        data[0] = 1;
+        return 1;
+
+    case 0x06: /* CHECK_CLEAR_STATUS */
+        data[0] = 1;
+        return 2;
+
+    case 0x07: /* GET_CAPABILITIES */
+        data[0] = 1;
+        data[5] = 0x1;  /* Supports termChar */
+        data[14] = 0x4;
+        data[15] = 0x8;
+        return 0x18;
+
+    case 128: /* READ_STATUS_BYTE */
+        data[0] = 1;
+        data[1] = wValue;
+        return 3;
+
+    case 160: /* REN_CONTROL */
+        data[0] = 1;
+        return 1;
+    }
+    return LIBUSB_ERROR_PIPE;
+}
+
+int LIBUSB_CALL
+libusb_bulk_transfer(libusb_device_handle *dev_handle, unsigned char endpoint,
+                     unsigned char *data, int length, int *actual_length,
+                     unsigned int timeout)
+{
+    *actual_length = 0;
+    epicsMutexLock(mock.mutex);
+    if (endpoint == MOCK_BULK_OUT_ENDPOINT) {
+        mockBulkOut(data, length);
+        *actual_length = length;
+        epicsMutexUnlock(mock.mutex);
+        epicsEventSignal(mock.activity);
+        return 0;
+    }
+    if (endpoint != MOCK_BULK_IN_ENDPOINT) {
+        epicsMutexUnlock(mock.mutex);
+        return LIBUSB_ERROR_PIPE;
+    }
+    if (mock.replyCount == 0) {
+        epicsMutexUnlock(mock.mutex);
+        return LIBUSB_ERROR_TIMEOUT;
+    }
+    mockBulkIn(data, length, actual_length);
+    epicsMutexUnlock(mock.mutex);
+    return 0;
+}
+
+int LIBUSB_CALL
+libusb_interrupt_transfer(libusb_device_handle *dev_handle,
+                          unsigned char endpoint, unsigned char *data,
+                          int length, int *actual_length, unsigned int timeout)
+{
+    return LIBUSB_ERROR_NOT_SUPPORTED;
+}
+
+struct libusb_transfer * LIBUSB_CALL
+libusb_alloc_transfer(int iso_packets)
+{
+    return calloc(1, sizeof(struct libusb_transfer));
+}
+
+void LIBUSB_CALL
+libusb_free_transfer(struct libusb_transfer *transfer)
+{
+    free(transfer);
+}
+
+int LIBUSB_CALL
+libusb_submit_transfer(struct libusb_transfer *transfer)
+{
+    if (transfer->endpoint != MOCK_BULK_IN_ENDPOINT)
+        return LIBUSB_ERROR_NOT_SUPPORTED;
+    epicsMutexLock(mock.mutex);
+    if (mock.pendingCount == MOCK_MAX_PENDING) {
+        epicsMutexUnlock(mock.mutex);
+        return LIBUSB_ERROR_BUSY;
+    }
+    transfer->actual_length = 0;
+    mock.cancelled[mock.pendingCount] = 0;
+    mock.pending[mock.pendingCount++] = transfer;
+    epicsMutexUnlock(mock.mutex);
+    epicsEventSignal(mock.activity);
+    return 0;
+}
+
+int LIBUSB_CALL
+libusb_cancel_transfer(struct libusb_transfer *transfer)
+{
+    int i;
+
+    epicsMutexLock(mock.mutex);
+    for (i = 0 ; i < mock.pendingCount ; i++) {
+        if ((mock.pending[i] == transfer) && !mock.cancelled[i]) {
+            mock.cancelled[i] = 1;
+            epicsMutexUnlock(mock.mutex);
+            epicsEventSignal(mock.activity);
+            return 0;
+        }
+    }
+    epicsMutexUnlock(mock.mutex);
+    return LIBUSB_ERROR_NOT_FOUND;
+}
+
+/*
+ * Complete transfers in order.  Only the oldest transfer that isn't
+ * cancelled receives data.
+ */
+static int
+mockCompleteTransfers(struct libusb_transfer **done)
+{
+    int i, j = 0, nDone = 0;
+    int receiving = 1;
+
+    for (i = 0 ; i < mock.pendingCount ; i++) {
+        struct libusb_transfer *xfer = mock.pending[i];
+        if (mock.cancelled[i]) {
+            xfer->status = LIBUSB_TRANSFER_CANCELLED;
+            done[nDone++] = xfer;
+            continue;
+        }
+        if (receiving
+         && mockBulkIn(xfer->buffer, xfer->length, &xfer->actual_length)) {
+            xfer->status = LIBUSB_TRANSFER_COMPLETED;
+            done[nDone++] = xfer;
+            continue;
+        }
+        receiving = 0;
+        mock.cancelled[j] = 0;
+        mock.pending[j++] = xfer;
+    }
+    mock.pendingCount = j;
+    return nDone;
+}
+
+int LIBUSB_CALL
+libusb_handle_events_timeout_completed(libusb_context *ctx, struct timeval *tv,
+                                       int *completed)
+{
+    struct libusb_transfer *done[MOCK_MAX_PENDING];
+    int i, nDone;
+
+    epicsMutexLock(mock.mutex);
+    if (completed && *completed) {
+        epicsMutexUnlock(mock.mutex);
+        return 0;
+    }
+    nDone = mockCompleteTransfers(done);
+    if (nDone == 0) {
+        epicsMutexUnlock(mock.mutex);
+        epicsEventWaitWithTimeout(mock.activity,
+                                  tv->tv_sec + tv->tv_usec / 1000000.0);
+        epicsMutexLock(mock.mutex);
+        nDone = mockCompleteTransfers(done);
+    }
+    epicsMutexUnlock(mock.mutex);
+    for (i = 0 ; i < nDone ; i++)
+        done[i]->callback(done[i]);
+    return 0;
+}
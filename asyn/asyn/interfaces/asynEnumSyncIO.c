@@ -22,6 +22,7 @@
 #include "asynDriver.h"
 #include "asynEnum.h"
 #include "asynDrvUser.h"
+#include "asynSyncIOCache.h"
 
 #include <epicsExport.h>
 #include "asynEnumSyncIO.h"
@@ -185,12 +186,12 @@ static asynStatus writeOpOnce(const char *port, int addr,
     asynStatus status;
     asynUser   *pasynUser;
 
-    status = connect(port,addr,&pasynUser,drvInfo);
+    status = asynSyncIOCacheGet(connect,disconnect,port,addr,drvInfo,&pasynUser);
     if(status!=asynSuccess) {
         asynPrint(pasynUser, ASYN_TRACE_ERROR,
             "asynEnumSyncIO connect failed %s\n",
             pasynUser->errorMessage);
-        disconnect(pasynUser);
+        asynSyncIOCacheRelease(pasynUser);
         return status;
     }
     status = writeOp(pasynUser, strings, values, severities, nElements, timeout);
@@ -198,7 +199,7 @@ static asynStatus writeOpOnce(const char *port, int addr,
        asynPrint(pasynUser, ASYN_TRACE_ERROR,
             "asynEnumSyncIO writeOp failed %s\n",pasynUser->errorMessage);
     }
-    disconnect(pasynUser);
+    asynSyncIOCacheRelease(pasynUser);
     return status;
 }
 
@@ -208,12 +209,12 @@ static asynStatus readOpOnce(const char *port, int addr,
     asynStatus status;
     asynUser   *pasynUser;
 
-    status = connect(port,addr,&pasynUser,drvInfo);
+    status = asynSyncIOCacheGet(connect,disconnect,port,addr,drvInfo,&pasynUser);
     if(status!=asynSuccess) {
         asynPrint(pasynUser, ASYN_TRACE_ERROR,
            "asynEnumSyncIO connect failed %s\n",
            pasynUser->errorMessage);
-        disconnect(pasynUser);
+        asynSyncIOCacheRelease(pasynUser);
         return status;
     }
     status = readOp(pasynUser, strings, values, severities, nElements, nIn, timeout);
@@ -221,6 +222,6 @@ static asynStatus readOpOnce(const char *port, int addr,
        asynPrint(pasynUser, ASYN_TRACE_ERROR,
             "asynEnumSyncIO readOp failed %s\n",pasynUser->errorMessage);
     }
-    disconnect(pasynUser);
+    asynSyncIOCacheRelease(pasynUser);
     return status;
 }
@@ -22,6 +22,7 @@
 #include "asynDriver.h"
 #include "asynFloat64.h"
 #include "asynDrvUser.h"
+#include "asynSyncIOCache.h"
 
 #include <epicsExport.h>
 #include "asynFloat64SyncIO.h"
@@ -177,12 +178,12 @@ static asynStatus writeOpOnce(const char *port, int addr,
     asynStatus status;
     asynUser   *pasynUser;
 
-    status = connect(port,addr,&pasynUser,drvInfo);
+    status = asynSyncIOCacheGet(connect,disconnect,port,addr,drvInfo,&pasynUser);
     if(status!=asynSuccess) {
        asynPrint(pasynUser, ASYN_TRACE_ERROR,
            "asynFloat64SyncIO connect failed %s\n",
            pasynUser->errorMessage);
-        disconnect(pasynUser);
+        asynSyncIOCacheRelease(pasynUser);
         return status;
     }
     status = writeOp(pasynUser,value,timeout);
@@ -190,7 +191,7 @@ static asynStatus writeOpOnce(const char *port, int addr,
        asynPrint(pasynUser, ASYN_TRACE_ERROR,
             "asynFloat64SyncIO writeOp failed %s\n",pasynUser->errorMessage);
     }
-    disconnect(pasynUser);
+    asynSyncIOCacheRelease(pasynUser);
     return status;
 }
 
@@ -200,12 +201,12 @@ static asynStatus readOpOnce(const char *port, int addr,
     asynStatus status;
     asynUser   *pasynUser;
 
-    status = connect(port,addr,&pasynUser,drvInfo);
+    status = asynSyncIOCacheGet(connect,disconnect,port,addr,drvInfo,&pasynUser);
     if(status!=asynSuccess) {
         asynPrint(pasynUser, ASYN_TRACE_ERROR,
            "asynFloat64SyncIO connect failed %s\n",
            pasynUser->errorMessage);
-        disconnect(pasynUser);
+        asynSyncIOCacheRelease(pasynUser);
         return status;
     }
     status = readOp(pasynUser,pvalue,timeout);
@@ -213,6 +214,6 @@ static asynStatus readOpOnce(const char *port, int addr,
        asynPrint(pasynUser, ASYN_TRACE_ERROR,
             "asynFloat64SyncIO readOp failed %s\n",pasynUser->errorMessage);
     }
-    disconnect(pasynUser);
+    asynSyncIOCacheRelease(pasynUser);
     return status;
 }
@@ -22,6 +22,7 @@
 #include "asynDriver.h"
 #include "asynGenericPointer.h"
 #include "asynDrvUser.h"
+#include "asynSyncIOCache.h"
 
 #include <epicsExport.h>
 #include "asynGenericPointerSyncIO.h"
@@ -221,12 +222,12 @@ static asynStatus writeOpOnce(const char *port, int addr,
     asynStatus status;
     asynUser   *pasynUser;
 
-    status = connect(port,addr,&pasynUser,drvInfo);
+    status = asynSyncIOCacheGet(connect,disconnect,port,addr,drvInfo,&pasynUser);
     if(status!=asynSuccess) {
        asynPrint(pasynUser, ASYN_TRACE_ERROR,
            "asynGenericPointerSyncIO connect failed %s\n",
            pasynUser->errorMessage);
-        disconnect(pasynUser);
+        asynSyncIOCacheRelease(pasynUser);
         return status;
     }
     status = writeOp(pasynUser,pvalue,timeout);
@@ -234,7 +235,7 @@ static asynStatus writeOpOnce(const char *port, int addr,
        asynPrint(pasynUser, ASYN_TRACE_ERROR,
             "asynGenericPointerSyncIO writeOp failed %s\n",pasynUser->errorMessage);
     }
-    disconnect(pasynUser);
+    asynSyncIOCacheRelease(pasynUser);
     return status;
 }
 
@@ -244,12 +245,12 @@ static asynStatus readOpOnce(const char *port, int addr,
     asynStatus status;
     asynUser   *pasynUser;
 
-    status = connect(port,addr,&pasynUser,drvInfo);
+    status = asynSyncIOCacheGet(connect,disconnect,port,addr,drvInfo,&pasynUser);
     if(status!=asynSuccess) {
         asynPrint(pasynUser, ASYN_TRACE_ERROR,
            "asynGenericPointerSyncIO connect failed %s\n",
            pasynUser->errorMessage);
-        disconnect(pasynUser);
+        asynSyncIOCacheRelease(pasynUser);
         return status;
     }
     status = readOp(pasynUser,pvalue,timeout);
@@ -257,7 +258,7 @@ static asynStatus readOpOnce(const char *port, int addr,
        asynPrint(pasynUser, ASYN_TRACE_ERROR,
             "asynGenericPointerSyncIO readOp failed %s\n",pasynUser->errorMessage);
     }
-    disconnect(pasynUser);
+    asynSyncIOCacheRelease(pasynUser);
     return status;
 }
 
@@ -267,12 +268,12 @@ static asynStatus writeReadOpOnce(const char *port, int addr,
     asynStatus status;
     asynUser   *pasynUser;
 
-    status = connect(port,addr,&pasynUser,drvInfo);
+    status = asynSyncIOCacheGet(connect,disconnect,port,addr,drvInfo,&pasynUser);
     if(status!=asynSuccess) {
         asynPrint(pasynUser, ASYN_TRACE_ERROR,
            "asynGenericPointerSyncIO connect failed %s\n",
            pasynUser->errorMessage);
-        disconnect(pasynUser);
+        asynSyncIOCacheRelease(pasynUser);
         return status;
     }
     status = writeReadOp(pasynUser,pwrite_buffer,pread_buffer,timeout);
@@ -280,7 +281,7 @@ static asynStatus writeReadOpOnce(const char *port, int addr,
        asynPrint(pasynUser, ASYN_TRACE_ERROR,
             "asynGenericPointerSyncIO writeReadOp failed %s\n",pasynUser->errorMessage);
     }
-    disconnect(pasynUser);
+    asynSyncIOCacheRelease(pasynUser);
     return status;
 }
 
@@ -31,6 +31,12 @@ typedef struct asynOctetInterrupt {
     void *userPvt;
 }asynOctetInterrupt;
 
+/* One piece of the output for writeVector */
+typedef struct asynOctetVector {
+    const char *data;
+    size_t     numchars;
+}asynOctetVector;
+
 
 #define asynOctetType "asynOctet"
 typedef struct asynOctet{
@@ -53,12 +59,20 @@ typedef struct asynOctet{
                     const char *eos,int eoslen);
     asynStatus (*getOutputEos)(void *drvPvt,asynUser *pasynUser,
                     char *eos, int eossize, int *eoslen);
+    /* Writes count pieces as if they were one buffer. May be null, callers */
+    /* and interpose layers must then use write. nbytesTransfered is the total */
+    /* This member was added at the end, code that declares or calls an */
+    /* asynOctet must be rebuilt against this version of the header */
+    asynStatus (*writeVector)(void *drvPvt,asynUser *pasynUser,
+                    const asynOctetVector *vector,int count,
+                    size_t *nbytesTransfered);
 }asynOctet;
 
 /* asynOctetBase does the following:
    calls  registerInterface for asynOctet.
    Implements registerInterruptUser and cancelInterruptUser
    Provides default implementations of all methods.
+   writeVector is null if the driver does not implement it.
    registerInterruptUser and cancelInterruptUser can be called
    directly rather than via queueRequest.
 */
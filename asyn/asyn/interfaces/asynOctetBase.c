@@ -35,6 +35,7 @@
 
 typedef struct octetPvt {
     asynInterface octetBase; /*Implemented by asynOctetBase*/
+    asynOctet     octet;     /*octetBase methods, writeVector only if driver has it*/
     asynOctet     *pasynOctet; /* copy of driver with defaults*/
     void          *drvPvt;
     int           override;
@@ -71,11 +72,14 @@ static asynStatus setOutputEos(void *drvPvt,asynUser *pasynUser,
                         const char *eos,int eoslen);
 static asynStatus getOutputEos(void *drvPvt,asynUser *pasynUser,
                        char *eos, int eossize, int *eoslen);
+static asynStatus writeVectorIt(void *drvPvt,asynUser *pasynUser,
+    const asynOctetVector *vector,int count,size_t *nbytesTransfered);
 
 static asynOctet octet = {
     writeIt,readIt,flushIt,
     registerInterruptUser,cancelInterruptUser,
-    setInputEos,getInputEos,setOutputEos,getOutputEos
+    setInputEos,getInputEos,setOutputEos,getOutputEos,
+    writeVectorIt
 };
 /*Implementation to replace null methods*/
 static asynStatus writeFail(void *drvPvt, asynUser *pasynUser,
@@ -135,7 +139,11 @@ static asynStatus initialize(const char *portName,
     poctetPvt = callocMustSucceed(1,sizeof(octetPvt),
         "asynOctetBase:initialize");
     poctetPvt->octetBase.interfaceType = asynOctetType;
-    poctetPvt->octetBase.pinterface = &octet;
+    /*writeVector is only provided if the driver implements it, so that
+     *callers and interpose layers know whether it avoids a copy*/
+    poctetPvt->octet = octet;
+    if(!poctetDriver->writeVector) poctetPvt->octet.writeVector = 0;
+    poctetPvt->octetBase.pinterface = &poctetPvt->octet;
     poctetPvt->octetBase.drvPvt = poctetPvt;
     poctetPvt->pasynOctet = (asynOctet *)pdriver->pinterface;
     poctetPvt->drvPvt = pdriver->drvPvt;
@@ -369,6 +377,16 @@ static asynStatus getOutputEos(void *drvPvt,asynUser *pasynUser,
                  eos,eossize,eoslen);
 }
 
+static asynStatus writeVectorIt(void *drvPvt,asynUser *pasynUser,
+    const asynOctetVector *vector,int count,size_t *nbytesTransfered)
+{
+    octetPvt   *poctetPvt = (octetPvt *)drvPvt;
+    asynOctet  *pasynOctet = poctetPvt->pasynOctet;
+
+    return pasynOctet->writeVector(poctetPvt->drvPvt,pasynUser,
+                      vector,count,nbytesTransfered);
+}
+
 static asynStatus showFailure(asynUser *pasynUser,const char *method)
 {
     const char *portName;
@@ -28,10 +28,14 @@
 #include "asynDriver.h"
 #include "asynOctet.h"
 #include "asynDrvUser.h"
+#include "asynSyncIOCache.h"
 
 #include <epicsExport.h>
 #include "asynOctetSyncIO.h"
 
+/* Longest input EOS of asynInterposeEos */
+#define MAX_EOS_LEN 16
+
 typedef struct ioPvt {
    asynCommon   *pasynCommon;
    void         *pcommonPvt;
@@ -85,6 +89,12 @@ static asynStatus setOutputEosOnce(const char *port, int addr,
                         const char *eos,int eoslen,const char *drvInfo);
 static asynStatus getOutputEosOnce(const char *port, int addr,
                         char *eos, int eossize, int *eoslen,const char *drvInfo);
+static asynStatus writeReadPipeline(asynUser *pasynUser,
+                        asynOctetTransaction *ptransaction, int count,
+                        double timeout);
+static asynStatus writeReadPipelineOnce(const char *port, int addr,
+                        asynOctetTransaction *ptransaction, int count,
+                        double timeout, const char *drvInfo);
 
 static asynOctetSyncIO asynOctetSyncIOManager = {
     connect,
@@ -104,7 +114,9 @@ static asynOctetSyncIO asynOctetSyncIOManager = {
     setInputEosOnce,
     getInputEosOnce,
     setOutputEosOnce,
-    getOutputEosOnce
+    getOutputEosOnce,
+    writeReadPipeline,
+    writeReadPipelineOnce
 };
 epicsShareDef asynOctetSyncIO *pasynOctetSyncIO = &asynOctetSyncIOManager;
 
@@ -398,11 +410,11 @@ static asynStatus writeOnce(const char *port, int addr,
     asynStatus status;
     asynUser   *pasynUser;
 
-    status = connect(port,addr,&pasynUser,drvInfo);
+    status = asynSyncIOCacheGet(connect,disconnect,port,addr,drvInfo,&pasynUser);
     if(status!=asynSuccess) {
          asynPrint(pasynUser, ASYN_TRACE_ERROR,
              "asynOctetSyncIO connect failed %s\n",pasynUser->errorMessage);
-         disconnect(pasynUser);
+         asynSyncIOCacheRelease(pasynUser);
          return status;
     }
     status = writeIt(pasynUser,buffer,buffer_len,timeout,nbytesTransfered);
@@ -410,7 +422,7 @@ static asynStatus writeOnce(const char *port, int addr,
         asynPrint(pasynUser, ASYN_TRACE_ERROR,
              "asynOctetSyncIO write failed %s\n",pasynUser->errorMessage);
     }
-    disconnect(pasynUser);
+    asynSyncIOCacheRelease(pasynUser);
     return status;
 }
 
@@ -422,11 +434,11 @@ static asynStatus readOnce(const char *port, int addr,
     asynStatus status;
     asynUser   *pasynUser;
 
-    status = connect(port,addr,&pasynUser,drvInfo);
+    status = asynSyncIOCacheGet(connect,disconnect,port,addr,drvInfo,&pasynUser);
     if(status!=asynSuccess) {
          asynPrint(pasynUser, ASYN_TRACE_ERROR,
              "asynOctetSyncIO connect failed %s\n",pasynUser->errorMessage);
-         disconnect(pasynUser);
+         asynSyncIOCacheRelease(pasynUser);
          return status;
     }
     status = readIt(pasynUser,buffer,buffer_len,
@@ -435,7 +447,86 @@ static asynStatus readOnce(const char *port, int addr,
         asynPrint(pasynUser, ASYN_TRACE_ERROR,
              "asynOctetSyncIO read failed %s\n",pasynUser->errorMessage);
     }
-    disconnect(pasynUser);
+    asynSyncIOCacheRelease(pasynUser);
+    return status;
+}
+
+/*
+ * Up to the pipeline depth of the port commands are written before the reply
+ * to the first one is read, and a new command is written after each reply.
+ * Replies can only be told apart by the input EOS, so without one the
+ * transactions are done one at a time.
+ * When a write or read fails the replies still outstanding can no longer be
+ * matched, so the input is flushed and the remaining transactions fail.
+ */
+static asynStatus writeReadPipeline(asynUser *pasynUser,
+                        asynOctetTransaction *ptransaction, int count,
+                        double timeout)
+{
+    asynStatus status = asynSuccess, unlockStatus;
+    ioPvt      *pioPvt = (ioPvt *)pasynUser->userPvt;
+    asynOctetTransaction *pt;
+    int        depth = 1;
+    int        nWritten = 0, nRead = 0;
+    char       eos[MAX_EOS_LEN];
+    int        eoslen = 0;
+    int        i;
+
+    for (i=0; i<count; i++) {
+        pt = &ptransaction[i];
+        pt->nbytesOut = 0;
+        pt->nbytesIn = 0;
+        pt->eomReason = 0;
+        pt->status = asynError;
+    }
+    pasynUser->timeout = timeout;
+    status = pasynManager->queueLockPort(pasynUser);
+    if(status!=asynSuccess) {
+        return status;
+    }
+    pasynManager->getPipelineDepth(pasynUser,&depth);
+    if(depth>1) {
+        if(pioPvt->pasynOctet->getInputEos(pioPvt->octetPvt,pasynUser,
+            eos,sizeof(eos),&eoslen)!=asynSuccess || eoslen==0) depth = 1;
+    }
+    status = pioPvt->pasynOctet->flush(pioPvt->octetPvt,pasynUser);
+    if(status!=asynSuccess) {
+        goto done;
+    }
+    while(nRead<count) {
+        while(nWritten<count && nWritten-nRead<depth) {
+            pt = &ptransaction[nWritten];
+            status = pioPvt->pasynOctet->write(pioPvt->octetPvt,pasynUser,
+                pt->writeBuffer,pt->writeLen,&pt->nbytesOut);
+            pt->status = status;
+            if(status!=asynSuccess) goto lost;
+            asynPrintIO(pasynUser, ASYN_TRACEIO_DEVICE,
+                pt->writeBuffer,pt->nbytesOut,"asynOctetSyncIO wrote:\n");
+            nWritten++;
+        }
+        pt = &ptransaction[nRead];
+        status = pioPvt->pasynOctet->read(pioPvt->octetPvt,pasynUser,
+            pt->readBuffer,pt->readLen,&pt->nbytesIn,&pt->eomReason);
+        pt->status = status;
+        nRead++;
+        if(status!=asynSuccess) goto lost;
+        asynPrintIO(pasynUser, ASYN_TRACEIO_DEVICE,
+            pt->readBuffer,pt->nbytesIn,"asynOctetSyncIO read:\n");
+    }
+    goto done;
+lost:
+    if(nWritten>nRead) {
+        asynPrint(pasynUser, ASYN_TRACE_ERROR,
+            "asynOctetSyncIO writeReadPipeline discards %d outstanding replies\n",
+            nWritten-nRead);
+        for (i=nRead; i<nWritten; i++) ptransaction[i].status = asynError;
+        pioPvt->pasynOctet->flush(pioPvt->octetPvt,pasynUser);
+    }
+done:
+    unlockStatus = pasynManager->queueUnlockPort(pasynUser);
+    if (unlockStatus != asynSuccess) {
+        return unlockStatus;
+    }
     return status;
 }
 
@@ -449,11 +540,11 @@ static asynStatus writeReadOnce(const char *port, int addr,
     asynStatus status;
     asynUser   *pasynUser;
 
-    status = connect(port,addr,&pasynUser,drvInfo);
+    status = asynSyncIOCacheGet(connect,disconnect,port,addr,drvInfo,&pasynUser);
     if(status!=asynSuccess) {
          asynPrint(pasynUser, ASYN_TRACE_ERROR,
              "asynOctetSyncIO connect failed %s\n",pasynUser->errorMessage);
-         disconnect(pasynUser);
+         asynSyncIOCacheRelease(pasynUser);
          return status;
     }
     status = writeRead(pasynUser,write_buffer,write_buffer_len,
@@ -463,7 +554,7 @@ static asynStatus writeReadOnce(const char *port, int addr,
         asynPrint(pasynUser, ASYN_TRACE_ERROR,
              "asynOctetSyncIO writeReadOnce failed %s\n",pasynUser->errorMessage);
     }
-    disconnect(pasynUser);
+    asynSyncIOCacheRelease(pasynUser);
     return status;
 }
 
@@ -472,11 +563,11 @@ static asynStatus flushOnce(const char *port, int addr,const char *drvInfo)
     asynStatus status;
     asynUser   *pasynUser;
 
-    status = connect(port,addr,&pasynUser,drvInfo);
+    status = asynSyncIOCacheGet(connect,disconnect,port,addr,drvInfo,&pasynUser);
     if(status!=asynSuccess) {
          asynPrint(pasynUser, ASYN_TRACE_ERROR,
              "asynOctetSyncIO connect failed %s\n",pasynUser->errorMessage);
-         disconnect(pasynUser);
+         asynSyncIOCacheRelease(pasynUser);
          return status;
     }
     status = flushIt(pasynUser);
@@ -484,7 +575,7 @@ static asynStatus flushOnce(const char *port, int addr,const char *drvInfo)
         asynPrint(pasynUser, ASYN_TRACE_ERROR,
              "asynOctetSyncIO flush failed %s\n",pasynUser->errorMessage);
     }
-    disconnect(pasynUser);
+    asynSyncIOCacheRelease(pasynUser);
     return status;
 }
 
@@ -494,11 +585,11 @@ static asynStatus setInputEosOnce(const char *port, int addr,
     asynStatus status;
     asynUser   *pasynUser;
 
-    status = connect(port,addr,&pasynUser,drvInfo);
+    status = asynSyncIOCacheGet(connect,disconnect,port,addr,drvInfo,&pasynUser);
     if(status!=asynSuccess) {
          asynPrint(pasynUser, ASYN_TRACE_ERROR,
              "asynOctetSyncIO connect failed %s\n",pasynUser->errorMessage);
-         disconnect(pasynUser);
+         asynSyncIOCacheRelease(pasynUser);
          return status;
     }
     status = setInputEos(pasynUser,eos,eoslen);
@@ -506,7 +597,7 @@ static asynStatus setInputEosOnce(const char *port, int addr,
         asynPrint(pasynUser, ASYN_TRACE_ERROR,
              "asynOctetSyncIO setInputEos failed %s\n",pasynUser->errorMessage);
     }
-    disconnect(pasynUser);
+    asynSyncIOCacheRelease(pasynUser);
     return status;
 }
 
@@ -516,11 +607,11 @@ static asynStatus getInputEosOnce(const char *port, int addr,
     asynStatus status;
     asynUser   *pasynUser;
 
-    status = connect(port,addr,&pasynUser,drvInfo);
+    status = asynSyncIOCacheGet(connect,disconnect,port,addr,drvInfo,&pasynUser);
     if(status!=asynSuccess) {
          asynPrint(pasynUser, ASYN_TRACE_ERROR,
              "asynOctetSyncIO connect failed %s\n",pasynUser->errorMessage);
-         disconnect(pasynUser);
+         asynSyncIOCacheRelease(pasynUser);
          return status;
     }
     status = getInputEos(pasynUser,eos,eossize,eoslen);
@@ -528,7 +619,7 @@ static asynStatus getInputEosOnce(const char *port, int addr,
         asynPrint(pasynUser, ASYN_TRACE_ERROR,
              "asynOctetSyncIO getInputEos failed %s\n",pasynUser->errorMessage);
     }
-    disconnect(pasynUser);
+    asynSyncIOCacheRelease(pasynUser);
     return status;
 }
 
@@ -538,11 +629,11 @@ static asynStatus setOutputEosOnce(const char *port, int addr,
     asynStatus status;
     asynUser   *pasynUser;
 
-    status = connect(port,addr,&pasynUser,drvInfo);
+    status = asynSyncIOCacheGet(connect,disconnect,port,addr,drvInfo,&pasynUser);
     if(status!=asynSuccess) {
          asynPrint(pasynUser, ASYN_TRACE_ERROR,
              "asynOctetSyncIO connect failed %s\n",pasynUser->errorMessage);
-         disconnect(pasynUser);
+         asynSyncIOCacheRelease(pasynUser);
          return status;
     }
     status = setOutputEos(pasynUser,eos,eoslen);
@@ -550,7 +641,7 @@ static asynStatus setOutputEosOnce(const char *port, int addr,
         asynPrint(pasynUser, ASYN_TRACE_ERROR,
              "asynOctetSyncIO setOutputEos failed %s\n",pasynUser->errorMessage);
     }
-    disconnect(pasynUser);
+    asynSyncIOCacheRelease(pasynUser);
     return status;
 }
 
@@ -560,11 +651,11 @@ static asynStatus getOutputEosOnce(const char *port, int addr,
     asynStatus status;
     asynUser   *pasynUser;
 
-    status = connect(port,addr,&pasynUser,drvInfo);
+    status = asynSyncIOCacheGet(connect,disconnect,port,addr,drvInfo,&pasynUser);
     if(status!=asynSuccess) {
          asynPrint(pasynUser, ASYN_TRACE_ERROR,
              "asynOctetSyncIO connect failed %s\n",pasynUser->errorMessage);
-         disconnect(pasynUser);
+         asynSyncIOCacheRelease(pasynUser);
          return status;
     }
     status = getOutputEos(pasynUser,eos,eossize,eoslen);
@@ -572,6 +663,29 @@ static asynStatus getOutputEosOnce(const char *port, int addr,
         asynPrint(pasynUser, ASYN_TRACE_ERROR,
              "asynOctetSyncIO getOutputEos failed %s\n",pasynUser->errorMessage);
     }
-    disconnect(pasynUser);
+    asynSyncIOCacheRelease(pasynUser);
+    return status;
+}
+
+static asynStatus writeReadPipelineOnce(const char *port, int addr,
+                        asynOctetTransaction *ptransaction, int count,
+                        double timeout, const char *drvInfo)
+{
+    asynStatus status;
+    asynUser   *pasynUser;
+
+    status = asynSyncIOCacheGet(connect,disconnect,port,addr,drvInfo,&pasynUser);
+    if(status!=asynSuccess) {
+         asynPrint(pasynUser, ASYN_TRACE_ERROR,
+             "asynOctetSyncIO connect failed %s\n",pasynUser->errorMessage);
+         asynSyncIOCacheRelease(pasynUser);
+         return status;
+    }
+    status = writeReadPipeline(pasynUser,ptransaction,count,timeout);
+    if(status!=asynSuccess) {
+        asynPrint(pasynUser, ASYN_TRACE_ERROR,
+             "asynOctetSyncIO writeReadPipelineOnce failed %s\n",pasynUser->errorMessage);
+    }
+    asynSyncIOCacheRelease(pasynUser);
     return status;
 }
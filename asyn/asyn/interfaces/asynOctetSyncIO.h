@@ -26,6 +26,19 @@
 extern "C" {
 #endif /* __cplusplus */
 
+/* One command and its reply for writeReadPipeline */
+typedef struct asynOctetTransaction {
+   const char *writeBuffer;
+   size_t     writeLen;
+   char       *readBuffer;
+   size_t     readLen;
+   /* The following are set by writeReadPipeline */
+   size_t     nbytesOut;
+   size_t     nbytesIn;
+   int        eomReason;
+   asynStatus status;
+} asynOctetTransaction;
+
 typedef struct asynOctetSyncIO {
    asynStatus (*connect)(const char *port, int addr,
                          asynUser **ppasynUser, const char *drvInfo);
@@ -69,6 +82,13 @@ typedef struct asynOctetSyncIO {
                   const char *eos,int eoslen,const char *drvInfo);
    asynStatus (*getOutputEosOnce)(const char *port, int addr,
                   char *eos, int eossize, int *eoslen,const char *drvInfo);
+   /* Writes up to the pipeline depth of the port commands before reading the
+    * first reply. Replies are matched to commands in order by the input EOS */
+   asynStatus (*writeReadPipeline)(asynUser *pasynUser,
+                  asynOctetTransaction *ptransaction, int count, double timeout);
+   asynStatus (*writeReadPipelineOnce)(const char *port, int addr,
+                  asynOctetTransaction *ptransaction, int count, double timeout,
+                  const char *drvInfo);
 } asynOctetSyncIO;
 epicsShareExtern asynOctetSyncIO *pasynOctetSyncIO;
 
@@ -0,0 +1,200 @@
+/* asynSyncIOCache.c */
+/***********************************************************************
+* asynDriver is distributed subject to a Software License Agreement
+* found in file LICENSE that is included with this distribution.
+***********************************************************************/
+/*
+ * The "Once" methods of the SyncIO interfaces keep their connected asynUsers
+ * in a least recently used cache, so that a call does not create an asynUser,
+ * connect it, find the interfaces and call drvUser->create.
+ *
+ * Each port has a watch asynUser with an exception callback. When the port
+ * disconnects its generation is incremented, and cached asynUsers that were
+ * connected with an older generation are disconnected instead of reused.
+ * Watch asynUsers are never freed, ports are never removed.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <cantProceed.h>
+#include <ellLib.h>
+#include <epicsMutex.h>
+#include <epicsString.h>
+#include <epicsThread.h>
+
+#include "asynDriver.h"
+#include "asynSyncIOCache.h"
+
+#define MAX_CACHED 32
+
+typedef struct portWatch {
+    ELLNODE       node;   /* Must be first */
+    char          *portName;
+    asynUser      *pasynUser;
+    unsigned long generation;
+} portWatch;
+
+typedef struct cacheEntry {
+    ELLNODE              node;   /* Must be first */
+    asynSyncIOConnect    pconnect;
+    asynSyncIODisconnect pdisconnect;
+    char                 *portName;
+    int                  addr;
+    char                 *drvInfo;
+    portWatch            *pportWatch; /* 0 if the entry must not be cached */
+    unsigned long        generation;
+    asynUser             *pasynUser;
+} cacheEntry;
+
+typedef struct syncIOCache {
+    epicsMutexId lock;      /* protects the lists of entries and generation */
+    epicsMutexId watchLock; /* protects watchList, not taken by callbacks */
+    ELLLIST      idleList;  /* most recently used first */
+    ELLLIST      busyList;
+    ELLLIST      watchList;
+} syncIOCache;
+static syncIOCache *pcache = 0;
+static epicsThreadOnceId cacheOnceId = EPICS_THREAD_ONCE_INIT;
+
+static void cacheInit(void *arg)
+{
+    pcache = callocMustSucceed(1, sizeof(*pcache), "asynSyncIOCache");
+    pcache->lock = epicsMutexMustCreate();
+    pcache->watchLock = epicsMutexMustCreate();
+    ellInit(&pcache->idleList);
+    ellInit(&pcache->busyList);
+    ellInit(&pcache->watchList);
+}
+
+static void watchException(asynUser *pasynUser, asynException exception)
+{
+    portWatch *pportWatch = (portWatch *)pasynUser->userPvt;
+    int       yesNo = 1;
+
+    if (exception != asynExceptionConnect) return;
+    pasynManager->isConnected(pasynUser, &yesNo);
+    if (yesNo) return;
+    epicsMutexMustLock(pcache->lock);
+    pportWatch->generation++;
+    epicsMutexUnlock(pcache->lock);
+}
+
+static portWatch *findPortWatch(const char *port)
+{
+    portWatch *pportWatch;
+    asynUser  *pasynUser;
+
+    epicsMutexMustLock(pcache->watchLock);
+    for (pportWatch = (portWatch *)ellFirst(&pcache->watchList); pportWatch;
+         pportWatch = (portWatch *)ellNext(&pportWatch->node)) {
+        if (strcmp(pportWatch->portName, port) == 0) break;
+    }
+    if (!pportWatch) {
+        pasynUser = pasynManager->createAsynUser(0, 0);
+        if ((pasynManager->connectDevice(pasynUser, port, -1) != asynSuccess) ||
+            (pasynManager->exceptionCallbackAdd(pasynUser, watchException) != asynSuccess)) {
+            pasynManager->freeAsynUser(pasynUser);
+        } else {
+            pportWatch = callocMustSucceed(1, sizeof(*pportWatch), "asynSyncIOCache");
+            pportWatch->portName = epicsStrDup(port);
+            pportWatch->pasynUser = pasynUser;
+            pasynUser->userPvt = pportWatch;
+            ellAdd(&pcache->watchList, &pportWatch->node);
+        }
+    }
+    epicsMutexUnlock(pcache->watchLock);
+    return pportWatch;
+}
+
+static int sameKey(cacheEntry *pentry, asynSyncIOConnect pconnect,
+                   portWatch *pportWatch, int addr, const char *drvInfo)
+{
+    if ((pentry->pconnect != pconnect) || (pentry->pportWatch != pportWatch) ||
+        (pentry->addr != addr)) return 0;
+    if (!pentry->drvInfo || !drvInfo) return pentry->drvInfo == drvInfo;
+    return strcmp(pentry->drvInfo, drvInfo) == 0;
+}
+
+static void freeEntry(cacheEntry *pentry)
+{
+    pentry->pdisconnect(pentry->pasynUser);
+    free(pentry->portName);
+    free(pentry->drvInfo);
+    free(pentry);
+}
+
+asynStatus asynSyncIOCacheGet(asynSyncIOConnect pconnect,
+                              asynSyncIODisconnect pdisconnect,
+                              const char *port, int addr, const char *drvInfo,
+                              asynUser **ppasynUser)
+{
+    portWatch  *pportWatch;
+    cacheEntry *pentry, *pstale = 0;
+    asynStatus status;
+
+    epicsThreadOnce(&cacheOnceId, cacheInit, 0);
+    pportWatch = findPortWatch(port);
+    epicsMutexMustLock(pcache->lock);
+    if (pportWatch) {
+        for (pentry = (cacheEntry *)ellFirst(&pcache->idleList); pentry;
+             pentry = (cacheEntry *)ellNext(&pentry->node)) {
+            if (sameKey(pentry, pconnect, pportWatch, addr, drvInfo)) break;
+        }
+        if (pentry) {
+            ellDelete(&pcache->idleList, &pentry->node);
+            if (pentry->generation == pportWatch->generation) {
+                ellAdd(&pcache->busyList, &pentry->node);
+                epicsMutexUnlock(pcache->lock);
+                *ppasynUser = pentry->pasynUser;
+                return asynSuccess;
+            }
+            pstale = pentry;
+        }
+    }
+    pentry = callocMustSucceed(1, sizeof(*pentry), "asynSyncIOCache");
+    pentry->pconnect = pconnect;
+    pentry->pdisconnect = pdisconnect;
+    pentry->portName = epicsStrDup(port);
+    pentry->addr = addr;
+    if (drvInfo) pentry->drvInfo = epicsStrDup(drvInfo);
+    pentry->pportWatch = pportWatch;
+    /* A disconnect while connecting makes the entry stale */
+    if (pportWatch) pentry->generation = pportWatch->generation;
+    ellAdd(&pcache->busyList, &pentry->node);
+    epicsMutexUnlock(pcache->lock);
+    if (pstale) freeEntry(pstale);
+    status = pconnect(port, addr, &pentry->pasynUser, drvInfo);
+    if (status != asynSuccess) pentry->pportWatch = 0;
+    *ppasynUser = pentry->pasynUser;
+    return status;
+}
+
+void asynSyncIOCacheRelease(asynUser *pasynUser)
+{
+    cacheEntry *pentry;
+    cacheEntry *pevict = 0;
+
+    epicsMutexMustLock(pcache->lock);
+    for (pentry = (cacheEntry *)ellFirst(&pcache->busyList); pentry;
+         pentry = (cacheEntry *)ellNext(&pentry->node)) {
+        if (pentry->pasynUser == pasynUser) break;
+    }
+    if (!pentry) {
+        epicsMutexUnlock(pcache->lock);
+        return;
+    }
+    ellDelete(&pcache->busyList, &pentry->node);
+    if (!pentry->pportWatch || (pentry->generation != pentry->pportWatch->generation)) {
+        epicsMutexUnlock(pcache->lock);
+        freeEntry(pentry);
+        return;
+    }
+    ellInsert(&pcache->idleList, 0, &pentry->node);
+    if (ellCount(&pcache->idleList) > MAX_CACHED) {
+        pevict = (cacheEntry *)ellLast(&pcache->idleList);
+        ellDelete(&pcache->idleList, &pevict->node);
+    }
+    epicsMutexUnlock(pcache->lock);
+    if (pevict) freeEntry(pevict);
+}
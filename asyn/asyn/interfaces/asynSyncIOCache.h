@@ -0,0 +1,39 @@
+/* asynSyncIOCache.h */
+/***********************************************************************
+* asynDriver is distributed subject to a Software License Agreement
+* found in file LICENSE that is included with this distribution.
+***********************************************************************/
+/*
+ * Cache of connected asynUsers for the "Once" methods of the
+ * asynXXXSyncIO interfaces. Only used by the SyncIO implementations.
+ */
+
+#ifndef asynSyncIOCacheH
+#define asynSyncIOCacheH
+
+#include <asynDriver.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif  /* __cplusplus */
+
+typedef asynStatus (*asynSyncIOConnect)(const char *port, int addr,
+                                        asynUser **ppasynUser, const char *drvInfo);
+typedef asynStatus (*asynSyncIODisconnect)(asynUser *pasynUser);
+
+/* Returns an asynUser connected by pconnect. An idle cached asynUser with the
+ * same connect function, port, addr and drvInfo is reused if the port has not
+ * disconnected since it was connected. If the status is not asynSuccess
+ * *ppasynUser is still valid and must be given to asynSyncIOCacheRelease */
+asynStatus asynSyncIOCacheGet(asynSyncIOConnect pconnect,
+                              asynSyncIODisconnect pdisconnect,
+                              const char *port, int addr, const char *drvInfo,
+                              asynUser **ppasynUser);
+/* Returns the asynUser to the cache, or disconnects it */
+void asynSyncIOCacheRelease(asynUser *pasynUser);
+
+#ifdef __cplusplus
+}
+#endif  /* __cplusplus */
+
+#endif /* asynSyncIOCacheH */
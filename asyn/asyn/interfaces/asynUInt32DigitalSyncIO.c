@@ -22,6 +22,7 @@
 #include "asynDriver.h"
 #include "asynUInt32Digital.h"
 #include "asynDrvUser.h"
+#include "asynSyncIOCache.h"
 
 #include <epicsExport.h>
 #include "asynUInt32DigitalSyncIO.h"
@@ -278,12 +279,12 @@ static asynStatus writeOpOnce(const char *port, int addr,
     asynStatus status;
     asynUser   *pasynUser;
 
-    status = connect(port,addr,&pasynUser,drvInfo);
+    status = asynSyncIOCacheGet(connect,disconnect,port,addr,drvInfo,&pasynUser);
     if(status!=asynSuccess) {
         asynPrint(pasynUser, ASYN_TRACE_ERROR,
             "asynUInt32DigitalSyncIO connect failed %s\n",
             pasynUser->errorMessage);
-        disconnect(pasynUser);
+        asynSyncIOCacheRelease(pasynUser);
         return status;
     }
     status = writeOp(pasynUser,value,mask,timeout);
@@ -292,7 +293,7 @@ static asynStatus writeOpOnce(const char *port, int addr,
             "asynUInt32DigitalSyncIO writeOp failed %s\n",
             pasynUser->errorMessage);
     }
-    disconnect(pasynUser);
+    asynSyncIOCacheRelease(pasynUser);
     return status;
 }
 
@@ -303,12 +304,12 @@ static asynStatus readOpOnce(const char *port, int addr,
     asynStatus status;
     asynUser   *pasynUser;
 
-    status = connect(port,addr,&pasynUser,drvInfo);
+    status = asynSyncIOCacheGet(connect,disconnect,port,addr,drvInfo,&pasynUser);
     if(status!=asynSuccess) {
         asynPrint(pasynUser, ASYN_TRACE_ERROR,
             "asynUInt32DigitalSyncIO connect failed %s\n",
             pasynUser->errorMessage);
-        disconnect(pasynUser);
+        asynSyncIOCacheRelease(pasynUser);
         return status;
     }
     status = readOp(pasynUser,pvalue,mask,timeout);
@@ -317,7 +318,7 @@ static asynStatus readOpOnce(const char *port, int addr,
             "asynUInt32DigitalSyncIO readOp failed %s\n",
             pasynUser->errorMessage);
     }
-    disconnect(pasynUser);
+    asynSyncIOCacheRelease(pasynUser);
     return status;
 }
 
@@ -328,12 +329,12 @@ static asynStatus setInterruptOnce(const char *port, int addr,
     asynStatus status;
     asynUser   *pasynUser;
 
-    status = connect(port,addr,&pasynUser,drvInfo);
+    status = asynSyncIOCacheGet(connect,disconnect,port,addr,drvInfo,&pasynUser);
     if(status!=asynSuccess) {
         asynPrint(pasynUser, ASYN_TRACE_ERROR,
             "asynUInt32DigitalSyncIO connect failed %s\n",
             pasynUser->errorMessage);
-        disconnect(pasynUser);
+        asynSyncIOCacheRelease(pasynUser);
         return status;
     }
     status = setInterrupt(pasynUser,mask,reason,timeout);
@@ -342,7 +343,7 @@ static asynStatus setInterruptOnce(const char *port, int addr,
             "asynUInt32DigitalSyncIO setInterrupt failed %s\n",
             pasynUser->errorMessage);
     }
-    disconnect(pasynUser);
+    asynSyncIOCacheRelease(pasynUser);
     return status;
 }
 
@@ -352,12 +353,12 @@ static asynStatus clearInterruptOnce(const char *port, int addr,
     asynStatus status;
     asynUser   *pasynUser;
 
-    status = connect(port,addr,&pasynUser,drvInfo);
+    status = asynSyncIOCacheGet(connect,disconnect,port,addr,drvInfo,&pasynUser);
     if(status!=asynSuccess) {
         asynPrint(pasynUser, ASYN_TRACE_ERROR,
             "asynUInt32DigitalSyncIO connect failed %s\n",
             pasynUser->errorMessage);
-        disconnect(pasynUser);
+        asynSyncIOCacheRelease(pasynUser);
         return status;
     }
     status = clearInterrupt(pasynUser,mask,timeout);
@@ -366,7 +367,7 @@ static asynStatus clearInterruptOnce(const char *port, int addr,
             "asynUInt32DigitalSyncIO clearInterrupt failed %s\n",
             pasynUser->errorMessage);
     }
-    disconnect(pasynUser);
+    asynSyncIOCacheRelease(pasynUser);
     return status;
 }
 
@@ -377,12 +378,12 @@ static asynStatus getInterruptOnce(const char *port, int addr,
     asynStatus status;
     asynUser   *pasynUser;
 
-    status = connect(port,addr,&pasynUser,drvInfo);
+    status = asynSyncIOCacheGet(connect,disconnect,port,addr,drvInfo,&pasynUser);
     if(status!=asynSuccess) {
         asynPrint(pasynUser, ASYN_TRACE_ERROR,
             "asynUInt32DigitalSyncIO connect failed %s\n",
             pasynUser->errorMessage);
-        disconnect(pasynUser);
+        asynSyncIOCacheRelease(pasynUser);
         return status;
     }
     status = getInterrupt(pasynUser,mask,reason,timeout);
@@ -391,6 +392,6 @@ static asynStatus getInterruptOnce(const char *port, int addr,
             "asynUInt32DigitalSyncIO getInterrupt failed %s\n",
             pasynUser->errorMessage);
     }
-    disconnect(pasynUser);
+    asynSyncIOCacheRelease(pasynUser);
     return status;
 }
@@ -0,0 +1,177 @@
+/*
+ * PipelineTest.cpp
+ *
+ * Tests asynOctetSyncIO writeReadPipeline with a device that queues its
+ * replies, like an instrument which accepts several queries before answering.
+ *
+ ***************************************************************************
+ * This file is distributed subject to a Software License Agreement found  *
+ * in the file LICENSE that is included with this distribution.            *
+ ***************************************************************************
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "asynPortDriver.h"
+#include <asynOctetSyncIO.h>
+#include <asynInterposeEos.h>
+#include <asynShellCommands.h>
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#define PORT_NAME   "PIPELINE"
+#define MAX_PENDING 1024
+#define NUM_COMMANDS 10
+
+/* Driver that answers each command with "R:<command>" and the terminator,
+ * which ends with '\n'. Commands starting with 'X' get no reply */
+class pipelinedDevice : public asynPortDriver {
+public:
+    pipelinedDevice(const char *portName);
+    virtual asynStatus writeOctet(asynUser *pasynUser, const char *value, size_t maxChars,
+                                  size_t *nActual);
+    virtual asynStatus readOctet(asynUser *pasynUser, char *value, size_t maxChars,
+                                 size_t *nActual, int *eomReason);
+    int outstanding;
+    int maxOutstanding;
+    size_t pending;
+    char replies[MAX_PENDING];
+    const char *terminator;
+};
+
+pipelinedDevice::pipelinedDevice(const char *portName)
+    : asynPortDriver(portName, 1, 1, asynOctetMask | asynDrvUserMask, 0, 0, 1, 0, 0),
+      outstanding(0), maxOutstanding(0), pending(0), terminator("\n")
+{
+}
+
+asynStatus pipelinedDevice::writeOctet(asynUser *pasynUser, const char *value, size_t maxChars,
+                                       size_t *nActual)
+{
+    size_t terminatorLen = strlen(terminator);
+
+    *nActual = maxChars;
+    if ((maxChars > 0) && (value[0] == 'X')) return asynSuccess;
+    if (pending + maxChars + 2 + terminatorLen > MAX_PENDING) return asynError;
+    memcpy(replies + pending, "R:", 2);
+    memcpy(replies + pending + 2, value, maxChars);
+    pending += maxChars + 2;
+    memcpy(replies + pending, terminator, terminatorLen);
+    pending += terminatorLen;
+    outstanding++;
+    if (outstanding > maxOutstanding) maxOutstanding = outstanding;
+    return asynSuccess;
+}
+
+/* Returns all queued replies, like a socket would */
+asynStatus pipelinedDevice::readOctet(asynUser *pasynUser, char *value, size_t maxChars,
+                                      size_t *nActual, int *eomReason)
+{
+    size_t i;
+
+    if (eomReason) *eomReason = 0;
+    *nActual = 0;
+    if (pending == 0) return asynTimeout;
+    if (maxChars > pending) maxChars = pending;
+    memcpy(value, replies, maxChars);
+    for (i=0; i<maxChars; i++) {
+        if (replies[i] == '\n') outstanding--;
+    }
+    memmove(replies, replies + maxChars, pending - maxChars);
+    pending -= maxChars;
+    *nActual = maxChars;
+    return asynSuccess;
+}
+
+static int checkReplies(asynOctetTransaction *pt, int count)
+{
+    char expected[40];
+    int i;
+
+    for (i=0; i<count; i++) {
+        sprintf(expected, "R:%s", pt[i].writeBuffer);
+        if ((pt[i].status != asynSuccess) || (pt[i].nbytesIn != strlen(expected)) ||
+            (strncmp(pt[i].readBuffer, expected, pt[i].nbytesIn) != 0)) return 0;
+    }
+    return 1;
+}
+
+MAIN(PipelineTest)
+{
+    pipelinedDevice *pDevice;
+    asynUser *pasynUser;
+    asynOctetTransaction transactions[NUM_COMMANDS];
+    char commands[NUM_COMMANDS][8];
+    char replies[NUM_COMMANDS][40];
+    int depth;
+    int i;
+
+    testPlan(13);
+
+    pDevice = new pipelinedDevice(PORT_NAME);
+    asynInterposeEosConfig(PORT_NAME, -1, 1, 0);
+    pasynOctetSyncIO->connect(PORT_NAME, 0, &pasynUser, NULL);
+    for (i=0; i<NUM_COMMANDS; i++) {
+        sprintf(commands[i], "Q%d?", i);
+        transactions[i].writeBuffer = commands[i];
+        transactions[i].writeLen = strlen(commands[i]);
+        transactions[i].readBuffer = replies[i];
+        transactions[i].readLen = sizeof(replies[i]);
+    }
+
+    pasynManager->getPipelineDepth(pasynUser, &depth);
+    testOk(depth == 1, "default pipeline depth is 1");
+    testOk(pasynManager->setPipelineDepth(pasynUser, 0) != asynSuccess,
+           "pipeline depth 0 is rejected");
+    testOk(asynSetPipelineDepth(PORT_NAME, 0) != 0, "asynSetPipelineDepth fails for depth 0");
+    testOk(asynSetPipelineDepth("NO_SUCH_PORT", 4) != 0,
+           "asynSetPipelineDepth fails for an unknown port");
+    testOk(asynSetPipelineDepth(PORT_NAME, 1) == 0, "asynSetPipelineDepth for depth 1");
+
+    /* Without an input EOS the replies can not be told apart. Each reply
+     * fills the read buffer so that the reads end without a timeout */
+    pasynManager->setPipelineDepth(pasynUser, 4);
+    for (i=0; i<NUM_COMMANDS; i++) transactions[i].readLen = 6;
+    pasynOctetSyncIO->writeReadPipeline(pasynUser, transactions, NUM_COMMANDS, 1.0);
+    for (i=0; i<NUM_COMMANDS; i++) transactions[i].readLen = sizeof(replies[i]);
+    testOk(pDevice->maxOutstanding == 1 && transactions[NUM_COMMANDS-1].status == asynSuccess,
+           "without an input EOS one command is outstanding");
+
+    pasynOctetSyncIO->setInputEos(pasynUser, "\n", 1);
+    pDevice->maxOutstanding = 0;
+    testOk(pasynOctetSyncIO->writeReadPipeline(pasynUser, transactions, NUM_COMMANDS, 1.0)
+           == asynSuccess, "writeReadPipeline with depth 4");
+    testOk(pDevice->maxOutstanding == 4, "%d commands were outstanding",
+           pDevice->maxOutstanding);
+    testOk(checkReplies(transactions, NUM_COMMANDS), "replies are matched in order");
+
+    /* An input EOS longer than two characters */
+    pDevice->terminator = "<end>\n";
+    pasynOctetSyncIO->setInputEos(pasynUser, "<end>\n", 6);
+    pDevice->maxOutstanding = 0;
+    pasynOctetSyncIO->writeReadPipeline(pasynUser, transactions, NUM_COMMANDS, 1.0);
+    testOk(pDevice->maxOutstanding == 4 && checkReplies(transactions, NUM_COMMANDS),
+           "%d commands were outstanding with a 6 character input EOS",
+           pDevice->maxOutstanding);
+    pDevice->terminator = "\n";
+    pasynOctetSyncIO->setInputEos(pasynUser, "\n", 1);
+
+    pasynManager->setPipelineDepth(pasynUser, 1);
+    pDevice->maxOutstanding = 0;
+    pasynOctetSyncIO->writeReadPipeline(pasynUser, transactions, NUM_COMMANDS, 1.0);
+    testOk(pDevice->maxOutstanding == 1 && checkReplies(transactions, NUM_COMMANDS),
+           "depth 1 does one transaction at a time");
+
+    /* The device stops answering, the replies that are still expected are lost */
+    pasynManager->setPipelineDepth(pasynUser, 4);
+    for (i=2; i<NUM_COMMANDS; i++) commands[i][0] = 'X';
+    testOk(pasynOctetSyncIO->writeReadPipeline(pasynUser, transactions, NUM_COMMANDS, 0.1)
+           == asynTimeout, "missing reply times out");
+    testOk(checkReplies(transactions, 2) && transactions[2].status == asynTimeout &&
+           transactions[3].status == asynError && transactions[NUM_COMMANDS-1].status == asynError,
+           "transactions after the missing reply fail");
+
+    pasynOctetSyncIO->disconnect(pasynUser);
+    return testDone();
+}
@@ -0,0 +1,102 @@
+/*
+ * SyncIOCacheTest.cpp
+ *
+ * Tests that the asynXXXSyncIO "Once" methods reuse their asynUser, and that
+ * a port disconnect makes them connect again.
+ *
+ ***************************************************************************
+ * This file is distributed subject to a Software License Agreement found  *
+ * in the file LICENSE that is included with this distribution.            *
+ ***************************************************************************
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "asynPortDriver.h"
+#include <asynInt32SyncIO.h>
+#include <asynFloat64SyncIO.h>
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#define PORT_NAME   "SYNCIO_CACHE"
+#define NUM_WRITES  10
+
+/* Driver that counts the drvUser create and destroy calls */
+class drvUserCounter : public asynPortDriver {
+public:
+    drvUserCounter(const char *portName);
+    virtual asynStatus drvUserCreate(asynUser *pasynUser, const char *drvInfo,
+                                     const char **pptypeName, size_t *psize);
+    virtual asynStatus drvUserDestroy(asynUser *pasynUser);
+    int numCreate;
+    int numDestroy;
+    int P_Value;
+    int P_Other;
+};
+
+drvUserCounter::drvUserCounter(const char *portName)
+    : asynPortDriver(portName, 1, 2, asynInt32Mask | asynFloat64Mask | asynDrvUserMask,
+                     0, 0, 1, 0, 0),
+      numCreate(0), numDestroy(0)
+{
+    createParam("VALUE", asynParamInt32, &P_Value);
+    createParam("OTHER", asynParamFloat64, &P_Other);
+}
+
+asynStatus drvUserCounter::drvUserCreate(asynUser *pasynUser, const char *drvInfo,
+                                         const char **pptypeName, size_t *psize)
+{
+    numCreate++;
+    return asynPortDriver::drvUserCreate(pasynUser, drvInfo, pptypeName, psize);
+}
+
+asynStatus drvUserCounter::drvUserDestroy(asynUser *pasynUser)
+{
+    numDestroy++;
+    return asynPortDriver::drvUserDestroy(pasynUser);
+}
+
+MAIN(SyncIOCacheTest)
+{
+    drvUserCounter *pDriver;
+    asynUser *pasynUser;
+    epicsInt32 ivalue;
+    epicsFloat64 dvalue;
+    int i;
+
+    testPlan(7);
+
+    pDriver = new drvUserCounter(PORT_NAME);
+    for (i=0; i<NUM_WRITES; i++) {
+        pasynInt32SyncIO->writeOnce(PORT_NAME, 0, i, 1.0, "VALUE");
+    }
+    pasynInt32SyncIO->readOnce(PORT_NAME, 0, &ivalue, 1.0, "VALUE");
+    testOk(ivalue == NUM_WRITES-1, "readOnce got %d", ivalue);
+    testOk(pDriver->numCreate == 1, "%d drvUser created for %d calls",
+           pDriver->numCreate, NUM_WRITES+1);
+
+    pasynFloat64SyncIO->writeOnce(PORT_NAME, 0, 2.5, 1.0, "OTHER");
+    pasynFloat64SyncIO->readOnce(PORT_NAME, 0, &dvalue, 1.0, "OTHER");
+    testOk(dvalue == 2.5 && pDriver->numCreate == 2,
+           "another drvInfo and interface gets its own asynUser");
+
+    testOk(pasynInt32SyncIO->writeOnce("NO_SUCH_PORT", 0, 1, 1.0, "VALUE") != asynSuccess,
+           "writeOnce to a port that does not exist fails");
+
+    /* The port disconnects and connects again */
+    pasynUser = pasynManager->createAsynUser(0, 0);
+    pasynManager->connectDevice(pasynUser, PORT_NAME, -1);
+    pasynManager->exceptionDisconnect(pasynUser);
+    pasynManager->exceptionConnect(pasynUser);
+    testOk(pDriver->numDestroy == 0, "cached asynUsers are kept until they are used");
+    pasynInt32SyncIO->writeOnce(PORT_NAME, 1, 7, 1.0, "VALUE");
+    pasynInt32SyncIO->writeOnce(PORT_NAME, 0, 8, 1.0, "VALUE");
+    testOk(pDriver->numCreate == 4 && pDriver->numDestroy == 1,
+           "after a disconnect the asynUser is connected again");
+    pasynInt32SyncIO->readOnce(PORT_NAME, 0, &ivalue, 1.0, "VALUE");
+    testOk(ivalue == 8 && pDriver->numCreate == 4, "the new asynUser is reused");
+
+    pasynManager->freeAsynUser(pasynUser);
+    return testDone();
+}
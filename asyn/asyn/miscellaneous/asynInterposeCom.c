@@ -68,6 +68,8 @@ typedef struct interposePvt {
     asynInterface  option;        /* This asynOption interface */
     asynOctet     *pasynOctetDrv; /* Methods of next lower interface */
     void          *drvPvt;        /* Private data of next lower interface */
+    asynOption    *pasynOptionDrv;/* Options of next lower interface, or NULL */
+    void          *optionDrvPvt;
 
     int            baud;          /* Serial line parameters */
     int            parity;
@@ -572,6 +574,11 @@ setOption(void *ppvt, asynUser *pasynUser, const char *key, const char *val)
         status = sbComPortOption(pinterposePvt, pasynUser, xBuf, 2, rBuf);
         if (status == asynSuccess) pinterposePvt->flow = rBuf[0] & 0xFF;
     }
+    else if (pinterposePvt->pasynOptionDrv) {
+        /* Options of the driver below, e.g. of drvAsynIPPort */
+        return pinterposePvt->pasynOptionDrv->setOption(pinterposePvt->optionDrvPvt,
+                                                        pasynUser, key, val);
+    }
     else {
         epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
                                           "Can't handle option \"%s\"", key);
@@ -614,6 +621,10 @@ getOption(void *ppvt, asynUser *pasynUser, const char *key, char *val, int valSi
             return asynError;
         }
     }
+    else if (pinterposePvt->pasynOptionDrv) {
+        return pinterposePvt->pasynOptionDrv->getOption(pinterposePvt->optionDrvPvt,
+                                                        pasynUser, key, val, valSize);
+    }
     else {
         epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
                                                 "Unsupported key \"%s\"", key);
@@ -720,8 +731,11 @@ asynInterposeCOM(const char *portName)
         free(pinterposePvt);
         return -1;
     }
-    if (poptionasynInterface != NULL)
-        printf("WARNING -- asynInterposeCOM options overriding those of lower interface.\n");
+    if (poptionasynInterface != NULL) {
+        /* Keys that are not serial line parameters go to the lower interface */
+        pinterposePvt->pasynOptionDrv = (asynOption *)poptionasynInterface->pinterface;
+        pinterposePvt->optionDrvPvt = poptionasynInterface->drvPvt;
+    }
 
     /*
      * Set default parameters
@@ -32,10 +32,13 @@
 
 #define START_OUTPUT_SIZE 100
 #define INPUT_SIZE        2048
+#define MAX_EOS_LEN       16
+#define MAX_VECTOR        8
 
 typedef struct eosPvt {
     char          *portName;
     asynInterface eosInterface;
+    asynOctet     octet;    /* Our methods, writeVector only if the lower level has it */
     asynOctet     *poctet;  /* The methods we're overriding */
     void          *octetPvt;
     asynUser      *pasynUser;     /* For connect/disconnect reporting */
@@ -44,13 +47,15 @@ typedef struct eosPvt {
     char          *inBuf;
     unsigned int  inBufHead;
     unsigned int  inBufTail;
-    char          eosIn[2];
+    char          eosIn[MAX_EOS_LEN];
     int           eosInLen;
     int           eosInMatch;
+    /* eosInFail[n] is the match length after a mismatch at eosIn[n] */
+    int           eosInFail[MAX_EOS_LEN];
     int           processEosOut;
     size_t        outBufSize;
     char          *outBuf;
-    char          eosOut[2];
+    char          eosOut[MAX_EOS_LEN];
     int           eosOutLen;
 }eosPvt;
     
@@ -75,10 +80,13 @@ static asynStatus setOutputEos(void *ppvt,asynUser *pasynUser,
     const char *eos,int eoslen);
 static asynStatus getOutputEos(void *ppvt,asynUser *pasynUser,
     char *eos,int eossize,int *eoslen);
+static asynStatus writeVectorIt(void *ppvt,asynUser *pasynUser,
+    const asynOctetVector *vector,int count,size_t *nbytesTransfered);
 static asynOctet octet = {
     writeIt,readIt,flushIt,
     registerInterruptUser, cancelInterruptUser,
-    setInputEos,getInputEos,setOutputEos,getOutputEos
+    setInputEos,getInputEos,setOutputEos,getOutputEos,
+    writeVectorIt
 };
 
 epicsShareFunc int asynInterposeEosConfig(const char *portName,int addr,
@@ -95,7 +103,9 @@ epicsShareFunc int asynInterposeEosConfig(const char *portName,int addr,
     peosPvt->portName = (char *)(peosPvt+1);
     strcpy(peosPvt->portName,portName);
     peosPvt->eosInterface.interfaceType = asynOctetType;
-    peosPvt->eosInterface.pinterface = &octet;
+    peosPvt->octet = octet;
+    peosPvt->octet.writeVector = 0;
+    peosPvt->eosInterface.pinterface = &peosPvt->octet;
     peosPvt->eosInterface.drvPvt = peosPvt;
     pasynUser = pasynManager->createAsynUser(0,0);
     peosPvt->pasynUser = pasynUser;
@@ -125,6 +135,7 @@ epicsShareFunc int asynInterposeEosConfig(const char *portName,int addr,
     }
     peosPvt->poctet = (asynOctet *)plowerLevelInterface->pinterface;
     peosPvt->octetPvt = plowerLevelInterface->drvPvt;
+    if(peosPvt->poctet->writeVector) peosPvt->octet.writeVector = writeVectorIt;
     peosPvt->processEosIn = processEosIn;
     if(processEosIn) {
         peosPvt->inBuf = callocMustSucceed(1,INPUT_SIZE,
@@ -157,11 +168,18 @@ static asynStatus writeIt(void *ppvt,asynUser *pasynUser,
     eosPvt     *peosPvt = (eosPvt *)ppvt;
     asynStatus status;
     size_t     nbytesActual = 0;
+    asynOctetVector vector;
 
     if(!peosPvt->processEosOut) {
         return peosPvt->poctet->write(peosPvt->octetPvt,
             pasynUser,data,numchars,nbytesTransfered);
     }
+    /* Only a native writeVector avoids the copy into outBuf */
+    if(peosPvt->poctet->writeVector) {
+        vector.data = data;
+        vector.numchars = numchars;
+        return writeVectorIt(ppvt,pasynUser,&vector,1,nbytesTransfered);
+    }
     if(peosPvt->outBufSize<(numchars + peosPvt->eosOutLen)) {
         pasynManager->memFree(peosPvt->outBuf,peosPvt->outBufSize);
         peosPvt->outBufSize = numchars + peosPvt->eosOutLen;
@@ -180,6 +198,91 @@ static asynStatus writeIt(void *ppvt,asynUser *pasynUser,
     return status;
 }
 
+/*
+ * Only provided if the lower level implements writeVector. The output EOS
+ * is added as one more piece, so the data is not copied.
+ */
+static asynStatus writeVectorIt(void *ppvt,asynUser *pasynUser,
+    const asynOctetVector *vector,int count,size_t *nbytesTransfered)
+{
+    eosPvt          *peosPvt = (eosPvt *)ppvt;
+    asynOctetVector localVector[MAX_VECTOR+1];
+    asynOctetVector *pvector = localVector;
+    asynStatus      status;
+    size_t          numchars = 0;
+    size_t          nbytesActual = 0;
+    size_t          offset;
+    int             i;
+
+    if(!peosPvt->processEosOut || peosPvt->eosOutLen==0) {
+        return peosPvt->poctet->writeVector(peosPvt->octetPvt,pasynUser,
+            vector,count,nbytesTransfered);
+    }
+    if(count>MAX_VECTOR) {
+        pvector = pasynManager->memMalloc((count+1)*sizeof(asynOctetVector));
+    }
+    for(i=0; i<count; i++) {
+        pvector[i] = vector[i];
+        numchars += vector[i].numchars;
+    }
+    pvector[count].data = peosPvt->eosOut;
+    pvector[count].numchars = peosPvt->eosOutLen;
+    status = peosPvt->poctet->writeVector(peosPvt->octetPvt,pasynUser,
+        pvector,count+1,&nbytesActual);
+    if (status!=asynError) {
+        for(i=0, offset=0; i<=count && offset<nbytesActual; i++) {
+            size_t n = pvector[i].numchars;
+            if(n>nbytesActual-offset) n = nbytesActual-offset;
+            asynPrintIO(pasynUser,ASYN_TRACEIO_FILTER,pvector[i].data,n,
+                "%s wrote\n",peosPvt->portName);
+            offset += n;
+        }
+    }
+    if(pvector!=localVector) {
+        pasynManager->memFree(pvector,(count+1)*sizeof(asynOctetVector));
+    }
+    *nbytesTransfered = (nbytesActual>numchars) ? numchars : nbytesActual;
+    return status;
+}
+
+/*
+ * Returns the number of octets of buf up to and including the end of
+ * the input EOS, or len if it does not end in buf.  eosInMatch is the
+ * number of EOS octets matched so far, which can be from an earlier buf.
+ * While nothing is matched memchr finds the next possible start of the EOS.
+ */
+static size_t findEos(eosPvt *peosPvt,const char *buf,size_t len,int *found)
+{
+    const char *p = buf;
+    const char *end = buf + len;
+    int        match = peosPvt->eosInMatch;
+
+    *found = 0;
+    while (p < end) {
+        if (match == 0) {
+            p = memchr(p, peosPvt->eosIn[0], end - p);
+            if (!p) {
+                p = end;
+                break;
+            }
+            p++;
+            match = 1;
+        } else {
+            char c = *p++;
+            while (match > 0 && c != peosPvt->eosIn[match])
+                match = peosPvt->eosInFail[match];
+            if (c == peosPvt->eosIn[match]) match++;
+        }
+        if (match == peosPvt->eosInLen) {
+            match = 0;
+            *found = 1;
+            break;
+        }
+    }
+    peosPvt->eosInMatch = match;
+    return p - buf;
+}
+
 static asynStatus readIt(void *ppvt,asynUser *pasynUser,
     char *data,size_t maxchars,size_t *nbytesTransfered,int *eomReason)
 {
@@ -194,32 +297,26 @@ static asynStatus readIt(void *ppvt,asynUser *pasynUser,
     }
     for (;;) {
         if ((peosPvt->inBufTail != peosPvt->inBufHead)) {
-            char c = *data++ = peosPvt->inBuf[peosPvt->inBufTail++];
-            nRead++;
-            if (peosPvt->eosInLen > 0) {
-                if (c == peosPvt->eosIn[peosPvt->eosInMatch]) {
-                    if (++peosPvt->eosInMatch == peosPvt->eosInLen) {
-                        peosPvt->eosInMatch = 0;
-                        nRead -= peosPvt->eosInLen;
-                        data -= peosPvt->eosInLen;
-                        *(data+1) = 0;
-                        eom |= ASYN_EOM_EOS;
-                        break;
-                    }
-                } else {
-                    /*
-                     * Resynchronize the search.  Since the driver
-                     * allows a maximum two-character EOS it doesn't
-                     * have to worry about cases like:
-                     *    End-of-string is "eeef"
-                     *    Input stream so far is "eeeeeeeee"
-                     */
-                    if (c == peosPvt->eosIn[0]) {
-                        peosPvt->eosInMatch = 1;
-                    } else {
-                        peosPvt->eosInMatch = 0;
-                    }
-                }
+            const char *pin = &peosPvt->inBuf[peosPvt->inBufTail];
+            size_t nCopy = peosPvt->inBufHead - peosPvt->inBufTail;
+            int found = 0;
+
+            if (nCopy > maxchars - nRead) nCopy = maxchars - nRead;
+            if (peosPvt->eosInLen > 0)
+                nCopy = findEos(peosPvt, pin, nCopy, &found);
+            memcpy(data, pin, nCopy);
+            data += nCopy;
+            nRead += nCopy;
+            peosPvt->inBufTail += (unsigned int)nCopy;
+            if (found) {
+                /* EOS octets returned by an earlier read can not be removed */
+                size_t nEos = peosPvt->eosInLen;
+
+                if (nEos > nRead) nEos = nRead;
+                nRead -= nEos;
+                data -= nEos;
+                eom |= ASYN_EOM_EOS;
+                break;
             }
             if (nRead >= maxchars)  {
                 eom |= ASYN_EOM_CNT;
@@ -293,14 +390,23 @@ static asynStatus setInputEos(void *ppvt,asynUser *pasynUser,
     }
     asynPrintIO(pasynUser,ASYN_TRACE_FLOW,eos,eoslen,
             "%s set Eos %d\n",peosPvt->portName, eoslen);
-    switch (eoslen) {
-    default:
+    if (eoslen < 0 || eoslen > MAX_EOS_LEN) {
         epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
                         "%s illegal eoslen %d", peosPvt->portName,eoslen);
         return asynError;
-    case 2: peosPvt->eosIn[1] = eos[1]; /* fall through to case 1 */
-    case 1: peosPvt->eosIn[0] = eos[0]; break;
-    case 0: break;
+    }
+    memcpy(peosPvt->eosIn, eos, eoslen);
+    /* Knuth-Morris-Pratt failure function, so that no input is scanned twice */
+    if (eoslen > 0) {
+        int i, match = 0;
+
+        peosPvt->eosInFail[0] = 0;
+        for (i = 1; i < eoslen; i++) {
+            peosPvt->eosInFail[i] = match;
+            while (match > 0 && eos[i] != eos[match])
+                match = peosPvt->eosInFail[match];
+            if (eos[i] == eos[match]) match++;
+        }
     }
     peosPvt->eosInLen = eoslen;
     peosPvt->eosInMatch = 0;
@@ -322,15 +428,7 @@ static asynStatus getInputEos(void *ppvt,asynUser *pasynUser,
                                 peosPvt->portName,eossize,peosPvt->eosInLen);
         return(asynError);
     }
-    switch (peosPvt->eosInLen) {
-    default:
-        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
-            "%s illegal peosPvt->eosInLen %d", peosPvt->portName,peosPvt->eosInLen);
-        return asynError;
-    case 2: eos[1] = peosPvt->eosIn[1]; /* fall through to case 1 */
-    case 1: eos[0] = peosPvt->eosIn[0]; break;
-    case 0: break;
-    }
+    memcpy(eos, peosPvt->eosIn, peosPvt->eosInLen);
     *eoslen = peosPvt->eosInLen;
     if(peosPvt->eosInLen<eossize) eos[peosPvt->eosInLen] = 0;
     asynPrintIO(pasynUser, ASYN_TRACE_FLOW, eos, *eoslen,
@@ -346,15 +444,12 @@ static asynStatus setOutputEos(void *ppvt,asynUser *pasynUser,
     assert(peosPvt);
     asynPrintIO(pasynUser,ASYN_TRACE_FLOW,eos,eoslen,
             "%s set Eos %d\n",peosPvt->portName, eoslen);
-    switch (eoslen) {
-    default:
+    if (eoslen < 0 || eoslen > MAX_EOS_LEN) {
         epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
                         "%s illegal eoslen %d", peosPvt->portName,eoslen);
         return asynError;
-    case 2: peosPvt->eosOut[1] = eos[1]; /* fall through to case 1 */
-    case 1: peosPvt->eosOut[0] = eos[0]; break;
-    case 0: break;
     }
+    memcpy(peosPvt->eosOut, eos, eoslen);
     peosPvt->eosOutLen = eoslen;
     return asynSuccess;
 }
@@ -371,15 +466,7 @@ static asynStatus getOutputEos(void *ppvt,asynUser *pasynUser,
                                 peosPvt->portName,eossize,peosPvt->eosOutLen);
         return(asynError);
     }
-    switch (peosPvt->eosOutLen) {
-    default:
-        epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
-            "%s illegal peosPvt->eosOutLen %d", peosPvt->portName,peosPvt->eosOutLen);
-        return asynError;
-    case 2: eos[1] = peosPvt->eosOut[1]; /* fall through to case 1 */
-    case 1: eos[0] = peosPvt->eosOut[0]; break;
-    case 0: break;
-    }
+    memcpy(eos, peosPvt->eosOut, peosPvt->eosOutLen);
     *eoslen = peosPvt->eosOutLen;
     asynPrintIO(pasynUser, ASYN_TRACE_FLOW, eos, *eoslen,
             "%s get Eos %d\n", peosPvt->portName, *eoslen);
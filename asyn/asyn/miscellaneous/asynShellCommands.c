@@ -833,6 +833,243 @@ static void asynEnableCall(const iocshArgBuf * args) {
     asynEnable(portName,addr,yesNo);
 }
 
+static const iocshArg asynEnableQueueStatisticsArg0 = {"portName", iocshArgString};
+static const iocshArg asynEnableQueueStatisticsArg1 = {"yesNo", iocshArgInt};
+static const iocshArg *const asynEnableQueueStatisticsArgs[] = {
+    &asynEnableQueueStatisticsArg0,&asynEnableQueueStatisticsArg1};
+static const iocshFuncDef asynEnableQueueStatisticsDef =
+    {"asynEnableQueueStatistics", 2, asynEnableQueueStatisticsArgs};
+epicsShareFunc int
+ asynEnableQueueStatistics(const char *portName,int yesNo)
+{
+    asynUser *pasynUser;
+    asynStatus status;
+
+    pasynUser = pasynManager->createAsynUser(0,0);
+    status = pasynManager->connectDevice(pasynUser,portName,-1);
+    if(status!=asynSuccess) {
+        printf("%s\n",pasynUser->errorMessage);
+        pasynManager->freeAsynUser(pasynUser);
+        return -1;
+    }
+    status = pasynManager->enableQueueStatistics(pasynUser,yesNo);
+    if(status!=asynSuccess) {
+        printf("%s\n",pasynUser->errorMessage);
+    }
+    pasynManager->freeAsynUser(pasynUser);
+    return 0;
+}
+static void asynEnableQueueStatisticsCall(const iocshArgBuf * args) {
+    const char *portName = args[0].sval;
+    int yesNo = args[1].ival;
+    asynEnableQueueStatistics(portName,yesNo);
+}
+
+static void showTimeHistogram(const char *title,unsigned long *histogram)
+{
+    int i;
+
+    printf("%s:",title);
+    for(i=0; i<ASYN_QUEUE_STATISTICS_BINS; i++) {
+        printf(" %s:%lu",asynQueueStatisticsLabels[i],histogram[i]);
+    }
+    printf("\n");
+}
+
+static const iocshArg asynShowQueueStatisticsArg0 = {"portName", iocshArgString};
+static const iocshArg asynShowQueueStatisticsArg1 = {"addr", iocshArgInt};
+static const iocshArg asynShowQueueStatisticsArg2 = {"clear", iocshArgInt};
+static const iocshArg *const asynShowQueueStatisticsArgs[] = {
+    &asynShowQueueStatisticsArg0,&asynShowQueueStatisticsArg1,
+    &asynShowQueueStatisticsArg2};
+static const iocshFuncDef asynShowQueueStatisticsDef =
+    {"asynShowQueueStatistics", 3, asynShowQueueStatisticsArgs};
+epicsShareFunc int
+ asynShowQueueStatistics(const char *portName,int addr,int clear)
+{
+    asynUser *pasynUser;
+    asynStatus status;
+    asynQueueStatistics statistics;
+
+    pasynUser = pasynManager->createAsynUser(0,0);
+    status = pasynManager->connectDevice(pasynUser,portName,addr);
+    if(status!=asynSuccess) {
+        printf("%s\n",pasynUser->errorMessage);
+        pasynManager->freeAsynUser(pasynUser);
+        return -1;
+    }
+    status = pasynManager->getQueueStatistics(pasynUser,&statistics,clear);
+    if(status!=asynSuccess) {
+        printf("%s\n",pasynUser->errorMessage);
+        pasynManager->freeAsynUser(pasynUser);
+        return -1;
+    }
+    printf("%s addr %d\n",portName,addr);
+    showTimeHistogram("    queue wait",statistics.queueWait);
+    showTimeHistogram("    service time",statistics.service);
+    printf("    timeouts %lu cancels %lu\n",
+        statistics.numberTimeouts,statistics.numberCancels);
+    pasynManager->freeAsynUser(pasynUser);
+    return 0;
+}
+static void asynShowQueueStatisticsCall(const iocshArgBuf * args) {
+    const char *portName = args[0].sval;
+    int addr = args[1].ival;
+    int clear = args[2].ival;
+    asynShowQueueStatistics(portName,addr,clear);
+}
+
+static const iocshArg asynSetPortThreadsArg0 = {"portName", iocshArgString};
+static const iocshArg asynSetPortThreadsArg1 = {"numberThreads", iocshArgInt};
+static const iocshArg *const asynSetPortThreadsArgs[] = {
+    &asynSetPortThreadsArg0,&asynSetPortThreadsArg1};
+static const iocshFuncDef asynSetPortThreadsDef =
+    {"asynSetPortThreads", 2, asynSetPortThreadsArgs};
+epicsShareFunc int
+ asynSetPortThreads(const char *portName,int numberThreads)
+{
+    asynUser *pasynUser;
+    asynStatus status;
+
+    pasynUser = pasynManager->createAsynUser(0,0);
+    status = pasynManager->connectDevice(pasynUser,portName,-1);
+    if(status!=asynSuccess) {
+        printf("%s\n",pasynUser->errorMessage);
+        pasynManager->freeAsynUser(pasynUser);
+        return -1;
+    }
+    status = pasynManager->setPortThreads(pasynUser,numberThreads);
+    if(status!=asynSuccess) {
+        printf("%s\n",pasynUser->errorMessage);
+        pasynManager->freeAsynUser(pasynUser);
+        return -1;
+    }
+    pasynManager->freeAsynUser(pasynUser);
+    return 0;
+}
+static void asynSetPortThreadsCall(const iocshArgBuf * args) {
+    const char *portName = args[0].sval;
+    int numberThreads = args[1].ival;
+    asynSetPortThreads(portName,numberThreads);
+}
+
+static const iocshArg asynSetPipelineDepthArg0 = {"portName", iocshArgString};
+static const iocshArg asynSetPipelineDepthArg1 = {"depth", iocshArgInt};
+static const iocshArg *const asynSetPipelineDepthArgs[] = {
+    &asynSetPipelineDepthArg0,&asynSetPipelineDepthArg1};
+static const iocshFuncDef asynSetPipelineDepthDef =
+    {"asynSetPipelineDepth", 2, asynSetPipelineDepthArgs};
+epicsShareFunc int
+ asynSetPipelineDepth(const char *portName,int depth)
+{
+    asynUser *pasynUser;
+    asynStatus status;
+
+    pasynUser = pasynManager->createAsynUser(0,0);
+    status = pasynManager->connectDevice(pasynUser,portName,-1);
+    if(status!=asynSuccess) {
+        printf("%s\n",pasynUser->errorMessage);
+        pasynManager->freeAsynUser(pasynUser);
+        return -1;
+    }
+    status = pasynManager->setPipelineDepth(pasynUser,depth);
+    if(status!=asynSuccess) {
+        printf("%s\n",pasynUser->errorMessage);
+        pasynManager->freeAsynUser(pasynUser);
+        return -1;
+    }
+    pasynManager->freeAsynUser(pasynUser);
+    return 0;
+}
+static void asynSetPipelineDepthCall(const iocshArgBuf * args) {
+    const char *portName = args[0].sval;
+    int depth = args[1].ival;
+    asynSetPipelineDepth(portName,depth);
+}
+
+static const iocshArg asynSetTraceRingArg0 = {"portName", iocshArgString};
+static const iocshArg asynSetTraceRingArg1 = {"numberRecords", iocshArgInt};
+static const iocshArg asynSetTraceRingArg2 = {"drain", iocshArgInt};
+static const iocshArg *const asynSetTraceRingArgs[] = {
+    &asynSetTraceRingArg0,&asynSetTraceRingArg1,&asynSetTraceRingArg2};
+static const iocshFuncDef asynSetTraceRingDef =
+    {"asynSetTraceRing", 3, asynSetTraceRingArgs};
+epicsShareFunc int
+ asynSetTraceRing(const char *portName,int numberRecords,int drain)
+{
+    asynUser *pasynUser;
+    asynStatus status;
+
+    pasynUser = pasynManager->createAsynUser(0,0);
+    status = pasynManager->connectDevice(pasynUser,portName,-1);
+    if(status!=asynSuccess) {
+        printf("%s\n",pasynUser->errorMessage);
+        pasynManager->freeAsynUser(pasynUser);
+        return -1;
+    }
+    status = pasynTrace->setTraceRing(pasynUser,numberRecords,drain);
+    if(status!=asynSuccess) {
+        printf("%s\n",pasynUser->errorMessage);
+        pasynManager->freeAsynUser(pasynUser);
+        return -1;
+    }
+    pasynManager->freeAsynUser(pasynUser);
+    return 0;
+}
+static void asynSetTraceRingCall(const iocshArgBuf * args) {
+    const char *portName = args[0].sval;
+    int numberRecords = args[1].ival;
+    int drain = args[2].ival;
+    asynSetTraceRing(portName,numberRecords,drain);
+}
+
+static const iocshArg asynTraceRingDumpArg0 = {"portName", iocshArgString};
+static const iocshArg asynTraceRingDumpArg1 = {"filename", iocshArgString};
+static const iocshArg *const asynTraceRingDumpArgs[] = {
+    &asynTraceRingDumpArg0,&asynTraceRingDumpArg1};
+static const iocshFuncDef asynTraceRingDumpDef =
+    {"asynTraceRingDump", 2, asynTraceRingDumpArgs};
+epicsShareFunc int
+ asynTraceRingDump(const char *portName,const char *filename)
+{
+    asynUser *pasynUser;
+    asynStatus status;
+    FILE     *fp;
+    int      nRecords;
+
+    pasynUser = pasynManager->createAsynUser(0,0);
+    status = pasynManager->connectDevice(pasynUser,portName,-1);
+    if(status!=asynSuccess) {
+        printf("%s\n",pasynUser->errorMessage);
+        pasynManager->freeAsynUser(pasynUser);
+        return -1;
+    }
+    if(!filename || strlen(filename)==0 || strcmp(filename,"stdout")==0) {
+        fp = stdout;
+    } else if(strcmp(filename,"stderr")==0) {
+        fp = stderr;
+    } else {
+        fp = fopen(filename,"a");
+        if(!fp) {
+            printf("fopen failed %s\n",strerror(errno));
+            pasynManager->freeAsynUser(pasynUser);
+            return -1;
+        }
+    }
+    nRecords = pasynTrace->dumpTraceRing(pasynUser,fp);
+    if(nRecords<0) {
+        printf("%s\n",pasynUser->errorMessage);
+    }
+    if(fp!=stdout && fp!=stderr) fclose(fp);
+    pasynManager->freeAsynUser(pasynUser);
+    return 0;
+}
+static void asynTraceRingDumpCall(const iocshArgBuf * args) {
+    const char *portName = args[0].sval;
+    const char *filename = args[1].sval;
+    asynTraceRingDump(portName,filename);
+}
+
 static const iocshArg asynAutoConnectArg0 = {"portName", iocshArgString};
 static const iocshArg asynAutoConnectArg1 = {"addr", iocshArgInt};
 static const iocshArg asynAutoConnectArg2 = {"yesNo", iocshArgInt};
@@ -1098,6 +1335,12 @@ static void asynRegister(void)
     iocshRegister(&asynSetTraceIOTruncateSizeDef,asynSetTraceIOTruncateSizeCall);
     iocshRegister(&asynEnableDef,asynEnableCall);
     iocshRegister(&asynAutoConnectDef,asynAutoConnectCall);
+    iocshRegister(&asynEnableQueueStatisticsDef,asynEnableQueueStatisticsCall);
+    iocshRegister(&asynShowQueueStatisticsDef,asynShowQueueStatisticsCall);
+    iocshRegister(&asynSetPortThreadsDef,asynSetPortThreadsCall);
+    iocshRegister(&asynSetPipelineDepthDef,asynSetPipelineDepthCall);
+    iocshRegister(&asynSetTraceRingDef,asynSetTraceRingCall);
+    iocshRegister(&asynTraceRingDumpDef,asynTraceRingDumpCall);
     iocshRegister(&asynOctetConnectDef,asynOctetConnectCall);
     iocshRegister(&asynOctetDisconnectDef,asynOctetDisconnectCall);
     iocshRegister(&asynOctetReadDef,asynOctetReadCall);
@@ -37,6 +37,18 @@ epicsShareFunc int
  asynAutoConnect(const char *portName,int addr,int yesNo);
 epicsShareFunc int 
  asynEnable(const char *portName,int addr,int yesNo);
+epicsShareFunc int 
+ asynEnableQueueStatistics(const char *portName,int yesNo);
+epicsShareFunc int 
+ asynShowQueueStatistics(const char *portName,int addr,int clear);
+epicsShareFunc int 
+ asynSetPortThreads(const char *portName,int numberThreads);
+epicsShareFunc int 
+ asynSetPipelineDepth(const char *portName,int depth);
+epicsShareFunc int 
+ asynSetTraceRing(const char *portName,int numberRecords,int drain);
+epicsShareFunc int 
+ asynTraceRingDump(const char *portName,const char *filename);
 
 epicsShareFunc int 
  asynOctetConnect(const char *entry, const char *port, int addr,
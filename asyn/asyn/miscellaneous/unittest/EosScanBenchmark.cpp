@@ -0,0 +1,236 @@
+/*
+ * EosScanBenchmark.cpp
+ *
+ * Reads 1 MB of line-delimited input through asynInterposeEos and checks the
+ * lines for 1, 2 and 5 character terminators. The time is compared with the
+ * character at a time EOS matching that asynInterposeEos used before.
+ *
+ ***************************************************************************
+ * This file is distributed subject to a Software License Agreement found  *
+ * in the file LICENSE that is included with this distribution.            *
+ ***************************************************************************
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <epicsTime.h>
+#include "asynPortDriver.h"
+#include <asynOctet.h>
+#include <asynInterposeEos.h>
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#define PORT_NAME  "EOS_BENCH"
+#define INPUT_SIZE (1024*1024)
+#define BLOCK_SIZE 2048
+#define MAX_LINE   256
+
+/* Low level driver that returns the input a block at a time, like a TCP port */
+class eosSource : public asynPortDriver {
+public:
+    eosSource(const char *portName);
+    virtual asynStatus readOctet(asynUser *pasynUser, char *value, size_t maxChars,
+                                 size_t *nActual, int *eomReason);
+    void setInput(const char *input, size_t len, size_t blockSize);
+private:
+    const char *input_;
+    size_t len_;
+    size_t pos_;
+    size_t blockSize_;
+};
+
+eosSource::eosSource(const char *portName)
+    : asynPortDriver(portName, 1, 1, asynOctetMask | asynDrvUserMask, 0, 0, 1, 0, 0),
+      input_(0), len_(0), pos_(0), blockSize_(BLOCK_SIZE)
+{
+}
+
+asynStatus eosSource::readOctet(asynUser *pasynUser, char *value, size_t maxChars,
+                                size_t *nActual, int *eomReason)
+{
+    size_t n = len_ - pos_;
+
+    if (n > maxChars) n = maxChars;
+    if (n > blockSize_) n = blockSize_;
+    memcpy(value, input_ + pos_, n);
+    pos_ += n;
+    *nActual = n;
+    if (eomReason) *eomReason = 0;
+    return asynSuccess;
+}
+
+void eosSource::setInput(const char *input, size_t len, size_t blockSize)
+{
+    input_ = input;
+    len_ = len;
+    pos_ = 0;
+    blockSize_ = blockSize;
+}
+
+static int makeLine(int i, char *line)
+{
+    return sprintf(line, "%d,%.6f,%.6e,waveform point %d of the dump", i, i*0.001, i*1.5e-3, i);
+}
+
+/* Returns the number of lines that fit in INPUT_SIZE */
+static int makeInput(char *input, const char *eos, size_t *len)
+{
+    char line[MAX_LINE];
+    size_t eosLen = strlen(eos);
+    size_t pos = 0;
+    int n, i;
+
+    for (i=0; ; i++) {
+        n = makeLine(i, line);
+        if (pos + n + eosLen > INPUT_SIZE) break;
+        memcpy(input + pos, line, n);
+        memcpy(input + pos + n, eos, eosLen);
+        pos += n + eosLen;
+    }
+    *len = pos;
+    return i;
+}
+
+/* Reads lines until the input is used up. If check is not 0 the lines are compared
+ * with the input. Returns the number of lines that do not match */
+static int readLines(asynOctet *pasynOctet, void *drvPvt, asynUser *pasynUser, int nLines,
+                     int check, int *nRead)
+{
+    char data[MAX_LINE], line[MAX_LINE];
+    size_t nbytes;
+    int eomReason, nBad = 0;
+
+    for (*nRead=0; ; (*nRead)++) {
+        if (pasynOctet->read(drvPvt, pasynUser, data, sizeof(data), &nbytes, &eomReason)) break;
+        if (nbytes == 0 && !(eomReason & ASYN_EOM_EOS)) break;
+        if (!check) continue;
+        makeLine(*nRead, line);
+        if (!(eomReason & ASYN_EOM_EOS) || nbytes != strlen(line) || memcmp(data, line, nbytes)) nBad++;
+    }
+    if (*nRead != nLines) nBad++;
+    return nBad;
+}
+
+/* The character at a time EOS matching that asynInterposeEos used before, for a 2 character EOS */
+static size_t oldReadIt(eosSource *pSource, asynUser *pasynUser, char *inBuf, size_t *inBufHead,
+                        size_t *inBufTail, int *eosInMatch, const char *eosIn,
+                        char *data, size_t maxchars)
+{
+    size_t nRead = 0, thisRead;
+    int eom = 0;
+
+    for (;;) {
+        if (*inBufTail != *inBufHead) {
+            char c = *data++ = inBuf[(*inBufTail)++];
+            nRead++;
+            if (c == eosIn[*eosInMatch]) {
+                if (++(*eosInMatch) == 2) {
+                    *eosInMatch = 0;
+                    nRead -= 2;
+                    data -= 2;
+                    eom |= ASYN_EOM_EOS;
+                    break;
+                }
+            } else {
+                *eosInMatch = (c == eosIn[0]) ? 1 : 0;
+            }
+            if (nRead >= maxchars) break;
+            continue;
+        }
+        pSource->readOctet(pasynUser, inBuf, BLOCK_SIZE, &thisRead, &eom);
+        if (thisRead == 0) break;
+        *inBufTail = 0;
+        *inBufHead = thisRead;
+    }
+    if (nRead < maxchars) *data = 0;
+    return nRead;
+}
+
+MAIN(EosScanBenchmark)
+{
+    eosSource *pSource;
+    asynUser *pasynUser;
+    asynInterface *pasynInterface;
+    asynOctet *pasynOctet;
+    void *drvPvt;
+    char *input;
+    char inBuf[BLOCK_SIZE], data[MAX_LINE];
+    size_t len, inBufHead = 0, inBufTail = 0, nbytes;
+    int eosInMatch = 0, nLines, nRead, nBad, eomReason;
+    epicsTimeStamp start, end;
+    double newTime, oldTime;
+    static const char *eosList[] = {"\n", "\r\n", "<EOL>"};
+    int i;
+
+    testPlan(8);
+    input = (char *)malloc(INPUT_SIZE);
+    pSource = new eosSource(PORT_NAME);
+    testOk(asynInterposeEosConfig(PORT_NAME, -1, 1, 0) == 0, "asynInterposeEosConfig");
+    pasynUser = pasynManager->createAsynUser(0, 0);
+    pasynManager->connectDevice(pasynUser, PORT_NAME, 0);
+    pasynInterface = pasynManager->findInterface(pasynUser, asynOctetType, 1);
+    pasynOctet = (asynOctet *)pasynInterface->pinterface;
+    drvPvt = pasynInterface->drvPvt;
+
+    for (i=0; i<3; i++) {
+        nLines = makeInput(input, eosList[i], &len);
+        pSource->setInput(input, len, BLOCK_SIZE);
+        pasynOctet->setInputEos(drvPvt, pasynUser, eosList[i], (int)strlen(eosList[i]));
+        nBad = readLines(pasynOctet, drvPvt, pasynUser, nLines, 1, &nRead);
+        testOk(nBad == 0, "%d character EOS: %d of %d lines read correctly", (int)strlen(eosList[i]),
+               nRead, nLines);
+        pSource->setInput(input, len, BLOCK_SIZE);
+        epicsTimeGetCurrent(&start);
+        readLines(pasynOctet, drvPvt, pasynUser, nLines, 0, &nRead);
+        epicsTimeGetCurrent(&end);
+        newTime = epicsTimeDiffInSeconds(&end, &start);
+        testDiag("%d character EOS: %lu bytes in %f sec, %f MB/sec", (int)strlen(eosList[i]),
+                 (unsigned long)len, newTime, len/newTime/1e6);
+    }
+
+    /* Blocks of 7 bytes split the 5 character EOS between reads */
+    nLines = makeInput(input, "<EOL>", &len);
+    pSource->setInput(input, len, 7);
+    nBad = readLines(pasynOctet, drvPvt, pasynUser, nLines, 1, &nRead);
+    testOk(nBad == 0, "EOS split between reads: %d of %d lines read correctly", nRead, nLines);
+
+    /* A partial match of the EOS is part of the data */
+    pSource->setInput("caaabdaab<<E<EOL>", 17, BLOCK_SIZE);
+    pasynOctet->setInputEos(drvPvt, pasynUser, "aab", 3);
+    pasynOctet->read(drvPvt, pasynUser, data, sizeof(data), &nbytes, &eomReason);
+    nBad = (nbytes != 2 || strcmp(data, "ca"));
+    pasynOctet->read(drvPvt, pasynUser, data, sizeof(data), &nbytes, &eomReason);
+    nBad += (nbytes != 1 || strcmp(data, "d"));
+    pasynOctet->setInputEos(drvPvt, pasynUser, "<EOL>", 5);
+    pasynOctet->read(drvPvt, pasynUser, data, sizeof(data), &nbytes, &eomReason);
+    nBad += (nbytes != 3 || strcmp(data, "<<E"));
+    testOk(nBad == 0, "EOS found after a partial match");
+
+    /* The old character at a time matching */
+    nLines = makeInput(input, "\r\n", &len);
+    pSource->setInput(input, len, BLOCK_SIZE);
+    epicsTimeGetCurrent(&start);
+    for (nRead=0; ; nRead++) {
+        if (oldReadIt(pSource, pasynUser, inBuf, &inBufHead, &inBufTail, &eosInMatch, "\r\n",
+                      data, sizeof(data)) == 0 && inBufHead == inBufTail) break;
+    }
+    epicsTimeGetCurrent(&end);
+    oldTime = epicsTimeDiffInSeconds(&end, &start);
+    testOk(nRead == nLines, "character at a time matching read %d of %d lines", nRead, nLines);
+    testDiag("character at a time matching: %lu bytes in %f sec, %f MB/sec",
+             (unsigned long)len, oldTime, len/oldTime/1e6);
+
+    pSource->setInput(input, len, BLOCK_SIZE);
+    pasynOctet->setInputEos(drvPvt, pasynUser, "\r\n", 2);
+    epicsTimeGetCurrent(&start);
+    readLines(pasynOctet, drvPvt, pasynUser, nLines, 0, &nRead);
+    epicsTimeGetCurrent(&end);
+    newTime = epicsTimeDiffInSeconds(&end, &start);
+    testOk(nRead == nLines, "block scan read %d of %d lines", nRead, nLines);
+    testDiag("block scan: %lu bytes in %f sec, %f MB/sec, %.1f times the character at a time rate",
+             (unsigned long)len, newTime, len/newTime/1e6, oldTime/newTime);
+
+    free(input);
+    return testDone();
+}
@@ -0,0 +1,165 @@
+/*
+ * OctetVectorTest.cpp
+ *
+ * Tests asynOctet writeVector through asynInterposeEos. For a driver that only
+ * implements write there is no writeVector and write appends the EOS in one
+ * write. For drvAsynIPPort connected to a local TCP socket the pieces and the
+ * EOS are sent without copying them.
+ *
+ ***************************************************************************
+ * This file is distributed subject to a Software License Agreement found  *
+ * in the file LICENSE that is included with this distribution.            *
+ ***************************************************************************
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <osiSock.h>
+#include "asynPortDriver.h"
+#include <asynOctet.h>
+#include <asynInterposeEos.h>
+#include <drvAsynIPPort.h>
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#define PORT_NAME   "VECTOR_WRITE"
+#define IP_NAME     "VECTOR_IP"
+#define MAX_WRITE   256
+#define NUM_PIECES  40
+
+/* Driver that only implements write, and keeps what was written */
+class writeRecorder : public asynPortDriver {
+public:
+    writeRecorder(const char *portName);
+    virtual asynStatus writeOctet(asynUser *pasynUser, const char *value, size_t maxChars,
+                                  size_t *nActual);
+    int numWrites;
+    size_t length;
+    char data[MAX_WRITE];
+};
+
+writeRecorder::writeRecorder(const char *portName)
+    : asynPortDriver(portName, 1, 1, asynOctetMask | asynDrvUserMask, 0, 0, 1, 0, 0),
+      numWrites(0), length(0)
+{
+}
+
+asynStatus writeRecorder::writeOctet(asynUser *pasynUser, const char *value, size_t maxChars,
+                                     size_t *nActual)
+{
+    numWrites++;
+    if (maxChars > MAX_WRITE) maxChars = MAX_WRITE;
+    memcpy(data, value, maxChars);
+    length = maxChars;
+    *nActual = maxChars;
+    return asynSuccess;
+}
+
+static asynOctet *findOctet(const char *portName, asynUser **ppasynUser, void **pdrvPvt)
+{
+    asynInterface *pasynInterface;
+
+    *ppasynUser = pasynManager->createAsynUser(0, 0);
+    pasynManager->connectDevice(*ppasynUser, portName, 0);
+    pasynInterface = pasynManager->findInterface(*ppasynUser, asynOctetType, 1);
+    *pdrvPvt = pasynInterface->drvPvt;
+    return (asynOctet *)pasynInterface->pinterface;
+}
+
+/* Reads from the socket until len bytes are received or the connection is closed */
+static size_t readAll(SOCKET fd, char *buffer, size_t len)
+{
+    size_t nread = 0;
+    int n;
+
+    while (nread < len) {
+        n = recv(fd, buffer + nread, (int)(len - nread), 0);
+        if (n <= 0) break;
+        nread += n;
+    }
+    return nread;
+}
+
+MAIN(OctetVectorTest)
+{
+    writeRecorder *pRecorder;
+    asynUser *pasynUser;
+    asynOctet *pasynOctet;
+    void *drvPvt;
+    asynInterface *pasynInterface;
+    asynCommon *pasynCommon;
+    asynOctetVector vector[NUM_PIECES];
+    char pieces[NUM_PIECES][8];
+    char expected[NUM_PIECES*8 + 2], received[NUM_PIECES*8 + 2];
+    size_t nbytes, len;
+    struct sockaddr_in addr;
+    osiSocklen_t addrSize = sizeof(addr);
+    SOCKET listenFd, fd;
+    char hostInfo[40];
+    int i;
+
+    testPlan(10);
+
+    /* A driver without writeVector has none through asynOctetBase and asynInterposeEos */
+    pRecorder = new writeRecorder(PORT_NAME);
+    pasynOctet = findOctet(PORT_NAME, &pasynUser, &drvPvt);
+    testOk(pasynOctet->writeVector == 0, "asynOctetBase has no writeVector for a driver without it");
+    pasynManager->freeAsynUser(pasynUser);
+    testOk(asynInterposeEosConfig(PORT_NAME, -1, 0, 1) == 0, "asynInterposeEosConfig");
+    pasynOctet = findOctet(PORT_NAME, &pasynUser, &drvPvt);
+    testOk(pasynOctet->writeVector == 0, "asynInterposeEos has no writeVector for a driver without it");
+    pasynOctet->setOutputEos(drvPvt, pasynUser, "\r\n", 2);
+    pasynOctet->write(drvPvt, pasynUser, "CMD", 3, &nbytes);
+    testOk(pRecorder->numWrites == 1 && pRecorder->length == 5 &&
+           memcmp(pRecorder->data, "CMD\r\n", 5) == 0 && nbytes == 3,
+           "write appends the EOS in one write");
+    pasynOctet->write(drvPvt, pasynUser, "LONGER COMMAND", 14, &nbytes);
+    testOk(pRecorder->numWrites == 2 && pRecorder->length == 16 &&
+           memcmp(pRecorder->data, "LONGER COMMAND\r\n", 16) == 0 && nbytes == 14,
+           "second write appends the EOS");
+    pasynManager->freeAsynUser(pasynUser);
+
+    /* drvAsynIPPort sends the pieces and the EOS to the socket */
+    osiSockAttach();
+    listenFd = epicsSocketCreate(AF_INET, SOCK_STREAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    bind(listenFd, (struct sockaddr *)&addr, sizeof(addr));
+    listen(listenFd, 1);
+    getsockname(listenFd, (struct sockaddr *)&addr, &addrSize);
+    sprintf(hostInfo, "127.0.0.1:%d", ntohs(addr.sin_port));
+    testOk(drvAsynIPPortConfigure(IP_NAME, hostInfo, 0, 1, 0) == 0,
+           "drvAsynIPPortConfigure %s", hostInfo);
+    pasynOctet = findOctet(IP_NAME, &pasynUser, &drvPvt);
+    pasynUser->timeout = 1.0;
+    pasynInterface = pasynManager->findInterface(pasynUser, asynCommonType, 1);
+    pasynCommon = (asynCommon *)pasynInterface->pinterface;
+    pasynCommon->connect(pasynInterface->drvPvt, pasynUser);
+    pasynOctet->setOutputEos(drvPvt, pasynUser, "\n", 1);
+
+    len = 0;
+    for (i=0; i<NUM_PIECES; i++) {
+        sprintf(pieces[i], "%d,", i);
+        vector[i].data = pieces[i];
+        vector[i].numchars = strlen(pieces[i]);
+        memcpy(expected + len, pieces[i], vector[i].numchars);
+        len += vector[i].numchars;
+    }
+    expected[len++] = '\n';
+    testOk(pasynOctet->writeVector != 0, "asynInterposeEos has writeVector for %s", IP_NAME);
+    testOk(pasynOctet->writeVector(drvPvt, pasynUser, vector, NUM_PIECES, &nbytes) == asynSuccess &&
+           nbytes == len - 1, "writeVector of %d pieces to %s", NUM_PIECES, IP_NAME);
+    fd = epicsSocketAccept(listenFd, (struct sockaddr *)&addr, &addrSize);
+    testOk(fd != INVALID_SOCKET, "connection accepted");
+    nbytes = readAll(fd, received, len);
+    testOk(nbytes == len && memcmp(received, expected, len) == 0,
+           "received %lu of %lu bytes in order", (unsigned long)nbytes, (unsigned long)len);
+
+    pasynManager->freeAsynUser(pasynUser);
+    epicsSocketDestroy(fd);
+    epicsSocketDestroy(listenFd);
+    return testDone();
+}
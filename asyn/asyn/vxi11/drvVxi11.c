@@ -54,13 +54,24 @@
 
 #define FLAG_RECOVER_WITH_IFC   0x1
 #define FLAG_LOCK_DEVICES       0x2
+#define FLAG_LINK_CLIENTS       0x4
 
 #define DEFAULT_RPC_TIMEOUT 4
 
 typedef struct devLink {
-    Device_Link lid;
-    BOOL        connected;
-    int         eos;
+    Device_Link    lid;
+    BOOL           connected;
+    int            eos;
+    /* lock and rpcClient are only set for a link with its own RPC client */
+    epicsMutexId   lock;       /* serializes the calls on rpcClient */
+    CLIENT         *rpcClient;
+    struct timeval rpcTimeout; /* zero for the rpcTimeout of the port */
+    unsigned long  numberReads;
+    unsigned long  numberWrites;
+    unsigned long  bytesRead;
+    unsigned long  bytesWritten;
+    unsigned long  numberTimeouts;
+    unsigned long  numberErrors;
 }devLink;
 typedef struct linkPrimary {
     devLink primary;
@@ -83,6 +94,8 @@ typedef struct vxiPort {
     BOOL          singleLinkInterrupt; /*Is there an unhandled interrupt */
     struct in_addr inAddr; /* ip address of gateway */
     CLIENT        *rpcClient; /* returned by clnttcp_create() */
+    epicsMutexId  rpcLock;    /* serializes the calls on rpcClient */
+    BOOL          linkClients; /* each device link has its own rpcClient */
     unsigned long maxRecvSize; /* max. # of bytes accepted by link */
     unsigned short abortPort;   /* TCP port for abort channel */
     double        defTimeout;
@@ -105,18 +118,32 @@ static char *vxiError(Device_ErrorCode error);
 static unsigned long getIoTimeout(asynUser *pasynUser,vxiPort *ppvxiPort);
 static BOOL vxiIsPortConnected(vxiPort * pvxiPort,asynUser *pasynUser);
 static void vxiDisconnectException(vxiPort *pvxiPort,int addr);
-static BOOL vxiCreateDeviceLink(vxiPort * pvxiPort,
+static CLIENT *vxiCreateClient(vxiPort *pvxiPort,asynUser *pasynUser);
+static CLIENT *lockClient(vxiPort *pvxiPort,devLink *pdevLink);
+static void unlockClient(vxiPort *pvxiPort,devLink *pdevLink);
+static struct timeval linkRpcTimeout(vxiPort *pvxiPort,devLink *pdevLink);
+static BOOL vxiCreateDeviceLink(vxiPort * pvxiPort,devLink *pdevLink,
     char *devName,Device_Link *pDevice_Link);
-static BOOL vxiCreateDevLink(vxiPort * pvxiPort,int addr,Device_Link *plid);
+static BOOL vxiCreateDevLink(vxiPort * pvxiPort,devLink *pdevLink,
+    int addr,Device_Link *plid);
 static devLink *vxiGetDevLink(vxiPort * pvxiPort, asynUser *pasynUser,int addr);
-static BOOL vxiDestroyDevLink(vxiPort * pvxiPort, Device_Link devLink);
+static BOOL vxiDestroyDevLink(vxiPort * pvxiPort, devLink *pdevLink);
+static BOOL vxiOpenLink(vxiPort *pvxiPort,devLink *pdevLink,
+    asynUser *pasynUser,int addr);
+static BOOL vxiCloseLink(vxiPort *pvxiPort,devLink *pdevLink);
+static void vxiLinkFailed(vxiPort *pvxiPort,devLink *pdevLink,
+    asynUser *pasynUser,int addr);
 static int vxiWriteAddressed(vxiPort * pvxiPort,asynUser *pasynUser,
     Device_Link lid,char *buffer,int length,double timeout);
 static int vxiWriteCmd(vxiPort * pvxiPort,asynUser *pasynUser,
     char *buffer, int length);
+static enum clnt_stat linkCall(vxiPort * pvxiPort,devLink *pdevLink,
+    u_long req,xdrproc_t proc1, caddr_t addr1,xdrproc_t proc2, caddr_t addr2,
+    struct timeval rpcTimeout);
 static enum clnt_stat clientCall(vxiPort * pvxiPort,
     u_long req,xdrproc_t proc1, caddr_t addr1,xdrproc_t proc2, caddr_t addr2);
-static enum clnt_stat clientIoCall(vxiPort * pvxiPort,asynUser *pasynUser,
+static enum clnt_stat clientIoCall(vxiPort * pvxiPort,devLink *pdevLink,
+    asynUser *pasynUser,
     u_long req,xdrproc_t proc1, caddr_t addr1,xdrproc_t proc2, caddr_t addr2);
 static asynStatus vxiBusStatus(vxiPort * pvxiPort, int request,
     double timeout,int *status);
@@ -255,7 +282,69 @@ static void vxiDisconnectException(vxiPort *pvxiPort,int addr)
     assert(status==asynSuccess);
 }
 
-static BOOL vxiCreateDeviceLink(vxiPort * pvxiPort,
+/*
+ * We could simplify this by calling clnt_create rather than clnttcp_create
+ * but clnt_create often makes use of the non-thread-safe gethostbyname()
+ * routine.
+ */
+static CLIENT *vxiCreateClient(vxiPort *pvxiPort,asynUser *pasynUser)
+{
+    struct sockaddr_in vxiServer;
+    int                sock = -1;
+    CLIENT             *rpcClient;
+
+    memset((void *)&vxiServer, 0, sizeof vxiServer);
+    vxiServer.sin_family = AF_INET;
+    vxiServer.sin_port = htons(0);
+    if (hostToIPAddr(pvxiPort->hostName, &vxiServer.sin_addr) < 0) {
+        asynPrint(pasynUser,ASYN_TRACE_ERROR,"%s can't get IP address of %s\n",
+                                    pvxiPort->portName, pvxiPort->hostName);
+        return 0;
+    }
+    rpcClient = clnttcp_create(&vxiServer, 
+                                DEVICE_CORE, DEVICE_CORE_VERSION, &sock, 0, 0);
+    if(!rpcClient) {
+        asynPrint(pasynUser,ASYN_TRACE_ERROR,"%s vxiCreateClient error %s\n",
+            pvxiPort->portName, clnt_spcreateerror(pvxiPort->hostName));
+    }
+    return rpcClient;
+}
+
+/* Returns the RPC client of pdevLink locked, or 0 if it has no client.
+ * A link without its own client uses the client of the port */
+static CLIENT *lockClient(vxiPort *pvxiPort,devLink *pdevLink)
+{
+    CLIENT *rpcClient;
+
+    if(pdevLink->lock) {
+        epicsMutexMustLock(pdevLink->lock);
+        rpcClient = pdevLink->rpcClient;
+        if(!rpcClient) epicsMutexUnlock(pdevLink->lock);
+    } else {
+        epicsMutexMustLock(pvxiPort->rpcLock);
+        rpcClient = pvxiPort->rpcClient;
+        if(!rpcClient) epicsMutexUnlock(pvxiPort->rpcLock);
+    }
+    return rpcClient;
+}
+
+static void unlockClient(vxiPort *pvxiPort,devLink *pdevLink)
+{
+    if(pdevLink->lock) {
+        epicsMutexUnlock(pdevLink->lock);
+    } else {
+        epicsMutexUnlock(pvxiPort->rpcLock);
+    }
+}
+
+static struct timeval linkRpcTimeout(vxiPort *pvxiPort,devLink *pdevLink)
+{
+    if(pdevLink->rpcTimeout.tv_sec || pdevLink->rpcTimeout.tv_usec)
+        return pdevLink->rpcTimeout;
+    return pvxiPort->vxiRpcTimeout;
+}
+
+static BOOL vxiCreateDeviceLink(vxiPort * pvxiPort,devLink *pdevLink,
     char *devName,Device_Link *pDevice_Link)
 {
     enum clnt_stat   clntStat;
@@ -263,29 +352,39 @@ static BOOL vxiCreateDeviceLink(vxiPort * pvxiPort,
     Create_LinkResp  crLinkR;
     BOOL             rtnVal = FALSE;
     asynUser         *pasynUser = pvxiPort->pasynUser;
+    CLIENT           *rpcClient;
 
-    crLinkP.clientId = (long) pvxiPort->rpcClient;
+    rpcClient = lockClient(pvxiPort,pdevLink);
+    if(!rpcClient) return FALSE;
+    crLinkP.clientId = (long) rpcClient;
     crLinkP.lockDevice = (pvxiPort->lockDevices != 0); 
     crLinkP.lock_timeout = 0;/* if device is locked, forget it */
     crLinkP.device = devName;
     /* initialize crLinkR */
     memset((char *) &crLinkR, 0, sizeof(Create_LinkResp));
     /* RPC call */
-    clntStat = clnt_call(pvxiPort->rpcClient, create_link,
+    clntStat = clnt_call(rpcClient, create_link,
         (xdrproc_t)xdr_Create_LinkParms,(caddr_t)&crLinkP,
         (xdrproc_t)xdr_Create_LinkResp, (caddr_t)&crLinkR,
-        pvxiPort->vxiRpcTimeout);
+        linkRpcTimeout(pvxiPort,pdevLink));
     if(clntStat != RPC_SUCCESS) {
         asynPrint(pasynUser,ASYN_TRACE_ERROR,
             "%s vxiCreateDeviceLink RPC error %s\n",
-            devName,clnt_sperror(pvxiPort->rpcClient,""));
-    } else if(crLinkR.error != VXI_OK) {
+            devName,clnt_sperror(rpcClient,""));
+        unlockClient(pvxiPort,pdevLink);
+        xdr_free((const xdrproc_t) xdr_Create_LinkResp, (char *) &crLinkR);
+        return FALSE;
+    }
+    unlockClient(pvxiPort,pdevLink);
+    if(crLinkR.error != VXI_OK) {
         asynPrint(pasynUser,ASYN_TRACE_ERROR,
             "%s vxiCreateDeviceLink error %s\n",
             devName,vxiError(crLinkR.error));
     } else {
         *pDevice_Link = crLinkR.lid;
         rtnVal = TRUE;
+        /* links with their own client are created concurrently */
+        epicsMutexMustLock(pvxiPort->rpcLock);
         if(pvxiPort->maxRecvSize==0) {
             pvxiPort->maxRecvSize = crLinkR.maxRecvSize;
         } else if(pvxiPort->maxRecvSize!=crLinkR.maxRecvSize) {
@@ -300,12 +399,14 @@ static BOOL vxiCreateDeviceLink(vxiPort * pvxiPort,
                 "%s vxiCreateDeviceLink abort channel TCP port changed from %u to %u\n",
                                 devName,pvxiPort->abortPort,crLinkR.abortPort);
         }
+        epicsMutexUnlock(pvxiPort->rpcLock);
     }
     xdr_free((const xdrproc_t) xdr_Create_LinkResp, (char *) &crLinkR);
     return rtnVal;
 }
 
-static BOOL vxiCreateDevLink(vxiPort * pvxiPort,int addr,Device_Link *plid)
+static BOOL vxiCreateDevLink(vxiPort * pvxiPort,devLink *pdevLink,
+    int addr,Device_Link *plid)
 {
     int         primary,secondary;
     char        devName[40];
@@ -322,7 +423,7 @@ static BOOL vxiCreateDevLink(vxiPort * pvxiPort,int addr,Device_Link *plid)
     } else {
         sprintf(devName, "%s,%d,%d", pvxiPort->vxiName, primary, secondary);
     }
-    return vxiCreateDeviceLink(pvxiPort,devName,plid);
+    return vxiCreateDeviceLink(pvxiPort,pdevLink,devName,plid);
 }
 
 static devLink *vxiGetDevLink(vxiPort *pvxiPort, asynUser *pasynUser,int addr)
@@ -361,22 +462,23 @@ static devLink *vxiGetDevLink(vxiPort *pvxiPort, asynUser *pasynUser,int addr)
     }
 }
 
-static BOOL vxiDestroyDevLink(vxiPort * pvxiPort, Device_Link devLink)
+static BOOL vxiDestroyDevLink(vxiPort * pvxiPort, devLink *pdevLink)
 {
     enum clnt_stat clntStat;
     Device_Error   devErr;
+    Device_Link    lid = pdevLink->lid;
     asynUser       *pasynUser = pvxiPort->pasynUser;
     int            status = TRUE;
 
-    clntStat = clnt_call(pvxiPort->rpcClient, destroy_link,
-        (xdrproc_t) xdr_Device_Link,(caddr_t) &devLink,
+    clntStat = linkCall(pvxiPort, pdevLink, destroy_link,
+        (xdrproc_t) xdr_Device_Link,(caddr_t) &lid,
         (xdrproc_t) xdr_Device_Error, (caddr_t) &devErr,
-        pvxiPort->vxiRpcTimeout);
+        linkRpcTimeout(pvxiPort,pdevLink));
     if(clntStat != RPC_SUCCESS) {
         status = FALSE;
         asynPrint(pasynUser,ASYN_TRACE_ERROR,
             "%s vxiDestroyDevLink RPC error %s\n",
-             pvxiPort->portName,clnt_sperror(pvxiPort->rpcClient,""));
+             pvxiPort->portName,clnt_sperrno(clntStat));
     } else if(devErr.error != VXI_OK) {
         status = FALSE;
         asynPrint(pasynUser,ASYN_TRACE_ERROR,
@@ -386,6 +488,78 @@ static BOOL vxiDestroyDevLink(vxiPort * pvxiPort, Device_Link devLink)
     xdr_free((const xdrproc_t) xdr_Device_Error, (char *) &devErr);
     return status;
 }
+
+/* Creates the link for addr. With FLAG_LINK_CLIENTS the link gets its own
+ * RPC client, so that I/O for different addresses can run concurrently
+ * when the port has more than one port thread (asynSetPortThreads). */
+static BOOL vxiOpenLink(vxiPort *pvxiPort,devLink *pdevLink,
+    asynUser *pasynUser,int addr)
+{
+    Device_Link lid;
+
+    if(pvxiPort->linkClients) {
+        if(!pdevLink->lock) pdevLink->lock = epicsMutexMustCreate();
+        epicsMutexMustLock(pdevLink->lock);
+        if(!pdevLink->rpcClient)
+            pdevLink->rpcClient = vxiCreateClient(pvxiPort,pasynUser);
+        epicsMutexUnlock(pdevLink->lock);
+        if(!pdevLink->rpcClient) return FALSE;
+    }
+    if(!vxiCreateDevLink(pvxiPort,pdevLink,addr,&lid)) return FALSE;
+    pdevLink->lid = lid;
+    pdevLink->connected = TRUE;
+    return TRUE;
+}
+
+/* Destroys the link and the RPC client of the link */
+static BOOL vxiCloseLink(vxiPort *pvxiPort,devLink *pdevLink)
+{
+    BOOL status = TRUE;
+
+    if(pdevLink->lock) {
+        epicsMutexMustLock(pdevLink->lock);
+        if(pdevLink->rpcClient) {
+            status = vxiDestroyDevLink(pvxiPort,pdevLink);
+            clnt_destroy(pdevLink->rpcClient);
+            pdevLink->rpcClient = 0;
+        }
+    } else {
+        status = vxiDestroyDevLink(pvxiPort,pdevLink);
+    }
+    pdevLink->lid = 0;
+    pdevLink->connected = FALSE;
+    if(pdevLink->lock) epicsMutexUnlock(pdevLink->lock);
+    return status;
+}
+
+/* An RPC call failed. A link with its own client is disconnected by itself,
+ * otherwise the whole port is disconnected */
+static void vxiLinkFailed(vxiPort *pvxiPort,devLink *pdevLink,
+    asynUser *pasynUser,int addr)
+{
+    BOOL wasConnected;
+
+    if(!pdevLink->lock) {
+        vxiDisconnectPort(pvxiPort);
+        return;
+    }
+    epicsMutexMustLock(pdevLink->lock);
+    if(pdevLink->rpcClient) {
+        clnt_destroy(pdevLink->rpcClient);
+        pdevLink->rpcClient = 0;
+    }
+    wasConnected = pdevLink->connected;
+    pdevLink->lid = 0;
+    pdevLink->connected = FALSE;
+    epicsMutexUnlock(pdevLink->lock);
+    /* vxiDisconnectPort may have closed the link already */
+    if(!wasConnected) return;
+    if(pasynUser) {
+        pasynManager->exceptionDisconnect(pasynUser);
+    } else {
+        vxiDisconnectException(pvxiPort,addr);
+    }
+}
 
 /*write with ATN true */
 static int vxiWriteAddressed(vxiPort *pvxiPort,asynUser *pasynUser,
@@ -416,7 +590,7 @@ static int vxiWriteAddressed(vxiPort *pvxiPort,asynUser *pasynUser,
         (const xdrproc_t) xdr_Device_DocmdResp,(void *) &devDocmdR);
     if(clntStat != RPC_SUCCESS) {
         printf("%s vxiWriteAddressed %s RPC error %s\n",
-            pvxiPort->portName,buffer,clnt_sperror(pvxiPort->rpcClient,""));
+            pvxiPort->portName,buffer,clnt_sperrno(clntStat));
         status = -1;
     } else if(devDocmdR.error != VXI_OK) {
         if(devDocmdR.error != VXI_IOTIMEOUT) {
@@ -503,7 +677,7 @@ static asynStatus vxiBusStatus(vxiPort * pvxiPort, int request,
             (const xdrproc_t) xdr_Device_DocmdResp, (void *) &devDocmdR);
         if(clntStat != RPC_SUCCESS) {
             printf("%s vxiBusStatus RPC error %s\n",
-                pvxiPort->portName, clnt_sperror(pvxiPort->rpcClient,""));
+                pvxiPort->portName, clnt_sperrno(clntStat));
             xdr_free((const xdrproc_t)xdr_Device_DocmdResp,(char *) &devDocmdR);
             return (clntStat==RPC_TIMEDOUT) ? asynTimeout : asynError;
         }
@@ -527,13 +701,26 @@ static asynStatus vxiBusStatus(vxiPort * pvxiPort, int request,
     return asynSuccess;
 }
 
+static enum clnt_stat linkCall(vxiPort * pvxiPort,devLink *pdevLink,
+    u_long req,xdrproc_t proc1, caddr_t addr1,xdrproc_t proc2, caddr_t addr2,
+    struct timeval rpcTimeout)
+{
+    enum clnt_stat stat;
+    CLIENT         *rpcClient = lockClient(pvxiPort,pdevLink);
+
+    if(!rpcClient) return RPC_CANTSEND;
+    stat = clnt_call(rpcClient, req, proc1, addr1, proc2, addr2, rpcTimeout);
+    unlockClient(pvxiPort,pdevLink);
+    return stat;
+}
+
 static enum clnt_stat clientCall(vxiPort * pvxiPort,
     u_long req,xdrproc_t proc1, caddr_t addr1,xdrproc_t proc2, caddr_t addr2)
 {
     enum clnt_stat stat;
     asynUser *pasynUser = pvxiPort->pasynUser;
 
-    stat = clnt_call(pvxiPort->rpcClient,
+    stat = linkCall(pvxiPort, &pvxiPort->server,
         req, proc1, addr1, proc2, addr2, pvxiPort->vxiRpcTimeout);
     if(stat!=RPC_SUCCESS) {
         asynPrint(pasynUser,ASYN_TRACE_ERROR,
@@ -544,7 +731,8 @@ static enum clnt_stat clientCall(vxiPort * pvxiPort,
     return stat;
 }
 
-static enum clnt_stat clientIoCall(vxiPort * pvxiPort,asynUser *pasynUser,
+static enum clnt_stat clientIoCall(vxiPort * pvxiPort,devLink *pdevLink,
+    asynUser *pasynUser,
     u_long req,xdrproc_t proc1, caddr_t addr1,xdrproc_t proc2, caddr_t addr2)
 {
     enum clnt_stat stat;
@@ -560,7 +748,7 @@ static enum clnt_stat clientIoCall(vxiPort * pvxiPort,asynUser *pasynUser,
         rpcTimeout.tv_sec = (unsigned long)(timeout+1.0);
     }
     while(TRUE) {
-        stat = clnt_call(pvxiPort->rpcClient,
+        stat = linkCall(pvxiPort, pdevLink,
             req, proc1, addr1, proc2, addr2, rpcTimeout);
         if(timeout>=0.0 || stat!=RPC_TIMEDOUT) break;
     }
@@ -568,7 +756,7 @@ static enum clnt_stat clientIoCall(vxiPort * pvxiPort,asynUser *pasynUser,
         asynPrint(pasynUser,ASYN_TRACE_ERROR,
             "%s vxi11 clientIoCall errno %s clnt_stat %d\n",
             pvxiPort->portName,strerror(errno),stat);
-        if(stat!=RPC_TIMEDOUT) vxiDisconnectPort(pvxiPort);
+        if(stat!=RPC_TIMEDOUT) vxiLinkFailed(pvxiPort,pdevLink,pasynUser,-1);
     }
     return stat;
 }
@@ -701,7 +889,7 @@ static void vxiCreateIrqChannel(vxiPort *pvxiPort,asynUser *pasynUser)
     if(clntStat != RPC_SUCCESS) {
         asynPrint(pasynUser,ASYN_TRACE_ERROR,
             "%s vxiCreateIrqChannel (create_intr_chan)%s\n",
-            pvxiPort->portName,clnt_sperror(pvxiPort->rpcClient,""));
+            pvxiPort->portName,clnt_sperrno(clntStat));
         xdr_free((const xdrproc_t) xdr_Device_Error, (char *) &devErr);
     } else if(devErr.error != VXI_OK) {
         asynPrint(pasynUser,ASYN_TRACE_ERROR,
@@ -850,9 +1038,7 @@ static asynStatus vxiConnectPort(vxiPort *pvxiPort,asynUser *pasynUser)
 {
     int         isController;
     Device_Link link;
-    int         sock = -1;
     asynStatus  status;
-    struct sockaddr_in vxiServer;
 
     /* Previously this pasynUser was created and connected to the port in vxi11Configure 
      * after calling pasynGpib->registerPort
@@ -882,30 +1068,12 @@ static asynStatus vxiConnectPort(vxiPort *pvxiPort,asynUser *pasynUser)
         }
         pvxiPort->rpcTaskInitCalled = TRUE;
     }
-
-    /*
-     * We could simplify this by calling clnt_create rather than clnttcp_create
-     * but clnt_create often makes use of the non-thread-safe gethostbyname()
-     * routine.
-     */
-    memset((void *)&vxiServer, 0, sizeof vxiServer);
-    vxiServer.sin_family = AF_INET;
-    vxiServer.sin_port = htons(0);
-    if (hostToIPAddr(pvxiPort->hostName, &vxiServer.sin_addr) < 0) {
-        asynPrint(pasynUser,ASYN_TRACE_ERROR,"%s can't get IP address of %s\n",
-                                    pvxiPort->portName, pvxiPort->hostName);
-        return asynError;
-    }
-    pvxiPort->rpcClient = clnttcp_create(&vxiServer, 
-                                DEVICE_CORE, DEVICE_CORE_VERSION, &sock, 0, 0);
-    if(!pvxiPort->rpcClient) {
-        asynPrint(pasynUser,ASYN_TRACE_ERROR,"%s vxiConnectPort error %s\n",
-            pvxiPort->portName, clnt_spcreateerror(pvxiPort->hostName));
-        return asynError;
-    }
+    pvxiPort->rpcClient = vxiCreateClient(pvxiPort,pasynUser);
+    if(!pvxiPort->rpcClient) return asynError;
     /* now establish a link to the gateway (for docmds etc.) */
     pvxiPort->abortPort = 0;
-    if(!vxiCreateDeviceLink(pvxiPort,pvxiPort->vxiName,&link)) return asynError;
+    if(!vxiCreateDeviceLink(pvxiPort,&pvxiPort->server,pvxiPort->vxiName,&link))
+        return asynError;
     pvxiPort->server.lid = link;
     pvxiPort->server.connected = TRUE;
     pvxiPort->ctrlAddr = -1;
@@ -967,7 +1135,10 @@ static asynStatus vxiDisconnectPort(vxiPort *pvxiPort)
     int          addr,secondary;
     asynUser     *pasynUser = pvxiPort->pasynUser;
 
+    /* With FLAG_LINK_CLIENTS this can be called by several port threads */
+    epicsMutexMustLock(pvxiPort->rpcLock);
     if(!pvxiPort->server.connected) {
+        epicsMutexUnlock(pvxiPort->rpcLock);
         asynPrint(pasynUser,ASYN_TRACE_ERROR,
             "%s vxiDisconnectPort but not connected\n",pvxiPort->portName);
         return asynError;
@@ -981,7 +1152,7 @@ static asynStatus vxiDisconnectPort(vxiPort *pvxiPort)
         pdevLink = &pvxiPort->primary[addr].primary;
         if(pdevLink->connected) {
             if(addr!=pvxiPort->ctrlAddr) {
-                vxiDestroyDevLink(pvxiPort, pdevLink->lid);
+                vxiCloseLink(pvxiPort, pdevLink);
                 vxiDisconnectException(pvxiPort,addr);
             }
             pdevLink->lid = 0;
@@ -990,25 +1161,44 @@ static asynStatus vxiDisconnectPort(vxiPort *pvxiPort)
         for(secondary = 0; secondary < NUM_GPIB_ADDRESSES; secondary++) {
             pdevLink = &pvxiPort->primary[addr].secondary[secondary];
             if(pdevLink->connected) {
-                vxiDestroyDevLink(pvxiPort, pdevLink->lid);
+                vxiCloseLink(pvxiPort, pdevLink);
                 vxiDisconnectException(pvxiPort,(addr*100 + secondary));
-                pdevLink->lid = 0;
-                pdevLink->connected = FALSE;
             }
         }
     }
     vxiDestroyIrqChannel(pvxiPort);
-    vxiDestroyDevLink(pvxiPort, pvxiPort->server.lid);
-    pvxiPort->server.connected = FALSE;
-    pvxiPort->server.lid = 0;
+    vxiCloseLink(pvxiPort, &pvxiPort->server);
     clnt_destroy(pvxiPort->rpcClient);
+    pvxiPort->rpcClient = 0;
+    epicsMutexUnlock(pvxiPort->rpcLock);
     pasynManager->exceptionDisconnect(pvxiPort->pasynUser);
     return asynSuccess;
 }
 
+static void vxiReportLink(FILE *fd,vxiPort *pvxiPort,devLink *pdevLink,int addr)
+{
+    struct timeval rpcTimeout;
+
+    if(!pdevLink->connected && !pdevLink->numberReads && !pdevLink->numberWrites)
+        return;
+    fprintf(fd,"    addr %d connected:%s reads %lu (%lu bytes) writes %lu (%lu bytes)"
+        " timeouts %lu errors %lu",
+        addr,((pdevLink->connected) ? "yes" : "no"),
+        pdevLink->numberReads,pdevLink->bytesRead,
+        pdevLink->numberWrites,pdevLink->bytesWritten,
+        pdevLink->numberTimeouts,pdevLink->numberErrors);
+    if(pdevLink->lock) {
+        rpcTimeout = linkRpcTimeout(pvxiPort,pdevLink);
+        fprintf(fd," rpcTimeout %.3f",
+            rpcTimeout.tv_sec + ((double)rpcTimeout.tv_usec)/1e6);
+    }
+    fprintf(fd,"\n");
+}
+
 static void vxiReport(void *drvPvt,FILE *fd,int details)
 {
     vxiPort *pvxiPort = (vxiPort *)drvPvt;
+    int     addr,secondary;
     assert(pvxiPort);
     fprintf(fd,"    vxi11, host name: %s\n", pvxiPort->hostName);
     if(details > 1) {
@@ -1018,9 +1208,20 @@ static void vxiReport(void *drvPvt,FILE *fd,int details)
         fprintf(fd,"    vxi name:%s", pvxiPort->vxiName);
         fprintf(fd," ctrlAddr:%d",pvxiPort->ctrlAddr);
         fprintf(fd," maxRecvSize:%lu", pvxiPort->maxRecvSize);
-        fprintf(fd," isSingleLink:%s isGpibLink:%s\n",
+        fprintf(fd," isSingleLink:%s isGpibLink:%s linkClients:%s\n",
             ((pvxiPort->isSingleLink) ? "yes" : "no"),
-            ((pvxiPort->isGpibLink) ? "yes" : "no"));
+            ((pvxiPort->isGpibLink) ? "yes" : "no"),
+            ((pvxiPort->linkClients) ? "yes" : "no"));
+        vxiReportLink(fd,pvxiPort,&pvxiPort->server,-1);
+        if(!pvxiPort->isSingleLink)
+        for(addr = 0; addr < NUM_GPIB_ADDRESSES; addr++) {
+            vxiReportLink(fd,pvxiPort,&pvxiPort->primary[addr].primary,addr);
+            for(secondary = 0; secondary < NUM_GPIB_ADDRESSES; secondary++) {
+                vxiReportLink(fd,pvxiPort,
+                    &pvxiPort->primary[addr].secondary[secondary],
+                    addr*100 + secondary);
+            }
+        }
     }
 }
 
@@ -1049,16 +1250,12 @@ static asynStatus vxiConnect(void *drvPvt,asynUser *pasynUser)
     }
     if(addr==-1) return vxiConnectPort(pvxiPort,pasynUser);
     if(!pdevLink->connected) {
-        Device_Link lid;
-
-        if(!vxiCreateDevLink(pvxiPort,addr,&lid)) {
+        if(!vxiOpenLink(pvxiPort,pdevLink,pasynUser,addr)) {
             asynPrint(pasynUser,ASYN_TRACE_ERROR,
                 "%s vxiCreateDevLink failed for addr %d\n",
                 pvxiPort->portName,addr);
             return asynError;
         }
-        pdevLink->lid = lid;
-        pdevLink->connected = TRUE;
     }
     pasynManager->exceptionConnect(pasynUser);
     return asynSuccess;
@@ -1084,13 +1281,11 @@ static asynStatus vxiDisconnect(void *drvPvt,asynUser *pasynUser)
         return asynError;
     }
     if(addr==-1) return vxiDisconnectPort(pvxiPort);
-    if(!vxiDestroyDevLink(pvxiPort,pdevLink->lid)) {
+    if(!vxiCloseLink(pvxiPort,pdevLink)) {
         epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
             "%s vxiDestroyDevLink failed for addr %d",pvxiPort->portName,addr);
         status = asynError;
     }
-    pdevLink->lid = 0;
-    pdevLink->connected = 0;
     pasynManager->exceptionDisconnect(pasynUser);
     return status;
 }
@@ -1137,7 +1332,7 @@ static asynStatus vxiRead(void *drvPvt,asynUser *pasynUser,
         memset((char *) &devReadR, 0, sizeof(Device_ReadResp));
         /* RPC call */
         while(TRUE) { /*Allow for very long or infinite timeout*/
-            clntStat = clientIoCall(pvxiPort, pasynUser, device_read,
+            clntStat = clientIoCall(pvxiPort, pdevLink, pasynUser, device_read,
                 (const xdrproc_t) xdr_Device_ReadParms,(void *) &devReadP,
                 (const xdrproc_t) xdr_Device_ReadResp,(void *) &devReadR);
             if(devReadP.io_timeout!=UINT_MAX
@@ -1169,6 +1364,10 @@ static asynStatus vxiRead(void *drvPvt,asynUser *pasynUser,
         }
         xdr_free((const xdrproc_t) xdr_Device_ReadResp, (char *) &devReadR);
     } while(!devReadR.reason && thisRead>0);
+    pdevLink->numberReads++;
+    pdevLink->bytesRead += nRead;
+    if(status==asynTimeout) pdevLink->numberTimeouts++;
+    else if(status!=asynSuccess) pdevLink->numberErrors++;
     if(eomReason) {
         *eomReason = 0;
         if(devReadR.reason & VXI_REQCNT) *eomReason |= ASYN_EOM_CNT;
@@ -1225,7 +1424,7 @@ static asynStatus vxiWrite(void *drvPvt,asynUser *pasynUser,
         /* initialize devWriteR */
         memset((char *) &devWriteR, 0, sizeof(Device_WriteResp));
         /* RPC call */
-        clntStat = clientIoCall(pvxiPort, pasynUser, device_write,
+        clntStat = clientIoCall(pvxiPort, pdevLink, pasynUser, device_write,
             (const xdrproc_t) xdr_Device_WriteParms,(void *) &devWriteP,
             (const xdrproc_t) xdr_Device_WriteResp,(void *) &devWriteR);
         if(clntStat != RPC_SUCCESS) {
@@ -1251,6 +1450,10 @@ static asynStatus vxiWrite(void *drvPvt,asynUser *pasynUser,
         }
         xdr_free((const xdrproc_t) xdr_Device_WriteResp, (char *) &devWriteR);
     } while(size==thisWrite && numchars>0);
+    pdevLink->numberWrites++;
+    pdevLink->bytesWritten += nWrite;
+    if(status==asynTimeout) pdevLink->numberTimeouts++;
+    else if(status!=asynSuccess) pdevLink->numberErrors++;
     *nbytesTransfered = nWrite;
     return status;
 }
@@ -1420,7 +1623,7 @@ static asynStatus vxiIfc(void *drvPvt, asynUser *pasynUser)
         (const xdrproc_t) xdr_Device_DocmdResp, (void *) &devDocmdR);
     if(clntStat != RPC_SUCCESS) {
         asynPrint(pasynUser,ASYN_TRACE_ERROR,"%s vxiIfc RPC error %s\n",
-            pvxiPort->portName,clnt_sperror(pvxiPort->rpcClient,""));
+            pvxiPort->portName,clnt_sperrno(clntStat));
         status = asynError;
     } else if(devDocmdR.error != VXI_OK) {
         asynPrint(pasynUser,ASYN_TRACE_ERROR,"%s vxiIfc %s\n",
@@ -1469,7 +1672,7 @@ static asynStatus vxiRen(void *drvPvt,asynUser *pasynUser, int onOff)
         (const xdrproc_t) xdr_Device_DocmdResp, (void *) &devDocmdR);
     if(clntStat != RPC_SUCCESS) {
         asynPrint(pasynUser,ASYN_TRACE_ERROR,"%s vxiRen RPC error %s\n",
-            pvxiPort->portName,clnt_sperror(pvxiPort->rpcClient,""));
+            pvxiPort->portName,clnt_sperrno(clntStat));
         status = asynError;
     } else if(devDocmdR.error != VXI_OK) {
         asynPrint(pasynUser,ASYN_TRACE_ERROR,"%s vxiRen %s\n", 
@@ -1537,7 +1740,7 @@ static asynStatus vxiSrqEnable(void *drvPvt, int onOff)
         (const xdrproc_t) xdr_Device_Error, (void *) &devErr);
     if(clntStat != RPC_SUCCESS) {
         printf("%s vxiSrqEnable RPC error %s\n",
-            pvxiPort->portName, clnt_sperror(pvxiPort->rpcClient,""));
+            pvxiPort->portName, clnt_sperrno(clntStat));
         status = asynError;
     } else if(devErr.error != VXI_OK) {
         printf("%s vxiSrqEnable %s\n",
@@ -1573,14 +1776,11 @@ static asynStatus vxiSerialPoll(void *drvPvt, int addr,
     pdevLink = vxiGetDevLink(pvxiPort,0,addr);
     if(!pdevLink) return asynError;
     if(!pdevLink->connected) {
-        Device_Link lid;
-        if(!vxiCreateDevLink(pvxiPort,addr,&lid)) {
+        if(!vxiOpenLink(pvxiPort,pdevLink,pvxiPort->pasynUser,addr)) {
             printf("%s vxiCreateDevLink failed for addr %d\n",
                 pvxiPort->portName,addr);
             return asynError;
         }
-        pdevLink->lid = lid;
-    	pdevLink->connected = TRUE;
     }
     devGenP.lid = pdevLink->lid;
     devGenP.flags = 0; /* no timeout on a locked gateway */
@@ -1588,12 +1788,14 @@ static asynStatus vxiSerialPoll(void *drvPvt, int addr,
     devGenP.lock_timeout = 0;
     /* initialize devGenR */
     memset((char *) &devGenR, 0, sizeof(Device_ReadStbResp));
-    clntStat = clientCall(pvxiPort, device_readstb,
+    clntStat = linkCall(pvxiPort, pdevLink, device_readstb,
         (const xdrproc_t) xdr_Device_GenericParms, (void *) &devGenP,
-        (const xdrproc_t) xdr_Device_ReadStbResp, (void *) &devGenR);
+        (const xdrproc_t) xdr_Device_ReadStbResp, (void *) &devGenR,
+        linkRpcTimeout(pvxiPort,pdevLink));
     if(clntStat != RPC_SUCCESS) {
         printf("%s vxiSerialPoll %d RPC error %s\n",
-            pvxiPort->portName, addr, clnt_sperror(pvxiPort->rpcClient,""));
+            pvxiPort->portName, addr, clnt_sperrno(clntStat));
+        if(clntStat!=RPC_TIMEDOUT) vxiLinkFailed(pvxiPort,pdevLink,0,addr);
         return asynError;
     } else if(devGenR.error != VXI_OK) {
         if(devGenR.error == VXI_IOTIMEOUT) {
@@ -1624,6 +1826,8 @@ static asynStatus vxiSetPortOption(void *drvPvt,
     double  timeout;
     int     seconds,microseconds;
     int     nitems;
+    int     addr;
+    struct timeval *prpcTimeout = &pvxiPort->vxiRpcTimeout;
 
     if(epicsStrCaseCmp(key, "rpctimeout") != 0) {
         epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
@@ -1636,10 +1840,21 @@ static asynStatus vxiSetPortOption(void *drvPvt,
             "Illegal value \"%s\"", val);
         return asynError;
     }
+    /* links with their own client can have their own rpcTimeout */
+    if(pvxiPort->linkClients
+    && pasynManager->getAddr(pasynUser,&addr)==asynSuccess && addr>=0) {
+        devLink *pdevLink = vxiGetDevLink(pvxiPort,pasynUser,addr);
+        if(!pdevLink) {
+            epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
+                "Illegal addr %d", addr);
+            return asynError;
+        }
+        prpcTimeout = &pdevLink->rpcTimeout;
+    }
     seconds = (int)timeout;
     microseconds = (int)(((timeout - (double)seconds))*1e6);
-    pvxiPort->vxiRpcTimeout.tv_sec = seconds;
-    pvxiPort->vxiRpcTimeout.tv_usec = microseconds;
+    prpcTimeout->tv_sec = seconds;
+    prpcTimeout->tv_usec = microseconds;
     return asynSuccess;
 }
 
@@ -1648,14 +1863,21 @@ static asynStatus vxiGetPortOption(void *drvPvt,
 {
     vxiPort *pvxiPort = (vxiPort *)drvPvt;
     double  timeout;
+    int     addr;
+    struct timeval rpcTimeout = pvxiPort->vxiRpcTimeout;
 
     if(epicsStrCaseCmp(key, "rpctimeout") != 0) {
         epicsSnprintf(pasynUser->errorMessage,pasynUser->errorMessageSize,
             "Unsupported key \"%s\"", key);
         return asynError;
     }
-    timeout = pvxiPort->vxiRpcTimeout.tv_sec;
-    timeout += ((double)pvxiPort->vxiRpcTimeout.tv_usec)/1e6;
+    if(pvxiPort->linkClients
+    && pasynManager->getAddr(pasynUser,&addr)==asynSuccess && addr>=0) {
+        devLink *pdevLink = vxiGetDevLink(pvxiPort,pasynUser,addr);
+        if(pdevLink) rpcTimeout = linkRpcTimeout(pvxiPort,pdevLink);
+    }
+    timeout = rpcTimeout.tv_sec;
+    timeout += ((double)rpcTimeout.tv_usec)/1e6;
     epicsSnprintf(val,valSize,"%f",timeout);
     return asynSuccess;
 }
@@ -1709,6 +1931,7 @@ int vxi11Configure(char *dn, char *hostName, int flags,
         defTimeout : (double)DEFAULT_RPC_TIMEOUT ;
     if(flags & FLAG_RECOVER_WITH_IFC) pvxiPort->recoverWithIFC = TRUE;
     if(flags & FLAG_LOCK_DEVICES) pvxiPort->lockDevices = TRUE;
+    pvxiPort->rpcLock = epicsMutexMustCreate();
     pvxiPort->inAddr = inAddr;
     pvxiPort->hostName = (char *)callocMustSucceed(1,strlen(hostName)+1,
         "vxi11Configure");
@@ -1717,6 +1940,8 @@ int vxi11Configure(char *dn, char *hostName, int flags,
     if(epicsStrnCaseCmp("inst", vxiName, 4) == 0) pvxiPort->isSingleLink = 1;
     if(epicsStrnCaseCmp("com", vxiName, 3) == 0) pvxiPort->isSingleLink = 1;
     strcpy(pvxiPort->hostName, hostName);
+    if((flags & FLAG_LINK_CLIENTS) && !pvxiPort->isSingleLink)
+        pvxiPort->linkClients = TRUE;
     attributes = ASYN_CANBLOCK;
     if(!pvxiPort->isSingleLink) attributes |= ASYN_MULTIDEVICE;
     pvxiPort->asynGpibPvt = pasynGpib->registerPort(pvxiPort->portName,
@@ -1748,7 +1973,7 @@ int vxi11Configure(char *dn, char *hostName, int flags,
 #include <iocsh.h>
 static const iocshArg vxi11ConfigureArg0 = { "portName",iocshArgString};
 static const iocshArg vxi11ConfigureArg1 = { "host name",iocshArgString};
-static const iocshArg vxi11ConfigureArg2 = { "flags (lock devices : recover with IFC)",iocshArgInt};
+static const iocshArg vxi11ConfigureArg2 = { "flags (link clients : lock devices : recover with IFC)",iocshArgInt};
 static const iocshArg vxi11ConfigureArg3 = { "default timeout",iocshArgString};
 static const iocshArg vxi11ConfigureArg4 = { "vxiName",iocshArgString};
 static const iocshArg vxi11ConfigureArg5 = { "priority",iocshArgInt};
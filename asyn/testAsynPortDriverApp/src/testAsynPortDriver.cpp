@@ -64,8 +64,10 @@ testAsynPortDriver::testAsynPortDriver(const char *portName, int maxPoints)
     /* Make sure maxPoints is positive */
     if (maxPoints < 1) maxPoints = 100;
     
-    /* Allocate the waveform array */
-    pData_ = (epicsFloat64 *)calloc(maxPoints, sizeof(epicsFloat64));
+    /* Allocate the waveform array. Each new waveform is published in a shared buffer,
+     * so records with info(SWAP_ARRAY,"1") do not copy it */
+    pDataBuffer_ = pasynArrayBuffer->create(maxPoints, sizeof(epicsFloat64));
+    pData_ = (epicsFloat64 *)pDataBuffer_->data;
 
     /* Allocate the time base array */
     pTimeBase_ = (epicsFloat64 *)calloc(maxPoints, sizeof(epicsFloat64));
@@ -149,6 +151,8 @@ void testAsynPortDriver::simTask(void)
     double time, timeStep;
     double noise, yScale;
     int run, i, maxPoints;
+    asynArrayBuffer *pbuffer;
+    epicsFloat64 *pValue;
     double pi=4.0*atan(1.0);
     
     lock();
@@ -178,16 +182,22 @@ void testAsynPortDriver::simTask(void)
         meanValue = 0.;
     
         yScale = 1.0 / voltsPerDiv;
+        /* The data of the previous buffer may still be used by records, so fill a new one */
+        pbuffer = pasynArrayBuffer->create(maxPoints, sizeof(epicsFloat64));
+        pValue = (epicsFloat64 *)pbuffer->data;
         for (i=0; i<maxPoints; i++) {
             noise = noiseAmplitude * (rand()/(double)RAND_MAX - 0.5);
-            pData_[i] = AMPLITUDE * (sin(time*FREQUENCY*2*pi)) + noise;
+            pValue[i] = AMPLITUDE * (sin(time*FREQUENCY*2*pi)) + noise;
             /* Compute statistics before doing the yOffset and yScale */
-            if (pData_[i] < minValue) minValue = pData_[i];
-            if (pData_[i] > maxValue) maxValue = pData_[i];
-            meanValue += pData_[i];
-            pData_[i] = NUM_DIVISIONS/2 + yScale * (voltOffset + pData_[i]);
+            if (pValue[i] < minValue) minValue = pValue[i];
+            if (pValue[i] > maxValue) maxValue = pValue[i];
+            meanValue += pValue[i];
+            pValue[i] = NUM_DIVISIONS/2 + yScale * (voltOffset + pValue[i]);
             time += timeStep;
         }
+        pasynArrayBuffer->release(pDataBuffer_);
+        pDataBuffer_ = pbuffer;
+        pData_ = pValue;
         updateTimeStamp();
         meanValue = meanValue/maxPoints;
         setDoubleParam(P_MinValue, minValue);
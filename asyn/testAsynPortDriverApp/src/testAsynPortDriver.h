@@ -13,6 +13,7 @@
  */
 
 #include "asynPortDriver.h"
+#include "asynArrayBuffer.h"
 
 #define NUM_VERT_SELECTIONS 4
 
@@ -83,7 +84,8 @@ protected:
 private:
     /* Our data */
     epicsEventId eventId_;
-    epicsFloat64 *pData_;
+    epicsFloat64 *pData_;           /* data of pDataBuffer_ */
+    asynArrayBuffer *pDataBuffer_;  /* shared buffer of the last waveform */
     epicsFloat64 *pTimeBase_;
     // Actual volts per division are these values divided by vertical gain
     char *voltsPerDivStrings_[NUM_VERT_SELECTIONS];
@@ -35,6 +35,8 @@
 #include <epicsAssert.h>
 #include <epicsTime.h>
 #include <epicsTimer.h>
+#include <epicsMutex.h>
+#include <epicsThread.h>
 extern "C" {
 #include <callback.h>
 }
@@ -106,6 +108,11 @@ initially. This calls intrCallbackOctet() every time input is received,
 but only if someone else is doing a read. Thus, if nobody reads
 something, arrange for periodical read polls.
 
+If the client has an input terminator, the interface does not register
+itself but attaches to the InputDemux of its port, address and
+terminator. The InputDemux registers intrCallbackDemux() once and passes
+each input line only to the interfaces which might match it.
+
 */
 
 extern "C" {
@@ -117,6 +124,10 @@ static void intrCallbackInt32(void* pvt, asynUser *pasynUser,
     epicsInt32 data);
 static void intrCallbackUInt32(void* pvt, asynUser *pasynUser,
     epicsUInt32 data);
+#ifndef EPICS_3_13
+static void intrCallbackDemux(void* pvt, asynUser *pasynUser,
+    char *data, size_t numchars, int eomReason);
+#endif
 }
 
 enum IoAction {
@@ -138,6 +149,11 @@ static const char* eomReasonStr[] = {
     "NONE", "CNT", "EOS", "CNT+EOS", "END", "CNT+END", "EOS+END", "CNT+EOS+END"
 };
 
+#ifndef EPICS_3_13
+class InputDemux;
+struct InputDemuxNode;
+#endif
+
 class AsynDriverInterface : StreamBusInterface
 #ifndef EPICS_3_13
  , epicsTimerNotify
@@ -175,6 +191,11 @@ class AsynDriverInterface : StreamBusInterface
 #else
     epicsTimerQueueActive* timerQueue;
     epicsTimer* timer;
+    // shared asynchronous input, see InputDemux
+    InputDemux* demux;
+    InputDemuxNode* demuxNode;
+    AsynDriverInterface* demuxNext;
+    AsynDriverInterface* demuxPrev;
 #endif
 
     AsynDriverInterface(Client* client);
@@ -244,6 +265,9 @@ class AsynDriverInterface : StreamBusInterface
         epicsInt32 data);
     friend void intrCallbackUInt32(void* pvt, asynUser *pasynUser,
         epicsUInt32 data);
+#ifndef EPICS_3_13
+    friend class InputDemux;
+#endif
 public:
     // static creator method
     static StreamBusInterface* getBusInterface(Client* client,
@@ -252,6 +276,61 @@ public:
 
 RegisterStreamBusInterface(AsynDriverInterface);
 
+#ifndef EPICS_3_13
+// Shared asynchronous input of all interfaces with the same
+// asyn port, address and input terminator.
+// Interfaces waiting for asynchronous input are sorted into a trie
+// by the literal prefix of their 'in' command. Each input line is
+// passed only to the interfaces on its path through the trie.
+// All other interfaces sit at the root and get every line.
+
+struct InputDemuxNode
+{
+    InputDemuxNode* child;          // first child
+    InputDemuxNode* sibling;        // next child of the same parent
+    AsynDriverInterface* clients;   // clients waiting for this prefix
+    char key;
+    InputDemuxNode(char key) :
+        child(NULL), sibling(NULL), clients(NULL), key(key) {}
+};
+
+class InputDemux
+{
+    static InputDemux* first;
+    static epicsMutex* listLock;
+    static epicsThreadOnceId onceId;
+    static void init(void*);
+
+    InputDemux* next;
+    StreamBuffer portname;
+    int addr;
+    StreamBuffer terminator;
+    asynUser* pasynUser;
+    asynOctet* pasynOctet;
+    void* pvtOctet;
+    void* intrPvtOctet;
+    epicsMutex lock;         // protects the trie and the line buffer
+    epicsMutex dispatchLock; // held while input is passed to clients
+    InputDemuxNode root;
+    StreamBuffer line;       // incomplete line
+    epicsTime lastInput;
+    double readTimeout;      // longest readTimeout of all clients
+
+    InputDemux(const char* portname, int addr,
+        const char* terminator, size_t terminatorlen);
+    bool connect();
+    void move(AsynDriverInterface* client, InputDemuxNode* node);
+    void dispatchLine(const char* data, long size, int eomReason);
+public:
+    static InputDemux* attach(AsynDriverInterface* client,
+        const char* terminator, size_t terminatorlen);
+    void detach(AsynDriverInterface* client);
+    void wait(AsynDriverInterface* client, double readTimeout);
+    void wake(AsynDriverInterface* client);
+    void dispatch(const char* data, size_t size, int eomReason);
+};
+#endif
+
 AsynDriverInterface::
 AsynDriverInterface(Client* client) : StreamBusInterface(client)
 {
@@ -279,6 +358,10 @@ AsynDriverInterface(Client* client) : StreamBusInterface(client)
     assert(timerQueue);
     timer = &timerQueue->createTimer();
     assert(timer);
+    demux = NULL;
+    demuxNode = NULL;
+    demuxNext = NULL;
+    demuxPrev = NULL;
 #endif
 }
 
@@ -303,6 +386,12 @@ AsynDriverInterface::
     {
         // octet stream interface is connected
         int wasQueued;
+#ifndef EPICS_3_13
+        if (demux)
+        {
+            demux->detach(this);
+        }
+#endif
         if (intrPvtOctet)
         {
             pasynOctet->cancelInterruptUser(pvtOctet,
@@ -354,6 +443,19 @@ bool AsynDriverInterface::
 supportsAsyncRead()
 {
     if (intrPvtOctet) return true;
+#ifndef EPICS_3_13
+    if (demux) return true;
+
+    // share "I/O Intr" input with other clients of the same device
+    const char* streameos;
+    size_t streameoslen;
+    streameos = getInTerminator(streameoslen);
+    if (streameos && streameoslen)
+    {
+        demux = InputDemux::attach(this, streameos, streameoslen);
+        if (demux) return true;
+    }
+#endif
 
     // hook "I/O Intr" support
     if (pasynOctet->registerInterruptUser(pvtOctet, pasynUser,
@@ -763,6 +865,9 @@ readRequest(unsigned long replyTimeout_ms, unsigned long readTimeout_ms,
         // First poll for input (no timeout),
         // later poll periodically if no other input arrives
         // from intrCallbackOctet()
+#ifndef EPICS_3_13
+        if (demux) demux->wait(this, readTimeout);
+#endif
     }
     else {
         ioAction = Read;
@@ -863,7 +968,9 @@ readHandler()
     {
         buffersize = inputBuffer.capacity();
     }
-    char* buffer = inputBuffer.clear().reserve(buffersize);
+    // read directly into the client's input buffer if possible
+    char* buffer = getInputBuffer(buffersize);
+    if (!buffer) buffer = inputBuffer.clear().reserve(buffersize);
 
     if (ioAction == AsyncRead)
     {
@@ -1067,6 +1174,9 @@ readHandler()
         {
             bytesToRead = inputBuffer.capacity();
         }
+        // the client has taken the input, read the next chunk after it
+        buffer = getInputBuffer(bytesToRead);
+        if (!buffer) buffer = inputBuffer.clear().reserve(bytesToRead);
         debug("AsynDriverInterface::readHandler(%s) "
             "readMore=%ld bytesToRead=%ld\n",
             clientName(), readMore, bytesToRead);
@@ -1203,6 +1313,279 @@ asynReadHandler(const char *buffer, size_t received, int eomReason)
         clientName(), readMore, ioActionStr[ioAction]);
 }
 
+#ifndef EPICS_3_13
+InputDemux* InputDemux::first = NULL;
+epicsMutex* InputDemux::listLock = NULL;
+epicsThreadOnceId InputDemux::onceId = EPICS_THREAD_ONCE_INIT;
+
+void InputDemux::
+init(void*)
+{
+    listLock = new epicsMutex;
+}
+
+InputDemux::
+InputDemux(const char* port, int address,
+    const char* term, size_t termlen) :
+    next(NULL), portname(port), addr(address), terminator(term, termlen),
+    pasynUser(NULL), pasynOctet(NULL), pvtOctet(NULL), intrPvtOctet(NULL),
+    root(0), lastInput(epicsTime::getCurrent()), readTimeout(0.0)
+{
+}
+
+// find or create the demux of the port, address and terminator
+// of the client and add the client to it
+InputDemux* InputDemux::
+attach(AsynDriverInterface* client,
+    const char* term, size_t termlen)
+{
+    const char* port;
+    int address;
+    InputDemux* demux;
+
+    if (pasynManager->getPortName(client->pasynUser, &port) != asynSuccess ||
+        pasynManager->getAddr(client->pasynUser, &address) != asynSuccess)
+    {
+        return NULL;
+    }
+    epicsThreadOnce(&onceId, init, NULL);
+    listLock->lock();
+    for (demux = first; demux; demux = demux->next)
+    {
+        if (demux->addr == address &&
+            strcmp(demux->portname(), port) == 0 &&
+            demux->terminator.length() == (long)termlen &&
+            demux->terminator.startswith(term, termlen))
+            break;
+    }
+    if (!demux)
+    {
+        demux = new InputDemux(port, address, term, termlen);
+        demux->pasynOctet = client->pasynOctet;
+        demux->pvtOctet = client->pvtOctet;
+        demux->pasynUser = pasynManager->createAsynUser(NULL, NULL);
+        demux->pasynUser->userPvt = demux;
+        if (pasynManager->connectDevice(demux->pasynUser,
+                port, address) != asynSuccess ||
+            demux->pasynOctet->registerInterruptUser(demux->pvtOctet,
+                demux->pasynUser, intrCallbackDemux, demux,
+                &demux->intrPvtOctet) != asynSuccess)
+        {
+            // fall back to a separate interrupt user for this client
+            debug("InputDemux::attach(%s): %s\n",
+                client->clientName(), demux->pasynUser->errorMessage);
+            pasynManager->disconnect(demux->pasynUser);
+            pasynManager->freeAsynUser(demux->pasynUser);
+            delete demux;
+            listLock->unlock();
+            return NULL;
+        }
+        debug("InputDemux::attach(%s): new demux for %s addr %d "
+            "terminator \"%s\"\n",
+            client->clientName(), port, address,
+            demux->terminator.expand()());
+        demux->next = first;
+        first = demux;
+    }
+    listLock->unlock();
+    demux->lock.lock();
+    demux->move(client, &demux->root);
+    demux->lock.unlock();
+    return demux;
+}
+
+void InputDemux::
+detach(AsynDriverInterface* client)
+{
+    lock.lock();
+    move(client, NULL);
+    lock.unlock();
+    // does not return while dispatch() might still use the client
+    dispatchLock.lock();
+    dispatchLock.unlock();
+}
+
+// the client waits for asynchronous input:
+// sort it into the trie by the prefix of its 'in' command
+void InputDemux::
+wait(AsynDriverInterface* client, double clientReadTimeout)
+{
+    const char* prefix;
+    size_t length, i;
+    InputDemuxNode* node;
+    InputDemuxNode* child;
+
+    prefix = client->getInPrefix(length);
+    lock.lock();
+    if (clientReadTimeout > readTimeout)
+        readTimeout = clientReadTimeout;
+    // Nodes are never removed. There are only as many
+    // as there are different prefixes in the protocols.
+    node = &root;
+    for (i = 0; i < length; i++)
+    {
+        for (child = node->child; child; child = child->sibling)
+        {
+            if (child->key == prefix[i]) break;
+        }
+        if (!child)
+        {
+            child = new InputDemuxNode(prefix[i]);
+            child->sibling = node->child;
+            node->child = child;
+        }
+        node = child;
+    }
+    move(client, node);
+    lock.unlock();
+}
+
+// the client does not wait any more: give it all input
+void InputDemux::
+wake(AsynDriverInterface* client)
+{
+    lock.lock();
+    move(client, &root);
+    lock.unlock();
+}
+
+// must be called with lock held
+void InputDemux::
+move(AsynDriverInterface* client, InputDemuxNode* node)
+{
+    if (client->demuxNode == node) return;
+    if (client->demuxNode)
+    {
+        if (client->demuxPrev)
+            client->demuxPrev->demuxNext = client->demuxNext;
+        else
+            client->demuxNode->clients = client->demuxNext;
+        if (client->demuxNext)
+            client->demuxNext->demuxPrev = client->demuxPrev;
+    }
+    client->demuxNode = node;
+    client->demuxPrev = NULL;
+    client->demuxNext = NULL;
+    if (!node) return;
+    client->demuxNext = node->clients;
+    if (node->clients)
+        node->clients->demuxPrev = client;
+    node->clients = client;
+}
+
+void InputDemux::
+dispatch(const char* data, size_t size, int eomReason)
+{
+    epicsTime now = epicsTime::getCurrent();
+    StreamBuffer input;
+    long start, end;
+
+    dispatchLock.lock();
+    lock.lock();
+    if (line && now - lastInput > readTimeout)
+    {
+        // the clients would have discarded it after readTimeout
+        debug("InputDemux::dispatch(%s) discard incomplete line \"%s\"\n",
+            portname(), line.expand()());
+        line.clear();
+    }
+    lastInput = now;
+    line.append(data, size);
+    if (eomReason & ASYN_EOM_EOS)
+    {
+        // terminator was cut off: restore it (see asynReadHandler())
+        char deveos[16];
+        int deveoslen;
+        if (pasynOctet->getInputEos(pvtOctet, pasynUser,
+            deveos, sizeof(deveos)-1, &deveoslen) == asynSuccess)
+        {
+            line.append(deveos, deveoslen);
+        }
+    }
+    // take all complete lines, keep the rest for the next call
+    start = 0;
+    while ((end = line.find(terminator, start)) >= 0)
+        start = end + terminator.length();
+    if (eomReason & ASYN_EOM_END)
+        start = line.length();
+    input.set(line(), start);
+    line.remove(start);
+    lock.unlock();
+
+    start = 0;
+    while (start < input.length())
+    {
+        end = input.find(terminator, start);
+        if (end >= 0)
+        {
+            end += terminator.length();
+            dispatchLine(input(start), end - start, 0);
+        }
+        else
+        {
+            // end of message without terminator
+            end = input.length();
+            dispatchLine(input(start), end - start, ASYN_EOM_END);
+        }
+        start = end;
+    }
+    dispatchLock.unlock();
+}
+
+void InputDemux::
+dispatchLine(const char* data, long size, int eomReason)
+{
+    StreamBuffer targets;
+    AsynDriverInterface* client;
+    InputDemuxNode* node;
+    long i, n;
+
+    lock.lock();
+    // collect all clients on the path of the line through the trie
+    node = &root;
+    i = 0;
+    while (node)
+    {
+        for (client = node->clients; client; client = client->demuxNext)
+            targets.append(&client, sizeof(client));
+        if (i >= size) break;
+        for (node = node->child; node; node = node->sibling)
+        {
+            if (node->key == data[i]) break;
+        }
+        i++;
+    }
+    // they get all input until they wait again
+    for (n = 0; n < targets.length(); n += sizeof(client))
+    {
+        memcpy(&client, targets(n), sizeof(client));
+        move(client, &root);
+    }
+    lock.unlock();
+#ifndef NO_TEMPORARY
+    debug("InputDemux::dispatchLine(%s, \"%s\") %ld clients\n",
+        portname(), StreamBuffer(data, size).expand()(),
+        targets.length() / (long)sizeof(client));
+#endif
+    // do not hold the lock here: clients call wait() from readCallback()
+    for (n = 0; n < targets.length(); n += sizeof(client))
+    {
+        memcpy(&client, targets(n), sizeof(client));
+        client->asynReadHandler(data, size, eomReason);
+    }
+}
+
+void intrCallbackDemux(void* /*pvt*/, asynUser *pasynUser,
+    char *data, size_t numchars, int eomReason)
+{
+    InputDemux* demux =
+        static_cast<InputDemux*>(pasynUser->userPvt);
+
+    if (!interruptAccept) return; // too early to process records
+    demux->dispatch(data, numchars, eomReason);
+}
+#endif
+
 // interface function: we want to receive an event
 bool AsynDriverInterface::
 acceptEvent(unsigned long mask, unsigned long replytimeout_ms)
@@ -1414,6 +1797,9 @@ finish()
         clientName());
     cancelTimer();
     ioAction = None;
+#ifndef EPICS_3_13
+    if (demux) demux->wake(this);
+#endif
 //     if (pasynGpib)
 //     {
 //         // Release GPIB device the the end of the protocol
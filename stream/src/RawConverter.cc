@@ -28,6 +28,10 @@ class RawConverter : public StreamFormatConverter
     int parse(const StreamFormat&, StreamBuffer&, const char*&, bool);
     bool printLong(const StreamFormat&, StreamBuffer&, long);
     int scanLong(const StreamFormat&, const char*, long&);
+    long printLongs(const StreamFormat&, StreamBuffer&,
+        const long*, long, const StreamBuffer&);
+    long scanLongs(const StreamFormat&, const char*, long,
+        long*, long, const StreamBuffer&, long&);
 };
 
 int RawConverter::
@@ -37,22 +41,27 @@ parse(const StreamFormat&, StreamBuffer&,
     return long_format;
 }
 
-bool RawConverter::
-printLong(const StreamFormat& format, StreamBuffer& output, long value)
+static int rawWidth(const StreamFormat& format, int& prec)
 {
-    int prec = format.prec;      // number of bytes from value
+    prec = format.prec;          // number of bytes from value
     if (prec == -1) prec = 1;    // default: 1 byte
     int width = prec;            // number of bytes in output
     if (prec > (int)sizeof(long)) prec=sizeof(long);
     if (format.width > width) width = format.width;
-    
+    return width;
+}
+
+// write exactly width bytes to output
+static void printRaw(const StreamFormat& format, char* output,
+    long value, int prec, int width)
+{
     char byte = 0;
     if (format.flags & alt_flag) // little endian (lsb first)
     {
         while (prec--)
         {
             byte = static_cast<char>(value);
-            output.append(byte);
+            *output++ = byte;
             value >>= 8;
             width--;
         }
@@ -68,7 +77,7 @@ printLong(const StreamFormat& format, StreamBuffer& output, long value)
         }
         while (width--)
         {
-            output.append(byte);
+            *output++ = byte;
         }
     }
     else // big endian (msb first)
@@ -85,17 +94,48 @@ printLong(const StreamFormat& format, StreamBuffer& output, long value)
         }
         while (width > prec)
         {
-            output.append(byte);
+            *output++ = byte;
             width--;
         }
         while (prec--)
         {
-            output.append(static_cast<char>(value >> (8 * prec)));
+            *output++ = static_cast<char>(value >> (8 * prec));
         }
     }
+}
+
+bool RawConverter::
+printLong(const StreamFormat& format, StreamBuffer& output, long value)
+{
+    int prec;
+    int width = rawWidth(format, prec);
+    printRaw(format, output.reserve(width), value, prec, width);
     return true;
 }
 
+long RawConverter::
+printLongs(const StreamFormat& format, StreamBuffer& output,
+    const long* values, long count, const StreamBuffer& separator)
+{
+    if (count <= 0) return 0;
+    int prec;
+    int width = rawWidth(format, prec);
+    long seplen = separator.length();
+    // fixed size output: reserve all at once
+    char* p = output.reserve(count*(width+seplen)-seplen);
+    for (long n = 0; n < count; n++)
+    {
+        if (n)
+        {
+            memcpy(p, separator(), seplen);
+            p += seplen;
+        }
+        printRaw(format, p, values[n], prec, width);
+        p += width;
+    }
+    return count;
+}
+
 int RawConverter::
 scanLong(const StreamFormat& format, const char* input, long& value)
 {
@@ -154,4 +194,28 @@ scanLong(const StreamFormat& format, const char* input, long& value)
     return length;
 }
 
+long RawConverter::
+scanLongs(const StreamFormat& format, const char* input, long length,
+    long* values, long maxcount, const StreamBuffer& separator,
+    long& consumed)
+{
+    long width = format.width;
+    if (width == 0) width = 1; // default: 1 byte
+    long n;
+    consumed = 0;
+    for (n = 0; n < maxcount; n++)
+    {
+        if (n)
+        {
+            if (!matchSeparator(separator, input+consumed, length-consumed))
+                break;
+            consumed += separator.length();
+        }
+        // fixed size input
+        if (width > length-consumed) break;
+        consumed += RawConverter::scanLong(format, input+consumed, values[n]);
+    }
+    return n;
+}
+
 RegisterConverter (RawConverter, "r");
@@ -30,6 +30,10 @@ class RawFloatConverter : public StreamFormatConverter
     int parse(const StreamFormat&, StreamBuffer&, const char*&, bool);
     bool printDouble(const StreamFormat&, StreamBuffer&, double);
     int scanDouble(const StreamFormat&, const char*, double&);
+    long printDoubles(const StreamFormat&, StreamBuffer&,
+        const double*, long, const StreamBuffer&);
+    long scanDoubles(const StreamFormat&, const char*, long,
+        double*, long, const StreamBuffer&, long&);
 };
 
 int RawFloatConverter::
@@ -54,10 +58,10 @@ parse(const StreamFormat& format, StreamBuffer&,
     return false;
 }
 
-bool RawFloatConverter::
-printDouble(const StreamFormat& format, StreamBuffer& output, double value)
+// write exactly nbOfBytes bytes to output
+static void printRawFloat(const StreamFormat& format, char* output,
+    double value, int nbOfBytes)
 {
-    int nbOfBytes;
     int n;
     union {
         double dval;
@@ -65,10 +69,6 @@ printDouble(const StreamFormat& format, StreamBuffer& output, double value)
         char   bytes[8];
     } buffer;
 
-    nbOfBytes = format.width;
-    if (nbOfBytes == 0)
-        nbOfBytes = 4;
-
     if (nbOfBytes == 4)
         buffer.fval = (float)value;
     else
@@ -79,17 +79,47 @@ printDouble(const StreamFormat& format, StreamBuffer& output, double value)
         // swap if byte orders differ
     	for (n = nbOfBytes-1; n >= 0; n--)
     	{
-            output.append(buffer.bytes[n]);
+            *output++ = buffer.bytes[n];
     	}
     } else {
-    	for (n = 0; n < nbOfBytes; n++)
-    	{
-            output.append(buffer.bytes[n]);
-    	}
+        memcpy(output, buffer.bytes, nbOfBytes);
     }
+}
+
+bool RawFloatConverter::
+printDouble(const StreamFormat& format, StreamBuffer& output, double value)
+{
+    int nbOfBytes = format.width;
+    if (nbOfBytes == 0)
+        nbOfBytes = 4;
+    printRawFloat(format, output.reserve(nbOfBytes), value, nbOfBytes);
     return true;
 }
 
+long RawFloatConverter::
+printDoubles(const StreamFormat& format, StreamBuffer& output,
+    const double* values, long count, const StreamBuffer& separator)
+{
+    if (count <= 0) return 0;
+    int nbOfBytes = format.width;
+    if (nbOfBytes == 0)
+        nbOfBytes = 4;
+    long seplen = separator.length();
+    // fixed size output: reserve all at once
+    char* p = output.reserve(count*(nbOfBytes+seplen)-seplen);
+    for (long n = 0; n < count; n++)
+    {
+        if (n)
+        {
+            memcpy(p, separator(), seplen);
+            p += seplen;
+        }
+        printRawFloat(format, p, values[n], nbOfBytes);
+        p += nbOfBytes;
+    }
+    return count;
+}
+
 int RawFloatConverter::
 scanDouble(const StreamFormat& format, const char* input, double& value)
 {
@@ -133,4 +163,30 @@ scanDouble(const StreamFormat& format, const char* input, double& value)
     return nbOfBytes;
 }
 
+long RawFloatConverter::
+scanDoubles(const StreamFormat& format, const char* input, long length,
+    double* values, long maxcount, const StreamBuffer& separator,
+    long& consumed)
+{
+    long nbOfBytes = format.width;
+    if (nbOfBytes == 0)
+        nbOfBytes = 4;
+    long n;
+    consumed = 0;
+    for (n = 0; n < maxcount; n++)
+    {
+        if (n)
+        {
+            if (!matchSeparator(separator, input+consumed, length-consumed))
+                break;
+            consumed += separator.length();
+        }
+        // fixed size input
+        if (nbOfBytes > length-consumed) break;
+        consumed += RawFloatConverter::scanDouble(format,
+            input+consumed, values[n]);
+    }
+    return n;
+}
+
 RegisterConverter (RawFloatConverter, "R");
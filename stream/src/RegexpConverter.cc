@@ -30,11 +30,23 @@
    This should not be too much of a problem unless streamReload is
    called really often before the IOC is restarted. It is not a
    run-time leak.
+ - The regexp is studied (and JIT compiled if PCRE supports it) in
+   parse, too. The study data is never freed either.
  - A maximum of 9 subexpressions is supported. Only one of them can
    be the result of the match.
+ - With the # flag, the regexp is anchored to the current input
+   position, i.e. the rest of the input is not searched for a match.
  - vxWorks and maybe other OS don't have a PCRE library. Provide one?
 */
 
+// stored in the info string
+struct RegexpInfo
+{
+    pcre* code;
+    pcre_extra* extra;
+    int ovecsize;
+};
+
 class RegexpConverter : public StreamFormatConverter
 {
     int parse (const StreamFormat&, StreamBuffer&, const char*&, bool);
@@ -55,9 +67,9 @@ parse(const StreamFormat& fmt, StreamBuffer& info,
         error("Subexpression index %d too big (>9)\n", fmt.prec);
         return false;
     }    
-    if (fmt.flags & (left_flag|space_flag|zero_flag|alt_flag))
+    if (fmt.flags & (left_flag|space_flag|zero_flag))
     {
-        error("Use of modifiers '-', ' ', '0', '#'"
+        error("Use of modifiers '-', ' ', '0' "
             "not allowed with %%/regexp/ conversion\n");
         return false;
     }
@@ -79,14 +91,37 @@ parse(const StreamFormat& fmt, StreamBuffer& info,
     debug("regexp = \"%s\"\n", pattern());
     const char* errormsg;
     int eoffset;
-    pcre* code = pcre_compile(pattern(), 0, 
+    RegexpInfo regexp;
+    regexp.code = pcre_compile(pattern(),
+        (fmt.flags & alt_flag) ? PCRE_ANCHORED : 0,
         &errormsg, &eoffset, NULL);
-    if (!code)
+    if (!regexp.code)
     {
         error("%s after \"%s\"\n", errormsg, pattern.expand(0, eoffset)());
         return false;
     }
-    info.append(&code, sizeof(code));
+    // Do all the expensive work now, not for each match
+#ifdef PCRE_STUDY_JIT_COMPILE
+    regexp.extra = pcre_study(regexp.code, PCRE_STUDY_JIT_COMPILE, &errormsg);
+#else
+    regexp.extra = pcre_study(regexp.code, 0, &errormsg);
+#endif
+    if (errormsg)
+    {
+        error("Studying regexp \"%s\" failed: %s\n", pattern(), errormsg);
+        return false;
+    }
+    // Only record the subexpressions we need. But with back references
+    // PCRE needs them all and would allocate memory for each match.
+    int count = 0;
+    int backref = 0;
+    pcre_fullinfo(regexp.code, regexp.extra, PCRE_INFO_CAPTURECOUNT, &count);
+    pcre_fullinfo(regexp.code, regexp.extra, PCRE_INFO_BACKREFMAX, &backref);
+    regexp.ovecsize = 3 * ((backref ? count : fmt.prec > 0 ? fmt.prec : 0) + 1);
+    if (regexp.ovecsize > 30) regexp.ovecsize = 30;
+    debug("regexp: %d subexpressions, ovecsize=%d, %s\n",
+        count, regexp.ovecsize, regexp.extra ? "studied" : "not studied");
+    info.append(&regexp, sizeof(regexp));
     return string_format;
 }
 
@@ -94,18 +129,25 @@ int RegexpConverter::
 scanString(const StreamFormat& fmt, const char* input,
     char* value, size_t maxlen)
 {
-    pcre* code;
+    RegexpInfo regexp;
     size_t len;
     int ovector[30];
     int rc;
     int subexpr = 0;
     
-    memcpy (&code, fmt.info, sizeof(code));
+    memcpy (&regexp, fmt.info, sizeof(regexp));
     
     len = fmt.width > 0 ? fmt.width : strlen(input);
     subexpr = fmt.prec > 0 ? fmt.prec : 0;
-    rc = pcre_exec(code, NULL, input, len, 0, 0, ovector, 30);
-    if (rc < 1) return -1;
+    rc = pcre_exec(regexp.code, regexp.extra, input, len, 0, 0,
+        ovector, regexp.ovecsize);
+    // rc == 0: match but ovector too small for all subexpressions
+    if (rc < 0) return -1;
+    if (rc > 0 && rc <= subexpr)
+    {
+        // requested subexpression did not match: empty
+        ovector[subexpr*2] = ovector[subexpr*2+1] = ovector[1];
+    }
     if (fmt.flags & skip_flag) return ovector[1];
     len = ovector[subexpr*2+1] - ovector[subexpr*2];
     if (len >= maxlen) {
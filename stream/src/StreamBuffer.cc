@@ -125,15 +125,48 @@ append(const void* s, long size)
         if (size < -len) size = -len;
         memset (buffer+offs+len+size, 0, -size);
     }
-    else
+    else if (s != buffer+offs+len || len+offs+size >= cap)
     {
         check(size);
         memcpy(buffer+offs+len, s, size);
     }
+    else
+    {
+        // data has already been written to space()
+        buffer[offs+len+size] = 0;
+    }
     len += size;
     return *this;
 }
 
+void StreamBuffer::
+swap(StreamBuffer& s)
+{
+    char tmp[sizeof(local)];
+    char* b = buffer;
+    long l = len, c = cap, o = offs;
+
+    if (b == local) memcpy(tmp, local, sizeof(local));
+    if (s.buffer == s.local)
+    {
+        memcpy(local, s.local, sizeof(local));
+        buffer = local;
+    }
+    else buffer = s.buffer;
+    len = s.len;
+    cap = s.cap;
+    offs = s.offs;
+    if (b == local)
+    {
+        memcpy(s.local, tmp, sizeof(local));
+        s.buffer = s.local;
+    }
+    else s.buffer = b;
+    s.len = l;
+    s.cap = c;
+    s.offs = o;
+}
+
 long int StreamBuffer::
 find(const void* m, long size, long start) const
 {
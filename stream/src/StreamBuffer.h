@@ -108,6 +108,12 @@ public:
     char* reserve(long size)
         {check(size); char* p=buffer+offs+len; len+=size; return p;}
 
+    // space: get pointer to at least size free bytes after the end
+    // without changing the length (for reading something into it)
+    // append(end(), n) then takes the first n bytes without copying
+    char* space(long size)
+        {check(size); return buffer+offs+len;}
+
     // append: append data at the end of the buffer
     StreamBuffer& append(char c)
         {check(1); buffer[offs+len++]=c; return *this;}
@@ -191,6 +197,9 @@ public:
     StreamBuffer& print(const char* fmt, ...)
         __attribute__ ((format(printf,2,3)));
 
+    // swap: exchange contents with s (copies at most the local buffers)
+    void swap(StreamBuffer& s);
+
     // find: get index of data in buffer or -1
     long find(char c, long start=0) const
         {char* p;
@@ -151,3 +151,16 @@ priority()
 {
     return 0;
 }
+
+const char* StreamBusInterface::Client::
+getInPrefix(size_t& length)
+{
+    length = 0;
+    return NULL;
+}
+
+char* StreamBusInterface::Client::
+getInputBuffer(long)
+{
+    return NULL;
+}
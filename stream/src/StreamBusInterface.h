@@ -47,6 +47,8 @@ public:
         virtual const char* name() = 0;
         virtual const char* getInTerminator(size_t& length) = 0;
         virtual const char* getOutTerminator(size_t& length) = 0;
+        virtual const char* getInPrefix(size_t& length);
+        virtual char* getInputBuffer(long size);
     public:
         virtual ~Client();
     protected:
@@ -140,6 +142,10 @@ protected:
         { return client->getInTerminator(length); }
     const char* getOutTerminator(size_t& length)
         { return client->getOutTerminator(length); }
+    const char* getInPrefix(size_t& length)
+        { return client->getInPrefix(length); }
+    char* getInputBuffer(long size)
+        { return client->getInputBuffer(size); }
     long priority() { return client->priority(); }
     const char* clientName() { return client->name(); }
 
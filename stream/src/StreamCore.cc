@@ -103,23 +103,111 @@ printProtocol()
     printf("  outTerminator = \"%s\";\n", buffer());
         StreamProtocolParser::printString(buffer.clear(), separator());
     printf("  separator     = \"%s\";\n", buffer());
-    if (onInit)
+    if (*onInit)
         printf("  @Init {\n%s  }\n",
-        printCommands(buffer.clear(), onInit()));
-    if (onReplyTimeout)
+        printCommands(buffer.clear(), onInit));
+    if (*onReplyTimeout)
         printf("  @ReplyTimeout {\n%s  }\n",
-        printCommands(buffer.clear(), onReplyTimeout()));
-    if (onReadTimeout)
+        printCommands(buffer.clear(), onReplyTimeout));
+    if (*onReadTimeout)
         printf("  @ReadTimeout {\n%s  }\n",
-        printCommands(buffer.clear(), onReadTimeout()));
-    if (onWriteTimeout)
+        printCommands(buffer.clear(), onReadTimeout));
+    if (*onWriteTimeout)
         printf("  @WriteTimeout {\n%s  }\n",
-        printCommands(buffer.clear(), onWriteTimeout()));
-    if (onMismatch)
+        printCommands(buffer.clear(), onWriteTimeout));
+    if (*onMismatch)
         printf("  @Mismatch {\n%s  }\n",
-        printCommands(buffer.clear(), onMismatch()));
+        printCommands(buffer.clear(), onMismatch));
     printf("\n%s}\n",
-        printCommands(buffer.clear(), commands()));
+        printCommands(buffer.clear(), commands));
+}
+
+///////////////////////////////////////////////////////////////////////////
+
+class StreamCore::CompiledProtocol
+{
+    static CompiledProtocol* first;
+    CompiledProtocol* next;
+    StreamBuffer key;
+    unsigned long generation;
+    int users;
+public:
+    unsigned long flags;
+    unsigned long lockTimeout;
+    unsigned long writeTimeout;
+    unsigned long replyTimeout;
+    unsigned long readTimeout;
+    unsigned long pollPeriod;
+    unsigned long maxInput;
+    bool inTerminatorDefined;
+    bool outTerminatorDefined;
+    StreamBuffer inTerminator;
+    StreamBuffer outTerminator;
+    StreamBuffer separator;
+    StreamBuffer commands;
+    StreamBuffer onInit;
+    StreamBuffer onWriteTimeout;
+    StreamBuffer onReplyTimeout;
+    StreamBuffer onReadTimeout;
+    StreamBuffer onMismatch;
+
+    CompiledProtocol(const StreamBuffer& key);
+    static CompiledProtocol* find(const StreamBuffer& key);
+    void share();
+    void release();
+};
+
+StreamCore::CompiledProtocol* StreamCore::CompiledProtocol::first = NULL;
+
+StreamCore::CompiledProtocol::
+CompiledProtocol(const StreamBuffer& _key) : key(_key)
+{
+    next = NULL;
+    generation = StreamProtocolParser::generation;
+    users = 1;
+}
+
+// Find code compiled from the same protocol file contents.
+// After StreamProtocolParser::free() the files may have changed
+// (streamReload), thus older generations are not reused.
+StreamCore::CompiledProtocol* StreamCore::CompiledProtocol::
+find(const StreamBuffer& key)
+{
+    CompiledProtocol* entry;
+    for (entry = first; entry; entry = entry->next)
+    {
+        if (entry->generation == StreamProtocolParser::generation &&
+            entry->key.length() == key.length() &&
+            entry->key.startswith(key(), key.length()))
+        {
+            entry->users++;
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+void StreamCore::CompiledProtocol::
+share()
+{
+    next = first;
+    first = this;
+}
+
+void StreamCore::CompiledProtocol::
+release()
+{
+    if (--users) return;
+    CompiledProtocol** pentry;
+    for (pentry = &first; *pentry; pentry = &(*pentry)->next)
+    {
+        if (*pentry == this)
+        {
+            *pentry = next;
+            break;
+        }
+    }
+    delete this;
 }
 
 ///////////////////////////////////////////////////////////////////////////
@@ -132,7 +220,11 @@ StreamCore()
     businterface = NULL;
     flags = None;
     next = NULL;
+    compiled = NULL;
+    commands = onInit = onWriteTimeout = onReplyTimeout =
+        onReadTimeout = onMismatch = "";
     unparsedInput = false;
+    searchedInput = 0;
     // add myself to list of streams
     StreamCore** pstream;
     for (pstream = &first; *pstream; pstream = &(*pstream)->next);
@@ -144,6 +236,7 @@ StreamCore::
 {
     debug("~StreamCore(%s) %p\n", name(), (void*)this);
     releaseBus();
+    if (compiled) compiled->release();
     // remove myself from list of all streams
     StreamCore** pstream;
     for (pstream = &first; *pstream; pstream = &(*pstream)->next)
@@ -209,6 +302,20 @@ parse(const char* filename, const char* _protocolname)
         }
         protocolname.truncate(-1); // remove ')'
     }
+    // Records using the same protocol with the same arguments
+    // share the compiled code (read-only).
+    // Compilation depends on event support of the bus, too.
+    StreamBuffer key(filename);
+    key.append('\0').append(protocolname).append('\0')
+        .append(busSupportsEvent() ? 'E' : '-');
+    CompiledProtocol* entry = CompiledProtocol::find(key);
+    if (entry)
+    {
+        debug("StreamCore::parse(%s): sharing compiled protocol '%s'\n",
+            name(), _protocolname);
+        useCompiled(entry);
+        return true;
+    }
     StreamProtocolParser::Protocol* protocol;
     protocol = StreamProtocolParser::getProtocol(filename, protocolname);
     if (!protocol)
@@ -216,31 +323,37 @@ parse(const char* filename, const char* _protocolname)
         error("while reading protocol '%s' for '%s'\n", protocolname(), name());
         return false;
     }
-    if (!compile(protocol))
+    entry = new CompiledProtocol(key);
+    if (!compile(protocol, entry))
     {
         delete protocol;
+        entry->release();
         error("while compiling protocol '%s' for '%s'\n", _protocolname, name());
         return false;
     }
+    // Field addresses like %(EGU)f are relative to the record,
+    // such code cannot be shared with other records.
+    if (!protocol->usesFieldAddresses()) entry->share();
     delete protocol;
+    useCompiled(entry);
     return true;
 }
 
 bool StreamCore::
-compile(StreamProtocolParser::Protocol* protocol)
+compile(StreamProtocolParser::Protocol* protocol, CompiledProtocol* code)
 {
     const char* extraInputNames [] = {"error", "ignore", NULL};
 
     // default values for protocol variables
-    flags &= ~IgnoreExtraInput;
-    lockTimeout = 5000;
-    readTimeout = 100;
-    replyTimeout = 1000;
-    writeTimeout = 100;
-    maxInput = 0;
-    pollPeriod = 1000;
-    inTerminatorDefined = false;
-    outTerminatorDefined = false;
+    code->flags = None;
+    code->lockTimeout = 5000;
+    code->readTimeout = 100;
+    code->replyTimeout = 1000;
+    code->writeTimeout = 100;
+    code->maxInput = 0;
+    code->pollPeriod = 1000;
+    code->inTerminatorDefined = false;
+    code->outTerminatorDefined = false;
     
     unsigned short ignoreExtraInput = false;
     if (!protocol->getEnumVariable("extrainput", ignoreExtraInput,
@@ -248,38 +361,64 @@ compile(StreamProtocolParser::Protocol* protocol)
     {
         return false;
     }
-    if (ignoreExtraInput) flags |= IgnoreExtraInput;
-    if (!(protocol->getNumberVariable("locktimeout", lockTimeout) &&
-        protocol->getNumberVariable("readtimeout", readTimeout) &&
-        protocol->getNumberVariable("replytimeout", replyTimeout) &&
-        protocol->getNumberVariable("writetimeout", writeTimeout) &&
-        protocol->getNumberVariable("maxinput", maxInput) &&
+    if (ignoreExtraInput) code->flags |= IgnoreExtraInput;
+    if (!(protocol->getNumberVariable("locktimeout", code->lockTimeout) &&
+        protocol->getNumberVariable("readtimeout", code->readTimeout) &&
+        protocol->getNumberVariable("replytimeout", code->replyTimeout) &&
+        protocol->getNumberVariable("writetimeout", code->writeTimeout) &&
+        protocol->getNumberVariable("maxinput", code->maxInput) &&
         // use replyTimeout as default for pollPeriod
-        protocol->getNumberVariable("replytimeout", pollPeriod) &&
-        protocol->getNumberVariable("pollperiod", pollPeriod)))
+        protocol->getNumberVariable("replytimeout", code->pollPeriod) &&
+        protocol->getNumberVariable("pollperiod", code->pollPeriod)))
     {
         return false;
     }
-    if (!(protocol->getStringVariable("terminator", inTerminator, &inTerminatorDefined) &&
-        protocol->getStringVariable("terminator", outTerminator, &outTerminatorDefined) &&
-        protocol->getStringVariable("interminator", inTerminator, &inTerminatorDefined) &&
-        protocol->getStringVariable("outterminator", outTerminator, &outTerminatorDefined) &&
-        protocol->getStringVariable("separator", separator)))
+    if (!(protocol->getStringVariable("terminator", code->inTerminator, &code->inTerminatorDefined) &&
+        protocol->getStringVariable("terminator", code->outTerminator, &code->outTerminatorDefined) &&
+        protocol->getStringVariable("interminator", code->inTerminator, &code->inTerminatorDefined) &&
+        protocol->getStringVariable("outterminator", code->outTerminator, &code->outTerminatorDefined) &&
+        protocol->getStringVariable("separator", code->separator)))
     {
         return false;
     }
-    if (!(protocol->getCommands(NULL, commands, this) &&
-        protocol->getCommands("@init", onInit, this) &&
-        protocol->getCommands("@writetimeout", onWriteTimeout, this) &&
-        protocol->getCommands("@replytimeout", onReplyTimeout, this) &&
-        protocol->getCommands("@readtimeout", onReadTimeout, this) &&
-        protocol->getCommands("@mismatch", onMismatch, this)))
+    if (!(protocol->getCommands(NULL, code->commands, this) &&
+        protocol->getCommands("@init", code->onInit, this) &&
+        protocol->getCommands("@writetimeout", code->onWriteTimeout, this) &&
+        protocol->getCommands("@replytimeout", code->onReplyTimeout, this) &&
+        protocol->getCommands("@readtimeout", code->onReadTimeout, this) &&
+        protocol->getCommands("@mismatch", code->onMismatch, this)))
     {
         return false;
     }
     return protocol->checkUnused();
 }
 
+void StreamCore::
+useCompiled(CompiledProtocol* code)
+{
+    // copy the settings, point to the shared code
+    if (compiled) compiled->release();
+    compiled = code;
+    flags = (flags & ~IgnoreExtraInput) | code->flags;
+    lockTimeout = code->lockTimeout;
+    readTimeout = code->readTimeout;
+    replyTimeout = code->replyTimeout;
+    writeTimeout = code->writeTimeout;
+    maxInput = code->maxInput;
+    pollPeriod = code->pollPeriod;
+    inTerminatorDefined = code->inTerminatorDefined;
+    outTerminatorDefined = code->outTerminatorDefined;
+    inTerminator = code->inTerminator;
+    outTerminator = code->outTerminator;
+    separator = code->separator;
+    commands = code->commands();
+    onInit = code->onInit();
+    onWriteTimeout = code->onWriteTimeout();
+    onReplyTimeout = code->onReplyTimeout();
+    onReadTimeout = code->onReadTimeout();
+    onMismatch = code->onMismatch();
+}
+
 bool StreamCore::
 compileCommand(StreamProtocolParser::Protocol* protocol,
     StreamBuffer& buffer, const char* command, const char*& args)
@@ -433,12 +572,12 @@ startProtocol(StartMode startMode)
         case StartNormal:
             break;
     }
-    if (!commands)
+    if (!*commands)
     {
         error ("%s: No protocol loaded\n", name());
         return false;
     }
-    commandIndex = (startMode == StartInit) ? onInit() : commands();
+    commandIndex = (startMode == StartInit) ? onInit : commands;
     runningHandler = Success;
     protocolStartHook();
     return evalCommand();
@@ -467,23 +606,23 @@ finishProtocol(ProtocolResult status)
         // save original error status
         runningHandler = status;
         // look for error handler
-        char* handler;
+        const char* handler;
         switch (status)
         {
             case Success:
                 handler = NULL;
                 break;
             case WriteTimeout:
-                handler = onWriteTimeout();
+                handler = onWriteTimeout;
                 break;
             case ReplyTimeout:
-                handler = onReplyTimeout();
+                handler = onReplyTimeout;
                 break;
             case ReadTimeout:
-                handler = onReadTimeout();
+                handler = onReadTimeout;
                 break;
             case ScanError:
-                handler = onMismatch();
+                handler = onMismatch;
                 /* reparse old input if first command in handler is 'in' */
                 if (*handler == in_cmd)
                 {
@@ -503,6 +642,7 @@ finishProtocol(ProtocolResult status)
                 // get rid of all the rubbish whe might have collected
                 unparsedInput = false;
                 inputBuffer.clear();
+                searchedInput = 0;
                 handler = NULL;
         }
         if (handler)
@@ -591,6 +731,7 @@ evalOut()
     // flush all unread input
     unparsedInput = false;
     inputBuffer.clear();
+    searchedInput = 0;
     if (!formatOutput())
     {
         finishProtocol(FormatError);
@@ -715,22 +856,16 @@ normal_format:
     return true;
 }
 
-void StreamCore::
-printSeparator()
+static void printedSeparator(const StreamBuffer& separator,
+    StreamBuffer& output)
 {
-    if (!(flags & Separator))
-    {
-        flags |= Separator;
-        return;
-    }
-    if (!separator) return;
     long i = 0;
     for (; i < separator.length(); i++)
     {
         switch (separator[i])
         {
             case StreamProtocolParser::whitespace:
-                outputLine.append(' '); // print single space
+                output.append(' '); // print single space
             case StreamProtocolParser::skip:
                 continue;
             case esc:
@@ -738,11 +873,23 @@ printSeparator()
                 i++;
             default:
                 // literal byte
-                outputLine.append(separator[i]);
+                output.append(separator[i]);
         }
     }
 }
 
+void StreamCore::
+printSeparator()
+{
+    if (!(flags & Separator))
+    {
+        flags |= Separator;
+        return;
+    }
+    if (!separator) return;
+    printedSeparator(separator, outputLine);
+}
+
 bool StreamCore::
 printValue(const StreamFormat& fmt, long value)
 {
@@ -810,6 +957,60 @@ printValue(const StreamFormat& fmt, char* value)
     return true;
 }
 
+// Arrays are printed in one pass by the converter.
+
+bool StreamCore::
+printValues(const StreamFormat& fmt, const long* values, long count)
+{
+    if (fmt.type != long_format && fmt.type != enum_format)
+    {
+        error("%s: printValues(long) called with %%%c format\n",
+            name(), fmt.conv);
+        return false;
+    }
+    if (count <= 0) return true;
+    printSeparator();
+    StreamBuffer sep;
+    printedSeparator(separator, sep);
+    long n = StreamFormatConverter::find(fmt.conv)->
+        printLongs(fmt, outputLine, values, count, sep);
+    if (n < count)
+    {
+        error("%s: Formatting value %li failed\n",
+            name(), values[n]);
+        return false;
+    }
+    debug("StreamCore::printValues(%s, long, count=%ld): \"%s\"\n",
+        name(), count, outputLine.expand()());
+    return true;
+}
+
+bool StreamCore::
+printValues(const StreamFormat& fmt, const double* values, long count)
+{
+    if (fmt.type != double_format)
+    {
+        error("%s: printValues(double) called with %%%c format\n",
+            name(), fmt.conv);
+        return false;
+    }
+    if (count <= 0) return true;
+    printSeparator();
+    StreamBuffer sep;
+    printedSeparator(separator, sep);
+    long n = StreamFormatConverter::find(fmt.conv)->
+        printDoubles(fmt, outputLine, values, count, sep);
+    if (n < count)
+    {
+        error("%s: Formatting value %#g failed\n",
+            name(), values[n]);
+        return false;
+    }
+    debug("StreamCore::printValues(%s, double, count=%ld): \"%s\"\n",
+        name(), count, outputLine.expand()());
+    return true;
+}
+
 void StreamCore::
 lockCallback(StreamIoStatus status)
 {
@@ -979,6 +1180,7 @@ readCallback(StreamIoStatus status,
             error("%s: No reply from device within %ld ms\n",
                 name(), replyTimeout);
             inputBuffer.clear();
+            searchedInput = 0;
             finishProtocol(ReplyTimeout);
             return 0;
         case StreamIoFault:
@@ -990,6 +1192,7 @@ readCallback(StreamIoStatus status,
             finishProtocol(Fault);
             return 0;
     }
+    // input read into getInputBuffer() is not copied
     inputBuffer.append(input, size);
     debug("StreamCore::readCallback(%s) inputBuffer=\"%s\", size %ld\n",
         name(), inputBuffer.expand()(), inputBuffer.length());
@@ -1011,24 +1214,11 @@ readCallback(StreamIoStatus status,
         // look for terminator
         // performance issue for long inputs that come in chunks:
         // do not parse old chunks again or performance decreases to O(n^2)
-        // but make sure to get all terminators in multi-line input
+        // but beware of split terminators
+        // ('searchedInput' is reset when a line is removed from inputBuffer)
 
-        long start;
-        if (unparsedInput)
-        {
-            // multi-line input sets 'unparsedInput' and removes the line
-            // remaining unparsed lines are left at start of inputBuffer
-            start = 0;
-        }
-        else
-        {
-            // long line does not set 'unparsedInput' but keeps
-            // already parsed chunks in inputBuffer
-            // start parsing at beginning of new data
-            // but beware of split terminators
-            start = inputBuffer.length() - size - inTerminator.length();
-            if (start < 0) start = 0;
-        }
+        long start = searchedInput - inTerminator.length() + 1;
+        if (start < 0) start = 0;
         end = inputBuffer.find(inTerminator, start);
         if (end >= 0)
         {
@@ -1036,6 +1226,7 @@ readCallback(StreamIoStatus status,
             debug("StreamCore::readCallback(%s) inTerminator %s at position %ld\n",
                 name(), inTerminator.expand()(), end);
         } else {
+            searchedInput = inputBuffer.length();
             debug("StreamCore::readCallback(%s) inTerminator %s not found\n",
                 name(), inTerminator.expand()());
         }
@@ -1088,6 +1279,7 @@ readCallback(StreamIoStatus status,
                 name());
             unparsedInput = false;
             inputBuffer.clear();
+            searchedInput = 0;
             commandIndex = commandStart;
             evalIn();
             return 0;
@@ -1100,11 +1292,24 @@ readCallback(StreamIoStatus status,
         }
     }
 
-    inputLine.set(inputBuffer(), end);
+    // match the line in place: if it is longer than the input after it,
+    // pass the whole buffer to inputLine and move only the rest back
+    long rest = inputBuffer.length() - end - termlen;
+    if (rest < end)
+    {
+        inputLine.swap(inputBuffer);
+        inputBuffer.clear().append(inputLine(end + termlen), rest);
+        inputLine.truncate(end);
+    }
+    else
+    {
+        inputLine.set(inputBuffer(), end);
+        inputBuffer.remove(end + termlen);
+    }
+    searchedInput = 0;
     debug("StreamCore::readCallback(%s) input line: \"%s\"\n",
         name(), inputLine.expand()());
     bool matches = matchInput();
-    inputBuffer.remove(end + termlen);
     if (inputBuffer)
     {
         debug("StreamCore::readCallback(%s) unpared input left: \"%s\"\n",
@@ -1534,6 +1739,106 @@ scanValue(const StreamFormat& fmt, char* value, long maxlen)
     return consumed;
 }
 
+// Arrays are scanned in one pass by the converter if the separator
+// consists of literal bytes only. Otherwise, or if a default value
+// is requested, scan value by value.
+// Unlike scanValue(), scanValues() consumes the input and returns
+// the number of values scanned.
+
+static bool literalSeparator(const StreamBuffer& separator,
+    StreamBuffer& literal)
+{
+    long i = 0;
+    for (; i < separator.length(); i++)
+    {
+        switch (separator[i])
+        {
+            case StreamProtocolParser::whitespace:
+            case StreamProtocolParser::skip:
+                return false;
+            case esc:
+                i++;
+            default:
+                literal.append(separator[i]);
+        }
+    }
+    return true;
+}
+
+long StreamCore::
+scanValues(const StreamFormat& fmt, long* values, long maxcount)
+{
+    long n, consumed;
+    StreamBuffer sep;
+    if (fmt.type != long_format && fmt.type != enum_format)
+    {
+        error("%s: scanValues(long*) called with %%%c format\n",
+            name(), fmt.conv);
+        return -1;
+    }
+    if ((fmt.flags & default_flag) || !literalSeparator(separator, sep))
+    {
+        for (n = 0; n < maxcount; n++)
+        {
+            consumed = scanValue(fmt, values[n]);
+            if (consumed < 0) break;
+            consumedInput += consumed;
+        }
+        return n;
+    }
+    flags |= ScanTried;
+    if (maxcount <= 0 || !matchSeparator()) return 0;
+    n = StreamFormatConverter::find(fmt.conv)->
+        scanLongs(fmt, inputLine(consumedInput),
+            inputLine.length()-consumedInput, values, maxcount, sep,
+            consumed);
+    debug("StreamCore::scanValues(%s, format=%%%c, long*) input=\"%s\"\n",
+        name(), fmt.conv, inputLine.expand(consumedInput, 20)());
+    consumedInput += consumed;
+    if (n == 0) return 0;
+    debug("StreamCore::scanValues(%s) scanned %ld values\n",
+        name(), n);
+    flags |= GotValue;
+    return n;
+}
+
+long StreamCore::
+scanValues(const StreamFormat& fmt, double* values, long maxcount)
+{
+    long n, consumed;
+    StreamBuffer sep;
+    if (fmt.type != double_format)
+    {
+        error("%s: scanValues(double*) called with %%%c format\n",
+            name(), fmt.conv);
+        return -1;
+    }
+    if ((fmt.flags & default_flag) || !literalSeparator(separator, sep))
+    {
+        for (n = 0; n < maxcount; n++)
+        {
+            consumed = scanValue(fmt, values[n]);
+            if (consumed < 0) break;
+            consumedInput += consumed;
+        }
+        return n;
+    }
+    flags |= ScanTried;
+    if (maxcount <= 0 || !matchSeparator()) return 0;
+    n = StreamFormatConverter::find(fmt.conv)->
+        scanDoubles(fmt, inputLine(consumedInput),
+            inputLine.length()-consumedInput, values, maxcount, sep,
+            consumed);
+    debug("StreamCore::scanValues(%s, format=%%%c, double*) input=\"%s\"\n",
+        name(), fmt.conv, inputLine.expand(consumedInput, 20)());
+    consumedInput += consumed;
+    if (n == 0) return 0;
+    debug("StreamCore::scanValues(%s) scanned %ld values\n",
+        name(), n);
+    flags |= GotValue;
+    return n;
+}
+
 const char* StreamCore::
 getInTerminator(size_t& length)
 {
@@ -1549,6 +1854,45 @@ getInTerminator(size_t& length)
     }
 }
 
+const char* StreamCore::
+getInPrefix(size_t& length)
+{
+    // Literal bytes every input line must start with to match
+    // the current 'in' command. Used by the bus interface to pass
+    // asynchronous input only to clients which might match.
+    inPrefix.clear();
+    if (*activeCommand == in_cmd && !maxInput && !inputBuffer)
+    {
+        // code layout: see matchInput()
+        const char* c = commandIndex;
+        char command;
+        while ((command = *c++) != StreamProtocolParser::eos)
+        {
+            if (command == esc)
+                command = *c++;
+            else if (command == StreamProtocolParser::format ||
+                command == StreamProtocolParser::format_field ||
+                command == StreamProtocolParser::skip ||
+                command == StreamProtocolParser::whitespace)
+                break;
+            inPrefix.append(command);
+        }
+    }
+    length = inPrefix.length();
+    return inPrefix();
+}
+
+char* StreamCore::
+getInputBuffer(long size)
+{
+    // Free memory after the unparsed input. The bus interface may
+    // read into it and pass it to readCallback() which then takes
+    // the input without copying. Only clear() may happen meanwhile,
+    // which does not move the end of the input.
+    MutexLock lock(this);
+    return inputBuffer.space(size);
+}
+
 // Handle 'event' command
 
 bool StreamCore::
@@ -119,6 +119,10 @@ protected:
 
     friend class MutexLock;
 
+    // Compiled code of one protocol, shared read-only by all
+    // records using the same file, protocol and arguments.
+    class CompiledProtocol;
+
     StreamCore* next;
     static StreamCore* first;
 
@@ -139,6 +143,14 @@ protected:
     long scanValue(const StreamFormat& format, double& value);
     long scanValue(const StreamFormat& format, char* value, long maxlen);
     long scanValue(const StreamFormat& format);
+    bool printValues(const StreamFormat& format,
+        const long* values, long count);
+    bool printValues(const StreamFormat& format,
+        const double* values, long count);
+    long scanValues(const StreamFormat& format,
+        long* values, long maxcount);
+    long scanValues(const StreamFormat& format,
+        double* values, long maxcount);
 
     StreamBuffer protocolname;
     unsigned long lockTimeout;
@@ -152,18 +164,21 @@ protected:
     StreamBuffer inTerminator;
     StreamBuffer outTerminator;
     StreamBuffer separator;
-    StreamBuffer commands;        // the normal protocol
-    StreamBuffer onInit;          // init protocol (optional)
-    StreamBuffer onWriteTimeout;  // error handler (optional)
-    StreamBuffer onReplyTimeout;  // error handler (optional)
-    StreamBuffer onReadTimeout;   // error handler (optional)
-    StreamBuffer onMismatch;      // error handler (optional)
+    CompiledProtocol* compiled;   // owner of the code below
+    const char* commands;         // the normal protocol
+    const char* onInit;           // init protocol (optional)
+    const char* onWriteTimeout;   // error handler (optional)
+    const char* onReplyTimeout;   // error handler (optional)
+    const char* onReadTimeout;    // error handler (optional)
+    const char* onMismatch;       // error handler (optional)
     const char* commandIndex;     // current position
     const char* activeCommand;    // start of current command
     StreamBuffer outputLine;
     StreamBuffer inputBuffer;
     StreamBuffer inputLine;
+    StreamBuffer inPrefix;
     long consumedInput;
+    long searchedInput;
     ProtocolResult runningHandler;
     StreamBuffer fieldAddress;
 
@@ -171,7 +186,8 @@ protected:
     bool unparsedInput;
 
     StreamCore(const StreamCore&); // undefined
-    bool compile(StreamProtocolParser::Protocol*);
+    bool compile(StreamProtocolParser::Protocol*, CompiledProtocol*);
+    void useCompiled(CompiledProtocol*);
     bool evalCommand();
     bool evalOut();
     bool evalIn();
@@ -202,6 +218,8 @@ protected:
     void disconnectCallback(StreamIoStatus status);
     const char* getInTerminator(size_t& length);
     const char* getOutTerminator(size_t& length);
+    const char* getInPrefix(size_t& length);
+    char* getInputBuffer(long size);
 
 // virtual methods
     virtual void protocolStartHook() {}
@@ -154,6 +154,10 @@ class Stream : protected StreamCore
         const char* busname, int addr, const char* busparam);
     bool print(format_t *format, va_list ap);
     bool scan(format_t *format, void* pvalue, size_t maxStringSize);
+    bool printArray(format_t *format, const void* array, int ftvl,
+        long nelem);
+    bool scanArray(format_t *format, void* array, int ftvl,
+        long maxelem, long& nord);
     bool process();
 
 // device support functions
@@ -165,6 +169,10 @@ class Stream : protected StreamCore
     friend long streamPrintf(dbCommon *record, format_t *format, ...);
     friend long streamScanfN(dbCommon *record, format_t *format,
         void*, size_t maxStringSize);
+    friend long streamPrintfArray(dbCommon *record, format_t *format,
+        const void* array, int ftvl, long nelem);
+    friend long streamScanfArray(dbCommon *record, format_t *format,
+        void* array, int ftvl, long maxelem, long* nord);
     friend long streamReload(char* recordname);
 
 public:
@@ -515,6 +523,33 @@ long streamScanfN(dbCommon* record, format_t *format,
     return OK;
 }
 
+long streamPrintfArray(dbCommon *record, format_t *format,
+    const void* array, int ftvl, long nelem)
+{
+    debug("streamPrintfArray(%s,format=%%%c,nelem=%ld)\n",
+        record->name, format->priv->conv, nelem);
+    Stream* pstream = (Stream*)record->dpvt;
+    if (!pstream) return ERROR;
+    return pstream->printArray(format, array, ftvl, nelem) ? OK : ERROR;
+}
+
+long streamScanfArray(dbCommon *record, format_t *format,
+    void* array, int ftvl, long maxelem, long* nord)
+{
+    debug("streamScanfArray(%s,format=%%%c,maxelem=%ld)\n",
+        record->name, format->priv->conv, maxelem);
+    *nord = 0;
+    Stream* pstream = (Stream*)record->dpvt;
+    if (!pstream) return ERROR;
+    if (!pstream->scanArray(format, array, ftvl, maxelem, *nord))
+    {
+        return ERROR;
+    }
+    debug("streamScanfArray(%s) success, nord=%ld\n",
+        record->name, *nord);
+    return OK;
+}
+
 // Stream methods ////////////////////////////////////////////////////////
 
 Stream::
@@ -648,7 +683,7 @@ initRecord(const char* filename, const char* protocol,
     debug("Stream::initRecord %s: initialize the first time\n",
         name());
 
-    if (!onInit) return DO_NOT_CONVERT; // no @init handler, keep DOL
+    if (!*onInit) return DO_NOT_CONVERT; // no @init handler, keep DOL
 
     // initialize the record from hardware
     if (!startProtocol(StartInit))
@@ -788,6 +823,182 @@ scan(format_t *format, void* value, size_t maxStringSize)
     return true;
 }
 
+// Arrays are converted from/to long or double in one pass
+// and then printed/scanned in one pass.
+
+template <class T, class V>
+static void loadArray(V* values, const void* array, long nelem)
+{
+    for (long i = 0; i < nelem; i++) values[i] = ((const T*)array)[i];
+}
+
+template <class T, class V>
+static void storeArray(void* array, const V* values, long nelem)
+{
+    for (long i = 0; i < nelem; i++) ((T*)array)[i] = (T)values[i];
+}
+
+bool Stream::
+printArray(format_t *format, const void* array, int ftvl, long nelem)
+{
+    // called by streamPrintfArray
+    long* lptr;
+    double* dptr;
+    switch (format->type)
+    {
+        case DBF_ENUM:
+        case DBF_LONG:
+            lptr = (long*)fieldBuffer.clear().reserve(nelem*sizeof(long));
+            switch (ftvl)
+            {
+                case DBF_LONG:
+                    loadArray<epicsInt32>(lptr, array, nelem);
+                    break;
+                case DBF_ULONG:
+                    loadArray<epicsUInt32>(lptr, array, nelem);
+                    break;
+                case DBF_SHORT:
+                    loadArray<epicsInt16>(lptr, array, nelem);
+                    break;
+                case DBF_USHORT:
+                case DBF_ENUM:
+                    loadArray<epicsUInt16>(lptr, array, nelem);
+                    break;
+                case DBF_CHAR:
+                    loadArray<epicsInt8>(lptr, array, nelem);
+                    break;
+                case DBF_UCHAR:
+                    loadArray<epicsUInt8>(lptr, array, nelem);
+                    break;
+                default:
+                    error("%s: can't convert from %s to long\n",
+                        name(), pamapdbfType[ftvl].strvalue);
+                    return false;
+            }
+            return printValues(*format->priv, lptr, nelem);
+        case DBF_DOUBLE:
+            if (ftvl == DBF_DOUBLE)
+            {
+                // no conversion needed
+                return printValues(*format->priv,
+                    (const epicsFloat64*)array, nelem);
+            }
+            dptr = (double*)fieldBuffer.clear().reserve(nelem*sizeof(double));
+            switch (ftvl)
+            {
+                case DBF_FLOAT:
+                    loadArray<epicsFloat32>(dptr, array, nelem);
+                    break;
+                case DBF_LONG:
+                    loadArray<epicsInt32>(dptr, array, nelem);
+                    break;
+                case DBF_ULONG:
+                    loadArray<epicsUInt32>(dptr, array, nelem);
+                    break;
+                case DBF_SHORT:
+                    loadArray<epicsInt16>(dptr, array, nelem);
+                    break;
+                case DBF_USHORT:
+                case DBF_ENUM:
+                    loadArray<epicsUInt16>(dptr, array, nelem);
+                    break;
+                case DBF_CHAR:
+                    loadArray<epicsInt8>(dptr, array, nelem);
+                    break;
+                case DBF_UCHAR:
+                    loadArray<epicsUInt8>(dptr, array, nelem);
+                    break;
+                default:
+                    error("%s: can't convert from %s to double\n",
+                        name(), pamapdbfType[ftvl].strvalue);
+                    return false;
+            }
+            return printValues(*format->priv, dptr, nelem);
+    }
+    error("INTERNAL ERROR (%s): Illegal format type\n", name());
+    return false;
+}
+
+bool Stream::
+scanArray(format_t *format, void* array, int ftvl, long maxelem, long& nord)
+{
+    // called by streamScanfArray
+    long* lptr;
+    double* dptr;
+
+    // first remove old value from inputLine
+    consumedInput += currentValueLength;
+    currentValueLength = 0;
+    switch (format->type)
+    {
+        case DBF_LONG:
+        case DBF_ENUM:
+            lptr = (long*)fieldBuffer.clear().reserve(maxelem*sizeof(long));
+            nord = scanValues(*format->priv, lptr, maxelem);
+            if (nord <= 0)
+            {
+                nord = 0;
+                return false;
+            }
+            switch (ftvl)
+            {
+                case DBF_DOUBLE:
+                    storeArray<epicsFloat64>(array, lptr, nord);
+                    return true;
+                case DBF_FLOAT:
+                    storeArray<epicsFloat32>(array, lptr, nord);
+                    return true;
+                case DBF_LONG:
+                case DBF_ULONG:
+                    storeArray<epicsInt32>(array, lptr, nord);
+                    return true;
+                case DBF_SHORT:
+                case DBF_USHORT:
+                case DBF_ENUM:
+                    storeArray<epicsInt16>(array, lptr, nord);
+                    return true;
+                case DBF_CHAR:
+                case DBF_UCHAR:
+                    storeArray<epicsInt8>(array, lptr, nord);
+                    return true;
+            }
+            error("%s: can't convert from long to %s\n",
+                name(), pamapdbfType[ftvl].strvalue);
+            nord = 0;
+            return false;
+        case DBF_DOUBLE:
+            if (ftvl == DBF_DOUBLE)
+            {
+                // no conversion needed
+                nord = scanValues(*format->priv,
+                    (epicsFloat64*)array, maxelem);
+                if (nord <= 0)
+                {
+                    nord = 0;
+                    return false;
+                }
+                return true;
+            }
+            if (ftvl != DBF_FLOAT)
+            {
+                error("%s: can't convert from double to %s\n",
+                    name(), pamapdbfType[ftvl].strvalue);
+                return false;
+            }
+            dptr = (double*)fieldBuffer.clear().reserve(maxelem*sizeof(double));
+            nord = scanValues(*format->priv, dptr, maxelem);
+            if (nord <= 0)
+            {
+                nord = 0;
+                return false;
+            }
+            storeArray<epicsFloat32>(array, dptr, nord);
+            return true;
+    }
+    error("INTERNAL ERROR (%s): Illegal format type\n", name());
+    return false;
+}
+
 // epicsTimerNotify virtual method ///////////////////////////////////////
 
 #ifdef EPICS_3_13
@@ -1011,25 +1222,28 @@ formatValue(const StreamFormat& format, const void* fieldaddress)
                 pamapdbfType[dbfMapping[format.type]].strvalue);
             return false;
         }
+        StreamBuffer values;
+        long* lptr;
+        switch (format.type)
+        {
+            // numeric values in one pass
+            case enum_format:
+                lptr = (long*)values.reserve(nelem*sizeof(long));
+                loadArray<epicsUInt16>(lptr, buffer, nelem);
+                return printValues(format, lptr, nelem);
+            case long_format:
+                lptr = (long*)values.reserve(nelem*sizeof(long));
+                loadArray<epicsInt32>(lptr, buffer, nelem);
+                return printValues(format, lptr, nelem);
+            case double_format:
+                return printValues(format, (epicsFloat64*)buffer, nelem);
+            default:
+                break;
+        }
         for (i = 0; i < nelem; i++)
         {
             switch (format.type)
             {
-                case enum_format:
-                    if (!printValue(format,
-                        (long)((epicsUInt16*)buffer)[i]))
-                        return false;
-                    break;
-                case long_format:
-                    if (!printValue(format,
-                        (long)((epicsInt32*)buffer)[i]))
-                        return false;
-                    break;
-                case double_format:
-                    if (!printValue(format,
-                        (double)((epicsFloat64*)buffer)[i]))
-                        return false;
-                    break;
                 case string_format:
                     if (!printValue(format, buffer+MAX_STRING_SIZE*i))
                         return false;
@@ -1084,62 +1298,57 @@ matchValue(const StreamFormat& format, const void* fieldaddress)
         long nelem = pdbaddr->no_elements;
         size_t size = nelem * typeSize[format.type];
         buffer = fieldBuffer.clear().reserve(size);
-        for (nord = 0; nord < nelem; nord++)
+        StreamBuffer values;
+        long* lptr;
+        switch (format.type)
         {
-            debug("Stream::matchValue(%s): buffer before: %s\n",
-                name(), fieldBuffer.expand()());
-            switch (format.type)
-            {
-                case long_format:
-                {
-                    consumed = scanValue(format, lval);
-                    if (consumed >= 0) ((epicsInt32*)buffer)[nord] = lval;
-                    debug("Stream::matchValue(%s): %s[%li] = %li\n",
-                            name(), pdbaddr->precord->name, nord, lval);
-                    break;
-                }
-                case enum_format:
-                {
-                    consumed = scanValue(format, lval);
-                    if (consumed >= 0)
-                        ((epicsUInt16*)buffer)[nord] = (epicsUInt16)lval;
-                    debug("Stream::matchValue(%s): %s[%li] = %li\n",
-                            name(), pdbaddr->precord->name, nord, lval);
-                    break;
-                }
-                case double_format:
+            // numeric values in one pass
+            case long_format:
+            case enum_format:
+                lptr = (long*)values.reserve(nelem*sizeof(long));
+                nord = scanValues(format, lptr, nelem);
+                if (nord < 0) nord = 0;
+                if (nord) lval = lptr[nord-1];
+                if (format.type == long_format)
+                    storeArray<epicsInt32>(buffer, lptr, nord);
+                else
+                    storeArray<epicsUInt16>(buffer, lptr, nord);
+                debug("Stream::matchValue(%s): %s got %li values\n",
+                        name(), pdbaddr->precord->name, nord);
+                break;
+            case double_format:
+                nord = scanValues(format, (epicsFloat64*)buffer, nelem);
+                if (nord < 0) nord = 0;
+                if (nord) dval = ((epicsFloat64*)buffer)[nord-1];
+                debug("Stream::matchValue(%s): %s got %li values\n",
+                        name(), pdbaddr->precord->name, nord);
+                break;
+            default:
+                for (nord = 0; nord < nelem; nord++)
                 {
-                    consumed = scanValue(format, dval);
-                    // Direct assignment to buffer fails with
-                    // gcc 3.4.3 for xscale_be
-                    // Optimization bug?
-                    epicsFloat64 f64=dval;
-                    if (consumed >= 0)
-                        memcpy(((epicsFloat64*)buffer)+nord,
-                            &f64, sizeof(f64));
-                    debug("Stream::matchValue(%s): %s[%li] = %#g %#g\n",
-                            name(), pdbaddr->precord->name, nord, dval,
-                            ((epicsFloat64*)buffer)[nord]);
-                    break;
+                    debug("Stream::matchValue(%s): buffer before: %s\n",
+                        name(), fieldBuffer.expand()());
+                    switch (format.type)
+                    {
+                        case string_format:
+                        {
+                            consumed = scanValue(format,
+                                buffer+MAX_STRING_SIZE*nord, MAX_STRING_SIZE);
+                            debug("Stream::matchValue(%s): %s[%li] = \"%.*s\"\n",
+                                    name(), pdbaddr->precord->name, nord,
+                                    MAX_STRING_SIZE, buffer+MAX_STRING_SIZE*nord);
+                            break;
+                        }
+                        default:
+                            error("INTERNAL ERROR: Stream::matchValue %s: "
+                                "Illegal format type\n", name());
+                            return false;
+                    }
+                    debug("Stream::matchValue(%s): buffer after: %s\n",
+                        name(), fieldBuffer.expand()());
+                    if (consumed < 0) break;
+                    consumedInput += consumed;
                 }
-                case string_format:
-                {
-                    consumed = scanValue(format,
-                        buffer+MAX_STRING_SIZE*nord, MAX_STRING_SIZE);
-                    debug("Stream::matchValue(%s): %s[%li] = \"%.*s\"\n",
-                            name(), pdbaddr->precord->name, nord,
-                            MAX_STRING_SIZE, buffer+MAX_STRING_SIZE*nord);
-                    break;
-                }
-                default:
-                    error("INTERNAL ERROR: Stream::matchValue %s: "
-                        "Illegal format type\n", name());
-                    return false;
-            }
-            debug("Stream::matchValue(%s): buffer after: %s\n",
-                name(), fieldBuffer.expand()());
-            if (consumed < 0) break;
-            consumedInput += consumed;
         }
         if (!nord)
         {
@@ -227,6 +227,78 @@ scanPseudo(const StreamFormat& fmt, StreamBuffer&, long&)
     return -1;
 }
 
+// Array methods: defaults call the single value methods
+
+long StreamFormatConverter::
+printLongs(const StreamFormat& fmt, StreamBuffer& output,
+    const long* values, long count, const StreamBuffer& separator)
+{
+    long n;
+    for (n = 0; n < count; n++)
+    {
+        if (n) output.append(separator);
+        if (!printLong(fmt, output, values[n])) break;
+    }
+    return n;
+}
+
+long StreamFormatConverter::
+printDoubles(const StreamFormat& fmt, StreamBuffer& output,
+    const double* values, long count, const StreamBuffer& separator)
+{
+    long n;
+    for (n = 0; n < count; n++)
+    {
+        if (n) output.append(separator);
+        if (!printDouble(fmt, output, values[n])) break;
+    }
+    return n;
+}
+
+long StreamFormatConverter::
+scanLongs(const StreamFormat& fmt, const char* input, long length,
+    long* values, long maxcount, const StreamBuffer& separator,
+    long& consumed)
+{
+    long n, l;
+    consumed = 0;
+    for (n = 0; n < maxcount; n++)
+    {
+        if (n)
+        {
+            if (!matchSeparator(separator, input+consumed, length-consumed))
+                break;
+            consumed += separator.length();
+        }
+        l = scanLong(fmt, input+consumed, values[n]);
+        if (l < 0 || l > length-consumed) break;
+        consumed += l;
+    }
+    return n;
+}
+
+long StreamFormatConverter::
+scanDoubles(const StreamFormat& fmt, const char* input, long length,
+    double* values, long maxcount, const StreamBuffer& separator,
+    long& consumed)
+{
+    long n, l;
+    consumed = 0;
+    for (n = 0; n < maxcount; n++)
+    {
+        if (n)
+        {
+            if (!matchSeparator(separator, input+consumed, length-consumed))
+                break;
+            consumed += separator.length();
+        }
+        l = scanDouble(fmt, input+consumed, values[n]);
+        if (l < 0 || l > length-consumed) break;
+        consumed += l;
+    }
+    return n;
+}
+
 static void copyFormatString(StreamBuffer& info, const char* source)
 {
     const char* p = source - 1;
@@ -245,7 +317,8 @@ static void copyFormatString(StreamBuffer& info, const char* source)
 
 // Standard Long Converter for 'diouxX'
 
-static int prepareval(const StreamFormat& fmt, const char*& input, bool& neg)
+static int prepareval(const StreamFormat& fmt, const char*& input, bool& neg,
+    StreamBuffer& copy)
 {
     int length = 0;
     neg = false;
@@ -260,9 +333,11 @@ static int prepareval(const StreamFormat& fmt, const char*& input, bool& neg)
             // but do so if space flag is present
             width -= length;
         }
-        strncpy((char*)fmt.info, input, width);
-        ((char*)fmt.info)[width] = 0;
-        input = fmt.info;
+        // don't write to fmt.info: compiled protocols are shared
+        int n = 0;
+        while (n < width && input[n]) n++;
+        copy.set(input, n);
+        input = copy();
     }
     if (*input == '+')
     {
@@ -288,6 +363,11 @@ class StdLongConverter : public StreamFormatConverter
     int parse(const StreamFormat& fmt, StreamBuffer& output, const char*& value, bool scanFormat);
     bool printLong(const StreamFormat& fmt, StreamBuffer& output, long value);
     int scanLong(const StreamFormat& fmt, const char* input, long& value);
+    long printLongs(const StreamFormat& fmt, StreamBuffer& output,
+        const long* values, long count, const StreamBuffer& separator);
+    long scanLongs(const StreamFormat& fmt, const char* input, long length,
+        long* values, long maxcount, const StreamBuffer& separator,
+        long& consumed);
 };
 
 int StdLongConverter::
@@ -300,11 +380,7 @@ parse(const StreamFormat& fmt, StreamBuffer& info,
             fmt.prec, fmt.conv);
         return false;
     }
-    if (scanFormat)
-    {
-        if (fmt.width) info.reserve(fmt.width+1);
-    }
-    else
+    if (!scanFormat)
     {
         copyFormatString(info, source);
         info.append('l');
@@ -327,8 +403,9 @@ scanLong(const StreamFormat& fmt, const char* input, long& value)
     int length;
     bool neg;
     int base;
+    StreamBuffer copy;
 
-    length = prepareval(fmt, input, neg);
+    length = prepareval(fmt, input, neg, copy);
     if (length < 0) return -1;
     switch (fmt.conv)
     {
@@ -359,6 +436,88 @@ signcheck:
     return length;
 }
 
+long StdLongConverter::
+printLongs(const StreamFormat& fmt, StreamBuffer& output,
+    const long* values, long count, const StreamBuffer& separator)
+{
+    long n;
+    if (fmt.conv != 'd' || fmt.flags || fmt.width || fmt.prec >= 0)
+    {
+        for (n = 0; n < count; n++)
+        {
+            if (n) output.append(separator);
+            output.print(fmt.info, values[n]);
+        }
+        return count;
+    }
+    // plain %d: no need for printf
+    char digits[sizeof(long)*3+2];
+    char* end = digits+sizeof(digits);
+    for (n = 0; n < count; n++)
+    {
+        if (n) output.append(separator);
+        long value = values[n];
+        unsigned long val = value < 0 ?
+            -(unsigned long)value : (unsigned long)value;
+        char* p = end;
+        do *--p = '0' + val % 10; while (val /= 10);
+        if (value < 0) *--p = '-';
+        output.append(p, end-p);
+    }
+    return count;
+}
+
+long StdLongConverter::
+scanLongs(const StreamFormat& fmt, const char* input, long length,
+    long* values, long maxcount, const StreamBuffer& separator,
+    long& consumed)
+{
+    long n, l;
+    bool plain = fmt.conv == 'd' && !fmt.width &&
+        !(fmt.flags & (left_flag|alt_flag));
+    consumed = 0;
+    for (n = 0; n < maxcount; n++)
+    {
+        if (n)
+        {
+            if (!matchSeparator(separator, input+consumed, length-consumed))
+                break;
+            consumed += separator.length();
+        }
+        if (plain)
+        {
+            // plain %d: short numbers without strtoul
+            const char* p = input+consumed;
+            while (isspace(*p)) p++;
+            bool neg = (*p == '-');
+            if (neg || *p == '+') p++;
+            if (isdigit(*p))
+            {
+                unsigned long val = 0;
+                int digits = 0;
+                while (isdigit(*p) && digits < (int)sizeof(long)*2)
+                {
+                    val = val * 10 + (*p++ - '0');
+                    digits++;
+                }
+                if (!isdigit(*p))
+                {
+                    l = p - (input+consumed);
+                    if (l > length-consumed) break;
+                    values[n] = neg ? -(long)val : (long)val;
+                    consumed += l;
+                    continue;
+                }
+            }
+            // anything unusual: take the long way
+        }
+        l = StdLongConverter::scanLong(fmt, input+consumed, values[n]);
+        if (l < 0 || l > length-consumed) break;
+        consumed += l;
+    }
+    return n;
+}
+
 RegisterConverter (StdLongConverter, "diouxX");
 
 // Standard Double Converter for 'feEgG'
@@ -368,6 +527,10 @@ class StdDoubleConverter : public StreamFormatConverter
     virtual int parse(const StreamFormat&, StreamBuffer&, const char*&, bool);
     virtual bool printDouble(const StreamFormat&, StreamBuffer&, double);
     virtual int scanDouble(const StreamFormat&, const char*, double&);
+    virtual long printDoubles(const StreamFormat&, StreamBuffer&,
+        const double*, long, const StreamBuffer&);
+    virtual long scanDoubles(const StreamFormat&, const char*, long,
+        double*, long, const StreamBuffer&, long&);
 };
 
 int StdDoubleConverter::
@@ -380,11 +543,7 @@ parse(const StreamFormat& fmt, StreamBuffer& info,
             fmt.prec, fmt.conv);
         return false;
     }
-    if (scanFormat)
-    {
-        if (fmt.width) info.reserve(fmt.width+1);
-    }
-    else
+    if (!scanFormat)
     {
         copyFormatString(info, source);
         info.append(fmt.conv);
@@ -405,8 +564,9 @@ scanDouble(const StreamFormat& fmt, const char* input, double& value)
     char* end;
     int length;
     bool neg;
+    StreamBuffer copy;
 
-    length = prepareval(fmt, input, neg);
+    length = prepareval(fmt, input, neg, copy);
     if (length < 0) return -1;
     value = strtod(input, &end);
     if (neg) value = -value;
@@ -415,6 +575,41 @@ scanDouble(const StreamFormat& fmt, const char* input, double& value)
     return length;
 }
 
+long StdDoubleConverter::
+printDoubles(const StreamFormat& fmt, StreamBuffer& output,
+    const double* values, long count, const StreamBuffer& separator)
+{
+    long n;
+    for (n = 0; n < count; n++)
+    {
+        if (n) output.append(separator);
+        output.print(fmt.info, values[n]);
+    }
+    return count;
+}
+
+long StdDoubleConverter::
+scanDoubles(const StreamFormat& fmt, const char* input, long length,
+    double* values, long maxcount, const StreamBuffer& separator,
+    long& consumed)
+{
+    long n, l;
+    consumed = 0;
+    for (n = 0; n < maxcount; n++)
+    {
+        if (n)
+        {
+            if (!matchSeparator(separator, input+consumed, length-consumed))
+                break;
+            consumed += separator.length();
+        }
+        l = StdDoubleConverter::scanDouble(fmt, input+consumed, values[n]);
+        if (l < 0 || l > length-consumed) break;
+        consumed += l;
+    }
+    return n;
+}
+
 RegisterConverter (StdDoubleConverter, "feEgG");
 
 // Standard String Converter for 's'
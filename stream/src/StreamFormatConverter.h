@@ -64,8 +64,30 @@ public:
         const char* input, char* value, size_t maxlen);
     virtual int scanPseudo(const StreamFormat& fmt,
         StreamBuffer& inputLine, long& cursor);
+    virtual long printLongs(const StreamFormat& fmt,
+        StreamBuffer& output, const long* values, long count,
+        const StreamBuffer& separator);
+    virtual long printDoubles(const StreamFormat& fmt,
+        StreamBuffer& output, const double* values, long count,
+        const StreamBuffer& separator);
+    virtual long scanLongs(const StreamFormat& fmt,
+        const char* input, long length, long* values, long maxcount,
+        const StreamBuffer& separator, long& consumed);
+    virtual long scanDoubles(const StreamFormat& fmt,
+        const char* input, long length, double* values, long maxcount,
+        const StreamBuffer& separator, long& consumed);
+protected:
+    static bool matchSeparator(const StreamBuffer& separator,
+        const char* input, long length);
 };
 
+inline bool StreamFormatConverter::
+matchSeparator(const StreamBuffer& separator, const char* input, long length)
+{
+    return separator.length() <= length &&
+        memcmp(input, separator(), separator.length()) == 0;
+}
+
 inline StreamFormatConverter* StreamFormatConverter::
 find(unsigned char c) {
     return registered[c];
@@ -143,6 +165,17 @@ void* ref_##converter = &registrar_##converter\
 * skip_flag is set, you don't need to write to value, since the value will be
 * discarded anyway. Return -1 on failure.
 *
+* print[Longs|Doubles](), scan[Longs|Doubles]()
+* =================
+* Arrays are printed and scanned with these methods in one call.
+* Put the separator (literal bytes) between two values.
+* Return the number of values printed or scanned. In scan*s(), don't read
+* more than length bytes of input, don't scan more than maxcount values,
+* and set consumed to the number of consumed bytes (including a separator
+* after the last value, if the next value fails to scan).
+* The default implementations call print*() or scan*() for each value.
+* Override them only if your converter can do better in one pass.
+*
 *
 * Register your class
 * ===================
@@ -50,6 +50,7 @@ class StreamProtocolParser::Protocol::Variable
 
 StreamProtocolParser* StreamProtocolParser::parsers = NULL;
 const char* StreamProtocolParser::path = ".";
+unsigned long StreamProtocolParser::generation = 0;
 static const char* specialChars = " ,;{}=()$'\"+-*/";
 
 // Client destructor
@@ -137,6 +138,7 @@ free()
 {
     delete parsers;
     parsers = NULL;
+    generation++;
 }
 
 /*
@@ -715,6 +717,7 @@ Protocol(const char* filename)
 {
     line = 0;
     next = NULL;
+    fieldAddresses = 0;
     variables = new Variable(NULL, 0, 500);
     commands = &variables->value;
 }
@@ -725,6 +728,7 @@ Protocol(const Protocol& p, StreamBuffer& name, int _line)
     : protocolname(name), filename(p.filename)
 {
     next = NULL;
+    fieldAddresses = 0;
     // copy all variables
     Variable* pV;
     Variable** ppNewV = &variables;
@@ -1417,6 +1421,7 @@ compileFormat(StreamBuffer& buffer, const char*& formatstr,
                 "Field '%s' not found\n", buffer(fieldname));
             return false;
         }
+        fieldAddresses++;
         source = fieldnameEnd;
         unsigned short length = (unsigned short)fieldAddress.length();
         buffer.append(&length, sizeof(length));
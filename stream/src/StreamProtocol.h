@@ -50,6 +50,7 @@ public:
         StreamBuffer* commands;
         int line;
         const char* parameter[10];
+        int fieldAddresses;
 
         Protocol(const char* filename);
         Protocol(const Protocol& p, StreamBuffer& name, int line);
@@ -75,6 +76,7 @@ public:
         bool compileString(StreamBuffer& buffer, const char*& source,
             FormatType formatType = NoFormat, Client* = NULL, int quoted = false);
         bool checkUnused();
+        bool usesFieldAddresses() { return fieldAddresses != 0; }
         ~Protocol();
         void report();
     };
@@ -122,6 +124,7 @@ public:
         const StreamBuffer& protocolAndParams);
     static void free();
     static const char* path;
+    static unsigned long generation; // incremented by free()
     static const char* printString(StreamBuffer&, const char* string);
     void report();
 };
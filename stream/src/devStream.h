@@ -87,6 +87,10 @@ epicsShareExtern long streamGetIointInfo(int cmd,
 epicsShareExtern long streamPrintf(dbCommon *record, format_t *format, ...);
 epicsShareExtern long streamScanfN(dbCommon *record, format_t *format,
     void*, size_t maxStringSize);
+epicsShareExtern long streamPrintfArray(dbCommon *record, format_t *format,
+    const void* array, int ftvl, long nelem);
+epicsShareExtern long streamScanfArray(dbCommon *record, format_t *format,
+    void* array, int ftvl, long maxelem, long* nord);
 
 /* backward compatibility stuff */
 #define devStreamIoFunction streamIoFunction
@@ -28,71 +28,22 @@
 static long readData (dbCommon *record, format_t *format)
 {
     aaiRecord *aai = (aaiRecord *) record;
-    double dval;
     long lval;
+    long nord;
+    long status;
 
+    if (format->type != DBF_STRING)
+    {
+        /* numeric values: scan the whole array in one pass */
+        status = streamScanfArray (record, format,
+            aai->bptr, aai->ftvl, aai->nelm, &nord);
+        aai->nord = nord;
+        return status;
+    }
     for (aai->nord = 0; aai->nord < aai->nelm; aai->nord++)
     {
         switch (format->type)
         {
-            case DBF_DOUBLE:
-            {
-                if (streamScanf (record, format, &dval) != OK)
-                {
-                    return aai->nord ? OK : ERROR;
-                }
-                switch (aai->ftvl)
-                {
-                    case DBF_DOUBLE:
-                        ((epicsFloat64 *)aai->bptr)[aai->nord] = (epicsFloat64)dval;
-                        break;
-                    case DBF_FLOAT:
-                        ((epicsFloat32 *)aai->bptr)[aai->nord] = (epicsFloat32)dval;
-                        break;
-                    default:
-                        errlogSevPrintf (errlogFatal,
-                            "readData %s: can't convert from double to %s\n",
-                            record->name, pamapdbfType[aai->ftvl].strvalue);
-                        return ERROR;
-                }
-                break;
-            }
-            case DBF_LONG:
-            case DBF_ENUM:
-            {
-                if (streamScanf (record, format, &lval) != OK)
-                {
-                    return aai->nord ? OK : ERROR;
-                }
-                switch (aai->ftvl)
-                {
-                    case DBF_DOUBLE:
-                        ((epicsFloat64 *)aai->bptr)[aai->nord] = (epicsFloat64)lval;
-                        break;
-                    case DBF_FLOAT:
-                        ((epicsFloat32 *)aai->bptr)[aai->nord] = (epicsFloat32)lval;
-                        break;
-                    case DBF_LONG:
-                    case DBF_ULONG:
-                        ((epicsInt32 *)aai->bptr)[aai->nord] = (epicsInt32)lval;
-                        break;
-                    case DBF_SHORT:
-                    case DBF_USHORT:
-                    case DBF_ENUM:
-                        ((epicsInt16 *)aai->bptr)[aai->nord] = (epicsInt16)lval;
-                        break;
-                    case DBF_CHAR:
-                    case DBF_UCHAR:
-                        ((epicsInt8 *)aai->bptr)[aai->nord] = (epicsInt8)lval;
-                        break;
-                    default:
-                        errlogSevPrintf (errlogFatal,
-                            "readData %s: can't convert from long to %s\n",
-                            record->name, pamapdbfType[aai->ftvl].strvalue);
-                        return ERROR;
-                }
-                break;
-            }
             case DBF_STRING:
             {
                 switch (aai->ftvl)
@@ -144,87 +95,18 @@ static long readData (dbCommon *record, format_t *format)
 static long writeData (dbCommon *record, format_t *format)
 {
     aaiRecord *aai = (aaiRecord *) record;
-    double dval;
-    long lval;
     unsigned long nowd;
 
+    if (format->type != DBF_STRING)
+    {
+        /* numeric values: print the whole array in one pass */
+        return streamPrintfArray (record, format,
+            aai->bptr, aai->ftvl, aai->nord);
+    }
     for (nowd = 0; nowd < aai->nord; nowd++)
     {
         switch (format->type)
         {
-            case DBF_DOUBLE:
-            {
-                switch (aai->ftvl)
-                {
-                    case DBF_DOUBLE:
-                        dval = ((epicsFloat64 *)aai->bptr)[nowd];
-                        break;
-                    case DBF_FLOAT:
-                        dval = ((epicsFloat32 *)aai->bptr)[nowd];
-                        break;
-                    case DBF_LONG:
-                        dval = ((epicsInt32 *)aai->bptr)[nowd];
-                        break;
-                    case DBF_ULONG:
-                        dval = ((epicsUInt32 *)aai->bptr)[nowd];
-                        break;
-                    case DBF_SHORT:
-                        dval = ((epicsInt16 *)aai->bptr)[nowd];
-                        break;
-                    case DBF_USHORT:
-                    case DBF_ENUM:
-                        dval = ((epicsUInt16 *)aai->bptr)[nowd];
-                        break;
-                    case DBF_CHAR:
-                        dval = ((epicsInt8 *)aai->bptr)[nowd];
-                        break;
-                    case DBF_UCHAR:
-                        dval = ((epicsUInt8 *)aai->bptr)[nowd];
-                        break;
-                    default:
-                        errlogSevPrintf (errlogFatal,
-                            "writeData %s: can't convert from %s to double\n",
-                            record->name, pamapdbfType[aai->ftvl].strvalue);
-                        return ERROR;
-                }
-                if (streamPrintf (record, format, dval))
-                    return ERROR;
-                break;
-            }
-            case DBF_LONG:
-            case DBF_ENUM:
-            {
-                switch (aai->ftvl)
-                {
-                    case DBF_LONG:
-                        lval = ((epicsInt32 *)aai->bptr)[nowd];
-                        break;
-                    case DBF_ULONG:
-                        lval = ((epicsUInt32 *)aai->bptr)[nowd];
-                        break;
-                    case DBF_SHORT:
-                        lval = ((epicsInt16 *)aai->bptr)[nowd];
-                        break;
-                    case DBF_USHORT:
-                    case DBF_ENUM:
-                        lval = ((epicsUInt16 *)aai->bptr)[nowd];
-                        break;
-                    case DBF_CHAR:
-                        lval = ((epicsInt8 *)aai->bptr)[nowd];
-                        break;
-                    case DBF_UCHAR:
-                        lval = ((epicsUInt8 *)aai->bptr)[nowd];
-                        break;
-                    default:
-                        errlogSevPrintf (errlogFatal,
-                            "writeData %s: can't convert from %s to long\n",
-                            record->name, pamapdbfType[aai->ftvl].strvalue);
-                        return ERROR;
-                }
-                if (streamPrintf (record, format, lval))
-                    return ERROR;
-                break;
-            }
             case DBF_STRING:
             {
                 switch (aai->ftvl)
@@ -27,72 +27,23 @@
 static long readData (dbCommon *record, format_t *format)
 {
     waveformRecord *wf = (waveformRecord *) record;
-    double dval;
     long lval;
+    long nord;
+    long status;
 
     wf->rarm = 0;
+    if (format->type != DBF_STRING)
+    {
+        /* numeric values: scan the whole array in one pass */
+        status = streamScanfArray (record, format,
+            wf->bptr, wf->ftvl, wf->nelm, &nord);
+        wf->nord = nord;
+        return status;
+    }
     for (wf->nord = 0; wf->nord < wf->nelm; wf->nord++)
     {
         switch (format->type)
         {
-            case DBF_DOUBLE:
-            {
-                if (streamScanf (record, format, &dval) != OK)
-                {
-                    return wf->nord ? OK : ERROR;
-                }
-                switch (wf->ftvl)
-                {
-                    case DBF_DOUBLE:
-                        ((epicsFloat64 *)wf->bptr)[wf->nord] = (epicsFloat64)dval;
-                        break;
-                    case DBF_FLOAT:
-                        ((epicsFloat32 *)wf->bptr)[wf->nord] = (epicsFloat32)dval;
-                        break;
-                    default:
-                        errlogSevPrintf (errlogFatal,
-                            "readData %s: can't convert from double to %s\n",
-                            record->name, pamapdbfType[wf->ftvl].strvalue);
-                        return ERROR;
-                }
-                break;
-            }
-            case DBF_LONG:
-            case DBF_ENUM:
-            {
-                if (streamScanf (record, format, &lval) != OK)
-                {
-                    return wf->nord ? OK : ERROR;
-                }
-                switch (wf->ftvl)
-                {
-                    case DBF_DOUBLE:
-                        ((epicsFloat64 *)wf->bptr)[wf->nord] = (epicsFloat64)lval;
-                        break;
-                    case DBF_FLOAT:
-                        ((epicsFloat32 *)wf->bptr)[wf->nord] = (epicsFloat32)lval;
-                        break;
-                    case DBF_LONG:
-                    case DBF_ULONG:
-                        ((epicsInt32 *)wf->bptr)[wf->nord] = (epicsInt32)lval;
-                        break;
-                    case DBF_SHORT:
-                    case DBF_USHORT:
-                    case DBF_ENUM:
-                        ((epicsInt16 *)wf->bptr)[wf->nord] = (epicsInt16)lval;
-                        break;
-                    case DBF_CHAR:
-                    case DBF_UCHAR:
-                        ((epicsInt8 *)wf->bptr)[wf->nord] = (epicsInt8)lval;
-                        break;
-                    default:
-                        errlogSevPrintf (errlogFatal,
-                            "readData %s: can't convert from long to %s\n",
-                            record->name, pamapdbfType[wf->ftvl].strvalue);
-                        return ERROR;
-                }
-                break;
-            }
             case DBF_STRING:
             {
                 switch (wf->ftvl)
@@ -144,87 +95,18 @@ static long readData (dbCommon *record, format_t *format)
 static long writeData (dbCommon *record, format_t *format)
 {
     waveformRecord *wf = (waveformRecord *) record;
-    double dval;
-    long lval;
     unsigned long nowd;
 
+    if (format->type != DBF_STRING)
+    {
+        /* numeric values: print the whole array in one pass */
+        return streamPrintfArray (record, format,
+            wf->bptr, wf->ftvl, wf->nord);
+    }
     for (nowd = 0; nowd < wf->nord; nowd++)
     {
         switch (format->type)
         {
-            case DBF_DOUBLE:
-            {
-                switch (wf->ftvl)
-                {
-                    case DBF_DOUBLE:
-                        dval = ((epicsFloat64 *)wf->bptr)[nowd];
-                        break;
-                    case DBF_FLOAT:
-                        dval = ((epicsFloat32 *)wf->bptr)[nowd];
-                        break;
-                    case DBF_LONG:
-                        dval = ((epicsInt32 *)wf->bptr)[nowd];
-                        break;
-                    case DBF_ULONG:
-                        dval = ((epicsUInt32 *)wf->bptr)[nowd];
-                        break;
-                    case DBF_SHORT:
-                        dval = ((epicsInt16 *)wf->bptr)[nowd];
-                        break;
-                    case DBF_USHORT:
-                    case DBF_ENUM:
-                        dval = ((epicsUInt16 *)wf->bptr)[nowd];
-                        break;
-                    case DBF_CHAR:
-                        dval = ((epicsInt8 *)wf->bptr)[nowd];
-                        break;
-                    case DBF_UCHAR:
-                        dval = ((epicsUInt8 *)wf->bptr)[nowd];
-                        break;
-                    default:
-                        errlogSevPrintf (errlogFatal,
-                            "writeData %s: can't convert from %s to double\n",
-                            record->name, pamapdbfType[wf->ftvl].strvalue);
-                        return ERROR;
-                }
-                if (streamPrintf (record, format, dval))
-                    return ERROR;
-                break;
-            }
-            case DBF_LONG:
-            case DBF_ENUM:
-            {
-                switch (wf->ftvl)
-                {
-                    case DBF_LONG:
-                        lval = ((epicsInt32 *)wf->bptr)[nowd];
-                        break;
-                    case DBF_ULONG:
-                        lval = ((epicsUInt32 *)wf->bptr)[nowd];
-                        break;
-                    case DBF_SHORT:
-                        lval = ((epicsInt16 *)wf->bptr)[nowd];
-                        break;
-                    case DBF_USHORT:
-                    case DBF_ENUM:
-                        lval = ((epicsUInt16 *)wf->bptr)[nowd];
-                        break;
-                    case DBF_CHAR:
-                        lval = ((epicsInt8 *)wf->bptr)[nowd];
-                        break;
-                    case DBF_UCHAR:
-                        lval = ((epicsUInt8 *)wf->bptr)[nowd];
-                        break;
-                    default:
-                        errlogSevPrintf (errlogFatal,
-                            "writeData %s: can't convert from %s to long\n",
-                            record->name, pamapdbfType[wf->ftvl].strvalue);
-                        return ERROR;
-                }
-                if (streamPrintf (record, format, lval))
-                    return ERROR;
-                break;
-            }
             case DBF_STRING:
             {
                 switch (wf->ftvl)